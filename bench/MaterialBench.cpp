@@ -0,0 +1,436 @@
+/*
+Measures the CPU cost of setting up a draw (Material::use) for every submesh of Sponza, once
+with the uniforms looked up by name the way materials used to (uniformExists, then operator[]
+for every set call) and once with Material::use as it is (uniform blocks, handles resolved
+per link). The Standard shaders only have blocks now, so the by-name baseline sets its
+uniforms on a small program that declares them the way the shaders did before.
+Then draws Sponza with its mix of materials into an offscreen 1920x1080 target and compares
+the GPU time of the Standard program that checks the material flags at runtime with the
+variants compiled for each combination of maps (ShaderVariants).
+Needs an OpenGL 4.6 context, the window stays hidden.
+
+Usage: planets-materialbench [data directory] [repetitions]
+*/
+
+#include "ShaderProgram.hpp"
+#include "Material.hpp"
+#include "MeshImporter.hpp"
+#include "ThreadPool.hpp"
+#include "Texture2D.hpp"
+#include "StaticMesh.hpp"
+#include "ShaderVariants.hpp"
+#include "ShaderPreprocessor.hpp"
+#include "VirtualFileSystem.hpp"
+#include "UniformBuffer.hpp"
+#include "DebugUtils.hpp"
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <spdlog/spdlog.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <algorithm>
+#include <iterator>
+#include <cstdlib>
+
+namespace
+{
+    template <typename F>
+    double bestOfMs(int repetitions, F &&function)
+    {
+        double best = 1e30;
+        for (int i = 0; i < repetitions; i++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            function();
+            auto end = std::chrono::steady_clock::now();
+            best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+        }
+        return best;
+    }
+
+    // The plain uniforms Standard_vert/frag declared before the uniform blocks, all of them used
+    const char *NAMED_VERTEX_SOURCE = R"(#version 460 core
+layout (location = 0) in vec4 in_Position;
+
+uniform mat4 modelToClipSpace;
+uniform mat4 modelToWorldSpace;
+uniform mat3 modelToWorldSpace_Normal;
+uniform vec3 cameraWorldPosition;
+uniform vec3 cameraDirection;
+uniform float time;
+uniform int vertexFormat;
+
+out vec3 worldNormal;
+out float viewDepth;
+
+void main()
+{
+    vec4 worldPosition = modelToWorldSpace * in_Position;
+    worldNormal = modelToWorldSpace_Normal * vec3(0.0, 1.0, 0.0);
+    viewDepth = dot(worldPosition.xyz - cameraWorldPosition, cameraDirection) + time + float(vertexFormat);
+    gl_Position = modelToClipSpace * in_Position;
+}
+)";
+    const char *NAMED_FRAGMENT_SOURCE = R"(#version 460 core
+in vec3 worldNormal;
+in float viewDepth;
+
+uniform int materialFlags;
+uniform vec3 diffuseColor;
+uniform float roughness;
+uniform float metalness;
+uniform vec3 emissionColor;
+
+uniform sampler2D diffuseMap;
+uniform sampler2D roughnessMap;
+uniform sampler2D normalMap;
+uniform sampler2D metalnessMap;
+uniform sampler2D emissionMap;
+uniform sampler2D aoMap;
+
+uniform sampler2DArray diffuseArray;
+uniform sampler2DArray roughnessArray;
+uniform sampler2DArray normalArray;
+uniform sampler2DArray metalnessArray;
+uniform sampler2DArray emissionArray;
+uniform sampler2DArray aoArray;
+uniform int diffuseLayer;
+uniform int roughnessLayer;
+uniform int normalLayer;
+uniform int metalnessLayer;
+uniform int emissionLayer;
+uniform int aoLayer;
+
+out vec4 out_Color;
+
+void main()
+{
+    vec2 uv = worldNormal.xz;
+    vec4 color = vec4(diffuseColor * roughness + emissionColor * metalness, float(materialFlags) + viewDepth);
+    color += texture(diffuseMap, uv) + texture(diffuseArray, vec3(uv, diffuseLayer));
+    color += texture(roughnessMap, uv) + texture(roughnessArray, vec3(uv, roughnessLayer));
+    color += texture(normalMap, uv) + texture(normalArray, vec3(uv, normalLayer));
+    color += texture(metalnessMap, uv) + texture(metalnessArray, vec3(uv, metalnessLayer));
+    color += texture(emissionMap, uv) + texture(emissionArray, vec3(uv, emissionLayer));
+    color += texture(aoMap, uv) + texture(aoArray, vec3(uv, aoLayer));
+    out_Color = color;
+}
+)";
+
+    // The lookups ShaderProgram did for every set call before uniform handles
+    class NamedUniforms
+    {
+    public:
+        NamedUniforms(GLuint programId)
+        {
+            GLint numUniforms{0};
+            glGetProgramiv(programId, GL_ACTIVE_UNIFORMS, &numUniforms);
+            for (GLint i = 0; i < numUniforms; i++)
+            {
+                GLint size;
+                GLenum type;
+                GLchar name[256];
+                GLsizei length;
+                glGetActiveUniform(programId, static_cast<GLuint>(i), sizeof(name), &length, &size, &type, name);
+                m_Locations[name] = glGetUniformLocation(programId, name);
+            }
+        }
+
+        bool contains(const char *name) const { return m_Locations.find(name) != m_Locations.end(); }
+
+        void setMatrix4f(const char *name, const glm::mat4 &matrix)
+        {
+            if (m_Locations.find(name) != m_Locations.end())
+                glUniformMatrix4fv(m_Locations[name], 1, GL_FALSE, &matrix[0][0]);
+        }
+        void setMatrix3f(const char *name, const glm::mat3 &matrix)
+        {
+            if (m_Locations.find(name) != m_Locations.end())
+                glUniformMatrix3fv(m_Locations[name], 1, GL_FALSE, &matrix[0][0]);
+        }
+        void setVector3f(const char *name, const glm::vec3 &vector)
+        {
+            if (m_Locations.find(name) != m_Locations.end())
+                glUniform3fv(m_Locations[name], 1, &vector[0]);
+        }
+        void setFloat(const char *name, GLfloat value)
+        {
+            if (m_Locations.find(name) != m_Locations.end())
+                glUniform1f(m_Locations[name], value);
+        }
+        void setInt(const char *name, GLint value)
+        {
+            if (m_Locations.find(name) != m_Locations.end())
+                glUniform1i(m_Locations[name], value);
+        }
+
+    private:
+        std::unordered_map<std::string, GLint> m_Locations;
+    };
+}
+
+int main(int argc, char *argv[])
+{
+    std::string dataDirectory = argc > 1 ? argv[1] : "data";
+    int repetitions = argc > 2 ? std::max(1, std::atoi(argv[2])) : 20;
+
+    spdlog::set_level(spdlog::level::warn);
+
+    if (!glfwInit())
+    {
+        spdlog::critical("Unable to initialize GLFW");
+        return EXIT_FAILURE;
+    }
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow *window = glfwCreateWindow(64, 64, "planets-materialbench", nullptr, nullptr);
+    if (window == nullptr)
+    {
+        spdlog::critical("Unable to create an OpenGL 4.6 context");
+        glfwTerminate();
+        return EXIT_FAILURE;
+    }
+    glfwMakeContextCurrent(window);
+    gladLoadGL();
+
+    {
+        planets::ThreadPool threadPool;
+        planets::ImportedMesh sponza = planets::MeshImporter::importObj(dataDirectory + "/models/sponza_separated.obj", threadPool);
+
+        auto preprocessor = std::make_shared<planets::ShaderPreprocessor>(std::make_shared<planets::VirtualFileSystem>(dataDirectory), "shaders");
+        preprocessor->setEngineDefines();
+        auto program = std::make_shared<planets::ShaderProgram>(preprocessor->process("shaders/Standard_vert.glsl").source,
+                                                                preprocessor->process("shaders/Standard_frag.glsl").source);
+        auto variants = std::make_shared<planets::ShaderVariants>(program, preprocessor, "shaders/Standard_vert.glsl",
+                                                                  "shaders/Standard_frag.glsl", "VARIANT_FLAGS");
+
+        // A checkerboard with mips, so that the fetches the flags guard cost about what real maps do
+        const int textureSize = 512;
+        std::vector<unsigned char> pixels(textureSize * textureSize * 4);
+        for (int y = 0; y < textureSize; y++)
+        {
+            for (int x = 0; x < textureSize; x++)
+            {
+                unsigned char value = ((x / 32 + y / 32) % 2) ? 224 : 96;
+                for (int c = 0; c < 4; c++)
+                {
+                    pixels[(y * textureSize + x) * 4 + c] = c == 3 ? 255 : value;
+                }
+            }
+        }
+        auto texture = std::make_shared<planets::Texture2D>(textureSize, textureSize, pixels.data(), planets::Texture2D::TextureDataFormat::RGBA8);
+
+        // Same flags as the materials ResourceManager creates, all maps point to one texture
+        auto setUpMaterial = [&](planets::StandardMaterial &material, const planets::ImportedMaterial &imported)
+        {
+            material.setDiffuseColor(imported.diffuseColor);
+            if (!imported.diffuseMap.empty())
+                material.setDiffuseMap(texture);
+            if (!imported.normalMap.empty())
+                material.setNormalMap(texture);
+            if (!imported.roughnessMap.empty())
+                material.setRoughnessMap(texture);
+            if (!imported.metalnessMap.empty())
+                material.setMetalnessMap(texture);
+        };
+        std::vector<std::shared_ptr<planets::StandardMaterial>> materials;
+        std::vector<std::shared_ptr<planets::StandardMaterial>> variantMaterials;
+        for (const auto &imported : sponza.materials)
+        {
+            materials.push_back(std::make_shared<planets::StandardMaterial>(program, 0));
+            setUpMaterial(*materials.back(), imported);
+            variantMaterials.push_back(std::make_shared<planets::StandardMaterial>(variants, 0));
+            setUpMaterial(*variantMaterials.back(), imported);
+        }
+        auto fallback = std::make_shared<planets::StandardMaterial>(program, 0);
+        auto variantFallback = std::make_shared<planets::StandardMaterial>(variants, 0);
+
+        std::vector<const planets::StandardMaterial *> draws;
+        std::vector<const planets::StandardMaterial *> variantDraws;
+        for (const auto &submesh : sponza.submeshes)
+        {
+            draws.push_back(submesh.materialIndex >= 0 ? materials[submesh.materialIndex].get() : fallback.get());
+            variantDraws.push_back(submesh.materialIndex >= 0 ? variantMaterials[submesh.materialIndex].get() : variantFallback.get());
+        }
+
+        glm::mat4 modelToClip(1.0f), modelToWorld(1.0f);
+        glm::mat3 normalMatrix(1.0f);
+        glm::vec3 cameraPosition(0.0f), cameraDirection(0.0f, 0.0f, -1.0f);
+        planets::DrawStats drawStats;
+        planets::UniformRingBuffer objectUniforms(1 << 20);
+        planets::MaterialInput input{modelToClip, modelToWorld, normalMatrix, 1, objectUniforms, drawStats};
+
+        planets::ShaderProgram namedProgram(NAMED_VERTEX_SOURCE, NAMED_FRAGMENT_SOURCE);
+        GLuint programId{0};
+        namedProgram.use();
+        glGetIntegerv(GL_CURRENT_PROGRAM, reinterpret_cast<GLint *>(&programId));
+        NamedUniforms named(programId);
+        const char *mapNames[][3] = {{"diffuseMap", "diffuseArray", "diffuseLayer"},
+                                     {"roughnessMap", "roughnessArray", "roughnessLayer"},
+                                     {"normalMap", "normalArray", "normalLayer"},
+                                     {"metalnessMap", "metalnessArray", "metalnessLayer"},
+                                     {"emissionMap", "emissionArray", "emissionLayer"},
+                                     {"aoMap", "aoArray", "aoLayer"}};
+        // A uniform the driver optimized out would skip its glUniform call and flatter the baseline
+        std::vector<const char *> namedUniforms{"modelToClipSpace", "modelToWorldSpace", "modelToWorldSpace_Normal",
+                                                "cameraWorldPosition", "cameraDirection", "time", "vertexFormat",
+                                                "materialFlags", "diffuseColor", "roughness", "metalness", "emissionColor"};
+        for (const auto &names : mapNames)
+        {
+            namedUniforms.insert(namedUniforms.end(), std::begin(names), std::end(names));
+        }
+        for (const char *name : namedUniforms)
+        {
+            if (!named.contains(name))
+            {
+                spdlog::critical("The by-name baseline program does not use the uniform \"{}\"", name);
+                return EXIT_FAILURE;
+            }
+        }
+
+        // The calls StandardMaterial::use made per draw, minus the texture binds both paths share
+        double namedMs = bestOfMs(repetitions, [&]()
+                                  {
+                                      for (const auto *material : draws)
+                                      {
+                                          namedProgram.use();
+                                          named.setMatrix4f("modelToClipSpace", modelToClip);
+                                          named.setMatrix4f("modelToWorldSpace", modelToWorld);
+                                          named.setMatrix3f("modelToWorldSpace_Normal", normalMatrix);
+                                          named.setVector3f("cameraWorldPosition", cameraPosition);
+                                          named.setVector3f("cameraDirection", cameraDirection);
+                                          named.setFloat("time", 0.0f);
+                                          named.setInt("vertexFormat", 1);
+                                          named.setInt("materialFlags", material->getFlags());
+                                          named.setVector3f("diffuseColor", glm::vec3(1.0f));
+                                          named.setFloat("roughness", 0.5f);
+                                          named.setFloat("metalness", 0.0f);
+                                          named.setVector3f("emissionColor", glm::vec3(0.0f));
+                                          for (GLint unit = 0; unit < 6; unit++)
+                                          {
+                                              named.setInt(mapNames[unit][0], unit);
+                                              named.setInt(mapNames[unit][1], unit + 6);
+                                              if (material->getFlags() & (1 << unit))
+                                              {
+                                                  named.setInt(mapNames[unit][2], -1);
+                                              }
+                                          }
+                                      }
+                                      glFinish(); });
+
+        // Per-frame data is uploaded once per frame like in Scene::draw
+        planets::UniformBuffer frameUniforms(sizeof(planets::FrameBlock));
+        double handleMs = bestOfMs(repetitions, [&]()
+                                   {
+                                       planets::Material::resetBindings();
+                                       planets::FrameBlock frame{};
+                                       frame.cameraWorldPosition = cameraPosition;
+                                       frame.cameraDirection = cameraDirection;
+                                       frameUniforms.update(&frame, sizeof(frame));
+                                       frameUniforms.bind(planets::FRAME_BLOCK_BINDING);
+                                       objectUniforms.beginFrame();
+                                       for (const auto *material : draws)
+                                       {
+                                           material->use(input);
+                                       }
+                                       objectUniforms.endFrame();
+                                       glFinish(); });
+
+        // Fragment cost: the whole of Sponza seen from one end of the atrium
+        const GLsizei width = 1920, height = 1080;
+        GLuint framebuffer{0}, targets[3]{};
+        glCreateFramebuffers(1, &framebuffer);
+        glCreateTextures(GL_TEXTURE_2D, 3, targets);
+        glTextureStorage2D(targets[0], 1, GL_RGBA16F, width, height);
+        glTextureStorage2D(targets[1], 1, GL_RGBA16F, width, height);
+        glTextureStorage2D(targets[2], 1, GL_DEPTH_COMPONENT32F, width, height);
+        glNamedFramebufferTexture(framebuffer, GL_COLOR_ATTACHMENT0, targets[0], 0);
+        glNamedFramebufferTexture(framebuffer, GL_COLOR_ATTACHMENT1, targets[1], 0);
+        glNamedFramebufferTexture(framebuffer, GL_DEPTH_ATTACHMENT, targets[2], 0);
+        const GLenum drawBuffers[2]{GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+        glNamedFramebufferDrawBuffers(framebuffer, 2, drawBuffers);
+
+        std::vector<std::shared_ptr<planets::StaticMesh>> meshes;
+        for (auto &submesh : sponza.submeshes)
+        {
+            meshes.push_back(std::make_shared<planets::StaticMesh>(std::move(submesh.vertices),
+                                                                   std::move(submesh.triangleIndices),
+                                                                   std::move(submesh.lods)));
+            meshes.back()->uploadToGPU(planets::StaticMesh::VertexFormat::Float);
+        }
+
+        glm::mat4 viewProjection = glm::perspective(glm::radians(60.0f), float(width) / float(height), 0.1f, 100.0f) *
+                                   glm::lookAt(glm::vec3(-10.0f, 2.0f, 0.0f), glm::vec3(10.0f, 4.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        glm::mat4 identity(1.0f);
+        planets::MaterialInput sceneInput{viewProjection, identity, normalMatrix,
+                                          static_cast<GLint>(planets::StaticMesh::VertexFormat::Float), objectUniforms, drawStats};
+
+        GLuint query{0};
+        glGenQueries(1, &query);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glViewport(0, 0, width, height);
+        glEnable(GL_DEPTH_TEST);
+        auto gpuFrameMs = [&](const std::vector<const planets::StandardMaterial *> &frameDraws)
+        {
+            double best = 1e30;
+            for (int i = 0; i < repetitions; i++)
+            {
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                planets::Material::resetBindings();
+                planets::FrameBlock frame{};
+                frame.viewProjection = viewProjection;
+                frame.cameraWorldPosition = glm::vec3(-10.0f, 2.0f, 0.0f);
+                frame.cameraDirection = glm::vec3(1.0f, 0.0f, 0.0f);
+                frameUniforms.update(&frame, sizeof(frame));
+                frameUniforms.bind(planets::FRAME_BLOCK_BINDING);
+                objectUniforms.beginFrame();
+                glBeginQuery(GL_TIME_ELAPSED, query);
+                for (size_t draw = 0; draw < frameDraws.size(); draw++)
+                {
+                    frameDraws[draw]->use(sceneInput);
+                    meshes[draw]->draw();
+                }
+                glEndQuery(GL_TIME_ELAPSED);
+                objectUniforms.endFrame();
+                GLuint64 elapsedNs{0};
+                glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsedNs);
+                best = std::min(best, elapsedNs / 1e6);
+            }
+            return best;
+        };
+        // The first frames compile the variants and warm up the driver
+        gpuFrameMs(draws);
+        gpuFrameMs(variantDraws);
+        double runtimeFlagsMs = gpuFrameMs(draws);
+        double variantsMs = gpuFrameMs(variantDraws);
+
+        glDeleteQueries(1, &query);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glDeleteFramebuffers(1, &framebuffer);
+        glDeleteTextures(3, targets);
+
+        spdlog::set_level(spdlog::level::info);
+        spdlog::info("Sponza: {} draws with {} materials, best of {}", draws.size(), materials.size(), repetitions);
+        spdlog::info("  uniforms by name: {:.3f} ms per frame, {:.0f} ns per draw", namedMs, namedMs * 1e6 / draws.size());
+        spdlog::info("  uniform blocks:   {:.3f} ms per frame, {:.0f} ns per draw ({:.1f}x)",
+                     handleMs, handleMs * 1e6 / draws.size(), namedMs / handleMs);
+        spdlog::info("GPU time at {}x{}, {} shader variants", width, height, variants->size());
+        spdlog::info("  flags at runtime: {:.3f} ms per frame", runtimeFlagsMs);
+        spdlog::info("  shader variants:  {:.3f} ms per frame ({:.2f}x)", variantsMs, runtimeFlagsMs / variantsMs);
+    }
+
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return EXIT_SUCCESS;
+}
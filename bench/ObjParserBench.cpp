@@ -0,0 +1,113 @@
+/*
+Compares the parallel ObjParser with tinyobjloader on the bundled models. Both sides parse
+the OBJ and its material libraries. ThreadPool callers help with parallelFor, so a pool of
+N workers parses with N + 1 threads.
+
+Usage: planets-objbench [data directory] [repetitions]
+*/
+
+#include "ObjParser.hpp"
+#include "ThreadPool.hpp"
+
+#include <tinyobjloader/tiny_obj_loader.h>
+
+#include <spdlog/spdlog.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <filesystem>
+#include <cstdlib>
+#include <utility>
+
+namespace
+{
+    template <typename F>
+    double bestOfMs(int repetitions, F &&function)
+    {
+        double best = 1e30;
+        for (int i = 0; i < repetitions; i++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            function();
+            auto end = std::chrono::steady_clock::now();
+            best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+        }
+        return best;
+    }
+
+    // The parsers log at info level, only the results are printed
+    template <typename... Args>
+    void report(spdlog::format_string_t<Args...> format, Args &&...args)
+    {
+        spdlog::set_level(spdlog::level::info);
+        spdlog::info(format, std::forward<Args>(args)...);
+        spdlog::set_level(spdlog::level::warn);
+    }
+
+    void parseObjAndMtl(const std::string &path, planets::ThreadPool &pool)
+    {
+        planets::ObjData obj = planets::ObjParser::parseObj(path, pool);
+        for (const auto &library : obj.materialLibraries)
+        {
+            if (std::filesystem::exists(library))
+            {
+                planets::ObjParser::parseMtl(library);
+            }
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    std::string dataDirectory = argc > 1 ? argv[1] : "data";
+    int repetitions = argc > 2 ? std::max(1, std::atoi(argv[2])) : 5;
+
+    spdlog::set_level(spdlog::level::warn);
+
+    std::vector<std::string> models;
+    for (const auto &entry : std::filesystem::directory_iterator(dataDirectory + "/models"))
+    {
+        if (entry.path().extension() == ".obj")
+        {
+            models.push_back(entry.path().string());
+        }
+    }
+    std::sort(models.begin(), models.end());
+
+    // Worker counts, the calling thread comes on top
+    std::vector<size_t> workerCounts{1, 2, 4, 8};
+    size_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    if (hardwareThreads > 1 &&
+        std::find(workerCounts.begin(), workerCounts.end(), hardwareThreads - 1) == workerCounts.end())
+    {
+        workerCounts.push_back(hardwareThreads - 1);
+    }
+
+    for (const auto &model : models)
+    {
+        double sizeMb = std::filesystem::file_size(model) / (1024.0 * 1024.0);
+        report("{} ({:.1f} MB), best of {}", model, sizeMb, repetitions);
+
+        double tinyobjMs = bestOfMs(repetitions, [&]()
+                                    {
+                                        tinyobj::ObjReader reader;
+                                        tinyobj::ObjReaderConfig config;
+                                        config.triangulate = true;
+                                        config.mtl_search_path = dataDirectory + "/models/";
+                                        reader.ParseFromFile(model, config); });
+        report("  tinyobjloader                   {:9.2f} ms", tinyobjMs);
+
+        for (size_t workers : workerCounts)
+        {
+            planets::ThreadPool pool(workers);
+            double parserMs = bestOfMs(repetitions, [&]()
+                                       { parseObjAndMtl(model, pool); });
+            report("  ObjParser, {:2} workers + caller  {:9.2f} ms  ({:.2f}x)", workers, parserMs, tinyobjMs / parserMs);
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
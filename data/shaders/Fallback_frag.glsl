@@ -0,0 +1,18 @@
+#version 330 core
+
+in vec3 WorldSpacePosition;
+
+out vec4 FragColor;
+out vec4 Normal_Depth;
+
+#include "FrameData.glsl"
+
+void main()
+{
+  // Flat normal from the screen-space derivatives, enough to make out the shapes
+  vec3 N = normalize(cross(dFdx(WorldSpacePosition), dFdy(WorldSpacePosition)));
+  float light = 0.3 + 0.4 * abs(dot(N, normalize(cameraWorldPosition - WorldSpacePosition)));
+
+  FragColor = vec4(vec3(light), 1.0);
+  Normal_Depth = vec4(N, distance(WorldSpacePosition, cameraWorldPosition));
+}
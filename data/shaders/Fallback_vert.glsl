@@ -0,0 +1,17 @@
+#version 330 core
+
+// Drawn by materials whose program is still compiling, positions only
+
+// Float: xyz position. Packed: unorm16 position, the decode is folded into the model matrices.
+layout (location = 0) in vec4 in_Position;
+
+out vec3 WorldSpacePosition;
+
+#include "FrameData.glsl"
+#include "ObjectData.glsl"
+
+void main()
+{
+    WorldSpacePosition = (modelToWorldSpace * vec4(in_Position.xyz, 1.0)).xyz;
+    gl_Position = modelToClipSpace * vec4(in_Position.xyz, 1.0);
+}
@@ -0,0 +1,8 @@
+// Uniform blocks in std140 layout, see UniformBuffer.hpp. Bound to FRAME_BLOCK_BINDING.
+layout (std140) uniform FrameData
+{
+    mat4 viewProjection;
+    vec3 cameraWorldPosition;
+    float time;
+    vec3 cameraDirection;
+};
@@ -0,0 +1,46 @@
+#define LIGHT_POINTLIGHT  0
+#define LIGHT_SPOTLIGHT   1
+#define LIGHT_DIRECTIONAL 2
+
+struct Light {
+    int lightType;
+    vec3 positionWorld; // Not relevant for directional lights
+    vec4 direction_Angle; // Direction not relevant for point lights, angle for point lights
+    vec4 color_Intensity; // .xyz color, .w intensity (scale)
+};
+
+vec3 shade(Light light,
+           vec3 diffuse,
+           float roughness,
+           float metalness,
+           vec3 P,
+           vec3 N,
+           vec3 V)
+{
+    vec3 L = light.positionWorld - P; // direction to the light, not relevant for directional lights
+    float L_len = length(L); // distance to the light, not relevant for directional lights
+    L = L / L_len; // normalize it before using
+    float NdotL = max(dot(N, L), 0);
+
+    if (light.lightType == LIGHT_POINTLIGHT) {
+        vec3 H = normalize(L + V);
+        return diffuse
+                * NdotL
+                * (1 / (L_len * L_len))
+                * light.color_Intensity.rgb
+                * light.color_Intensity.a;
+
+    } else if (light.lightType == LIGHT_SPOTLIGHT) {
+        vec3 H = normalize(L + V);
+
+        return vec3(0.0);
+
+    } else if (light.lightType == LIGHT_DIRECTIONAL) {
+        vec3 H = normalize(-light.direction_Angle.xyz + V);
+
+        return vec3(0.0);
+
+    } else {
+        return vec3(0.0);
+    }
+}
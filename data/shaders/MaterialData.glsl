@@ -0,0 +1,16 @@
+// Bound to MATERIAL_BLOCK_BINDING, materialFlags holds HAS_*_MAP bits.
+// The texture array layer of each map is -1 for plain textures.
+layout (std140) uniform MaterialData
+{
+    vec3 diffuseColor;
+    float roughness;
+    vec3 emissionColor;
+    float metalness;
+    int materialFlags;
+    int diffuseLayer;
+    int roughnessLayer;
+    int normalLayer;
+    int metalnessLayer;
+    int emissionLayer;
+    int aoLayer;
+};
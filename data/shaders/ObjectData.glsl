@@ -0,0 +1,8 @@
+// Bound to OBJECT_BLOCK_BINDING, vertexFormat is one of VERTEX_FORMAT_*
+layout (std140) uniform ObjectData
+{
+    mat4 modelToClipSpace;
+    mat4 modelToWorldSpace;
+    mat3 modelToWorldSpace_Normal;
+    int vertexFormat;
+};
@@ -2,20 +2,24 @@
 
 #define M_PI 3.1415926535897932384626433832795
 
-// Flag definitions
-#define HAS_DIFFUSE_MAP   (1 << 0)
-#define HAS_ROUGHNESS_MAP (1 << 1)
-#define HAS_NORMAL_MAP    (1 << 2)
-#define HAS_METALNESS_MAP (1 << 3)
-#define HAS_EMISSION_MAP  (1 << 4)
-#define HAS_AO_MAP        (1 << 5)
+// HAS_*_MAP flags and MAX_LIGHTS are defined by the engine, see ShaderPreprocessor
 
-// Lighting-related definitions
-#define MAX_LIGHTS 128
-#define LIGHT_POINTLIGHT  0
-#define LIGHT_SPOTLIGHT   1
-#define LIGHT_DIRECTIONAL 2
+// Variants compiled for one combination of maps get it as VARIANT_FLAGS (see ShaderVariants),
+// the checks are then constant and the maps a variant does not use are compiled away. The bits
+// above ARRAY_MAP_SHIFT tell which maps are texture array layers, so variants do not check the
+// layer per fetch either.
+#ifdef VARIANT_FLAGS
+#define HAS_MAP(flag) ((VARIANT_FLAGS & (flag)) != 0)
+#define IN_ARRAY(flag, layer) ((VARIANT_FLAGS & ((flag) << ARRAY_MAP_SHIFT)) != 0)
+#else
+#define HAS_MAP(flag) bool(materialFlags & (flag))
+#define IN_ARRAY(flag, layer) ((layer) >= 0)
+#endif
 
+// A macro, a function would take the flag as a variable and branch on it at runtime
+#define SAMPLE_MAP(flag, map, array, layer, texCoord) (IN_ARRAY(flag, layer) ? texture(array, vec3(texCoord, float(layer))) : texture(map, texCoord))
+
+#include "Lighting.glsl"
 
 in vec3 WorldSpacePosition;
 in vec3 EyeDirection;
@@ -27,15 +31,8 @@ in vec2 TexCoord;
 out vec4 FragColor;
 out vec4 Normal_Depth;
 
-uniform vec3 cameraWorldPosition;
-uniform vec3 cameraDirection;
-uniform float time;
-
-uniform int materialFlags;
-uniform vec3 diffuseColor;
-uniform float roughness;
-uniform float metalness;
-uniform vec3 emissionColor;
+#include "FrameData.glsl"
+#include "MaterialData.glsl"
 
 /* Texture maps */
 uniform sampler2D diffuseMap;
@@ -45,20 +42,23 @@ uniform sampler2D metalnessMap;
 uniform sampler2D emissionMap;
 uniform sampler2D aoMap;
 
+/* The same maps when they are layers of texture arrays */
+uniform sampler2DArray diffuseArray;
+uniform sampler2DArray roughnessArray;
+uniform sampler2DArray normalArray;
+uniform sampler2DArray metalnessArray;
+uniform sampler2DArray emissionArray;
+uniform sampler2DArray aoArray;
+
 /* Ligths */
 const int numLights = 4;
-struct Light {
-  int lightType;
-  vec3 positionWorld; // Not relevant for directional lights
-  vec4 direction_Angle; // Direction not relevant for point lights, angle for point lights
-  vec4 color_Intensity; // .xyz color, .w intensity (scale) 
-} lights[MAX_LIGHTS];
+Light lights[MAX_LIGHTS];
 
 
 vec3 getDiffuseColor(vec2 texCoord, out float alpha)
 {
-  if (bool(materialFlags & HAS_DIFFUSE_MAP)) {
-    vec4 sample = texture2D(diffuseMap, TexCoord);
+  if (HAS_MAP(HAS_DIFFUSE_MAP)) {
+    vec4 sample = SAMPLE_MAP(HAS_DIFFUSE_MAP, diffuseMap, diffuseArray, diffuseLayer, TexCoord);
     alpha = sample.a;
     return sample.rgb * diffuseColor;
   } else {
@@ -69,8 +69,11 @@ vec3 getDiffuseColor(vec2 texCoord, out float alpha)
 
 vec3 getNormal(vec2 texCoord)
 {
-  if (bool(materialFlags & HAS_NORMAL_MAP)) {
-    vec3 tangentSpace = texture2D(normalMap, TexCoord).rgb * 2.0 - 1.0;
+  if (HAS_MAP(HAS_NORMAL_MAP)) {
+    // Only XY are stored (BC5 has two channels), Z follows from the normal being unit length
+    vec3 tangentSpace;
+    tangentSpace.xy = SAMPLE_MAP(HAS_NORMAL_MAP, normalMap, normalArray, normalLayer, TexCoord).rg * 2.0 - 1.0;
+    tangentSpace.z = sqrt(max(1.0 - dot(tangentSpace.xy, tangentSpace.xy), 0.0));
     return normalize(mat3(normalize(Tangent), normalize(Bitangent), normalize(Normal)) * tangentSpace);
   } else {
     return Normal;
@@ -79,8 +82,8 @@ vec3 getNormal(vec2 texCoord)
 
 float getRoughness(vec2 texCoord)
 {
-  if (bool(materialFlags & HAS_ROUGHNESS_MAP)) {
-    return texture2D(roughnessMap, TexCoord).r;
+  if (HAS_MAP(HAS_ROUGHNESS_MAP)) {
+    return SAMPLE_MAP(HAS_ROUGHNESS_MAP, roughnessMap, roughnessArray, roughnessLayer, TexCoord).r;
   } else {
     return roughness;
   }
@@ -88,8 +91,8 @@ float getRoughness(vec2 texCoord)
 
 float getMetalness(vec2 texCoord)
 {
-  if (bool(materialFlags & HAS_METALNESS_MAP)) {
-    return texture2D(metalnessMap, TexCoord).r;
+  if (HAS_MAP(HAS_METALNESS_MAP)) {
+    return SAMPLE_MAP(HAS_METALNESS_MAP, metalnessMap, metalnessArray, metalnessLayer, TexCoord).r;
   } else {
     return metalness;
   }
@@ -97,8 +100,8 @@ float getMetalness(vec2 texCoord)
 
 vec3 getEmission(vec2 texCoord)
 {
-  if (bool(materialFlags & HAS_EMISSION_MAP)) {
-    return texture2D(emissionMap, TexCoord).rgb;
+  if (HAS_MAP(HAS_EMISSION_MAP)) {
+    return SAMPLE_MAP(HAS_EMISSION_MAP, emissionMap, emissionArray, emissionLayer, TexCoord).rgb;
   } else {
     return emissionColor;
   }
@@ -106,52 +109,14 @@ vec3 getEmission(vec2 texCoord)
 
 float getAo(vec2 texCoord)
 {
-  if (bool(materialFlags & HAS_AO_MAP)) {
-    return texture2D(aoMap, TexCoord).r;
+  if (HAS_MAP(HAS_AO_MAP)) {
+    return SAMPLE_MAP(HAS_AO_MAP, aoMap, aoArray, aoLayer, TexCoord).r;
   } else {
     return 1.0; // No AO without AO map
   }
 }
 
 
-vec3 shade(Light light, 
-          vec3 diffuse, 
-          float roughness, 
-          float metalness, 
-          vec3 P, 
-          vec3 N, 
-          vec3 V)
-{
-  vec3 L = light.positionWorld - P; // direction to the light, not relevant for directional lights
-  float L_len = length(L); // distance to the light, not relevant for directional lights
-  L = L / L_len; // normalize it before using
-  float NdotL = max(dot(N, L), 0);
-
-  if (light.lightType == LIGHT_POINTLIGHT) {
-    vec3 H = normalize(L + V);
-    return diffuse 
-            * NdotL
-            * (1 / (L_len * L_len))
-            * light.color_Intensity.rgb
-            * light.color_Intensity.a;
-
-  } else if (light.lightType == LIGHT_SPOTLIGHT) {
-    vec3 H = normalize(L + V);
-    
-    return vec3(0.0);
-
-  } else if (light.lightType == LIGHT_DIRECTIONAL) {
-    vec3 H = normalize(-light.direction_Angle.xyz + V);
-
-    return vec3(0.0);
-
-  } else {
-    return vec3(0.0);
-  }
-}
-
-
-
 // Filmic Tonemapping Operators http://filmicworlds.com/blog/filmic-tonemapping-operators/
 vec3 filmic(vec3 x) {
   vec3 X = max(vec3(0.0), x - 0.004);
@@ -1,8 +1,10 @@
 #version 330 core
 
-layout (location = 0) in vec3 in_Position;
+// Float: xyz position, w defaults to 1. Packed: unorm16 position within the AABB, w bitangent sign as 0/1.
+layout (location = 0) in vec4 in_Position;
+// Float: xyz vectors, tangent w is the bitangent sign. Packed: octahedral xy, z is 0.
 layout (location = 1) in vec3 in_Normal;
-layout (location = 2) in vec3 in_Tangent;
+layout (location = 2) in vec4 in_Tangent;
 layout (location = 3) in vec2 in_TexCoord;
 
 out vec3 WorldSpacePosition;
@@ -12,26 +14,28 @@ out vec3 Tangent;
 out vec3 Bitangent;
 out vec2 TexCoord;
 
-uniform vec3 cameraWorldPosition;
-uniform vec3 cameraDirection;
-uniform mat3 modelToWorldSpace_Normal;
-uniform mat4 modelToClipSpace;
-uniform mat4 modelToWorldSpace;
-uniform float time;
+#include "FrameData.glsl"
+#include "ObjectData.glsl"
+#include "VertexDecode.glsl"
 
 void main()
 {
-    vec3 position = in_Position;// + vec3(0, sin(time + in_Position.x) * 0.25, 0);
+    // The position decode for packed vertices is folded into the model matrices
+    vec3 position = in_Position.xyz;// + vec3(0, sin(time + in_Position.x) * 0.25, 0);
     WorldSpacePosition = (modelToWorldSpace * vec4(position, 1.0)).xyz;
+
+    vec3 normal = decodeDirection(in_Normal);
+    vec3 tangent = decodeDirection(in_Tangent.xyz);
+    float bitangentSign = vertexFormat == VERTEX_FORMAT_PACKED ? in_Position.w * 2.0 - 1.0 : in_Tangent.w;
  
     //Normal = normalize((transpose(inverse(modelToWorldSpace)) * vec4(in_Normal, 0.0)).xyz);
-    Normal = modelToWorldSpace_Normal * in_Normal;
-    Tangent = in_Tangent;
-    Bitangent = cross(Normal, Tangent);
+    Normal = modelToWorldSpace_Normal * normal;
+    Tangent = modelToWorldSpace_Normal * tangent;
+    Bitangent = cross(Normal, Tangent) * bitangentSign;
 
     TexCoord = in_TexCoord;
 
-    EyeDirection = normalize(position - cameraWorldPosition);
+    EyeDirection = normalize(WorldSpacePosition - cameraWorldPosition);
     
     gl_Position = modelToClipSpace * vec4(position, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,17 @@
+// Attribute decoding for both vertex formats, see StaticMesh::VertexFormat. Needs ObjectData.glsl.
+// Positions need none, the decode for packed vertices is folded into the model matrices.
+
+vec3 octahedralDecode(vec2 e)
+{
+    vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (v.z < 0.0) {
+        v.xy = (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+    }
+    return normalize(v);
+}
+
+// Float: xyz vector. Packed: octahedral xy.
+vec3 decodeDirection(vec3 direction)
+{
+    return vertexFormat == VERTEX_FORMAT_PACKED ? octahedralDecode(direction.xy) : direction;
+}
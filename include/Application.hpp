@@ -12,6 +12,7 @@
 #include <string_view>
 #include <stdexcept>
 #include <memory>
+#include <unordered_map>
 
 #include "ResourceManager.hpp"
 #include "Scene.hpp"
@@ -38,6 +39,10 @@ namespace planets
 
         std::unique_ptr<ResourceManager> m_ResourceManager;
         std::string m_DataDirectory{"data"};
+        // Packed assets (see planets-pack), empty to read loose files only
+        std::string m_DataArchive;
+        // Program binaries (see ShaderProgram::setBinaryCacheDirectory), empty to always compile from source
+        std::string m_ShaderCacheDirectory;
 
         struct ApplicationWindowParams
         {
@@ -64,9 +69,40 @@ namespace planets
             }
         } m_ApplicationTimings;
 
+        struct RenderParams
+        {
+            StaticMesh::VertexFormat vertexFormat{StaticMesh::VertexFormat::Packed};
+            // Time per frame spent uploading asynchronously loaded resources
+            double uploadBudgetMs{4.0};
+            // Group same-sized material maps into texture arrays to save texture binds
+            bool textureArrays{true};
+            // Load models when their instances are first drawn instead of all at startup
+            bool lazyLoading{true};
+            // Compile the Standard shader once per combination of material maps instead of branching on them
+            bool shaderVariants{true};
+            // What stays in system memory after meshes are uploaded, per mesh name with a global default
+            StaticMesh::Residency meshResidency{StaticMesh::Residency::Keep};
+            std::unordered_map<std::string, StaticMesh::Residency> meshResidencyOverrides;
+
+            StaticMesh::Residency residencyFor(const std::string &meshName) const
+            {
+                auto it = meshResidencyOverrides.find(meshName);
+                return it != meshResidencyOverrides.end() ? it->second : meshResidency;
+            }
+        } m_RenderParams;
+
+        struct LoadingState
+        {
+            double startTime{0.0};
+            bool firstFrameDrawn{false};
+            bool finished{false};
+        } m_LoadingState;
+
         struct DebugParams
         {
             bool debugConsoleActive{false};
+            // Reload shaders, textures and meshes when their files in the data directory change
+            bool hotReload{false};
         } m_DebugParams;
 
         struct ControlParams
@@ -89,10 +125,13 @@ namespace planets
 
         void draw(double deltaTime);
 
+        void updateLoading();
+
         void initScene();
 
-        void drawDebugTree(std::shared_ptr<SpatialObject> node);
+        void drawDebugTree(const std::shared_ptr<SpatialObject> &node);
         void drawDebugConsole();
+        void drawLoadingScreen();
         void drawImGui();
 
         // Actual callbacks
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "MappedFile.hpp"
+#include "ThreadPool.hpp"
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+namespace planets
+{
+    /*
+    Packed asset archive written by planets-pack: a header, the file contents each starting
+    at an ENTRY_ALIGNMENT boundary, then the table of contents (path, offset, size, stored
+    size, compression). The archive is memory mapped once and uncompressed entries are used
+    in place. Compressed entries are split into BLOCK_SIZE blocks compressed independently
+    with LZ4, so they can be decompressed in parallel: a table with the stored size of every
+    block comes first, then the blocks. Blocks that did not get smaller are stored as they are.
+    */
+    class AssetArchive
+    {
+    public:
+        static constexpr uint32_t MAGIC = 0x4b415050; // "PPAK"
+        static constexpr uint32_t VERSION = 1;
+        static constexpr size_t ENTRY_ALIGNMENT = 64;
+        static constexpr size_t BLOCK_SIZE = 1 << 20;
+
+        enum class Compression : uint32_t
+        {
+            None,
+            Lz4
+        };
+
+        struct Entry
+        {
+            std::string path; // relative to the data directory, '/' separated
+            uint64_t offset{0};
+            uint64_t size{0};
+            uint64_t storedSize{0};
+            Compression compression{Compression::None};
+        };
+
+        // Input of write, compress is a request that is dropped if it does not save enough
+        struct SourceFile
+        {
+            std::string path;
+            std::string fullPath;
+            bool compress{true};
+        };
+
+        AssetArchive() = delete;
+        /*
+        Maps the archive and reads its table of contents, throws if it is unreadable
+        */
+        AssetArchive(const std::string &path);
+
+        const std::string &getPath() const { return m_Path; }
+        const std::vector<Entry> &getEntries() const { return m_Entries; }
+        /*
+        Returns nullptr if the archive has no such file
+        */
+        const Entry *find(const std::string &path) const;
+
+        /*
+        Stored bytes of an entry inside the mapping, the file itself if it is not compressed
+        */
+        const unsigned char *getStoredData(const Entry &entry) const { return m_File->data() + entry.offset; }
+        const std::shared_ptr<MappedFile> &getFile() const { return m_File; }
+
+        /*
+        Decompresses a compressed entry into entry.size bytes at decompressed, the blocks in
+        parallel if a thread pool is given. Returns false if the entry is corrupt.
+        */
+        bool decompress(const Entry &entry, unsigned char *decompressed, ThreadPool *threadPool) const;
+
+        /*
+        Packs the files in the given order. Compression is kept for files it makes at least
+        minSaving (a fraction of the size) smaller.
+        */
+        static bool write(const std::string &path, const std::vector<SourceFile> &files,
+                          ThreadPool &threadPool, double minSaving);
+
+    private:
+        std::string m_Path;
+        std::shared_ptr<MappedFile> m_File;
+        std::vector<Entry> m_Entries;
+        std::unordered_map<std::string, size_t> m_EntryIndices;
+    };
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <string>
+#include <map>
+#include <cstddef>
+
+namespace planets
+{
+    /*
+    Maps source asset paths (as passed to the ResourceManager, relative to the
+    data directory) to the cooked files that replace them. Stored as a text
+    file with one "<kind> <source path> <cooked path>" entry per line.
+    */
+    class AssetManifest
+    {
+    public:
+        static constexpr const char *DEFAULT_PATH = "cooked/manifest.txt";
+
+        enum class AssetKind
+        {
+            Mesh,
+            Texture
+        };
+
+        /*
+        Returns false if the manifest does not exist or cannot be read
+        */
+        bool load(const std::string &path);
+        /*
+        Reads a manifest that is already in memory, label names it in log messages
+        */
+        bool load(const char *data, size_t length, const std::string &label);
+        bool save(const std::string &path) const;
+
+        void add(AssetKind kind, const std::string &sourcePath, const std::string &cookedPath);
+
+        /*
+        Returns the cooked path of a source asset or an empty string
+        */
+        std::string find(AssetKind kind, const std::string &sourcePath) const;
+
+        size_t size() const { return m_Meshes.size() + m_Textures.size(); }
+
+    private:
+        // Ordered, so that saved manifests are stable
+        std::map<std::string, std::string> m_Meshes;
+        std::map<std::string, std::string> m_Textures;
+    };
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "Texture2D.hpp"
+#include "MappedFile.hpp"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+namespace planets
+{
+    /*
+    Runtime-ready texture produced by the asset cooker: a header followed by the
+    complete mip chain, each level 16-byte aligned. The file stays memory mapped
+    (or the memory it was read from stays alive) and the mip levels point directly into it.
+    */
+    class CookedTexture
+    {
+    public:
+        static constexpr uint32_t MAGIC = 0x58455450; // "PTEX"
+        static constexpr uint32_t VERSION = 1;
+
+        CookedTexture() = delete;
+        /*
+        Maps and validates a cooked texture, throws if it is unreadable
+        */
+        CookedTexture(const std::string &path);
+        /*
+        Uses a texture that is already in memory, owner keeps data alive
+        */
+        CookedTexture(const std::string &label, const unsigned char *data, size_t size, std::shared_ptr<const void> owner);
+
+        Texture2D::TextureDataFormat getFormat() const { return m_Format; }
+        const std::vector<Texture2D::MipLevel> &getMipLevels() const { return m_MipLevels; }
+
+        static bool write(const std::string &path,
+                          Texture2D::TextureDataFormat format,
+                          const std::vector<Texture2D::MipLevel> &mipLevels);
+
+    private:
+        std::shared_ptr<const void> m_Owner;
+        Texture2D::TextureDataFormat m_Format;
+        std::vector<Texture2D::MipLevel> m_MipLevels;
+
+        void parse(const std::string &label, const unsigned char *data, size_t size);
+    };
+}
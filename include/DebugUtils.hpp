@@ -7,11 +7,15 @@ namespace planets
         int lights{0};
         int staticMeshes{0};
         int drawCalls{0};
+        int triangles{0};
+        int textureBinds{0};
 
         void reset(){
             lights = 0;
             staticMeshes = 0;
             drawCalls = 0;
+            triangles = 0;
+            textureBinds = 0;
         }
     };   
 }
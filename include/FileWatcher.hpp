@@ -0,0 +1,53 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+
+namespace planets
+{
+    /*
+    Watches a directory tree with inotify on a background thread and reports files
+    that were written or moved into it. A file is only reported once it has not
+    changed for SETTLE_TIME, so editors writing in several steps cause one reload.
+    Does nothing on platforms without inotify.
+    */
+    class FileWatcher
+    {
+    public:
+        static constexpr std::chrono::milliseconds SETTLE_TIME{200};
+
+        FileWatcher(const std::string &rootDirectory);
+        ~FileWatcher();
+
+        FileWatcher(const FileWatcher &other) = delete;
+        FileWatcher &operator=(const FileWatcher &other) = delete;
+
+        bool isActive() const { return m_InotifyFd >= 0; }
+
+        /*
+        Returns the settled changed files as rootDirectory + '/' + path relative to it
+        */
+        std::vector<std::string> takeChangedFiles();
+
+    private:
+        std::string m_RootDirectory;
+        int m_InotifyFd{-1};
+        // Watch descriptor -> watched directory, only used by the watcher thread after construction
+        std::unordered_map<int, std::string> m_WatchedDirectories;
+
+        std::thread m_Thread;
+        std::atomic<bool> m_Stopping{false};
+
+        std::mutex m_Mutex;
+        // Changed file -> time of its last event
+        std::unordered_map<std::string, std::chrono::steady_clock::time_point> m_PendingChanges;
+
+        void watchRecursively(const std::string &directory);
+        void run();
+    };
+}
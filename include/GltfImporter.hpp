@@ -0,0 +1,117 @@
+#pragma once
+
+#include "MappedFile.hpp"
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace planets
+{
+    /*
+    Typed array inside the binary chunk of a GLB file. offset is relative to the start of
+    the binary chunk; count is 0 if the primitive does not have the attribute.
+    */
+    struct GltfAccessor
+    {
+        size_t offset{0};
+        size_t count{0};
+        size_t stride{0}; // bytes between elements, never 0
+        GLenum componentType{GL_FLOAT};
+        GLint components{0};
+        bool normalized{false};
+
+        size_t componentSize() const;
+        // Bytes from the first to the end of the last element
+        size_t byteLength() const { return count == 0 ? 0 : (count - 1) * stride + components * componentSize(); }
+    };
+
+    struct GltfPrimitive
+    {
+        std::string name; // "<mesh name>.<primitive index>"
+        int32_t materialIndex{-1};
+        GltfAccessor positions;
+        GltfAccessor normals;
+        GltfAccessor tangents;
+        GltfAccessor uvs;
+        GltfAccessor indices;
+    };
+
+    /*
+    Either a file relative to the GLB (uri) or a range of the binary chunk
+    */
+    struct GltfImage
+    {
+        std::string uri;
+        size_t offset{0};
+        size_t size{0};
+    };
+
+    /*
+    PBR metallic-roughness material, image indices are -1 if the texture is not used
+    */
+    struct GltfMaterial
+    {
+        std::string name;
+        glm::vec4 baseColorFactor{1.0f};
+        float metallicFactor{1.0f};
+        float roughnessFactor{1.0f};
+        glm::vec3 emissiveFactor{0.0f};
+        int32_t baseColorImage{-1};
+        int32_t metallicRoughnessImage{-1}; // roughness in G, metalness in B
+        int32_t normalImage{-1};
+        int32_t occlusionImage{-1}; // occlusion in R
+        int32_t emissiveImage{-1};
+    };
+
+    /*
+    Parsed GLB file. The accessors point into the file's memory (a mapping, an archive entry
+    or a decompressed copy), which owner keeps alive as long as the model (or a copy of the
+    pointer) lives, so their data can be uploaded without copying it first.
+    */
+    struct GltfModel
+    {
+        std::shared_ptr<const void> owner;
+        const unsigned char *binary{nullptr};
+        size_t binarySize{0};
+
+        std::vector<GltfImage> images;
+        std::vector<GltfMaterial> materials;
+        std::vector<GltfPrimitive> primitives;
+    };
+
+    /*
+    Reads binary glTF 2.0 files. Only triangle primitives without sparse accessors or morph
+    targets are supported. Node transforms are not applied, every mesh is imported once
+    in its own space.
+    */
+    class GltfImporter
+    {
+    public:
+        static constexpr uint32_t GLB_MAGIC = 0x46546c67; // "glTF"
+        static constexpr uint32_t GLB_VERSION = 2;
+
+        /*
+        Throws std::runtime_error if the file is not a valid GLB or uses unsupported features
+        */
+        static GltfModel importGlb(const std::string &fullPath);
+        /*
+        Imports a GLB that is already in memory, owner keeps data alive and label names it in messages
+        */
+        static GltfModel importGlb(const std::string &label, const unsigned char *data, size_t size,
+                                   std::shared_ptr<const void> owner);
+
+        /*
+        Converts the elements of an accessor to floats (normalized integers to [0, 1] or [-1, 1]),
+        components missing in the accessor are 0. For attributes that cannot be used as they are.
+        */
+        static std::vector<glm::vec4> readFloats(const GltfModel &model, const GltfAccessor &accessor);
+        static std::vector<GLuint> readIndices(const GltfModel &model, const GltfAccessor &accessor);
+    };
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace planets
+{
+    constexpr uint64_t FNV1A_64_OFFSET_BASIS = 14695981039346656037ull;
+    constexpr uint64_t FNV1A_64_PRIME = 1099511628211ull;
+
+    /*
+    64-bit FNV-1a. Pass the previous result as seed to hash data in pieces.
+    */
+    inline uint64_t hashBytes(const void *data, size_t size, uint64_t seed = FNV1A_64_OFFSET_BASIS) noexcept
+    {
+        const unsigned char *bytes = static_cast<const unsigned char *>(data);
+        uint64_t hash = seed;
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= bytes[i];
+            hash *= FNV1A_64_PRIME;
+        }
+        return hash;
+    }
+}
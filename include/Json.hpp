@@ -0,0 +1,72 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace planets
+{
+    /*
+    Minimal JSON document, enough for reading asset descriptions such as glTF.
+    Lookups of missing members or out of range elements return a null value,
+    so optional properties can be read without checking for them first.
+    */
+    class JsonValue
+    {
+    public:
+        enum class Type
+        {
+            Null,
+            Bool,
+            Number,
+            String,
+            Array,
+            Object
+        };
+
+        JsonValue() = default;
+
+        /*
+        Throws std::runtime_error with the offset of the first syntax error
+        */
+        static JsonValue parse(const char *text, size_t length);
+
+        Type getType() const { return m_Type; }
+        bool isNull() const { return m_Type == Type::Null; }
+        bool isNumber() const { return m_Type == Type::Number; }
+        bool isString() const { return m_Type == Type::String; }
+        bool isArray() const { return m_Type == Type::Array; }
+        bool isObject() const { return m_Type == Type::Object; }
+
+        /*
+        Return defaultValue if the value has another type
+        */
+        bool asBool(bool defaultValue = false) const;
+        double asNumber(double defaultValue = 0.0) const;
+        int64_t asInt(int64_t defaultValue = 0) const;
+        const std::string &asString() const;
+
+        /*
+        Number of array elements or object members, 0 for other types
+        */
+        size_t size() const { return m_Values.size(); }
+        const JsonValue &operator[](size_t index) const;
+        const JsonValue &operator[](const std::string &key) const;
+        bool has(const std::string &key) const;
+
+        const std::vector<JsonValue> &getElements() const { return m_Values; }
+        // Member names of an object, in the order of getElements
+        const std::vector<std::string> &getKeys() const { return m_Keys; }
+
+    private:
+        Type m_Type{Type::Null};
+        bool m_Bool{false};
+        double m_Number{0.0};
+        std::string m_String;
+        std::vector<std::string> m_Keys;
+        std::vector<JsonValue> m_Values;
+
+        friend class JsonParser;
+    };
+}
@@ -9,6 +9,9 @@ namespace planets
     class LightSource : public SpatialObject
     {
     public:
+        // Size of the light array in the shaders, handed to them as MAX_LIGHTS
+        static constexpr int MAX_LIGHTS = 128;
+
         struct LightMaterialInput
         {
             glm::vec3 worldPosition;
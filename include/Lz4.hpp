@@ -0,0 +1,27 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+namespace planets
+{
+    /*
+    LZ4 block format (no frame), compatible with the reference implementation's
+    LZ4_compress_default / LZ4_decompress_safe. The compressor is a simple greedy
+    one: it trades some ratio for a few dozen lines, decompression speed is the same.
+    */
+    class Lz4
+    {
+    public:
+        /*
+        Largest possible compressed size of size bytes of input
+        */
+        static size_t compressBound(size_t size) { return size + size / 255 + 16; }
+
+        static std::vector<unsigned char> compress(const unsigned char *data, size_t size);
+        /*
+        Returns false if the input is malformed or does not decompress to exactly decompressedSize bytes
+        */
+        static bool decompress(const unsigned char *data, size_t size, unsigned char *decompressed, size_t decompressedSize);
+    };
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+namespace planets
+{
+    /*
+    Read-only memory mapping of a whole file. The mapping lives as long as the object.
+    */
+    class MappedFile
+    {
+    public:
+        MappedFile() = delete;
+        MappedFile(const std::string &path);
+        ~MappedFile();
+
+        MappedFile(const MappedFile &other) = delete;
+        MappedFile &operator=(const MappedFile &other) = delete;
+
+        const unsigned char *data() const noexcept { return m_Data; }
+        size_t size() const noexcept { return m_Size; }
+
+    private:
+        const unsigned char *m_Data;
+        size_t m_Size;
+    };
+}
@@ -6,29 +6,44 @@
 #include <glm/glm.hpp>
 
 #include "ShaderProgram.hpp"
+#include "ShaderVariants.hpp"
 #include "Texture2D.hpp"
+#include "ResourceHandle.hpp"
+#include "UniformBuffer.hpp"
+#include "DebugUtils.hpp"
 
 #include <memory>
+#include <cstdint>
 
 namespace planets
 {
+    class ResourceManager;
+
     struct DrawInput
     {
         const glm::mat4 &viewProjection;
         const glm::vec3 &cameraPosition;
         const glm::vec3 &cameraDirection;
         const GLfloat time;
+        const GLfloat lodScale; // pixels per world unit at distance 1 (0.5 * viewport height * projection[1][1])
+        const GLfloat lodBias;  // log2 of the tolerated LOD error in pixels
+        UniformRingBuffer &objectUniforms;
+        // Resolves the resource handles of the drawn objects
+        const ResourceManager &resources;
     };
 
+    /*
+    Per-object data of a draw. Per-frame data (camera, time) is in the FrameData block that
+    Scene::draw fills.
+    */
     struct MaterialInput
     {
-        const glm::mat4 &viewProjection;
         const glm::mat4 &modelToClipSpace;
         const glm::mat4 &modelToWorldSpace;
         const glm::mat3 &modelToWorldSpace_Normal;
-        const glm::vec3 &cameraPosition;
-        const glm::vec3 &cameraDirection;
-        const GLfloat time;
+        const GLint vertexFormat; // StaticMesh::VertexFormat, tells the vertex shader how to decode attributes
+        UniformRingBuffer &objectUniforms;
+        DrawStats &drawStats;
     };
 
     class Material
@@ -40,8 +55,42 @@ namespace planets
         virtual void use(const MaterialInput &materialInput) const;
         virtual void disable() const;
 
+        /*
+        Materials only reference their program and textures, those are accounted for separately
+        */
+        virtual size_t getCpuSizeInBytes() const { return sizeof(Material); }
+
+        /*
+        Forgets which program, textures and material block the materials left bound. Must be
+        called before drawing a frame, since anything else binding them (e.g. uploads or the UI)
+        leaves the tracked state stale.
+        */
+        static void resetBindings();
+
+        /*
+        Drawn with instead of programs that are still compiling (see ShaderProgram::poll). It
+        only needs the FrameData and ObjectData blocks. Without one, draws wait for the program.
+        */
+        static void setFallbackProgram(std::shared_ptr<ShaderProgram> fallbackProgram);
+
     protected:
-        std::shared_ptr<ShaderProgram> m_ShaderProgram;
+        // Mutable since StandardMaterial switches variants when its maps turn out to be array layers
+        mutable std::shared_ptr<ShaderProgram> m_ShaderProgram;
+
+        /*
+        Sets up the uniforms outside the blocks. Called by use whenever the program has been
+        relinked or replaced since, with the program in use. Overrides must call the base version.
+        */
+        virtual void resolveUniforms() const {}
+
+        /*
+        Binds the texture unless it is still bound to the unit, counts the binds it does
+        */
+        static void bindTexture(GLint unit, GLenum target, GLuint textureId, DrawStats &drawStats);
+
+    private:
+        // Link id of the program the handles were resolved for, 0 before the first use
+        mutable uint32_t m_ResolvedLinkId{0};
     };
 
     class StandardMaterial : public Material
@@ -56,13 +105,42 @@ namespace planets
             HAS_EMISSION_MAP = 1 << 4,
             HAS_AO_MAP = 1 << 5
         };
+        /*
+        Variant masks are the flags with the flags of the maps that are texture array layers
+        shifted above them, so variants sample each map from the right kind of texture
+        */
+        static constexpr int ARRAY_MAP_SHIFT = 6;
 
         StandardMaterial(std::shared_ptr<ShaderProgram> shaderProgram,
                          GLint flags);
+        /*
+        Draws with the variant compiled for the flags (see ShaderVariants), picked again
+        whenever a map is set or the flags change
+        */
+        StandardMaterial(std::shared_ptr<ShaderVariants> variants,
+                         GLint flags);
         virtual ~StandardMaterial() override;
 
+        // The material block buffer belongs to one material, see updateFrom
+        StandardMaterial(const StandardMaterial &other) = delete;
+        StandardMaterial &operator=(const StandardMaterial &other) = delete;
+
+        /*
+        Takes over the flags, parameters and maps of other, e.g. from a hot reload of its MTL.
+        The material keeps its program or follows its variants to the new flags, its block
+        buffer is uploaded again on the next use.
+        */
+        void updateFrom(const StandardMaterial &other);
+
+        /*
+        The parameters and array layers go into the material's own MaterialData block, which is
+        only uploaded again when they change. Maps that are layers of a texture array are sampled from the array, so materials whose
+        maps share arrays need no texture binds between them. Maps that are not loaded yet are
+        sampled from their placeholder, the first use requests their load.
+        */
         virtual void use(const MaterialInput &materialInput) const override;
         virtual void disable() const override;
+        virtual size_t getCpuSizeInBytes() const override { return sizeof(StandardMaterial); }
 
         GLint getFlags() const
         {
@@ -72,42 +150,49 @@ namespace planets
         void setFlags(GLint flags)
         {
             m_Flags = flags;
+            selectVariant();
         }
 
-        void setDiffuseMap(std::shared_ptr<Texture2D> diffuseMap)
+        void setDiffuseMap(ResourceHandle<Texture2D> diffuseMap)
         {
             m_Flags |= HAS_DIFFUSE_MAP;
             m_DiffuseMap = diffuseMap;
+            selectVariant();
         }
 
-        void setRoughnessMap(std::shared_ptr<Texture2D> roughnessMap)
+        void setRoughnessMap(ResourceHandle<Texture2D> roughnessMap)
         {
             m_Flags |= HAS_ROUGHNESS_MAP;
             m_RoughnessMap = roughnessMap;
+            selectVariant();
         }
 
-        void setNormalMap(std::shared_ptr<Texture2D> normalMap)
+        void setNormalMap(ResourceHandle<Texture2D> normalMap)
         {
             m_Flags |= HAS_NORMAL_MAP;
             m_NormalMap = normalMap;
+            selectVariant();
         }
 
-        void setMetalnessMap(std::shared_ptr<Texture2D> metalnessMap)
+        void setMetalnessMap(ResourceHandle<Texture2D> metalnessMap)
         {
             m_Flags |= HAS_METALNESS_MAP;
             m_MetalnessMap = metalnessMap;
+            selectVariant();
         }
 
-        void setEmissionMap(std::shared_ptr<Texture2D> emissionMap)
+        void setEmissionMap(ResourceHandle<Texture2D> emissionMap)
         {
             m_Flags |= HAS_EMISSION_MAP;
             m_EmissionMap = emissionMap;
+            selectVariant();
         }
 
-        void setAoMap(std::shared_ptr<Texture2D> aoMap)
+        void setAoMap(ResourceHandle<Texture2D> aoMap)
         {
             m_Flags |= HAS_AO_MAP;
             m_AoMap = aoMap;
+            selectVariant();
         }
 
         void setDiffuseColor(const glm::vec3 &diffuseColor)
@@ -130,23 +215,47 @@ namespace planets
             m_EmissionColor = emissionColor;
         }
         
+        /*
+        The material keeps this program, it no longer follows its flags to a variant
+        */
         void replaceProgram(std::shared_ptr<ShaderProgram> newProgram)
         {
             m_ShaderProgram = newProgram;
+            m_Variants.reset();
         }
+
+    protected:
+        virtual void resolveUniforms() const override;
+
     private:
+        static constexpr size_t MAP_COUNT = 6;
+
+        // Created on first use
+        mutable std::shared_ptr<UniformBuffer> m_MaterialBuffer;
+        mutable MaterialBlock m_UploadedBlock{};
+        // Forces the next use to upload the block even if it compares equal
+        mutable bool m_BlockDirty{false};
+
         GLint m_Flags{0};
+        // Empty if the material draws with a fixed program
+        std::shared_ptr<ShaderVariants> m_Variants;
+        // Flags of the maps that were texture array layers at the last use
+        mutable GLint m_ArrayMaps{0};
+        // Flags of the maps that had no texture at the last use, they draw as if unset
+        mutable GLint m_MissingMaps{0};
 
         glm::vec3 m_DiffuseColor{1.f, 1.f, 1.f};
         GLfloat m_Roughness{0.5};
         GLfloat m_Metalness{0};
         glm::vec3 m_EmissionColor{0.f, 0.f, 0.f};
 
-        std::shared_ptr<Texture2D> m_DiffuseMap;
-        std::shared_ptr<Texture2D> m_RoughnessMap;
-        std::shared_ptr<Texture2D> m_NormalMap;
-        std::shared_ptr<Texture2D> m_MetalnessMap;
-        std::shared_ptr<Texture2D> m_EmissionMap;
-        std::shared_ptr<Texture2D> m_AoMap;
+        ResourceHandle<Texture2D> m_DiffuseMap;
+        ResourceHandle<Texture2D> m_RoughnessMap;
+        ResourceHandle<Texture2D> m_NormalMap;
+        ResourceHandle<Texture2D> m_MetalnessMap;
+        ResourceHandle<Texture2D> m_EmissionMap;
+        ResourceHandle<Texture2D> m_AoMap;
+
+        void selectVariant() const;
     };
 }
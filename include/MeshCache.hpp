@@ -0,0 +1,84 @@
+#pragma once
+
+#include "StaticMesh.hpp"
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace planets
+{
+    /*
+    CPU-side result of importing a model file: material descriptions and
+    ready-to-upload submeshes (interleaved vertices with tangents + indices)
+    */
+    struct ImportedMaterial
+    {
+        std::string name;
+        glm::vec3 diffuseColor{0.f};
+        std::string diffuseMap;
+        std::string normalMap;
+        std::string roughnessMap;
+        std::string metalnessMap;
+    };
+
+    struct ImportedSubmesh
+    {
+        std::string name;
+        int32_t materialIndex{-1};
+        std::vector<StaticMesh::Vertex> vertices;
+        std::vector<GLuint> triangleIndices; // all LODs concatenated
+        std::vector<StaticMesh::Lod> lods;
+    };
+
+    struct ImportedMesh
+    {
+        // Files the import was produced from, used to validate the cache. Relative to the
+        // data directory in cooked meshes.
+        std::vector<std::string> sourcePaths;
+        std::vector<ImportedMaterial> materials;
+        std::vector<ImportedSubmesh> submeshes;
+    };
+
+    /*
+    Versioned binary cache of an ImportedMesh, stored next to the source model.
+    Layout: header, source table (path, size, mtime, hash), material table, then
+    per submesh its name, material index, LOD table and 16-byte aligned vertex and index arrays.
+    */
+    class MeshCache
+    {
+    public:
+        static constexpr uint32_t MAGIC = 0x48534d50; // "PMSH"
+        static constexpr uint32_t VERSION = 5;
+
+        static std::string cachePathFor(const std::string &sourcePath) { return sourcePath + ".meshcache"; }
+
+        /*
+        Returns false if the cache does not exist, is corrupt, has another version or is stale.
+        Cooked meshes keep their source paths relative to the data directory, which is passed
+        as sourceDirectory. Their sources are only checked if they exist, cooked data may ship
+        without them.
+        */
+        static bool read(const std::string &cachePath, ImportedMesh &mesh, const std::string &sourceDirectory = std::string());
+        /*
+        Reads a cache that is already in memory, label names it in log messages. Archived
+        caches skip the source check, the archive is packed from matching files.
+        */
+        static bool read(const unsigned char *data, size_t size, const std::string &label, ImportedMesh &mesh,
+                         bool validateSources, const std::string &sourceDirectory = std::string());
+        /*
+        Reads one submesh without checking whether the sources changed, used to re-stream
+        mesh data that was dropped from system memory after the upload
+        */
+        static bool readSubmesh(const std::string &cachePath, size_t submeshIndex, ImportedSubmesh &submesh);
+        static bool readSubmesh(const unsigned char *data, size_t size, const std::string &label,
+                                size_t submeshIndex, ImportedSubmesh &submesh);
+        /*
+        The sources are stamped with their size, modification time and hash, the source paths
+        are relative to sourceDirectory if it is given
+        */
+        static bool write(const std::string &cachePath, const ImportedMesh &mesh, const std::string &sourceDirectory = std::string());
+    };
+}
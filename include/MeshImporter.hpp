@@ -0,0 +1,25 @@
+#pragma once
+
+#include "MeshCache.hpp"
+#include "ThreadPool.hpp"
+#include "VirtualFileSystem.hpp"
+
+#include <string>
+
+namespace planets
+{
+    /*
+    Turns model files into ImportedMeshes: welds the per-corner vertices into
+    shared ones and computes tangents (in parallel, see TangentGenerator). Does not touch OpenGL, so it is used
+    both by the ResourceManager and by the offline asset cooker.
+    */
+    class MeshImporter
+    {
+    public:
+        static ImportedMesh importObj(const std::string &fullPath, ThreadPool &threadPool);
+        /*
+        Reads the OBJ and its material libraries through the VFS, path is relative to its root
+        */
+        static ImportedMesh importObj(const VirtualFileSystem &vfs, const std::string &path, ThreadPool &threadPool);
+    };
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "StaticMesh.hpp"
+
+#include <glad/glad.h>
+
+#include <vector>
+#include <cstddef>
+
+namespace planets
+{
+    /*
+    Reorders the triangles and vertices of indexed meshes for the GPU: triangles for
+    the post-transform vertex cache (Forsyth's linear-speed algorithm), then clusters
+    of them so outward facing parts are drawn first and occlude the rest (Sander et
+    al., "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw"), and
+    finally vertices in the order the index buffer first references them.
+    */
+    class MeshOptimizer
+    {
+    public:
+        struct VertexCacheStatistics
+        {
+            float acmr{0.0f}; // average cache miss ratio, transformed vertices per triangle (0.5 - 3)
+            float atvr{0.0f}; // average transformed vertex ratio, transformed per referenced vertex (>= 1)
+        };
+
+        struct Statistics
+        {
+            VertexCacheStatistics before;
+            VertexCacheStatistics after;
+        };
+
+        static constexpr size_t FIFO_CACHE_SIZE = 16;
+        // Clusters are only reordered while the ACMR stays within this factor of the cache optimized one
+        static constexpr float OVERDRAW_THRESHOLD = 1.05f;
+
+        /*
+        Simulates a FIFO post-transform cache, the model closest to how current GPUs reuse vertices
+        */
+        static VertexCacheStatistics analyzeVertexCache(const std::vector<GLuint> &triangleIndices,
+                                                        size_t vertexCount,
+                                                        size_t cacheSize = FIFO_CACHE_SIZE);
+
+        static std::vector<GLuint> optimizeVertexCache(const std::vector<GLuint> &triangleIndices, size_t vertexCount);
+        /*
+        Expects vertex cache optimized indices and keeps runs of cache-friendly triangles together
+        */
+        static std::vector<GLuint> optimizeOverdraw(const std::vector<GLuint> &triangleIndices,
+                                                    const std::vector<StaticMesh::Vertex> &vertices,
+                                                    float threshold = OVERDRAW_THRESHOLD);
+        /*
+        Renumbers vertices in first-use order and drops unreferenced ones, updating the indices
+        */
+        static void optimizeVertexFetch(std::vector<StaticMesh::Vertex> &vertices, std::vector<GLuint> &triangleIndices);
+
+        /*
+        Runs all three passes in place and returns the vertex cache statistics before and after
+        */
+        static Statistics optimize(std::vector<StaticMesh::Vertex> &vertices, std::vector<GLuint> &triangleIndices);
+    };
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "StaticMesh.hpp"
+
+#include <glad/glad.h>
+
+#include <vector>
+#include <cstddef>
+
+namespace planets
+{
+    /*
+    Quadric error edge collapse (Garland and Heckbert) that only moves vertices onto
+    existing ones, so every LOD is an index buffer over the same vertices. Vertices
+    on open borders and on attribute seams (several vertices at one position) stay
+    where they are to avoid holes and texture cracks.
+    */
+    class MeshSimplifier
+    {
+    public:
+        static constexpr size_t MAX_LODS = 6;
+        // A LOD is only kept if it removes at least this fraction of its parent's triangles
+        static constexpr float MIN_LOD_REDUCTION = 0.2f;
+        static constexpr size_t MIN_LOD_TRIANGLES = 32;
+        // Collapses moving the surface by more than this fraction of the bounding radius are not made
+        static constexpr float MAX_LOD_ERROR = 0.1f;
+
+        /*
+        Collapses edges in order of increasing error until at most targetIndexCount indices are
+        left or the next collapse would exceed maxError (model space distance). resultError is
+        set to the largest error of all collapses that were made.
+        */
+        static std::vector<GLuint> simplify(const std::vector<StaticMesh::Vertex> &vertices,
+                                            const std::vector<GLuint> &triangleIndices,
+                                            size_t targetIndexCount,
+                                            float maxError,
+                                            float &resultError);
+
+        /*
+        Builds a LOD chain by halving the triangle count of the previous level. triangleIndices
+        holds LOD 0 on input and all levels concatenated on output, each level vertex cache
+        optimized. The errors are conservative upper bounds relative to LOD 0.
+        */
+        static std::vector<StaticMesh::Lod> generateLods(const std::vector<StaticMesh::Vertex> &vertices,
+                                                         std::vector<GLuint> &triangleIndices);
+    };
+}
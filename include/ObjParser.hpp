@@ -0,0 +1,61 @@
+#pragma once
+
+#include "MeshCache.hpp"
+#include "ThreadPool.hpp"
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace planets
+{
+    /*
+    Zero-based attribute indices of a single face corner, -1 if the attribute is missing
+    */
+    struct ObjIndex
+    {
+        int32_t position;
+        int32_t normal;
+        int32_t texcoord;
+    };
+
+    /*
+    Range of triangle corners belonging to one object/group with a single material
+    */
+    struct ObjShape
+    {
+        std::string name;
+        std::string materialName;
+        size_t indexBegin{0};
+        size_t indexCount{0};
+    };
+
+    struct ObjData
+    {
+        std::vector<glm::vec3> positions;
+        std::vector<glm::vec3> normals;
+        std::vector<glm::vec2> texcoords;
+        // Triangulated face corners, three per triangle
+        std::vector<ObjIndex> indices;
+        std::vector<ObjShape> shapes;
+        std::vector<std::string> materialLibraries;
+    };
+
+    /*
+    Wavefront OBJ/MTL parser. OBJ files are memory mapped, split into chunks at
+    line boundaries and the chunks are parsed in parallel, then merged using
+    prefix sums over the per-chunk attribute and face counts.
+    */
+    class ObjParser
+    {
+    public:
+        static ObjData parseObj(const std::string &path, ThreadPool &threadPool);
+        static ObjData parseObj(const char *data, size_t size, ThreadPool &threadPool);
+
+        static std::vector<ImportedMaterial> parseMtl(const std::string &path);
+        static std::vector<ImportedMaterial> parseMtl(const char *data, size_t size);
+    };
+}
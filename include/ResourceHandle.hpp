@@ -0,0 +1,58 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <functional>
+#include <utility>
+
+namespace planets
+{
+    /*
+    Reference to a resource that may not have been loaded yet. Until it is, get() returns the
+    placeholder (which may be nullptr), and the first get() asks the ResourceManager to load it.
+    Copies share their state, so every holder sees the resource once it arrives. Handles must
+    only be resolved on the thread owning the GL context.
+    */
+    template <typename T>
+    class ResourceHandle
+    {
+    public:
+        ResourceHandle() = default;
+        // Refers to a resource that is already loaded
+        ResourceHandle(std::shared_ptr<T> resource) : m_State(std::make_shared<State>())
+        {
+            m_State->resource = std::move(resource);
+        }
+
+        bool isValid() const { return m_State != nullptr; }
+        bool isLoaded() const { return m_State && m_State->resource; }
+
+        T *get() const
+        {
+            if (!m_State)
+            {
+                return nullptr;
+            }
+            if (!m_State->resource && m_State->requestLoad)
+            {
+                // Cleared first, so that a failed load is not retried every frame
+                std::function<void()> requestLoad = std::move(m_State->requestLoad);
+                m_State->requestLoad = nullptr;
+                requestLoad();
+            }
+            return m_State->resource ? m_State->resource.get() : m_State->placeholder.get();
+        }
+        T *operator->() const { return get(); }
+
+    private:
+        struct State
+        {
+            std::shared_ptr<T> resource;
+            std::shared_ptr<T> placeholder;
+            std::function<void()> requestLoad;
+        };
+        std::shared_ptr<State> m_State;
+
+        friend class ResourceManager;
+    };
+}
@@ -1,13 +1,32 @@
 #pragma once
 
 #include "ShaderProgram.hpp"
+#include "ShaderVariants.hpp"
+#include "ShaderPreprocessor.hpp"
 #include "StaticMesh.hpp"
 #include "Material.hpp"
 #include "Texture2D.hpp"
+#include "MeshCache.hpp"
+#include "ThreadPool.hpp"
+#include "AssetManifest.hpp"
+#include "CookedTexture.hpp"
+#include "FileWatcher.hpp"
+#include "GltfImporter.hpp"
+#include "VirtualFileSystem.hpp"
+#include "ResourceHandle.hpp"
+#include "StaticModel.hpp"
+#include "ResourceTable.hpp"
 
 #include <unordered_map>
+#include <unordered_set>
 #include <memory>
 #include <string>
+#include <vector>
+#include <utility>
+#include <deque>
+#include <mutex>
+#include <future>
+#include <functional>
 
 namespace planets
 {
@@ -15,43 +34,392 @@ namespace planets
     class ResourceManager
     {
     public:
-        ResourceManager(const std::string &dataDirectory);
+        using LoadedStaticMeshes = std::vector<std::pair<StaticMeshHandle, MaterialHandle>>;
+
+        struct LoadingProgress
+        {
+            size_t requested{0};
+            size_t completed{0};
+            // Name of the asset being uploaded and how many of its uploads are done
+            std::string uploading;
+            size_t uploadsDone{0};
+            size_t uploadsTotal{0};
+            // Shader programs and variants the driver is still compiling
+            size_t compilingShaders{0};
+
+            bool isLoading() const { return completed < requested || compilingShaders > 0; }
+        };
+
+        struct MemoryUsage
+        {
+            size_t count{0};
+            size_t cpuBytes{0};
+            size_t gpuBytes{0};
+
+            MemoryUsage &operator+=(const MemoryUsage &other)
+            {
+                count += other.count;
+                cpuBytes += other.cpuBytes;
+                gpuBytes += other.gpuBytes;
+                return *this;
+            }
+        };
+
+        struct MemoryReport
+        {
+            MemoryUsage shaderPrograms;
+            MemoryUsage materials;
+            MemoryUsage textures2D;
+            MemoryUsage staticMeshes;
+
+            MemoryUsage total() const
+            {
+                MemoryUsage sum;
+                sum += shaderPrograms;
+                sum += materials;
+                sum += textures2D;
+                sum += staticMeshes;
+                return sum;
+            }
+        };
+
+        /*
+        Assets are read from the archive if one is given and can be mounted, files missing in
+        it and all files without an archive come from the data directory
+        */
+        ResourceManager(const std::string &dataDirectory, const std::string &archivePath = "");
         ~ResourceManager();
 
+        /*
+        Deferred programs are returned while the driver compiles them, processUploads polls
+        them. Until they are ready their materials draw with the Fallback program.
+        */
         std::shared_ptr<ShaderProgram> loadShaderProgram(const std::string &name,
                                                          const std::string &vertexShaderSourcePath,
-                                                         const std::string &fragmentShaderSourcePath);
+                                                         const std::string &fragmentShaderSourcePath,
+                                                         ShaderProgram::CompileMode mode = ShaderProgram::CompileMode::Blocking);
         std::shared_ptr<ShaderProgram> getShaderProgram(const std::string &name) const;
+        /*
+        Hash of both preprocessed stages of the program, changes whenever the program or any
+        file it includes changes
+        */
+        uint64_t getShaderProgramHash(const std::string &name) const;
 
         std::shared_ptr<Material> createMaterial(const std::string &name,
                                                  std::shared_ptr<ShaderProgram> shaderProgram);
         std::shared_ptr<Material> createStandardMaterial(const std::string &name,
                                                          GLint flags);
         std::shared_ptr<Material> getMaterial(const std::string &name);
+        /*
+        Whether Standard materials draw with a variant of the Standard program compiled for
+        their combination of maps (on by default) or all share the program that checks the
+        flags at runtime. Only affects materials created afterwards.
+        */
+        void setShaderVariantsEnabled(bool enabled) { m_ShaderVariantsEnabled = enabled; }
 
         std::shared_ptr<Texture2D> loadTexture2DFromPNG(const std::string &name,
                                                         const std::string &path);
+        /*
+        Decodes all (name, path) pairs in parallel, then uploads them on the calling thread.
+        Textures that fail to load map to the NOTEXTURE fallback.
+        */
+        std::unordered_map<std::string, std::shared_ptr<Texture2D>>
+        loadTextures2D(const std::vector<std::pair<std::string, std::string>> &namesAndPaths);
         std::shared_ptr<Texture2D> getTexture2D(const std::string &name);
+        /*
+        Returns right away with a handle that resolves to NOTEXTURE until the texture is loaded.
+        Nothing is read before the handle is first resolved, then the texture is decoded on a
+        worker thread and uploaded by processUploads. Textures that are already loaded give a
+        loaded handle, requesting the same name again gives the same handle.
+        */
+        ResourceHandle<Texture2D> requestTexture2D(const std::string &name, const std::string &path);
+        /*
+        Whether the textures of each loaded model get grouped into texture arrays by size and
+        format (on by default). Only affects models loaded afterwards.
+        */
+        void setTextureArraysEnabled(bool enabled) { m_TextureArraysEnabled = enabled; }
+        /*
+        Logs the VRAM taken by all 2D textures and how much block compression saved
+        */
+        void logTextureMemoryUsage() const;
+        /*
+        Sums the CPU and estimated GPU memory of all loaded resources per type
+        */
+        MemoryReport getMemoryReport() const;
+        /*
+        Writes the per-type totals and every resource with its sizes as JSON
+        */
+        bool writeMemoryReport(const std::string &path) const;
 
         /*
-        Returns a vector of meshes and their corresponding materials
+        Returns a vector of meshes and their corresponding materials.
+        A cooked version listed in the asset manifest is preferred, otherwise the imported
+        data is cached in a binary file next to the OBJ and reused on later runs.
+        Meshes with a residency other than Keep re-stream their data from that file.
         */
-        std::vector<std::pair<std::shared_ptr<StaticMesh>,
-                              std::shared_ptr<Material>>>
-        loadStaticMesh(const std::string &name,
-                       const std::string &objPath);
+        LoadedStaticMeshes loadStaticMesh(const std::string &name,
+                                          const std::string &objPath,
+                                          StaticMesh::Residency residency = StaticMesh::Residency::Keep);
+        /*
+        Imports the mesh and decodes its textures on worker threads and returns immediately.
+        The GL uploads happen in processUploads, which calls onLoaded on the calling thread
+        once the meshes are on the GPU. Failed loads are logged and onLoaded is not called.
+        */
+        void loadStaticMeshAsync(const std::string &name,
+                                 const std::string &objPath,
+                                 StaticMesh::VertexFormat vertexFormat,
+                                 StaticMesh::Residency residency,
+                                 std::function<void(LoadedStaticMeshes &)> onLoaded);
+        /*
+        Uploads resources of finished asynchronous loads until budgetMs is used up, at least one
+        texture or mesh per call, and finishes the shader programs the driver is done compiling.
+        Must be called from the thread owning the GL context.
+        */
+        void processUploads(double budgetMs);
+        LoadingProgress getLoadingProgress() const;
+
+        /*
+        Loads a binary glTF 2.0 model. Primitives with float positions, normals and tangents are
+        drawn straight from the binary chunk of the mapped file, one GL buffer per primitive and
+        no intermediate copies. Other primitives are converted and get tangents like OBJ meshes.
+        Metallic-roughness materials map onto StandardMaterial. The meshes are uploaded before
+        this returns, vertexFormat only applies to the converted ones.
+        */
+        LoadedStaticMeshes loadGltfModel(const std::string &name,
+                                         const std::string &glbPath,
+                                         StaticMesh::VertexFormat vertexFormat);
+
+        /*
+        Returns right away with a handle that resolves to nullptr until the model is loaded.
+        The load (see loadStaticMeshAsync) only starts when the handle is first resolved,
+        usually by drawing a StaticMeshInstance of it, so models that are never drawn cost
+        nothing. Requesting the same name again gives the same handle.
+        */
+        ResourceHandle<StaticModel> requestStaticModel(const std::string &name,
+                                                       const std::string &objPath,
+                                                       StaticMesh::VertexFormat vertexFormat,
+                                                       StaticMesh::Residency residency);
+
         std::shared_ptr<StaticMesh> getStaticMesh(const std::string &name) const;
 
+        /*
+        Name lookups are meant for loading, the draw path keeps handles and resolves them. The
+        handle lookups give an invalid handle if there is no resource of that name.
+        */
+        ShaderProgramHandle getShaderProgramHandle(const std::string &name) const { return m_ShaderPrograms.findHandle(name); }
+        MaterialHandle getMaterialHandle(const std::string &name) const { return m_Materials.findHandle(name); }
+        Texture2DHandle getTexture2DHandle(const std::string &name) const { return m_Textures2D.findHandle(name); }
+        StaticMeshHandle getStaticMeshHandle(const std::string &name) const { return m_StaticMeshes.findHandle(name); }
+        /*
+        An array access, nullptr for invalid handles
+        */
+        ShaderProgram *resolve(ShaderProgramHandle handle) const { return m_ShaderPrograms.resolve(handle); }
+        Material *resolve(MaterialHandle handle) const { return m_Materials.resolve(handle); }
+        Texture2D *resolve(Texture2DHandle handle) const { return m_Textures2D.resolve(handle); }
+        StaticMesh *resolve(StaticMeshHandle handle) const { return m_StaticMeshes.resolve(handle); }
+
+        /*
+        Recompiles the program and swaps it into the existing ShaderProgram object, so every
+        material using it picks it up. Keeps the old program if the new one does not compile.
+        Nothing is recompiled if the preprocessed sources did not change.
+        */
+        void reloadShaderProgram(const std::string &name);
         void reloadStandardShader();
+
+        /*
+        Starts watching the data directory, see reloadChangedResources. Does nothing while
+        an archive is mounted.
+        */
+        void watchDataDirectory();
+        /*
+        Reloads shaders, textures and meshes whose source files changed since the last call.
+        Shaders are recompiled right away, also when only a file they include changed, images and models are read on worker threads and
+        swapped into the existing resources by processUploads.
+        */
+        void reloadChangedResources();
     private:
         std::string m_DataDirectory;
+        // Shared with the stream sources of the meshes
+        std::shared_ptr<VirtualFileSystem> m_Vfs;
+
+        // Workers for CPU-heavy import stages
+        ThreadPool m_ThreadPool;
+
+        // Cooked replacements of source assets, empty if nothing has been cooked
+        AssetManifest m_AssetManifest;
+
+        ResourceTable<ShaderProgram> m_ShaderPrograms;
+        // Resolves #include in data/shaders and adds the engine defines to every shader, shared with the variants
+        std::shared_ptr<ShaderPreprocessor> m_ShaderPreprocessor;
+        // Variants of the Standard program by StandardMaterialFlags
+        std::shared_ptr<ShaderVariants> m_StandardVariants;
+        ResourceTable<Material> m_Materials;
+        ResourceTable<Texture2D> m_Textures2D;
+        ResourceTable<StaticMesh> m_StaticMeshes;
+
+        // Handles given out for resources that were not loaded when requested
+        std::unordered_map<std::string, ResourceHandle<Texture2D>> m_TextureHandles;
+        std::unordered_map<std::string, ResourceHandle<StaticModel>> m_ModelHandles;
 
-        std::unordered_map<std::string, std::shared_ptr<ShaderProgram>> m_ShaderPrograms;
-        std::unordered_map<std::string, std::shared_ptr<Material>> m_Materials;
-        std::unordered_map<std::string, std::shared_ptr<Texture2D>> m_Textures2D;
-        std::unordered_map<std::string, std::shared_ptr<StaticMesh>> m_StaticMeshes;
+        // Source files of the loaded resources, paths relative to the data directory
+        struct ShaderSources
+        {
+            std::string vertex;
+            std::string fragment;
+            // Both files and everything they include, from the last successful preprocessing
+            std::vector<std::string> dependencies;
+            uint64_t hash{0};
+        };
+        struct MeshSources
+        {
+            std::string objPath;
+            std::vector<std::string> fullPaths; // normalized, the OBJ and its material libraries
+        };
+        std::unordered_map<std::string, ShaderSources> m_ShaderSources;
+        std::unordered_map<std::string, std::string> m_TextureSources;
+        std::unordered_map<std::string, MeshSources> m_MeshSources;
+
+        std::unique_ptr<FileWatcher> m_FileWatcher;
+
+        bool m_TextureArraysEnabled{true};
+        bool m_ShaderVariantsEnabled{true};
 
         std::string makePath(const std::string &relativePath) { return m_DataDirectory + '/' + relativePath; }
+
+        // Pixels decoded by stb_image, may be produced on a worker thread
+        struct DecodedImage
+        {
+            std::string path;
+            int width{0};
+            int height{0};
+            int numChannels{0};
+            std::unique_ptr<unsigned char, void (*)(void *)> pixels{nullptr, nullptr};
+            double decodeMs{0.0};
+        };
+
+        DecodedImage decodeImage(const std::string &path);
+        static DecodedImage decodeImage(const std::string &label, const unsigned char *data, size_t size);
+        /*
+        Returns nullptr if the texture has not been cooked or the cooked file cannot be used
+        */
+        std::shared_ptr<Texture2D> loadCookedTexture2D(const std::string &name, const std::string &path);
+        std::shared_ptr<Texture2D> createTexture2D(const std::string &name, const DecodedImage &image);
+        std::shared_ptr<Texture2D> createTexture2D(const std::string &name, const CookedTexture &cooked);
+        /*
+        Moves the textures into one texture array per group of at least two with the same size,
+        format and mip count. Textures that already are array layers are left alone.
+        */
+        void batchTextureArrays(const std::unordered_map<std::string, std::shared_ptr<Texture2D>> &textures);
+
+        // CPU side of a texture load, exactly one of cooked and image is valid
+        struct PendingTexture
+        {
+            std::string name;
+            std::string path;
+            std::unique_ptr<CookedTexture> cooked;
+            DecodedImage image;
+        };
+
+        // New pixels for an already loaded texture
+        struct TextureReload
+        {
+            std::string name;
+            DecodedImage image;
+        };
+
+        // Asynchronous static mesh load, filled by a worker and uploaded step by step afterwards
+        struct StaticMeshLoad
+        {
+            std::string name;
+            std::string objPath;
+            StaticMesh::VertexFormat vertexFormat;
+            StaticMesh::Residency residency{StaticMesh::Residency::Keep};
+            std::function<void(LoadedStaticMeshes &)> onLoaded;
+            // Hot reloads swap into the existing meshes and materials instead of calling onLoaded
+            bool reload{false};
+            // Textures that are already loaded and need no decoding
+            std::unordered_set<std::string> loadedTextures;
+
+            ImportedMesh imported;
+            std::vector<PendingTexture> textures;
+            std::vector<std::shared_ptr<StaticMesh>> meshes;
+            std::string error; // set if the worker failed
+
+            std::unordered_map<std::string, std::shared_ptr<Texture2D>> uploadedTextures;
+            size_t nextUpload{0}; // textures first, then meshes
+        };
+
+        // Guards the ready queues, everything else about loads is only touched by the GL thread
+        std::mutex m_LoadMutex;
+        std::deque<std::unique_ptr<StaticMeshLoad>> m_ReadyLoads;
+        std::deque<PendingTexture> m_ReadyTextures;
+        std::deque<TextureReload> m_ReadyTextureReloads;
+        std::unique_ptr<StaticMeshLoad> m_UploadingLoad;
+        std::vector<std::future<void>> m_LoadTasks;
+        size_t m_LoadsRequested{0};
+        size_t m_LoadsCompleted{0};
+        size_t m_CompilingShaders{0};
+
+        /*
+        Reads the mesh from the cooked assets or the mesh cache, importing the OBJ if neither
+        can be used. Does not touch OpenGL or the resource maps. streamPath is set to the file
+        the meshes can be re-streamed from (a VFS path), empty if the import could not be cached.
+        */
+        ImportedMesh importStaticMesh(const std::string &objPath, bool allowCooked, std::string &streamPath);
+        // Archived caches are used as they are, loose ones are checked against their sources
+        // Cooked meshes store their source paths relative to the data directory
+        bool readMeshCache(const std::string &cachePath, ImportedMesh &imported, bool cooked);
+        std::shared_ptr<StaticMesh> createStaticMesh(ImportedSubmesh &submesh,
+                                                     const std::string &streamPath,
+                                                     size_t submeshIndex,
+                                                     StaticMesh::Residency residency);
+        void queueStaticMeshLoad(std::unique_ptr<StaticMeshLoad> load);
+        // Drops the futures of worker tasks that are done, logging the ones that threw
+        void collectFinishedLoadTasks();
+        // Removes resources that lost their name to a newer one once nothing else owns them
+        void releaseReplacedResources();
+        static std::vector<std::pair<std::string, std::string>> collectTextures(const ImportedMesh &imported);
+        void prepareStaticMeshLoad(StaticMeshLoad &load);
+        // Reads the cooked texture or decodes the image, for worker threads
+        void prepareTexture(PendingTexture &pending);
+        std::shared_ptr<Texture2D> uploadPendingTexture(PendingTexture &pending);
+        void queueTextureLoad(const std::string &name, const std::string &path);
+        void finishTextureLoad(PendingTexture &pending);
+        // Does one upload of the load, returns true when nothing is left to upload
+        bool advanceUpload(StaticMeshLoad &load);
+        void finishStaticMeshLoad(StaticMeshLoad &load);
+        void finishStaticMeshReload(StaticMeshLoad &load);
+        void finishTextureReload(TextureReload &reload);
+
+        /*
+        Returns the preprocessed vertex and fragment source, fills in the dependencies and the
+        hash of sources. Throws std::runtime_error if a stage cannot be preprocessed.
+        */
+        std::pair<std::string, std::string> preprocessShaderSources(ShaderSources &sources) const;
+        // Finishes the programs and variants the driver is done with, updates m_CompilingShaders
+        void pollShaderPrograms();
+        static Texture2D::TextureDataFormat formatForChannels(int numChannels);
+        static std::string normalizePath(const std::string &path);
+
+        static std::string gltfImageName(const std::string &glbPath, const GltfModel &model, int32_t image);
+        /*
+        Undoes the vertical flip of the decoder (glTF puts the UV origin at the top left) and
+        keeps only the given channel, or all of them if channel is negative
+        */
+        static void prepareGltfImage(DecodedImage &image, int channel);
+        std::unordered_map<std::string, std::shared_ptr<Texture2D>> loadGltfTextures(const std::string &glbPath,
+                                                                                     const GltfModel &model);
+        std::shared_ptr<StaticMesh> createGltfStaticMesh(const GltfModel &model, const GltfPrimitive &primitive);
+
+        // Warns if the name is taken, see ResourceTable::add
+        MaterialHandle addMaterial(const std::string &name, std::shared_ptr<Material> material);
+        // Registers the material under its name
+        MaterialHandle createImportedMaterial(const ImportedMaterial &importedMaterial,
+                                              const std::unordered_map<std::string, std::shared_ptr<Texture2D>> &textures);
+        // Only creates the material, nothing is registered
+        std::shared_ptr<StandardMaterial> makeImportedMaterial(const ImportedMaterial &importedMaterial,
+                                                               const std::unordered_map<std::string, std::shared_ptr<Texture2D>> &textures);
+        std::shared_ptr<StandardMaterial> makeStandardMaterial(GLint flags);
     };
 
 }
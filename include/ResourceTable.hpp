@@ -0,0 +1,144 @@
+#pragma once
+
+#include "SlotMap.hpp"
+
+#include <unordered_map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace planets
+{
+    /*
+    Resources of one type kept in a SlotMap. Names are only used to look up handles when
+    loading, the resources themselves are reached through their handle and iterated in slot
+    order.
+    */
+    template <typename T>
+    class ResourceTable
+    {
+    public:
+        struct Entry
+        {
+            std::string name;
+            std::shared_ptr<T> resource;
+        };
+        using Handle = typename SlotMap<Entry>::Handle;
+
+        /*
+        The name moves to the new resource if it is taken. The old resource is removed and its
+        handles go stale right away if the table is its only owner. Otherwise it stays
+        reachable through its handles until releaseUnreferenced finds it unowned, but is no
+        longer found by name or iterated.
+        */
+        Handle add(const std::string &name, std::shared_ptr<T> resource)
+        {
+            auto it = m_Handles.find(name);
+            if (it != m_Handles.end())
+            {
+                Entry *old = m_Entries.get(it->second);
+                if (old->resource.use_count() <= 1)
+                {
+                    m_Entries.remove(it->second);
+                }
+                else
+                {
+                    old->name.clear();
+                    m_Unnamed++;
+                }
+            }
+            Handle handle = m_Entries.insert({name, std::move(resource)});
+            m_Handles[name] = handle;
+            return handle;
+        }
+
+        /*
+        Removes the replaced resources nothing but the table owns anymore, their handles go
+        stale. Returns how many were removed.
+        */
+        size_t releaseUnreferenced()
+        {
+            if (m_Unnamed == 0)
+            {
+                return 0;
+            }
+            std::vector<Handle> released;
+            m_Entries.forEach([&](Handle handle, const Entry &entry)
+                              {
+                                  if (entry.name.empty() && entry.resource.use_count() <= 1)
+                                  {
+                                      released.push_back(handle);
+                                  } });
+            for (Handle handle : released)
+            {
+                m_Entries.remove(handle);
+            }
+            m_Unnamed -= released.size();
+            return released.size();
+        }
+
+        /*
+        Invalid if there is no resource of that name
+        */
+        Handle findHandle(const std::string &name) const
+        {
+            auto it = m_Handles.find(name);
+            return it != m_Handles.end() ? it->second : Handle();
+        }
+        /*
+        nullptr if there is no resource of that name
+        */
+        const std::shared_ptr<T> *find(const std::string &name) const
+        {
+            return get(findHandle(name));
+        }
+        const std::shared_ptr<T> *get(Handle handle) const
+        {
+            const Entry *entry = m_Entries.get(handle);
+            return entry != nullptr ? &entry->resource : nullptr;
+        }
+        /*
+        For the draw path, no hashing and no reference counting. nullptr if the handle is stale.
+        */
+        T *resolve(Handle handle) const
+        {
+            const Entry *entry = m_Entries.get(handle);
+            return entry != nullptr ? entry->resource.get() : nullptr;
+        }
+        bool contains(const std::string &name) const { return m_Handles.find(name) != m_Handles.end(); }
+
+        size_t size() const { return m_Handles.size(); }
+
+        /*
+        Calls fn(name, resource) for every resource that has a name
+        */
+        template <typename Function>
+        void forEach(Function &&fn) const
+        {
+            m_Entries.forEach([&](Handle, const Entry &entry)
+                              {
+                                  if (!entry.name.empty())
+                                  {
+                                      fn(entry.name, entry.resource);
+                                  } });
+        }
+
+    private:
+        SlotMap<Entry> m_Entries;
+        std::unordered_map<std::string, Handle> m_Handles;
+        // Replaced resources that were still owned elsewhere
+        size_t m_Unnamed{0};
+    };
+
+    class ShaderProgram;
+    class Material;
+    class Texture2D;
+    class StaticMesh;
+
+    // Handles of the resources kept by ResourceManager
+    using ShaderProgramHandle = ResourceTable<ShaderProgram>::Handle;
+    using MaterialHandle = ResourceTable<Material>::Handle;
+    using Texture2DHandle = ResourceTable<Texture2D>::Handle;
+    using StaticMeshHandle = ResourceTable<StaticMesh>::Handle;
+}
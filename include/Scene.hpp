@@ -3,11 +3,13 @@
 #include "SpatialObject.hpp"
 #include "Camera.hpp"
 #include "DebugUtils.hpp"
+#include "UniformBuffer.hpp"
 
 #include <memory>
 
 namespace planets
 {
+    class ResourceManager;
 
     class Scene
     {
@@ -20,15 +22,21 @@ namespace planets
         std::shared_ptr<Camera> getActiveCamera() { return m_ActiveCamera; }
         void setActiveCamera(std::shared_ptr<Camera> camera);
 
-        std::shared_ptr<SpatialObject> getRoot() { return m_Root; }
+        const std::shared_ptr<SpatialObject> &getRoot() const { return m_Root; }
 
         void update(float deltaTime);
         void fixedUpdate();
-        void draw(int viewportWidth, int viewportHeight);
+        void draw(int viewportWidth, int viewportHeight, const ResourceManager &resources);
 
         DrawStats drawStats;
+        // Positive values allow coarser LODs, negative values keep finer ones
+        float lodBias{0.0f};
     private:
         std::shared_ptr<SpatialObject> m_Root;
         std::shared_ptr<Camera> m_ActiveCamera;
+
+        // FrameData block, and the ObjectData blocks of all draws
+        std::unique_ptr<UniformBuffer> m_FrameUniforms;
+        std::unique_ptr<UniformRingBuffer> m_ObjectUniforms;
     };
 }
\ No newline at end of file
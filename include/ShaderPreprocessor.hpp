@@ -0,0 +1,71 @@
+#pragma once
+
+#include "VirtualFileSystem.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <utility>
+#include <cstdint>
+
+namespace planets
+{
+    /*
+    A shader stage with its #include directives resolved and the engine defines added
+    */
+    struct PreprocessedShader
+    {
+        std::string source;
+        // VFS paths of the file and everything it includes, the file first
+        std::vector<std::string> dependencies;
+        // Of the source as it is handed to the driver, see hashBytes
+        uint64_t hash{0};
+    };
+
+    /*
+    Expands #include "file" lines with files from the include directory (each file once per
+    shader, later includes of it are skipped) and inserts "#define <name> <value>" for every
+    engine define right after #version, so shaders take constants like flag bits from C++
+    instead of repeating them. #line directives keep compile errors pointing to the right line;
+    their source string number is the index of the file in dependencies.
+    */
+    class ShaderPreprocessor
+    {
+    public:
+        // Names and values, in the order they are defined
+        using Defines = std::vector<std::pair<std::string, std::string>>;
+
+        ShaderPreprocessor(std::shared_ptr<VirtualFileSystem> vfs, const std::string &includeDirectory);
+
+        /*
+        Replaces the value of a define of the same name
+        */
+        void setDefine(const std::string &name, const std::string &value);
+        void setDefine(const std::string &name, long long value) { setDefine(name, std::to_string(value)); }
+        /*
+        Defines the constants the shaders share with C++: the HAS_*_MAP bits of
+        StandardMaterialFlags and ARRAY_MAP_SHIFT, MAX_LIGHTS, the *_BLOCK_BINDING points and VERTEX_FORMAT_*
+        */
+        void setEngineDefines();
+
+        /*
+        extraDefines are added after the engine defines, for this shader only (e.g. the mask of
+        a ShaderVariants variant). Throws std::runtime_error if a file is missing, an include is
+        malformed or recursive, or an included file has a #version.
+        */
+        PreprocessedShader process(const std::string &path, const Defines &extraDefines = {}) const;
+
+    private:
+        std::shared_ptr<VirtualFileSystem> m_Vfs;
+        std::string m_IncludeDirectory;
+        Defines m_Defines;
+
+        std::string readFile(const std::string &path) const;
+        /*
+        Appends the text of dependencies[fileIndex], which starts at firstLine of the file, to
+        the source with its includes expanded. includeStack holds the files being expanded.
+        */
+        void expand(const std::string &text, size_t firstLine, size_t fileIndex, PreprocessedShader &shader,
+                    std::vector<std::string> &includeStack) const;
+    };
+}
@@ -6,19 +6,104 @@
 #include <glm/glm.hpp>
 
 #include <string>
+#include <vector>
+#include <memory>
 #include <unordered_map>
+#include <cstdint>
 
 namespace planets
 {
+    /*
+    Resolved location of a uniform. Programs that do not use the uniform give -1, which the
+    setters pass on to GL, where it is ignored.
+    */
+    struct UniformHandle
+    {
+        GLint location{-1};
+    };
 
     class ShaderProgram
     {
     public:
+        /*
+        Time the calling thread spent creating programs since startup, from source and from the
+        binary cache. Deferred programs count the time to submit and to finish them.
+        */
+        struct SetupStats
+        {
+            size_t programs{0};
+            size_t fromCache{0};
+            double milliseconds{0.0};
+        };
+
+        static constexpr uint32_t BINARY_MAGIC = 0x42505050; // "PPPB"
+        static constexpr uint32_t BINARY_VERSION = 1;
+
+        enum class CompileMode
+        {
+            Blocking, // Ready when constructed, throws if the sources do not compile or link
+            Deferred  // Submitted to the driver when constructed, see poll
+        };
+
         ShaderProgram() = delete;
+        /*
+        Loads the linked program from the binary cache if it holds one for these sources and
+        this driver, otherwise compiles and links it and adds it to the cache
+        */
         ShaderProgram(const std::string &vertexSource, const std::string &fragmentSource);
+        /*
+        Deferred programs that are not in the binary cache only get submitted for compilation
+        and linking. Submitting all programs before polling the first one lets drivers that
+        support GL_KHR_parallel_shader_compile compile them all at once in the background.
+        */
+        ShaderProgram(const std::string &vertexSource, const std::string &fragmentSource, CompileMode mode);
         ~ShaderProgram();
 
+        /*
+        Directory the driver's program binaries are kept in, keyed by a hash of the sources and
+        the GL vendor, renderer and version. Created if missing. Empty (the default) disables
+        the cache. Has no effect if the driver offers no binary formats.
+        */
+        static void setBinaryCacheDirectory(const std::string &directory);
+        static SetupStats getSetupStats();
+
+        /*
+        Exchanges the GL programs, used to hot reload a program while materials keep pointing to it
+        */
+        void swap(ShaderProgram &other) noexcept;
+
+        /*
+        Finishes a deferred program once the driver is done with it, returns false while it is
+        still compiling. With parallel compilation this never waits, without it the first poll
+        does. Errors are logged and leave the program failed instead of throwing.
+        */
+        bool poll();
+        /*
+        Ready programs can be used and have their uniforms resolved. Programs still compiling
+        can be used as well, but their first use waits for the driver.
+        */
+        bool isReady() const noexcept { return !m_Pending && !m_Failed; }
+        bool hasFailed() const noexcept { return m_Failed; }
+
         void use() const noexcept;
+        GLuint getId() const noexcept { return m_ProgramId; }
+
+        /*
+        Changes whenever the program is relinked (swapped in by a hot reload), handles resolved
+        for an older link id must be resolved again
+        */
+        uint32_t getLinkId() const noexcept { return m_LinkId; }
+        /*
+        One lookup by name, meant to be done once per link. The setters taking a handle do no
+        string work and are the ones to use per draw.
+        */
+        UniformHandle getUniform(const char *name) const;
+
+        /*
+        The driver's program binary stands in for the GPU size, uniform lookups for the CPU size
+        */
+        size_t getCpuSizeInBytes() const;
+        size_t getGpuSizeInBytes() const;
 
         void setMatrix4f(const char *name, const glm::mat4 &matrix);
         void setMatrix3f(const char *name, const glm::mat3 &matrix);
@@ -29,18 +114,46 @@ namespace planets
         void setFloat(const char *name, GLfloat value);
         void setInt(const char *name, GLint value);
 
+        // The program must be in use
+        void setMatrix4f(UniformHandle uniform, const glm::mat4 &matrix) const noexcept;
+        void setMatrix3f(UniformHandle uniform, const glm::mat3 &matrix) const noexcept;
+        void setMatrix2f(UniformHandle uniform, const glm::mat2 &matrix) const noexcept;
+        void setVector4f(UniformHandle uniform, const glm::vec4 &vector) const noexcept;
+        void setVector3f(UniformHandle uniform, const glm::vec3 &vector) const noexcept;
+        void setVector2f(UniformHandle uniform, const glm::vec2 &vector) const noexcept;
+        void setFloat(UniformHandle uniform, GLfloat value) const noexcept;
+        void setInt(UniformHandle uniform, GLint value) const noexcept;
+
     private:
-        GLuint m_ProgramId;
+        // Objects of a compile and link that has been submitted but not checked yet
+        struct PendingLink
+        {
+            GLuint vertexShaderId{0};
+            GLuint fragmentShaderId{0};
+            GLuint programId{0};
+            std::string cachePath;
+            double submitMs{0.0};
+        };
+
+        GLuint m_ProgramId{0};
+        uint32_t m_LinkId{0};
+        std::unique_ptr<PendingLink> m_Pending;
+        bool m_Failed{false};
         // Uniforms
 
         std::unordered_map<std::string, GLint> m_UniformLocations;
 
-        inline bool uniformExists(const char *name)
-        {
-            return (m_UniformLocations.find(name) != m_UniformLocations.end());
-        }
-
         void getUniformLocations();
+        // Starts compiling and linking without waiting for the driver, throws only if GL objects cannot be created
+        static PendingLink submit(const std::string &vertexSource, const std::string &fragmentSource, bool retrievable);
+        // Checks the statuses of the pending link, throws if a shader did not compile or the program did not link
+        void finishLink();
+        void finishSetup(double start, bool cached);
+        // Both return false and leave the cache alone if anything goes wrong
+        bool loadBinary(const std::string &cachePath);
+        bool saveBinary(const std::string &cachePath) const;
+        // Connects the blocks the program declares to their UniformBlockBinding
+        void bindUniformBlocks();
     };
 
 }
\ No newline at end of file
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "ShaderProgram.hpp"
+#include "ShaderPreprocessor.hpp"
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace planets
+{
+    /*
+    Specialized versions of one program, each preprocessed with "#define <defineName> <mask>"
+    for one mask of feature flags. The shader tests the define instead of a uniform, so the code
+    for features a mask leaves out (and its samplers) is compiled away. Variants are compiled
+    on first request and kept for the lifetime of the object.
+    */
+    class ShaderVariants
+    {
+    public:
+        ShaderVariants() = delete;
+        /*
+        fallback is the unspecialized program, handed out for masks whose variant cannot be
+        created. Deferred variants are returned while still compiling, see poll.
+        */
+        ShaderVariants(std::shared_ptr<ShaderProgram> fallback,
+                       std::shared_ptr<const ShaderPreprocessor> preprocessor,
+                       const std::string &vertexSourcePath,
+                       const std::string &fragmentSourcePath,
+                       const std::string &defineName,
+                       ShaderProgram::CompileMode mode = ShaderProgram::CompileMode::Blocking);
+
+        ShaderVariants(const ShaderVariants &other) = delete;
+        ShaderVariants &operator=(const ShaderVariants &other) = delete;
+
+        std::shared_ptr<ShaderProgram> get(GLint mask);
+
+        /*
+        Polls the variants that are still compiling, returns how many are left. A variant that
+        fails gets the unspecialized program compiled into it, so its materials keep working.
+        */
+        size_t poll();
+
+        /*
+        Recompiles every variant from the source files and swaps it into the existing program,
+        so materials keep their pointers. Variants that do not compile keep the old program.
+        */
+        void reload();
+
+        size_t size() const { return m_Variants.size(); }
+
+        /*
+        Calls fn(mask, program) for every compiled variant
+        */
+        template <typename Function>
+        void forEach(Function &&fn) const
+        {
+            for (const auto &[mask, program] : m_Variants)
+            {
+                fn(mask, program);
+            }
+        }
+
+    private:
+        std::shared_ptr<ShaderProgram> m_Fallback;
+        std::shared_ptr<const ShaderPreprocessor> m_Preprocessor;
+        std::string m_VertexSourcePath;
+        std::string m_FragmentSourcePath;
+        std::string m_DefineName;
+        ShaderProgram::CompileMode m_Mode;
+
+        std::unordered_map<GLint, std::shared_ptr<ShaderProgram>> m_Variants;
+
+        // Without defines the program is unspecialized
+        std::shared_ptr<ShaderProgram> compile(const ShaderPreprocessor::Defines &defines, ShaderProgram::CompileMode mode) const;
+        ShaderPreprocessor::Defines definesFor(GLint mask) const { return {{m_DefineName, std::to_string(mask)}}; }
+    };
+}
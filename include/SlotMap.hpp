@@ -0,0 +1,142 @@
+#pragma once
+
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+
+namespace planets
+{
+    /*
+    Values addressed by 32-bit handles: the low INDEX_BITS select a slot, the high bits hold the
+    generation of the slot, which changes whenever its value is removed, so stale handles stop
+    resolving instead of reaching whatever reuses the slot. Lookups are an array access and a
+    comparison. Removed slots are reused, iteration skips them.
+    */
+    template <typename T>
+    class SlotMap
+    {
+    public:
+        static constexpr uint32_t INDEX_BITS = 20;
+        static constexpr uint32_t MAX_SLOTS = 1u << INDEX_BITS;
+
+        class Handle
+        {
+        public:
+            Handle() = default;
+
+            bool isValid() const { return m_Value != 0; }
+            uint32_t getValue() const { return m_Value; }
+
+            bool operator==(const Handle &other) const { return m_Value == other.m_Value; }
+            bool operator!=(const Handle &other) const { return m_Value != other.m_Value; }
+
+        private:
+            // Generations start at 1, so 0 never refers to a slot
+            uint32_t m_Value{0};
+
+            Handle(uint32_t index, uint32_t generation) : m_Value(generation << INDEX_BITS | index) {}
+            uint32_t index() const { return m_Value & (MAX_SLOTS - 1); }
+            uint32_t generation() const { return m_Value >> INDEX_BITS; }
+
+            friend class SlotMap;
+        };
+
+        /*
+        Returns an invalid handle if all MAX_SLOTS slots are taken
+        */
+        Handle insert(T value)
+        {
+            uint32_t index;
+            if (!m_FreeSlots.empty())
+            {
+                index = m_FreeSlots.back();
+                m_FreeSlots.pop_back();
+            }
+            else if (m_Slots.size() < MAX_SLOTS)
+            {
+                index = static_cast<uint32_t>(m_Slots.size());
+                m_Slots.emplace_back();
+            }
+            else
+            {
+                return {};
+            }
+
+            Slot &slot = m_Slots[index];
+            slot.value = std::move(value);
+            slot.occupied = true;
+            m_Size++;
+            return Handle(index, slot.generation);
+        }
+
+        bool remove(Handle handle)
+        {
+            Slot *slot = find(handle);
+            if (slot == nullptr)
+            {
+                return false;
+            }
+            slot->value = T();
+            slot->occupied = false;
+            // Wraps around past the generation bits, skipping 0
+            slot->generation = (slot->generation + 1) & (UINT32_MAX >> INDEX_BITS);
+            slot->generation += slot->generation == 0 ? 1 : 0;
+            m_FreeSlots.push_back(handle.index());
+            m_Size--;
+            return true;
+        }
+
+        /*
+        nullptr if the handle is invalid or its value has been removed
+        */
+        T *get(Handle handle)
+        {
+            Slot *slot = find(handle);
+            return slot != nullptr ? &slot->value : nullptr;
+        }
+        const T *get(Handle handle) const
+        {
+            return const_cast<SlotMap *>(this)->get(handle);
+        }
+        bool contains(Handle handle) const { return get(handle) != nullptr; }
+
+        size_t size() const { return m_Size; }
+
+        /*
+        Calls fn(handle, value) for every value in slot order
+        */
+        template <typename Function>
+        void forEach(Function &&fn) const
+        {
+            for (uint32_t i = 0; i < m_Slots.size(); i++)
+            {
+                if (m_Slots[i].occupied)
+                {
+                    fn(Handle(i, m_Slots[i].generation), m_Slots[i].value);
+                }
+            }
+        }
+
+    private:
+        struct Slot
+        {
+            T value{};
+            uint32_t generation{1};
+            bool occupied{false};
+        };
+        std::vector<Slot> m_Slots;
+        std::vector<uint32_t> m_FreeSlots;
+        size_t m_Size{0};
+
+        Slot *find(Handle handle)
+        {
+            if (!handle.isValid() || handle.index() >= m_Slots.size())
+            {
+                return nullptr;
+            }
+            Slot &slot = m_Slots[handle.index()];
+            return slot.occupied && slot.generation == handle.generation() ? &slot : nullptr;
+        }
+    };
+}
@@ -4,7 +4,7 @@
 #include <glm/gtc/quaternion.hpp>
 
 #include <memory>
-#include <unordered_map>
+#include <vector>
 #include <string>
 #include <string_view>
 
@@ -25,9 +25,14 @@ namespace planets
 
         const std::string &getName() const { return m_Name; }
         std::shared_ptr<SpatialObject> addChild(std::shared_ptr<SpatialObject> object);
+        /*
+        Name lookups compare against every child, keep the returned pointer instead of looking
+        the child up every frame
+        */
         bool hasChild(const std::string &name) const noexcept;
         std::shared_ptr<SpatialObject> getChild(const std::string &name) const noexcept;
-        auto getChildren() const { return m_Children; }
+        // In the order they were added
+        const std::vector<std::shared_ptr<SpatialObject>> &getChildren() const { return m_Children; }
 
         const glm::vec3 &getLocalRight() const { return m_LocalRight; }
         const glm::vec3 &getLocalUp() const { return m_LocalUp; }
@@ -53,7 +58,9 @@ namespace planets
         std::string m_Name;
 
         std::shared_ptr<SpatialObject> m_Parent;
-        std::unordered_map<std::string, std::shared_ptr<SpatialObject>> m_Children;
+        std::vector<std::shared_ptr<SpatialObject>> m_Children;
+
+        std::vector<std::shared_ptr<SpatialObject>>::const_iterator findChild(const std::string &name) const noexcept;
 
     protected:
         // Local transformation matrices
@@ -5,34 +5,28 @@
 
 #include <glm/glm.hpp>
 
+#include "ThreadPool.hpp"
+
 #include <vector>
+#include <functional>
+#include <memory>
+#include <cstdint>
 
 namespace planets
 {
     class StaticMesh
     {
     public:
-        StaticMesh(const std::vector<glm::vec3> &vertexPositions,
-                   const std::vector<glm::vec3> &vertexNormals,
-                   const std::vector<glm::vec2> &vertexUVs,
-                   const std::vector<GLuint> &triangleIndices);
-        ~StaticMesh();
-
-        void uploadToGPU();
-        void unloadFromGPU();
-
-        void draw() const noexcept;
-
-    private:
         struct Vertex
         {
             glm::vec3 position;
             glm::vec3 normal;
-            glm::vec3 tangent;
+            glm::vec4 tangent; // w is the bitangent sign, bitangent = w * cross(normal, tangent)
             glm::vec2 uv;
+            Vertex() = default;
             Vertex(const glm::vec3 &position,
                    const glm::vec3 &normal,
-                   const glm::vec3 &tangent,
+                   const glm::vec4 &tangent,
                    const glm::vec2 &uv) : position(position),
                                           normal(normal),
                                           tangent(tangent),
@@ -41,16 +35,211 @@ namespace planets
             }
         };
 
+        enum class VertexFormat
+        {
+            Float, // Vertex as is, 48 bytes
+            Packed // PackedVertex, 20 bytes
+        };
+
+        /*
+        Compact GPU layout. Positions are 16-bit unorm within the mesh AABB (decoded by the
+        matrix from getPositionDecodeMatrix), w holds the bitangent sign (0 = -1, 1 = +1).
+        Normals and tangents are octahedral snorm16x2, UVs half floats.
+        */
+        struct PackedVertex
+        {
+            uint16_t position[4];
+            uint32_t normal;  // packSnorm2x16
+            uint32_t tangent; // packSnorm2x16
+            uint32_t uv;      // packHalf2x16
+        };
+
+        /*
+        What stays in system memory once the mesh is on the GPU
+        */
+        enum class Residency
+        {
+            Keep,          // vertices and indices
+            PositionsOnly, // vertex positions and indices, for CPU-side queries
+            Discard        // nothing, uploading again re-streams the data from the stream source
+        };
+
+        /*
+        Reads the vertices and indices the mesh was created from again. Returns false on failure.
+        */
+        using StreamSource = std::function<bool(std::vector<StaticMesh::Vertex> &, std::vector<GLuint> &)>;
+
+        /*
+        Attribute array inside an ExternalBuffer, offset relative to its data
+        */
+        struct AttributeView
+        {
+            size_t offset{0};
+            GLsizei stride{0};
+            GLenum componentType{GL_FLOAT};
+            GLint components{0}; // 0 if the mesh does not have the attribute
+            GLboolean normalized{GL_FALSE};
+        };
+
+        /*
+        Vertices and indices in memory owned by someone else (e.g. a mapped model file), uploaded
+        into a single GL buffer as they are. Positions and normals must be float vec3, tangents
+        float vec4, indices 8, 16 or 32 bits.
+        */
+        struct ExternalBuffer
+        {
+            std::shared_ptr<const void> owner; // keeps data alive as long as the mesh
+            const unsigned char *data{nullptr};
+            size_t size{0};
+            size_t vertexCount{0};
+            AttributeView position;
+            AttributeView normal;
+            AttributeView tangent;
+            AttributeView uv;
+            size_t indexOffset{0};
+            size_t indexCount{0};
+            GLenum indexType{GL_UNSIGNED_INT};
+        };
+
+        /*
+        Range of the index buffer drawn for one level of detail. All levels share the vertices.
+        */
+        struct Lod
+        {
+            GLuint indexOffset;
+            GLuint indexCount;
+            float error; // how far the surface may deviate from LOD 0, in model space units
+        };
+
+        StaticMesh(const std::vector<glm::vec3> &vertexPositions,
+                   const std::vector<glm::vec3> &vertexNormals,
+                   const std::vector<glm::vec2> &vertexUVs,
+                   const std::vector<GLuint> &triangleIndices);
+        /*
+        Creates a mesh from already interleaved vertices (with precomputed tangents).
+        Without LODs the whole index buffer is the only level.
+        */
+        StaticMesh(std::vector<StaticMesh::Vertex> vertices,
+                   std::vector<GLuint> triangleIndices,
+                   std::vector<StaticMesh::Lod> lods = {});
+        /*
+        Creates a mesh drawing straight from external memory, with one level of detail.
+        Nothing is copied; the residency policy does not apply since the data is not owned.
+        */
+        StaticMesh(StaticMesh::ExternalBuffer buffer);
+        ~StaticMesh();
+
+        /*
+        Exchanges all CPU and GPU data, used to hot reload a mesh while instances keep pointing to it
+        */
+        void swap(StaticMesh &other) noexcept;
+
+        /*
+        Validates the vertex attribute arrays and interleaves them, computing per-vertex tangents
+        (see TangentGenerator), in parallel when given a thread pool
+        */
+        static std::vector<StaticMesh::Vertex> buildVertices(const std::vector<glm::vec3> &vertexPositions,
+                                                             const std::vector<glm::vec3> &vertexNormals,
+                                                             const std::vector<glm::vec2> &vertexUVs,
+                                                             const std::vector<GLuint> &triangleIndices,
+                                                             ThreadPool *threadPool = nullptr);
+
+        static void computeBoundingSphere(const std::vector<StaticMesh::Vertex> &vertices,
+                                          glm::vec3 &center,
+                                          float &radius);
+
+        /*
+        Packs vertices relative to the AABB [positionMin, positionMin + positionExtent]
+        */
+        static std::vector<StaticMesh::PackedVertex> packVertices(const std::vector<StaticMesh::Vertex> &vertices,
+                                                                  glm::vec3 &positionMin,
+                                                                  glm::vec3 &positionExtent);
+
+        /*
+        Indices are uploaded as 16 bits when there are fewer than 65536 vertices.
+        Meshes from an ExternalBuffer are uploaded as they are, whatever the format.
+        */
+        void uploadToGPU(StaticMesh::VertexFormat format = StaticMesh::VertexFormat::Packed);
+        /*
+        Data dropped by the residency policy is re-streamed by the next uploadToGPU
+        */
+        void unloadFromGPU();
+
+        /*
+        Applied after every upload. Without a stream source the data could not be uploaded
+        again, so everything is kept regardless of the residency.
+        */
+        void setResidency(StaticMesh::Residency residency);
+        StaticMesh::Residency getResidency() const { return m_Residency; }
+        void setStreamSource(StaticMesh::StreamSource streamSource) { m_StreamSource = std::move(streamSource); }
+
+        void draw(size_t lod = 0) const noexcept;
+
+        StaticMesh::VertexFormat getVertexFormat() const { return m_VertexFormat; }
+        /*
+        Maps the attribute read by the vertex shader to model space, identity for float vertices.
+        Meant to be folded into the model matrix.
+        */
+        const glm::mat4 &getPositionDecodeMatrix() const { return m_PositionDecode; }
+
+        /*
+        Empty while on the GPU unless the residency is Keep
+        */
+        const std::vector<StaticMesh::Vertex> &getVertices() const { return m_Vertices; }
+        /*
+        Vertex positions kept by the PositionsOnly residency, empty otherwise
+        */
+        const std::vector<glm::vec3> &getPositions() const { return m_Positions; }
+        /*
+        Empty while on the GPU if the residency is Discard
+        */
+        const std::vector<GLuint> &getTriangleIndices() const { return m_TriangleIndices; }
+        size_t getVertexCount() const { return m_VertexCount; }
+        size_t getIndexCount() const { return m_IndexCount; }
+        const std::vector<StaticMesh::Lod> &getLods() const { return m_Lods; }
+        const glm::vec3 &getBoundsCenter() const { return m_BoundsCenter; }
+        float getBoundsRadius() const { return m_BoundsRadius; }
+
+        /*
+        System memory held by the vertex, index and LOD arrays (see Residency), and the
+        size of the vertex and index buffers on the GPU (0 while not uploaded)
+        */
+        size_t getCpuSizeInBytes() const;
+        size_t getGpuSizeInBytes() const { return m_GpuSizeInBytes; }
+
+    private:
         std::vector<StaticMesh::Vertex> m_Vertices;
         /*std::vector<glm::vec3> m_VertexPositions;
         std::vector<glm::vec3> m_VertexNormals;
         std::vector<glm::vec2> m_VertexUVs;*/
         std::vector<GLuint> m_TriangleIndices;
+        std::vector<StaticMesh::Lod> m_Lods;
+        std::vector<glm::vec3> m_Positions;
+        size_t m_VertexCount{0};
+        size_t m_IndexCount{0};
+
+        StaticMesh::Residency m_Residency{StaticMesh::Residency::Keep};
+        StaticMesh::StreamSource m_StreamSource;
+        StaticMesh::ExternalBuffer m_External;
+
+        // Bounding sphere in model space, used for LOD selection
+        glm::vec3 m_BoundsCenter{0.0f};
+        float m_BoundsRadius{0.0f};
 
         bool m_IsOnGPU;
+        StaticMesh::VertexFormat m_VertexFormat{StaticMesh::VertexFormat::Float};
+        GLenum m_IndexType{GL_UNSIGNED_INT};
+        size_t m_IndexByteOffset{0}; // of LOD 0 within the element buffer
+        glm::mat4 m_PositionDecode{1.0f};
+        size_t m_GpuSizeInBytes{0};
 
         GLuint m_VboId;
         GLuint m_VaoId;
         GLuint m_EboId;
+
+        // Restores m_Vertices and m_TriangleIndices if the residency policy dropped them
+        void restreamCpuData();
+        void applyResidency();
+        void uploadExternalBuffer(size_t &vertexBytes, size_t &indexBytes);
     };
 }
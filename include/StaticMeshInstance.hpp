@@ -4,10 +4,14 @@
 #include "StaticMesh.hpp"
 #include "ShaderProgram.hpp"
 #include "Material.hpp"
+#include "StaticModel.hpp"
+#include "ResourceHandle.hpp"
+#include "ResourceTable.hpp"
 
 #include "DebugUtils.hpp"
 
 #include <memory>
+#include <vector>
 
 #include <glm/glm.hpp>
 
@@ -16,16 +20,37 @@ namespace planets
     class StaticMeshInstance : public SpatialObject
     {
     public:
+        /*
+        The handles are resolved through DrawInput::resources on every draw, nothing is drawn
+        for stale ones
+        */
         StaticMeshInstance(const std::string &name,
                            std::shared_ptr<SpatialObject> parent,
-                           std::shared_ptr<StaticMesh> mesh,
-                           std::shared_ptr<Material> material);
+                           StaticMeshHandle mesh,
+                           MaterialHandle material);
+        /*
+        Draws all meshes of the model with their materials. Nothing is drawn until the model
+        has been loaded, the first draw requests the load.
+        */
+        StaticMeshInstance(const std::string &name,
+                           std::shared_ptr<SpatialObject> parent,
+                           ResourceHandle<StaticModel> model);
 
         virtual void draw(const DrawInput &drawInput, DrawStats &drawStats) override;
 
     private:
-        std::shared_ptr<StaticMesh> m_Mesh;
-        std::shared_ptr<Material> m_Material;
-
+        struct Part
+        {
+            StaticMeshHandle mesh;
+            MaterialHandle material;
+            // Kept between frames so the selection only changes past a hysteresis band
+            size_t currentLod{0};
+        };
+        std::vector<Part> m_Parts;
+        // Turned into parts once loaded
+        ResourceHandle<StaticModel> m_Model;
+
+        size_t selectLod(Part &part, const StaticMesh &mesh, const DrawInput &drawInput);
+        void drawPart(Part &part, const DrawInput &drawInput, DrawStats &drawStats);
     };
 }
\ No newline at end of file
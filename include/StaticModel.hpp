@@ -0,0 +1,19 @@
+#pragma once
+
+#include "ResourceTable.hpp"
+
+#include <string>
+#include <vector>
+#include <utility>
+
+namespace planets
+{
+    /*
+    Meshes of one model file, each with the material it is drawn with, see ResourceManager::resolve
+    */
+    struct StaticModel
+    {
+        std::string name;
+        std::vector<std::pair<StaticMeshHandle, MaterialHandle>> meshes;
+    };
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "ThreadPool.hpp"
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstddef>
+
+namespace planets
+{
+    /*
+    Per-vertex tangent frames following MikkTSpace: face tangents point along dP/du,
+    are projected onto the plane of each corner's normal and weighted by the corner
+    angle. w holds the bitangent sign, bitangent = w * cross(normal, tangent).
+    Unlike MikkTSpace, vertices are not split where the UV orientation of the faces
+    around them disagrees; the majority orientation wins.
+    */
+    class TangentGenerator
+    {
+    public:
+        // Triangles with a smaller absolute UV area (x2) do not define a tangent direction
+        static constexpr float DEGENERATE_UV_AREA = 1e-12f;
+        // Smallest triangle range handed to one worker, each range has its own accumulation buffer
+        static constexpr size_t MIN_TRIANGLES_PER_RANGE = 16384;
+
+        /*
+        Vertices whose triangles all have degenerate UVs get an arbitrary tangent perpendicular
+        to their normal. Runs serially without a thread pool.
+        */
+        static std::vector<glm::vec4> generate(const std::vector<glm::vec3> &vertexPositions,
+                                               const std::vector<glm::vec3> &vertexNormals,
+                                               const std::vector<glm::vec2> &vertexUVs,
+                                               const std::vector<GLuint> &triangleIndices,
+                                               ThreadPool *threadPool = nullptr);
+    };
+}
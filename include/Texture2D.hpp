@@ -3,8 +3,14 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
+#include <vector>
+#include <memory>
+#include <cstddef>
+
 namespace planets
 {
+    class Texture2DArray;
+
     class Texture2D
     {
     public:
@@ -15,12 +21,47 @@ namespace planets
             RGBA8,
             R_FLOAT,
             RGB_FLOAT,
-            RGBA_FLOAT
+            RGBA_FLOAT,
+            // Block-compressed, 4x4 texel blocks
+            BC1, // RGB, 8 bytes per block
+            BC3, // RGBA, 16 bytes per block
+            BC4, // R, 8 bytes per block
+            BC5, // RG, 16 bytes per block
+            BC7  // RGBA, 16 bytes per block
+        };
+
+        struct MipLevel
+        {
+            GLsizei width;
+            GLsizei height;
+            const void *data;
+            size_t size;
         };
 
         Texture2D() = delete;
         Texture2D(GLsizei width, GLsizei height, const void *dataPtr, Texture2D::TextureDataFormat format);
+        /*
+        Uploads a complete mip chain (largest level first). A single uncompressed level gets its mips
+        generated on the GPU, compressed textures are used with exactly the levels that are passed in.
+        */
+        Texture2D(Texture2D::TextureDataFormat format, const std::vector<Texture2D::MipLevel> &mipLevels);
         ~Texture2D();
+
+        /*
+        Exchanges the GL textures and their descriptions, used to hot reload a texture in place
+        */
+        void swap(Texture2D &other) noexcept;
+
+        /*
+        Copies the texture into a layer of the array and replaces its own storage with a view of
+        that layer, so the texture can still be used on its own without taking VRAM twice.
+        */
+        void moveToArray(std::shared_ptr<Texture2DArray> array, GLint layer);
+        /*
+        The array the texture is a layer of, nullptr if it has its own storage
+        */
+        const std::shared_ptr<Texture2DArray> &getArray() const { return m_Array; }
+        GLint getArrayLayer() const { return m_ArrayLayer; }
         
         void bind(GLint unit) const noexcept
         {
@@ -34,8 +75,44 @@ namespace planets
             glBindTexture(GL_TEXTURE_2D, 0);
         }
 
+        GLsizei getWidth() const { return m_Width; }
+        GLsizei getHeight() const { return m_Height; }
+        GLsizei getMipLevelCount() const { return m_MipLevelCount; }
+        GLuint getId() const { return m_TextureId; }
+        Texture2D::TextureDataFormat getFormat() const { return m_Format; }
+        /*
+        Estimated VRAM taken by all mip levels (RGB8 counts as RGBX, the way drivers store it),
+        and what the same levels would take in the uncompressed format the source image would
+        have been uploaded with. Pixels are not kept in system memory after the upload.
+        */
+        size_t getGpuSizeInBytes() const { return m_SizeInBytes; }
+        size_t getUncompressedSizeInBytes() const { return m_UncompressedSizeInBytes; }
+        size_t getCpuSizeInBytes() const { return sizeof(Texture2D); }
+
+        /*
+        Bytes per texel of uncompressed formats, 0 for block-compressed ones
+        */
+        static size_t bytesPerPixel(Texture2D::TextureDataFormat format);
+        static bool isCompressed(Texture2D::TextureDataFormat format);
+        /*
+        Size of one mip level in bytes, partial blocks of compressed formats are rounded up
+        */
+        static size_t levelSize(Texture2D::TextureDataFormat format, GLsizei width, GLsizei height);
+        /*
+        Sized GL internal format, 0 for formats that cannot be uploaded
+        */
+        static GLenum internalFormat(Texture2D::TextureDataFormat format);
 
     private:
         GLuint m_TextureId;
+        GLsizei m_Width;
+        GLsizei m_Height;
+        Texture2D::TextureDataFormat m_Format;
+        GLsizei m_MipLevelCount{1};
+        size_t m_SizeInBytes{0};
+        size_t m_UncompressedSizeInBytes{0};
+
+        std::shared_ptr<Texture2DArray> m_Array;
+        GLint m_ArrayLayer{-1};
     };
-}
\ No newline at end of file
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Texture2D.hpp"
+
+#include <glad/glad.h>
+
+namespace planets
+{
+    /*
+    GL_TEXTURE_2D_ARRAY with immutable storage whose layers are filled from 2D textures of the
+    same size, format and mip count on the GPU. Materials sampling from one array need no
+    texture binds between them, see Texture2D::makeView.
+    */
+    class Texture2DArray
+    {
+    public:
+        Texture2DArray() = delete;
+        Texture2DArray(Texture2D::TextureDataFormat format, GLsizei width, GLsizei height,
+                       GLsizei mipLevelCount, GLsizei layerCount);
+        ~Texture2DArray();
+
+        Texture2DArray(const Texture2DArray &other) = delete;
+        Texture2DArray &operator=(const Texture2DArray &other) = delete;
+
+        /*
+        True if texture has the size, format and mip count of the layers
+        */
+        bool fits(const Texture2D &texture) const;
+        /*
+        Copies all mip levels of texture into a layer, throws if it does not fit
+        */
+        void copyLayer(GLint layer, const Texture2D &texture);
+
+        GLuint getId() const { return m_TextureId; }
+        Texture2D::TextureDataFormat getFormat() const { return m_Format; }
+        GLsizei getWidth() const { return m_Width; }
+        GLsizei getHeight() const { return m_Height; }
+        GLsizei getMipLevelCount() const { return m_MipLevelCount; }
+        GLsizei getLayerCount() const { return m_LayerCount; }
+
+    private:
+        GLuint m_TextureId;
+        Texture2D::TextureDataFormat m_Format;
+        GLsizei m_Width;
+        GLsizei m_Height;
+        GLsizei m_MipLevelCount;
+        GLsizei m_LayerCount;
+    };
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "Texture2D.hpp"
+
+#include <vector>
+
+namespace planets
+{
+    /*
+    CPU encoder for the block-compressed formats Texture2D accepts, used by the
+    asset cooker. Quality is aimed at fast offline cooking (principal axis
+    endpoints with one least squares refinement), not at the best possible PSNR.
+    */
+    class TextureCompressor
+    {
+    public:
+        /*
+        Encodes one mip level of tightly packed 8-bit pixels with 1 to 4 channels.
+        BC4 takes the first channel and BC5 the first two, missing colour channels
+        read as 0 and a missing alpha channel as 255. Throws for uncompressed formats.
+        */
+        static std::vector<unsigned char> compress(Texture2D::TextureDataFormat format,
+                                                   const unsigned char *pixels,
+                                                   int width,
+                                                   int height,
+                                                   int channels);
+    };
+}
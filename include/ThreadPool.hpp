@@ -0,0 +1,63 @@
+#pragma once
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <type_traits>
+
+namespace planets
+{
+    /*
+    Fixed-size pool of worker threads. Threads that wait for parallelFor help
+    executing queued tasks, so parallelFor may also be called from inside a task.
+    */
+    class ThreadPool
+    {
+    public:
+        /*
+        0 threads means one per hardware thread
+        */
+        ThreadPool(size_t numThreads = 0);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool &other) = delete;
+        ThreadPool &operator=(const ThreadPool &other) = delete;
+
+        size_t size() const noexcept { return m_Workers.size(); }
+
+        template <typename F>
+        auto submit(F &&task) -> std::future<std::invoke_result_t<std::decay_t<F>>>
+        {
+            using Result = std::invoke_result_t<std::decay_t<F>>;
+            auto packagedTask = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+            std::future<Result> future = packagedTask->get_future();
+            enqueue([packagedTask]()
+                    { (*packagedTask)(); });
+            return future;
+        }
+
+        /*
+        Splits [begin, end) into ranges of at least grainSize elements and calls
+        rangeFunction(rangeBegin, rangeEnd) for each of them in parallel. Blocks
+        until all ranges are done and rethrows the first exception thrown by any of them.
+        */
+        void parallelFor(size_t begin, size_t end, size_t grainSize,
+                         const std::function<void(size_t, size_t)> &rangeFunction);
+
+    private:
+        std::vector<std::thread> m_Workers;
+        std::queue<std::function<void()>> m_Tasks;
+        std::mutex m_Mutex;
+        std::condition_variable m_Condition;
+        bool m_Stopping{false};
+
+        void enqueue(std::function<void()> task);
+        bool runPendingTask();
+        void workerLoop();
+    };
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+
+namespace planets
+{
+    /*
+    Binding points of the uniform blocks shared by the shaders. ShaderProgram connects blocks
+    with these names to them after linking.
+    */
+    enum UniformBlockBinding : GLuint
+    {
+        FRAME_BLOCK_BINDING = 0,    // "FrameData", updated once per frame by Scene::draw
+        MATERIAL_BLOCK_BINDING = 1, // "MaterialData", one buffer per StandardMaterial
+        OBJECT_BLOCK_BINDING = 2    // "ObjectData", streamed per draw through a UniformRingBuffer
+    };
+
+    /*
+    Contents of the blocks in std140 layout, they must match the declarations in the shaders.
+    A vec3 followed by a scalar shares its 16 bytes with it.
+    */
+    struct FrameBlock
+    {
+        glm::mat4 viewProjection;
+        glm::vec3 cameraWorldPosition;
+        GLfloat time;
+        glm::vec3 cameraDirection;
+        GLfloat padding;
+    };
+    static_assert(sizeof(FrameBlock) == 96, "FrameBlock does not match the std140 layout");
+
+    struct MaterialBlock
+    {
+        glm::vec3 diffuseColor;
+        GLfloat roughness;
+        glm::vec3 emissionColor;
+        GLfloat metalness;
+        GLint materialFlags;
+        // Texture array layer of each map, -1 for plain textures
+        GLint diffuseLayer;
+        GLint roughnessLayer;
+        GLint normalLayer;
+        GLint metalnessLayer;
+        GLint emissionLayer;
+        GLint aoLayer;
+        GLint padding;
+    };
+    static_assert(sizeof(MaterialBlock) == 64, "MaterialBlock does not match the std140 layout");
+
+    struct ObjectBlock
+    {
+        glm::mat4 modelToClipSpace;
+        glm::mat4 modelToWorldSpace;
+        // std140 stores every column of a mat3 like a vec4
+        glm::vec4 modelToWorldSpace_Normal[3];
+        GLint vertexFormat;
+        GLint padding[3];
+    };
+    static_assert(sizeof(ObjectBlock) == 192, "ObjectBlock does not match the std140 layout");
+
+    class UniformBuffer
+    {
+    public:
+        UniformBuffer() = delete;
+        UniformBuffer(GLsizeiptr size);
+        ~UniformBuffer();
+        UniformBuffer(const UniformBuffer &) = delete;
+        UniformBuffer &operator=(const UniformBuffer &) = delete;
+
+        void update(const void *data, GLsizeiptr size) noexcept;
+        void bind(GLuint binding) const noexcept;
+        GLuint getId() const { return m_BufferId; }
+
+    private:
+        GLuint m_BufferId;
+    };
+
+    /*
+    Persistently mapped buffer for blocks that change every draw. Each of FRAMES_IN_FLIGHT
+    regions holds the blocks of one frame, beginFrame waits until the GPU is done with the
+    region it is about to overwrite. If a frame needs more than a region, the GPU is waited
+    for and the region starts over.
+    */
+    class UniformRingBuffer
+    {
+    public:
+        static constexpr int FRAMES_IN_FLIGHT = 3;
+
+        UniformRingBuffer() = delete;
+        UniformRingBuffer(GLsizeiptr regionSize);
+        ~UniformRingBuffer();
+        UniformRingBuffer(const UniformRingBuffer &) = delete;
+        UniformRingBuffer &operator=(const UniformRingBuffer &) = delete;
+
+        void beginFrame();
+        void endFrame();
+        /*
+        Copies the block into the region of the frame and binds the copy
+        */
+        void push(GLuint binding, const void *data, GLsizeiptr size);
+
+    private:
+        GLuint m_BufferId;
+        unsigned char *m_Mapped;
+        GLsizeiptr m_RegionSize;
+        GLsizeiptr m_Alignment;
+        int m_Region{0};
+        GLsizeiptr m_Offset{0};
+        GLsync m_Fences[FRAMES_IN_FLIGHT]{};
+        bool m_OverflowReported{false};
+    };
+}
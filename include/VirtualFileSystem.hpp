@@ -0,0 +1,72 @@
+#pragma once
+
+#include "AssetArchive.hpp"
+#include "ThreadPool.hpp"
+
+#include <string>
+#include <memory>
+#include <cstddef>
+
+namespace planets
+{
+    /*
+    Read-only view of a file's contents. owner keeps the memory alive: the mapping of the
+    archive for uncompressed entries, a decompressed copy, or the mapping of a loose file.
+    */
+    class VfsFile
+    {
+    public:
+        VfsFile() = default;
+        VfsFile(std::shared_ptr<const void> owner, const unsigned char *data, size_t size)
+            : m_Owner(std::move(owner)), m_Data(data), m_Size(size) {}
+
+        const unsigned char *data() const noexcept { return m_Data; }
+        size_t size() const noexcept { return m_Size; }
+        const std::shared_ptr<const void> &getOwner() const noexcept { return m_Owner; }
+
+    private:
+        std::shared_ptr<const void> m_Owner;
+        const unsigned char *m_Data{nullptr};
+        size_t m_Size{0};
+    };
+
+    /*
+    Resolves asset paths relative to the data directory. With an archive mounted, files are
+    read from it and only files missing in it from the data directory (loose files); without
+    one everything is loose. Lookups are thread-safe, mounting is not.
+    */
+    class VirtualFileSystem
+    {
+    public:
+        VirtualFileSystem(const std::string &rootDirectory);
+
+        /*
+        Throws if the archive cannot be read
+        */
+        void mountArchive(const std::string &archivePath);
+        bool hasArchive() const { return m_Archive != nullptr; }
+
+        bool exists(const std::string &path) const;
+        /*
+        True if the file is read from the archive, archived files never change
+        */
+        bool isArchived(const std::string &path) const { return findEntry(path) != nullptr; }
+        /*
+        Maps or decompresses the file, throws std::runtime_error if it does not exist or is corrupt.
+        Compressed archive entries are decompressed on the thread pool if one is given.
+        */
+        VfsFile open(const std::string &path, ThreadPool *threadPool = nullptr) const;
+
+        /*
+        Path of the file in the data directory, whether it exists or not
+        */
+        std::string getLoosePath(const std::string &path) const { return m_RootDirectory + '/' + path; }
+        const std::string &getRootDirectory() const { return m_RootDirectory; }
+
+    private:
+        std::string m_RootDirectory;
+        std::unique_ptr<AssetArchive> m_Archive;
+
+        const AssetArchive::Entry *findEntry(const std::string &path) const;
+    };
+}
@@ -29,6 +29,30 @@
 
 namespace planets
 {
+    namespace
+    {
+        bool parseResidency(const char *value, StaticMesh::Residency &residency)
+        {
+            if (strcmp(value, "Keep") == 0)
+            {
+                residency = StaticMesh::Residency::Keep;
+            }
+            else if (strcmp(value, "PositionsOnly") == 0)
+            {
+                residency = StaticMesh::Residency::PositionsOnly;
+            }
+            else if (strcmp(value, "Discard") == 0)
+            {
+                residency = StaticMesh::Residency::Discard;
+            }
+            else
+            {
+                return false;
+            }
+            return true;
+        }
+    }
+
     Application::Application(int argc, char *argv[], const std::string &configPath)
     {
         (void)argc;
@@ -38,7 +62,15 @@ namespace planets
         initPlatform();
         initImGui();
         
-        m_ResourceManager = std::make_unique<ResourceManager>(m_DataDirectory);
+        // Before the first program is created, the resource manager compiles the Standard shader
+        ShaderProgram::setBinaryCacheDirectory(m_ShaderCacheDirectory);
+        m_ResourceManager = std::make_unique<ResourceManager>(m_DataDirectory, m_DataArchive);
+        m_ResourceManager->setTextureArraysEnabled(m_RenderParams.textureArrays);
+        m_ResourceManager->setShaderVariantsEnabled(m_RenderParams.shaderVariants);
+        if (m_DebugParams.hotReload)
+        {
+            m_ResourceManager->watchDataDirectory();
+        }
 
         initScene();
     }
@@ -141,6 +173,113 @@ namespace planets
         {
             m_DataDirectory = pv;
         }
+
+        // Optional, loose files from the data directory are used without an archive
+        m_DataArchive = ini.GetValue("Application", "DataArchive", "");
+        // Optional, without it every program is compiled from source on every launch
+        m_ShaderCacheDirectory = ini.GetValue("Application", "ShaderCacheDirectory", "");
+
+        pv = ini.GetValue("Application", "HotReload", "");
+        if (strcmp(pv, "True") == 0)
+        {
+            m_DebugParams.hotReload = true;
+        }
+        else if (strcmp(pv, "False") == 0)
+        {
+            m_DebugParams.hotReload = false;
+        }
+        else
+        {
+            spdlog::warn("Config: hot reload not defined. Default value of False will be used.");
+        }
+
+        pv = ini.GetValue("Rendering", "VertexFormat", "");
+        if (strcmp(pv, "Packed") == 0)
+        {
+            m_RenderParams.vertexFormat = StaticMesh::VertexFormat::Packed;
+        }
+        else if (strcmp(pv, "Float") == 0)
+        {
+            m_RenderParams.vertexFormat = StaticMesh::VertexFormat::Float;
+        }
+        else
+        {
+            spdlog::warn("Config: vertex format not defined. Default value of Packed will be used.");
+        }
+
+        pv = ini.GetValue("Rendering", "UploadBudgetMs", "");
+        double budget = strtod(pv, &end);
+        if (strlen(pv) == 0 || *end != '\0' || budget <= 0.0)
+        {
+            spdlog::warn("Config: upload budget not defined. Default value of 4 ms will be used.");
+        }
+        else
+        {
+            m_RenderParams.uploadBudgetMs = budget;
+        }
+
+        pv = ini.GetValue("Rendering", "TextureArrays", "");
+        if (strcmp(pv, "True") == 0)
+        {
+            m_RenderParams.textureArrays = true;
+        }
+        else if (strcmp(pv, "False") == 0)
+        {
+            m_RenderParams.textureArrays = false;
+        }
+        else
+        {
+            spdlog::warn("Config: texture arrays not defined. Default value of True will be used.");
+        }
+
+        pv = ini.GetValue("Rendering", "LazyLoading", "");
+        if (strcmp(pv, "True") == 0)
+        {
+            m_RenderParams.lazyLoading = true;
+        }
+        else if (strcmp(pv, "False") == 0)
+        {
+            m_RenderParams.lazyLoading = false;
+        }
+        else
+        {
+            spdlog::warn("Config: lazy loading not defined. Default value of True will be used.");
+        }
+
+        pv = ini.GetValue("Rendering", "ShaderVariants", "");
+        if (strcmp(pv, "True") == 0)
+        {
+            m_RenderParams.shaderVariants = true;
+        }
+        else if (strcmp(pv, "False") == 0)
+        {
+            m_RenderParams.shaderVariants = false;
+        }
+        else
+        {
+            spdlog::warn("Config: shader variants not defined. Default value of True will be used.");
+        }
+
+        pv = ini.GetValue("Rendering", "MeshResidency", "");
+        if (!parseResidency(pv, m_RenderParams.meshResidency))
+        {
+            spdlog::warn("Config: mesh residency not defined. Default value of Keep will be used.");
+        }
+
+        CSimpleIniA::TNamesDepend meshNames;
+        ini.GetAllKeys("MeshResidency", meshNames);
+        for (const auto &key : meshNames)
+        {
+            StaticMesh::Residency residency;
+            if (parseResidency(ini.GetValue("MeshResidency", key.pItem, ""), residency))
+            {
+                m_RenderParams.meshResidencyOverrides[key.pItem] = residency;
+            }
+            else
+            {
+                spdlog::warn("Config: invalid residency of mesh \"{}\" will be ignored.", key.pItem);
+            }
+        }
     }
 
     void Application::loop()
@@ -152,6 +291,8 @@ namespace planets
 
             m_ApplicationTimings.update(glfwGetTime());
 
+            updateLoading();
+
             // Cursor pos
             double xpos, ypos;
             glfwGetCursorPos(m_Window, &xpos, &ypos);
@@ -211,34 +352,63 @@ namespace planets
 
 
             
-            auto suzanne = m_CurrentScene->getRoot()->getChild("Suzanne");
-            
-            auto sRot = suzanne->getLocalRotation();
-            sRot.y += 0.005f;
-            sRot.x += 0.0005f;
-            suzanne->setLocalRotation(sRot);
+            // Suzanne is only in the scene once its asynchronous load has finished
+            if (m_CurrentScene->getRoot()->hasChild("Suzanne"))
+            {
+                auto suzanne = m_CurrentScene->getRoot()->getChild("Suzanne");
 
-            auto sPos = suzanne->getLocalPosition();
-            sPos.y = 3.f + std::sin(m_ApplicationTimings.lastTime);
-            suzanne->setLocalPosition(sPos);
+                auto sRot = suzanne->getLocalRotation();
+                sRot.y += 0.005f;
+                sRot.x += 0.0005f;
+                suzanne->setLocalRotation(sRot);
 
-            auto suzanne1 = suzanne->getChild("Suzanne1");
+                auto sPos = suzanne->getLocalPosition();
+                sPos.y = 3.f + std::sin(m_ApplicationTimings.lastTime);
+                suzanne->setLocalPosition(sPos);
 
-            auto sRot1 = suzanne1->getLocalRotation();
-            sRot1.x += 0.01f;
-            suzanne1->setLocalRotation(sRot1);
+                auto suzanne1 = suzanne->getChild("Suzanne1");
 
-            auto suzanne2 = suzanne1->getChild("Suzanne2");
+                auto sRot1 = suzanne1->getLocalRotation();
+                sRot1.x += 0.01f;
+                suzanne1->setLocalRotation(sRot1);
 
-            auto sRot2 = suzanne2->getLocalRotation();
-            sRot2.z += 0.01f;
-            suzanne2->setLocalRotation(sRot2);
+                auto suzanne2 = suzanne1->getChild("Suzanne2");
+
+                auto sRot2 = suzanne2->getLocalRotation();
+                sRot2.z += 0.01f;
+                suzanne2->setLocalRotation(sRot2);
+            }
             
 
             draw(m_ApplicationTimings.currentDelta);
 
             glfwSwapBuffers(m_Window);
             glfwPollEvents();
+
+            if (!m_LoadingState.firstFrameDrawn)
+            {
+                m_LoadingState.firstFrameDrawn = true;
+                spdlog::info("First frame presented {:.1f} ms after the scene started loading",
+                             (glfwGetTime() - m_LoadingState.startTime) * 1000.0);
+            }
+        }
+    }
+
+    void Application::updateLoading()
+    {
+        m_ResourceManager->reloadChangedResources();
+        m_ResourceManager->processUploads(m_RenderParams.uploadBudgetMs);
+
+        // With lazy loading nothing is requested before the first frame draws the scene
+        if (!m_LoadingState.finished && m_LoadingState.firstFrameDrawn &&
+            !m_ResourceManager->getLoadingProgress().isLoading())
+        {
+            m_LoadingState.finished = true;
+            spdlog::info("Scene loaded in {:.1f} ms", (glfwGetTime() - m_LoadingState.startTime) * 1000.0);
+            ShaderProgram::SetupStats shaderStats = ShaderProgram::getSetupStats();
+            spdlog::info("Set up {} shader programs in {:.1f} ms, {} from the binary cache",
+                         shaderStats.programs, shaderStats.milliseconds, shaderStats.fromCache);
+            m_ResourceManager->logTextureMemoryUsage();
         }
     }
 
@@ -247,7 +417,7 @@ namespace planets
         (void)deltaTime;
 
         // Draw scene
-        m_CurrentScene->draw(m_WindowParams.windowWidth, m_WindowParams.windowHeight);
+        m_CurrentScene->draw(m_WindowParams.windowWidth, m_WindowParams.windowHeight, *m_ResourceManager);
 
         // Draw (debug) GUI
         drawImGui();
@@ -33,76 +33,123 @@ namespace planets
 
     void Application::initScene()
     {
+        m_LoadingState.startTime = glfwGetTime();
         std::unique_ptr<Scene> scene = std::make_unique<Scene>();
+        // Owned by m_CurrentScene once this returns, the load callbacks run later from loop()
+        Scene *scenePtr = scene.get();
 
         // Load resources
         auto defaultShader = m_ResourceManager->loadShaderProgram("default",
                                                                   "shaders/test_vert.glsl",
-                                                                  "shaders/test_frag.glsl");
+                                                                  "shaders/test_frag.glsl",
+                                                                  ShaderProgram::CompileMode::Deferred);
         auto testMaterial = m_ResourceManager->createMaterial("test", defaultShader);
 
-        auto tex = m_ResourceManager->loadTexture2DFromPNG("Bricks", "textures/red_brick_03_diff_2k.png");
-        auto texN = m_ResourceManager->loadTexture2DFromPNG("BricksNRM", "textures/red_brick_03_nor_gl_2k.png");
+        // Deferred, the 2k PNGs are only decoded once something drawn uses the material
+        auto tex = m_ResourceManager->requestTexture2D("Bricks", "textures/red_brick_03_diff_2k.png");
+        auto texN = m_ResourceManager->requestTexture2D("BricksNRM", "textures/red_brick_03_nor_gl_2k.png");
 
         auto brickMat = m_ResourceManager->createStandardMaterial("BricksMat", 0);
-        //(std::dynamic_pointer_cast<StandardMaterial>(brickMat))->setDiffuseMap(tex);
-        //(std::dynamic_pointer_cast<StandardMaterial>(brickMat))->setNormalMap(texN);
+        (std::dynamic_pointer_cast<StandardMaterial>(brickMat))->setDiffuseMap(tex);
+        (std::dynamic_pointer_cast<StandardMaterial>(brickMat))->setNormalMap(texN);
         (std::dynamic_pointer_cast<StandardMaterial>(brickMat))->setDiffuseColor({0.5, 0.5, 0.5});
         (std::dynamic_pointer_cast<StandardMaterial>(brickMat))->setRoughness(0.1);
 
-
-        size_t counter{0};
-        auto SponzaMeshes = m_ResourceManager->loadStaticMesh("Sponza", "models/sponza_separated.obj");
-        for (auto &[mesh, material] : SponzaMeshes)
+        if (m_RenderParams.lazyLoading)
         {
-            mesh->uploadToGPU();
-            scene->addObject(std::make_shared<StaticMeshInstance>("Sponza." + std::to_string(counter++),
-                                                                  scene->getRoot(),
-                                                                  mesh,
-                                                                  material));
-        }
-
-       
-
-        auto BarrelMeshes = m_ResourceManager->loadStaticMesh("Barrel", "models/Barrel.obj");
-        for (auto &[mesh, material] : BarrelMeshes)
-        {
-            mesh->uploadToGPU();
-            auto barrel = scene->addObject(std::make_shared<StaticMeshInstance>("Barrel" + std::to_string(counter++),
-                                                                             scene->getRoot(),
-                                                                             mesh,
-                                                                             material));
+            // Models are only loaded once their instances get drawn
+            auto requestModel = [this](const std::string &name, const std::string &objPath)
+            {
+                return m_ResourceManager->requestStaticModel(name, objPath, m_RenderParams.vertexFormat,
+                                                             m_RenderParams.residencyFor(name));
+            };
+
+            scene->addObject(std::make_shared<StaticMeshInstance>("Sponza", scene->getRoot(),
+                                                                  requestModel("Sponza", "models/sponza_separated.obj")));
+
+            auto barrel = scene->addObject(std::make_shared<StaticMeshInstance>("Barrel", scene->getRoot(),
+                                                                                requestModel("Barrel", "models/Barrel.obj")));
             barrel->setLocalPosition({4, 1, 0});
-        }
-
 
-         auto suzanneMeshes = m_ResourceManager->loadStaticMesh("Suzanne",
-                                                               "models/Suzanne.obj");
-        // Add Suzanne
-        for (auto &[mesh, material] : suzanneMeshes)
-        {
-            mesh->uploadToGPU();
-            auto suzanne = scene->addObject(std::make_shared<StaticMeshInstance>("Suzanne",
-                                                                                 scene->getRoot(),
-                                                                                 mesh,
-                                                                                 material));
+            auto suzanneModel = requestModel("Suzanne", "models/Suzanne.obj");
+            auto suzanne = scene->addObject(std::make_shared<StaticMeshInstance>("Suzanne", scene->getRoot(), suzanneModel));
             suzanne->setLocalPosition({0, 2, 0});
             suzanne->setLocalScale({1, 1, 1});
 
-            auto suzanne1 = suzanne->addChild(std::make_shared<StaticMeshInstance>("Suzanne1",
-                                                                                   suzanne,
-                                                                                   mesh,
-                                                                                   material));
+            auto suzanne1 = suzanne->addChild(std::make_shared<StaticMeshInstance>("Suzanne1", suzanne, suzanneModel));
             suzanne1->setLocalPosition({2, 0, 0});
             suzanne1->setLocalScale({0.7, 0.7, 0.7});
 
-            auto suzanne2 = suzanne1->addChild(std::make_shared<StaticMeshInstance>("Suzanne2",
-                                                                                    suzanne1,
-                                                                                    mesh,
-                                                                                    material));
+            auto suzanne2 = suzanne1->addChild(std::make_shared<StaticMeshInstance>("Suzanne2", suzanne1, suzanneModel));
             suzanne2->setLocalPosition({0, 2, 0});
             suzanne2->setLocalScale({0.7, 0.7, 0.7});
         }
+        else
+        {
+            // Meshes load in the background and are added to the scene as they become ready
+            m_ResourceManager->loadStaticMeshAsync("Sponza", "models/sponza_separated.obj", m_RenderParams.vertexFormat, m_RenderParams.residencyFor("Sponza"),
+                                                   [scenePtr](ResourceManager::LoadedStaticMeshes &SponzaMeshes)
+                                                   {
+                                                       size_t counter{0};
+                                                       for (auto &[mesh, material] : SponzaMeshes)
+                                                       {
+                                                           scenePtr->addObject(std::make_shared<StaticMeshInstance>("Sponza." + std::to_string(counter++),
+                                                                                                                    scenePtr->getRoot(),
+                                                                                                                    mesh,
+                                                                                                                    material));
+                                                       }
+                                                   });
+
+            m_ResourceManager->loadStaticMeshAsync("Barrel", "models/Barrel.obj", m_RenderParams.vertexFormat, m_RenderParams.residencyFor("Barrel"),
+                                                   [scenePtr](ResourceManager::LoadedStaticMeshes &BarrelMeshes)
+                                                   {
+                                                       size_t counter{0};
+                                                       for (auto &[mesh, material] : BarrelMeshes)
+                                                       {
+                                                           auto barrel = scenePtr->addObject(std::make_shared<StaticMeshInstance>("Barrel" + std::to_string(counter++),
+                                                                                                                                  scenePtr->getRoot(),
+                                                                                                                                  mesh,
+                                                                                                                                  material));
+                                                           barrel->setLocalPosition({4, 1, 0});
+                                                       }
+                                                   });
+
+            m_ResourceManager->loadStaticMeshAsync("Suzanne", "models/Suzanne.obj", m_RenderParams.vertexFormat, m_RenderParams.residencyFor("Suzanne"),
+                                                   [scenePtr](ResourceManager::LoadedStaticMeshes &suzanneMeshes)
+                                                   {
+                                                       // Add Suzanne
+                                                       for (auto &[mesh, material] : suzanneMeshes)
+                                                       {
+                                                           auto suzanne = scenePtr->addObject(std::make_shared<StaticMeshInstance>("Suzanne",
+                                                                                                                                   scenePtr->getRoot(),
+                                                                                                                                   mesh,
+                                                                                                                                   material));
+                                                           suzanne->setLocalPosition({0, 2, 0});
+                                                           suzanne->setLocalScale({1, 1, 1});
+
+                                                           auto suzanne1 = suzanne->addChild(std::make_shared<StaticMeshInstance>("Suzanne1",
+                                                                                                                                  suzanne,
+                                                                                                                                  mesh,
+                                                                                                                                  material));
+                                                           suzanne1->setLocalPosition({2, 0, 0});
+                                                           suzanne1->setLocalScale({0.7, 0.7, 0.7});
+
+                                                           auto suzanne2 = suzanne1->addChild(std::make_shared<StaticMeshInstance>("Suzanne2",
+                                                                                                                                   suzanne1,
+                                                                                                                                   mesh,
+                                                                                                                                   material));
+                                                           suzanne2->setLocalPosition({0, 2, 0});
+                                                           suzanne2->setLocalScale({0.7, 0.7, 0.7});
+                                                       }
+                                                   });
+        }
+
+        // Drawn straight from the binary chunk of the mapped GLB
+        for (auto &[mesh, material] : m_ResourceManager->loadGltfModel("Cube", "models/cube.glb", m_RenderParams.vertexFormat))
+        {
+            auto cube = scene->addObject(std::make_shared<StaticMeshInstance>("Cube", scene->getRoot(), mesh, material));
+            cube->setLocalPosition({-4, 1, 0});
+        }
 
         /*
         auto suzanne1 = suzanne->addChild(std::make_shared<StaticMeshInstance>("Suzanne1",
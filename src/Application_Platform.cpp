@@ -17,6 +17,7 @@
 
 #include <cstdlib>
 #include <cstring>
+#include <algorithm>
 
 namespace planets
 {
@@ -94,7 +95,7 @@ namespace planets
         ImGui_ImplOpenGL3_Init(glsl_version);
     }
 
-    void Application::drawDebugTree(std::shared_ptr<SpatialObject> node)
+    void Application::drawDebugTree(const std::shared_ptr<SpatialObject> &node)
     {
         ImGui::SetNextItemOpen(true);
         if (ImGui::TreeNode(node->getName().c_str()))
@@ -109,10 +110,9 @@ namespace planets
             ImGui::Text("Scale: %.1f %.1f %.1f", localScale.x, localScale.y, localScale.z);
             ImGui::PopStyleColor();
 
-            auto children = node->getChildren();
-            for (auto it = children.begin(); it != children.end(); it++)
+            for (const auto &child : node->getChildren())
             {
-                drawDebugTree(it->second);
+                drawDebugTree(child);
             }
             ImGui::TreePop();
         }
@@ -137,12 +137,13 @@ namespace planets
 
         if (ImGui::Button("Spawn"))
         {
-            auto mtl = m_ResourceManager->createStandardMaterial("NewSuzanne" + std::to_string(count++), 0);
+            std::string name = "NewSuzanne" + std::to_string(count++);
+            auto mtl = m_ResourceManager->createStandardMaterial(name, 0);
             (std::dynamic_pointer_cast<StandardMaterial>(mtl))->setDiffuseColor(color);
-            auto suzanne = m_CurrentScene->addObject(std::make_shared<StaticMeshInstance>("NewSuzanne" + std::to_string(count++),
+            auto suzanne = m_CurrentScene->addObject(std::make_shared<StaticMeshInstance>(name,
                                                                                           m_CurrentScene->getRoot(),
-                                                                                          m_ResourceManager->getStaticMesh("Suzanne.Suzanne"),
-                                                                                          mtl));
+                                                                                          m_ResourceManager->getStaticMeshHandle("Suzanne.Suzanne"),
+                                                                                          m_ResourceManager->getMaterialHandle(name)));
             suzanne->setLocalPosition(pos);
         }
 
@@ -171,6 +172,39 @@ namespace planets
         ImGui::End();
     }
 
+    void Application::drawLoadingScreen()
+    {
+        ResourceManager::LoadingProgress progress = m_ResourceManager->getLoadingProgress();
+
+        // Finished loads count fully, the one being uploaded by the share of its uploads that are done
+        float fraction = static_cast<float>(progress.completed);
+        if (progress.uploadsTotal > 0)
+        {
+            fraction += static_cast<float>(progress.uploadsDone) / static_cast<float>(progress.uploadsTotal);
+        }
+        fraction /= static_cast<float>(std::max<size_t>(progress.requested, 1));
+
+        ImGui::SetNextWindowPos(ImVec2(m_WindowParams.windowWidth * 0.5f, m_WindowParams.windowHeight * 0.5f),
+                                ImGuiCond_Always, ImVec2(0.5f, 0.5f));
+        ImGui::SetNextWindowSize(ImVec2(400, 0));
+        ImGui::Begin("Loading", NULL, ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoCollapse);
+        ImGui::Text("Loaded %zu of %zu assets", progress.completed, progress.requested);
+        if (!progress.uploading.empty())
+        {
+            ImGui::Text("Uploading \"%s\" (%zu/%zu)", progress.uploading.c_str(), progress.uploadsDone, progress.uploadsTotal);
+        }
+        else if (progress.completed < progress.requested)
+        {
+            ImGui::Text("Importing...");
+        }
+        if (progress.compilingShaders > 0)
+        {
+            ImGui::Text("Compiling %zu shader programs", progress.compilingShaders);
+        }
+        ImGui::ProgressBar(fraction, ImVec2(-1.0f, 0.0f));
+        ImGui::End();
+    }
+
     void Application::drawImGui()
     {
         ImGui_ImplOpenGL3_NewFrame();
@@ -188,6 +222,9 @@ namespace planets
         ImGui::Text("Static meshes: %d", m_CurrentScene->drawStats.staticMeshes);
         ImGui::Text("Lights: %d", m_CurrentScene->drawStats.lights);
         ImGui::Text("Draw calls: %d", m_CurrentScene->drawStats.drawCalls);
+        ImGui::Text("Triangles: %d", m_CurrentScene->drawStats.triangles);
+        ImGui::Text("Texture binds: %d", m_CurrentScene->drawStats.textureBinds);
+        ImGui::SliderFloat("LOD bias", &m_CurrentScene->lodBias, -2.0f, 4.0f, "%.1f");
         if (ImGui::Button("Reload Standard shader"))
         {
             try
@@ -198,6 +235,24 @@ namespace planets
             {
             }
         }
+        if (ImGui::CollapsingHeader("Memory"))
+        {
+            ResourceManager::MemoryReport report = m_ResourceManager->getMemoryReport();
+            auto memoryLine = [](const char *label, const ResourceManager::MemoryUsage &usage)
+            {
+                ImGui::Text("%s: %zu, CPU %.2f MB, GPU %.2f MB", label, usage.count,
+                            usage.cpuBytes / (1024.0 * 1024.0), usage.gpuBytes / (1024.0 * 1024.0));
+            };
+            memoryLine("Shader programs", report.shaderPrograms);
+            memoryLine("Materials", report.materials);
+            memoryLine("Textures", report.textures2D);
+            memoryLine("Static meshes", report.staticMeshes);
+            memoryLine("Total", report.total());
+            if (ImGui::Button("Dump memory report"))
+            {
+                m_ResourceManager->writeMemoryReport("memory_report.json");
+            }
+        }
         ImGui::End();
 
         if (m_DebugParams.debugConsoleActive)
@@ -205,6 +260,11 @@ namespace planets
             drawDebugConsole();
         }
 
+        if (m_ResourceManager->getLoadingProgress().isLoading())
+        {
+            drawLoadingScreen();
+        }
+
         ImGui::Render();
 
         glViewport(0, 0, m_WindowParams.windowWidth, m_WindowParams.windowHeight);
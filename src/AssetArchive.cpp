@@ -0,0 +1,315 @@
+#include "AssetArchive.hpp"
+#include "Lz4.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <atomic>
+#include <cstring>
+
+namespace planets
+{
+    namespace
+    {
+        struct ArchiveHeader
+        {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t entryCount;
+            uint32_t reserved;
+            uint64_t tocOffset;
+            uint64_t tocSize;
+        };
+
+        // Follows the path of every entry in the table of contents
+        struct TocRecord
+        {
+            uint64_t offset;
+            uint64_t size;
+            uint64_t storedSize;
+            uint32_t compression;
+            uint32_t reserved;
+        };
+
+        size_t alignUp(size_t value, size_t alignment)
+        {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+        size_t blockCountFor(uint64_t size)
+        {
+            return static_cast<size_t>((size + AssetArchive::BLOCK_SIZE - 1) / AssetArchive::BLOCK_SIZE);
+        }
+
+        [[noreturn]] void fail(const std::string &path, const char *message)
+        {
+            spdlog::error("Asset archive \"{}\": {}", path, message);
+            throw std::runtime_error(message);
+        }
+
+        // Compressed blocks of a file, blocks that did not get smaller stay empty and are stored as they are
+        struct PackedFile
+        {
+            std::vector<std::vector<unsigned char>> blocks;
+            uint64_t storedSize{0};
+        };
+
+        PackedFile compressBlocks(const unsigned char *data, size_t size, ThreadPool &threadPool)
+        {
+            PackedFile packed;
+            packed.blocks.resize(blockCountFor(size));
+            threadPool.parallelFor(0, packed.blocks.size(), 1, [&](size_t begin, size_t end)
+                                   {
+                                       for (size_t i = begin; i < end; i++)
+                                       {
+                                           size_t blockOffset = i * AssetArchive::BLOCK_SIZE;
+                                           size_t blockSize = std::min(AssetArchive::BLOCK_SIZE, size - blockOffset);
+                                           std::vector<unsigned char> compressed = Lz4::compress(data + blockOffset, blockSize);
+                                           if (compressed.size() < blockSize)
+                                           {
+                                               packed.blocks[i] = std::move(compressed);
+                                           }
+                                       } });
+
+            packed.storedSize = packed.blocks.size() * sizeof(uint32_t);
+            for (size_t i = 0; i < packed.blocks.size(); i++)
+            {
+                size_t blockSize = std::min(AssetArchive::BLOCK_SIZE, size - i * AssetArchive::BLOCK_SIZE);
+                packed.storedSize += packed.blocks[i].empty() ? blockSize : packed.blocks[i].size();
+            }
+            return packed;
+        }
+    }
+
+    AssetArchive::AssetArchive(const std::string &path) : m_Path(path), m_File(std::make_shared<MappedFile>(path))
+    {
+        const unsigned char *data = m_File->data();
+        size_t size = m_File->size();
+
+        ArchiveHeader header;
+        if (size < sizeof(ArchiveHeader))
+        {
+            fail(path, "Archive is truncated");
+        }
+        std::memcpy(&header, data, sizeof(ArchiveHeader));
+        if (header.magic != MAGIC || header.version != VERSION)
+        {
+            fail(path, "Archive has an incompatible version");
+        }
+        if (header.tocOffset > size || header.tocSize > size - header.tocOffset)
+        {
+            fail(path, "Table of contents is out of range");
+        }
+
+        const unsigned char *toc = data + header.tocOffset;
+        size_t tocOffset = 0;
+        m_Entries.resize(header.entryCount);
+        for (auto &entry : m_Entries)
+        {
+            uint32_t pathLength;
+            if (header.tocSize - tocOffset < sizeof(uint32_t))
+            {
+                fail(path, "Table of contents is truncated");
+            }
+            std::memcpy(&pathLength, toc + tocOffset, sizeof(uint32_t));
+            tocOffset += sizeof(uint32_t);
+            if (header.tocSize - tocOffset < pathLength + sizeof(TocRecord))
+            {
+                fail(path, "Table of contents is truncated");
+            }
+            entry.path.assign(reinterpret_cast<const char *>(toc + tocOffset), pathLength);
+            tocOffset += pathLength;
+
+            TocRecord record;
+            std::memcpy(&record, toc + tocOffset, sizeof(TocRecord));
+            tocOffset += sizeof(TocRecord);
+
+            if (record.offset > size || record.storedSize > size - record.offset)
+            {
+                fail(path, "Entry is out of range");
+            }
+            if (record.compression > static_cast<uint32_t>(Compression::Lz4) ||
+                (record.compression == static_cast<uint32_t>(Compression::None) && record.storedSize != record.size))
+            {
+                fail(path, "Entry has an unknown compression");
+            }
+            entry.offset = record.offset;
+            entry.size = record.size;
+            entry.storedSize = record.storedSize;
+            entry.compression = static_cast<Compression>(record.compression);
+
+            m_EntryIndices[entry.path] = static_cast<size_t>(&entry - m_Entries.data());
+        }
+    }
+
+    const AssetArchive::Entry *AssetArchive::find(const std::string &path) const
+    {
+        auto it = m_EntryIndices.find(path);
+        return it == m_EntryIndices.end() ? nullptr : &m_Entries[it->second];
+    }
+
+    bool AssetArchive::decompress(const Entry &entry, unsigned char *decompressed, ThreadPool *threadPool) const
+    {
+        const unsigned char *stored = getStoredData(entry);
+        if (entry.compression == Compression::None)
+        {
+            std::memcpy(decompressed, stored, entry.size);
+            return true;
+        }
+
+        size_t blockCount = blockCountFor(entry.size);
+        if (entry.storedSize < blockCount * sizeof(uint32_t))
+        {
+            return false;
+        }
+
+        // Blocks follow each other, their offsets come from the size table
+        std::vector<uint64_t> blockOffsets(blockCount + 1);
+        blockOffsets[0] = blockCount * sizeof(uint32_t);
+        for (size_t i = 0; i < blockCount; i++)
+        {
+            uint32_t storedBlockSize;
+            std::memcpy(&storedBlockSize, stored + i * sizeof(uint32_t), sizeof(uint32_t));
+            blockOffsets[i + 1] = blockOffsets[i] + storedBlockSize;
+        }
+        if (blockOffsets[blockCount] != entry.storedSize)
+        {
+            return false;
+        }
+
+        std::atomic<bool> valid{true};
+        auto decompressBlocks = [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end && valid; i++)
+            {
+                size_t blockSize = std::min<uint64_t>(BLOCK_SIZE, entry.size - i * BLOCK_SIZE);
+                size_t storedBlockSize = blockOffsets[i + 1] - blockOffsets[i];
+                unsigned char *out = decompressed + i * BLOCK_SIZE;
+                if (storedBlockSize == blockSize)
+                {
+                    std::memcpy(out, stored + blockOffsets[i], blockSize);
+                }
+                else if (!Lz4::decompress(stored + blockOffsets[i], storedBlockSize, out, blockSize))
+                {
+                    valid = false;
+                }
+            }
+        };
+        if (threadPool != nullptr && blockCount > 1)
+        {
+            threadPool->parallelFor(0, blockCount, 1, decompressBlocks);
+        }
+        else
+        {
+            decompressBlocks(0, blockCount);
+        }
+        return valid;
+    }
+
+    bool AssetArchive::write(const std::string &path, const std::vector<SourceFile> &files,
+                             ThreadPool &threadPool, double minSaving)
+    {
+        std::error_code ec;
+        std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+
+        std::ofstream stream(path, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!stream.is_open())
+        {
+            spdlog::error("Unable to create asset archive \"{}\"", path);
+            return false;
+        }
+
+        static const char zeros[ENTRY_ALIGNMENT]{};
+        ArchiveHeader header{MAGIC, VERSION, static_cast<uint32_t>(files.size()), 0, 0, 0};
+        stream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        size_t written = sizeof(header);
+
+        std::vector<Entry> entries;
+        for (const auto &file : files)
+        {
+            Entry entry;
+            entry.path = file.path;
+            try
+            {
+                MappedFile source(file.fullPath);
+                entry.size = source.size();
+
+                PackedFile packed;
+                if (file.compress && source.size() > 0)
+                {
+                    packed = compressBlocks(source.data(), source.size(), threadPool);
+                    if (packed.storedSize <= source.size() * (1.0 - minSaving))
+                    {
+                        entry.compression = Compression::Lz4;
+                    }
+                }
+
+                stream.write(zeros, alignUp(written, ENTRY_ALIGNMENT) - written);
+                written = alignUp(written, ENTRY_ALIGNMENT);
+                entry.offset = written;
+
+                if (entry.compression == Compression::Lz4)
+                {
+                    for (size_t i = 0; i < packed.blocks.size(); i++)
+                    {
+                        size_t blockSize = std::min(BLOCK_SIZE, source.size() - i * BLOCK_SIZE);
+                        uint32_t storedBlockSize = static_cast<uint32_t>(packed.blocks[i].empty() ? blockSize : packed.blocks[i].size());
+                        stream.write(reinterpret_cast<const char *>(&storedBlockSize), sizeof(uint32_t));
+                    }
+                    for (size_t i = 0; i < packed.blocks.size(); i++)
+                    {
+                        if (packed.blocks[i].empty())
+                        {
+                            size_t blockSize = std::min(BLOCK_SIZE, source.size() - i * BLOCK_SIZE);
+                            stream.write(reinterpret_cast<const char *>(source.data() + i * BLOCK_SIZE), blockSize);
+                        }
+                        else
+                        {
+                            stream.write(reinterpret_cast<const char *>(packed.blocks[i].data()), packed.blocks[i].size());
+                        }
+                    }
+                    entry.storedSize = packed.storedSize;
+                }
+                else
+                {
+                    stream.write(reinterpret_cast<const char *>(source.data()), source.size());
+                    entry.storedSize = source.size();
+                }
+                written += entry.storedSize;
+            }
+            catch (std::exception &e)
+            {
+                spdlog::error("Unable to pack \"{}\" into asset archive \"{}\": {}", file.fullPath, path, e.what());
+                return false;
+            }
+
+            spdlog::trace("Packed \"{}\": {} -> {} bytes", entry.path, entry.size, entry.storedSize);
+            entries.push_back(std::move(entry));
+        }
+
+        header.tocOffset = written;
+        for (const auto &entry : entries)
+        {
+            uint32_t pathLength = static_cast<uint32_t>(entry.path.size());
+            TocRecord record{entry.offset, entry.size, entry.storedSize, static_cast<uint32_t>(entry.compression), 0};
+            stream.write(reinterpret_cast<const char *>(&pathLength), sizeof(uint32_t));
+            stream.write(entry.path.data(), entry.path.size());
+            stream.write(reinterpret_cast<const char *>(&record), sizeof(TocRecord));
+            header.tocSize += sizeof(uint32_t) + entry.path.size() + sizeof(TocRecord);
+        }
+
+        // Now that the table of contents has been placed
+        stream.seekp(0);
+        stream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+        stream.close();
+        if (stream.fail())
+        {
+            spdlog::error("Unable to write asset archive \"{}\"", path);
+            return false;
+        }
+        return true;
+    }
+}
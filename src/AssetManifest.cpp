@@ -0,0 +1,122 @@
+#include "AssetManifest.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <fstream>
+#include <sstream>
+
+namespace planets
+{
+    namespace
+    {
+        // Source paths are used as keys, "textures//a.png" and "textures/a.png" are the same file
+        std::string normalizePath(const std::string &path)
+        {
+            std::string normalized;
+            for (char c : path)
+            {
+                if (c == '/' && !normalized.empty() && normalized.back() == '/')
+                {
+                    continue;
+                }
+                normalized.push_back(c);
+            }
+            size_t start = 0;
+            while (normalized.compare(start, 2, "./") == 0)
+            {
+                start += 2;
+            }
+            while (start < normalized.size() && normalized[start] == '/')
+            {
+                start++;
+            }
+            return normalized.substr(start);
+        }
+    }
+
+    bool AssetManifest::load(const std::string &path)
+    {
+        std::ifstream file(path, std::ios::in);
+        if (!file.is_open())
+        {
+            return false;
+        }
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        std::string text = buffer.str();
+        return load(text.data(), text.size(), path);
+    }
+
+    bool AssetManifest::load(const char *data, size_t length, const std::string &label)
+    {
+        std::istringstream stream(std::string(data, length));
+        std::string line;
+        size_t lineNumber = 0;
+        while (std::getline(stream, line))
+        {
+            lineNumber++;
+            if (line.empty() || line[0] == '#')
+            {
+                continue;
+            }
+
+            std::istringstream lineStream(line);
+            std::string kind, sourcePath, cookedPath;
+            if (!(lineStream >> kind >> sourcePath >> cookedPath))
+            {
+                spdlog::warn("Asset manifest \"{}\": malformed line {}", label, lineNumber);
+                continue;
+            }
+
+            if (kind == "mesh")
+            {
+                add(AssetKind::Mesh, sourcePath, cookedPath);
+            }
+            else if (kind == "texture")
+            {
+                add(AssetKind::Texture, sourcePath, cookedPath);
+            }
+            else
+            {
+                spdlog::warn("Asset manifest \"{}\": unknown asset kind \"{}\" on line {}", label, kind, lineNumber);
+            }
+        }
+
+        spdlog::trace("Loaded asset manifest \"{}\" with {} entries", label, size());
+        return true;
+    }
+
+    bool AssetManifest::save(const std::string &path) const
+    {
+        std::ofstream stream(path, std::ios::out | std::ios::trunc);
+        if (!stream.is_open())
+        {
+            spdlog::error("Unable to write asset manifest \"{}\"", path);
+            return false;
+        }
+
+        stream << "# Generated by planets-cook. <kind> <source path> <cooked path>, relative to the data directory\n";
+        for (const auto &[sourcePath, cookedPath] : m_Meshes)
+        {
+            stream << "mesh " << sourcePath << ' ' << cookedPath << '\n';
+        }
+        for (const auto &[sourcePath, cookedPath] : m_Textures)
+        {
+            stream << "texture " << sourcePath << ' ' << cookedPath << '\n';
+        }
+        return !stream.fail();
+    }
+
+    void AssetManifest::add(AssetKind kind, const std::string &sourcePath, const std::string &cookedPath)
+    {
+        auto &entries = kind == AssetKind::Mesh ? m_Meshes : m_Textures;
+        entries[normalizePath(sourcePath)] = cookedPath;
+    }
+
+    std::string AssetManifest::find(AssetKind kind, const std::string &sourcePath) const
+    {
+        const auto &entries = kind == AssetKind::Mesh ? m_Meshes : m_Textures;
+        auto it = entries.find(normalizePath(sourcePath));
+        return it == entries.end() ? std::string() : it->second;
+    }
+}
@@ -0,0 +1,137 @@
+#include "CookedTexture.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <cstring>
+
+namespace planets
+{
+    namespace
+    {
+        constexpr size_t DATA_ALIGNMENT = 16;
+
+        struct TextureHeader
+        {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t format;
+            uint32_t mipCount;
+        };
+
+        struct MipHeader
+        {
+            uint32_t width;
+            uint32_t height;
+            uint64_t offset; // from the beginning of the file
+            uint64_t size;
+        };
+
+        size_t alignUp(size_t value, size_t alignment)
+        {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+    }
+
+    CookedTexture::CookedTexture(const std::string &path)
+    {
+        auto file = std::make_shared<MappedFile>(path);
+        m_Owner = file;
+        parse(path, file->data(), file->size());
+    }
+
+    CookedTexture::CookedTexture(const std::string &label, const unsigned char *data, size_t size, std::shared_ptr<const void> owner)
+        : m_Owner(std::move(owner))
+    {
+        parse(label, data, size);
+    }
+
+    void CookedTexture::parse(const std::string &path, const unsigned char *data, size_t size)
+    {
+        TextureHeader header;
+        if (size < sizeof(TextureHeader))
+        {
+            spdlog::error("Cooked texture \"{}\" is truncated", path);
+            throw std::runtime_error("Cooked texture is truncated");
+        }
+        std::memcpy(&header, data, sizeof(TextureHeader));
+        if (header.magic != MAGIC || header.version != VERSION)
+        {
+            spdlog::error("Cooked texture \"{}\" has an incompatible version", path);
+            throw std::runtime_error("Cooked texture has an incompatible version");
+        }
+        if (header.mipCount == 0 || sizeof(TextureHeader) + header.mipCount * sizeof(MipHeader) > size)
+        {
+            spdlog::error("Cooked texture \"{}\" is corrupt", path);
+            throw std::runtime_error("Cooked texture is corrupt");
+        }
+
+        if (header.format > static_cast<uint32_t>(Texture2D::TextureDataFormat::BC7))
+        {
+            spdlog::error("Cooked texture \"{}\" has an unknown format", path);
+            throw std::runtime_error("Cooked texture has an unknown format");
+        }
+
+        m_Format = static_cast<Texture2D::TextureDataFormat>(header.format);
+        for (uint32_t i = 0; i < header.mipCount; i++)
+        {
+            MipHeader mip;
+            std::memcpy(&mip, data + sizeof(TextureHeader) + i * sizeof(MipHeader), sizeof(MipHeader));
+            if (mip.offset > size || mip.size > size - mip.offset)
+            {
+                spdlog::error("Cooked texture \"{}\" is corrupt", path);
+                throw std::runtime_error("Cooked texture is corrupt");
+            }
+            m_MipLevels.push_back(Texture2D::MipLevel{static_cast<GLsizei>(mip.width),
+                                                      static_cast<GLsizei>(mip.height),
+                                                      data + mip.offset,
+                                                      static_cast<size_t>(mip.size)});
+        }
+    }
+
+    bool CookedTexture::write(const std::string &path,
+                              Texture2D::TextureDataFormat format,
+                              const std::vector<Texture2D::MipLevel> &mipLevels)
+    {
+        std::error_code ec;
+        std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+
+        std::ofstream stream(path, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!stream.is_open())
+        {
+            spdlog::error("Unable to create cooked texture \"{}\"", path);
+            return false;
+        }
+
+        TextureHeader header{MAGIC, VERSION, static_cast<uint32_t>(format), static_cast<uint32_t>(mipLevels.size())};
+        stream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+        size_t offset = alignUp(sizeof(TextureHeader) + mipLevels.size() * sizeof(MipHeader), DATA_ALIGNMENT);
+        for (const auto &level : mipLevels)
+        {
+            MipHeader mip{static_cast<uint32_t>(level.width), static_cast<uint32_t>(level.height), offset, level.size};
+            stream.write(reinterpret_cast<const char *>(&mip), sizeof(mip));
+            offset = alignUp(offset + level.size, DATA_ALIGNMENT);
+        }
+
+        static const char zeros[DATA_ALIGNMENT]{};
+        size_t written = sizeof(TextureHeader) + mipLevels.size() * sizeof(MipHeader);
+        for (const auto &level : mipLevels)
+        {
+            stream.write(zeros, alignUp(written, DATA_ALIGNMENT) - written);
+            written = alignUp(written, DATA_ALIGNMENT);
+            stream.write(reinterpret_cast<const char *>(level.data), level.size);
+            written += level.size;
+        }
+
+        stream.close();
+        if (stream.fail())
+        {
+            spdlog::error("Unable to write cooked texture \"{}\"", path);
+            return false;
+        }
+        return true;
+    }
+}
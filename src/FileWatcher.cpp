@@ -0,0 +1,153 @@
+#include "FileWatcher.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <filesystem>
+#include <system_error>
+#include <cstring>
+#include <cerrno>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+namespace planets
+{
+    namespace
+    {
+        // How often the watcher thread checks whether it should stop
+        constexpr int POLL_TIMEOUT_MS = 100;
+    }
+
+    FileWatcher::FileWatcher(const std::string &rootDirectory) : m_RootDirectory(rootDirectory)
+    {
+#ifdef __linux__
+        m_InotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (m_InotifyFd < 0)
+        {
+            spdlog::warn("Unable to initialize inotify ({}), files will not be watched", std::strerror(errno));
+            return;
+        }
+
+        watchRecursively(m_RootDirectory);
+        spdlog::info("Watching {} directories under \"{}\" for changes", m_WatchedDirectories.size(), m_RootDirectory);
+
+        m_Thread = std::thread(&FileWatcher::run, this);
+#else
+        spdlog::warn("File watching is not supported on this platform, \"{}\" will not be watched", m_RootDirectory);
+#endif
+    }
+
+    FileWatcher::~FileWatcher()
+    {
+        m_Stopping = true;
+        if (m_Thread.joinable())
+        {
+            m_Thread.join();
+        }
+#ifdef __linux__
+        if (m_InotifyFd >= 0)
+        {
+            close(m_InotifyFd);
+        }
+#endif
+    }
+
+    std::vector<std::string> FileWatcher::takeChangedFiles()
+    {
+        std::vector<std::string> settled;
+        auto now = std::chrono::steady_clock::now();
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        for (auto it = m_PendingChanges.begin(); it != m_PendingChanges.end();)
+        {
+            if (now - it->second >= SETTLE_TIME)
+            {
+                settled.push_back(it->first);
+                it = m_PendingChanges.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+        return settled;
+    }
+
+    void FileWatcher::watchRecursively(const std::string &directory)
+    {
+#ifdef __linux__
+        int wd = inotify_add_watch(m_InotifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+        if (wd < 0)
+        {
+            spdlog::warn("Unable to watch directory \"{}\" ({})", directory, std::strerror(errno));
+            return;
+        }
+        m_WatchedDirectories[wd] = directory;
+
+        std::error_code ec;
+        for (const auto &entry : std::filesystem::directory_iterator(directory, ec))
+        {
+            if (entry.is_directory(ec))
+            {
+                watchRecursively(directory + '/' + entry.path().filename().string());
+            }
+        }
+#else
+        (void)directory;
+#endif
+    }
+
+    void FileWatcher::run()
+    {
+#ifdef __linux__
+        // Large enough for several events with long names, aligned for inotify_event
+        alignas(inotify_event) char buffer[16 * 1024];
+
+        while (!m_Stopping)
+        {
+            pollfd pfd{m_InotifyFd, POLLIN, 0};
+            if (poll(&pfd, 1, POLL_TIMEOUT_MS) <= 0)
+            {
+                continue;
+            }
+
+            ssize_t length = read(m_InotifyFd, buffer, sizeof(buffer));
+            for (ssize_t offset = 0; offset < length;)
+            {
+                const inotify_event *event = reinterpret_cast<const inotify_event *>(buffer + offset);
+                offset += sizeof(inotify_event) + event->len;
+
+                auto directoryIt = m_WatchedDirectories.find(event->wd);
+                if (directoryIt == m_WatchedDirectories.end() || event->len == 0)
+                {
+                    if (event->mask & IN_IGNORED)
+                    {
+                        m_WatchedDirectories.erase(event->wd);
+                    }
+                    continue;
+                }
+                std::string path = directoryIt->second + '/' + event->name;
+
+                if (event->mask & IN_ISDIR)
+                {
+                    // New directories (also ones moved in) get watched as well
+                    if (event->mask & (IN_CREATE | IN_MOVED_TO))
+                    {
+                        watchRecursively(path);
+                    }
+                    continue;
+                }
+                // A plain IN_CREATE is followed by IN_CLOSE_WRITE once the file has been written
+                if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
+                {
+                    std::lock_guard<std::mutex> lock(m_Mutex);
+                    m_PendingChanges[path] = std::chrono::steady_clock::now();
+                }
+            }
+        }
+#endif
+    }
+}
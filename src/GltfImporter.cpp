@@ -0,0 +1,416 @@
+#include "GltfImporter.hpp"
+#include "Json.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+
+namespace planets
+{
+    namespace
+    {
+        constexpr uint32_t CHUNK_JSON = 0x4e4f534a; // "JSON"
+        constexpr uint32_t CHUNK_BIN = 0x004e4942;  // "BIN\0"
+        constexpr int64_t MODE_TRIANGLES = 4;
+
+        struct BufferView
+        {
+            size_t offset;
+            size_t length;
+            size_t stride; // 0 if tightly packed
+        };
+
+        [[noreturn]] void fail(const std::string &path, const std::string &message)
+        {
+            spdlog::error("glTF \"{}\": {}", path, message);
+            throw std::runtime_error(message);
+        }
+
+        uint32_t readU32(const unsigned char *data)
+        {
+            uint32_t value;
+            std::memcpy(&value, data, sizeof(value));
+            return value;
+        }
+
+        GLint componentsOf(const std::string &type)
+        {
+            if (type == "SCALAR")
+            {
+                return 1;
+            }
+            if (type == "VEC2")
+            {
+                return 2;
+            }
+            if (type == "VEC3")
+            {
+                return 3;
+            }
+            if (type == "VEC4")
+            {
+                return 4;
+            }
+            return 0;
+        }
+
+        // Maps a textureInfo object to the image of its texture
+        int32_t imageOf(const std::string &path, const JsonValue &document, const JsonValue &textureInfo)
+        {
+            if (textureInfo.isNull())
+            {
+                return -1;
+            }
+            if (textureInfo["texCoord"].asInt(0) != 0)
+            {
+                spdlog::warn("glTF \"{}\": only TEXCOORD_0 is supported, a texture will use it instead", path);
+            }
+            const JsonValue &texture = document["textures"][static_cast<size_t>(textureInfo["index"].asInt(-1))];
+            if (!texture.has("source"))
+            {
+                spdlog::warn("glTF \"{}\": texture without a supported image is ignored", path);
+                return -1;
+            }
+            return static_cast<int32_t>(texture["source"].asInt());
+        }
+    }
+
+    size_t GltfAccessor::componentSize() const
+    {
+        switch (componentType)
+        {
+        case GL_BYTE:
+        case GL_UNSIGNED_BYTE:
+            return 1;
+        case GL_SHORT:
+        case GL_UNSIGNED_SHORT:
+            return 2;
+        default:
+            return 4;
+        }
+    }
+
+    GltfModel GltfImporter::importGlb(const std::string &fullPath)
+    {
+        auto file = std::make_shared<MappedFile>(fullPath);
+        return importGlb(fullPath, file->data(), file->size(), file);
+    }
+
+    GltfModel GltfImporter::importGlb(const std::string &label, const unsigned char *data, size_t size,
+                                      std::shared_ptr<const void> owner)
+    {
+        spdlog::trace("Importing glTF \"{}\"", label);
+
+        GltfModel model;
+        model.owner = std::move(owner);
+
+        if (size < 12 || readU32(data) != GLB_MAGIC)
+        {
+            fail(label, "Not a binary glTF file");
+        }
+        if (readU32(data + 4) != GLB_VERSION)
+        {
+            fail(label, "Unsupported glTF version");
+        }
+        size = std::min<size_t>(size, readU32(data + 8));
+
+        // The JSON chunk comes first, the binary chunk (if any) second
+        const char *json = nullptr;
+        size_t jsonLength = 0;
+        for (size_t offset = 12; offset + 8 <= size;)
+        {
+            uint32_t chunkLength = readU32(data + offset);
+            uint32_t chunkType = readU32(data + offset + 4);
+            if (chunkLength > size - offset - 8)
+            {
+                fail(label, "Chunk exceeds the file");
+            }
+            if (chunkType == CHUNK_JSON && json == nullptr)
+            {
+                json = reinterpret_cast<const char *>(data + offset + 8);
+                jsonLength = chunkLength;
+            }
+            else if (chunkType == CHUNK_BIN && model.binary == nullptr)
+            {
+                model.binary = data + offset + 8;
+                model.binarySize = chunkLength;
+            }
+            offset += 8 + ((chunkLength + 3) & ~size_t{3});
+        }
+        if (json == nullptr)
+        {
+            fail(label, "Missing JSON chunk");
+        }
+
+        JsonValue document = JsonValue::parse(json, jsonLength);
+        if (!document["extensionsRequired"].isNull() && document["extensionsRequired"].size() > 0)
+        {
+            fail(label, "Required extensions are not supported");
+        }
+
+        const JsonValue &buffers = document["buffers"];
+        for (size_t i = 0; i < buffers.size(); i++)
+        {
+            if (i > 0 || buffers[i].has("uri"))
+            {
+                fail(label, "Only the embedded binary buffer is supported");
+            }
+        }
+
+        std::vector<BufferView> bufferViews;
+        for (const JsonValue &view : document["bufferViews"].getElements())
+        {
+            BufferView bufferView{static_cast<size_t>(view["byteOffset"].asInt(0)),
+                                  static_cast<size_t>(view["byteLength"].asInt(0)),
+                                  static_cast<size_t>(view["byteStride"].asInt(0))};
+            if (view["buffer"].asInt(-1) != 0 || bufferView.offset > model.binarySize ||
+                bufferView.length > model.binarySize - bufferView.offset)
+            {
+                fail(label, "Buffer view is out of range");
+            }
+            bufferViews.push_back(bufferView);
+        }
+
+        auto readAccessor = [&](int64_t index, GltfAccessor &accessor)
+        {
+            const JsonValue &json = document["accessors"][static_cast<size_t>(index)];
+            if (json.isNull())
+            {
+                fail(label, "Invalid accessor index");
+            }
+            if (json.has("sparse") || !json.has("bufferView"))
+            {
+                fail(label, "Sparse accessors and accessors without a buffer view are not supported");
+            }
+            size_t viewIndex = static_cast<size_t>(json["bufferView"].asInt());
+            if (viewIndex >= bufferViews.size())
+            {
+                fail(label, "Invalid buffer view index");
+            }
+            const BufferView &view = bufferViews[viewIndex];
+
+            accessor.componentType = static_cast<GLenum>(json["componentType"].asInt());
+            accessor.components = componentsOf(json["type"].asString());
+            accessor.normalized = json["normalized"].asBool(false);
+            accessor.count = static_cast<size_t>(json["count"].asInt(0));
+            size_t elementSize = accessor.components * accessor.componentSize();
+            accessor.stride = view.stride != 0 ? view.stride : elementSize;
+            accessor.offset = view.offset + static_cast<size_t>(json["byteOffset"].asInt(0));
+
+            bool knownType = accessor.componentType == GL_BYTE || accessor.componentType == GL_UNSIGNED_BYTE ||
+                             accessor.componentType == GL_SHORT || accessor.componentType == GL_UNSIGNED_SHORT ||
+                             accessor.componentType == GL_UNSIGNED_INT || accessor.componentType == GL_FLOAT;
+            if (!knownType || accessor.components == 0 || accessor.count == 0)
+            {
+                fail(label, "Unsupported accessor type");
+            }
+            if (accessor.offset % accessor.componentSize() != 0 ||
+                accessor.offset > view.offset + view.length ||
+                accessor.byteLength() > view.offset + view.length - accessor.offset)
+            {
+                fail(label, "Accessor is out of range");
+            }
+        };
+
+        const JsonValue &meshes = document["meshes"];
+        for (size_t m = 0; m < meshes.size(); m++)
+        {
+            std::string meshName = meshes[m].has("name") ? meshes[m]["name"].asString() : "mesh" + std::to_string(m);
+            const JsonValue &primitives = meshes[m]["primitives"];
+            for (size_t p = 0; p < primitives.size(); p++)
+            {
+                const JsonValue &json = primitives[p];
+                if (json["mode"].asInt(MODE_TRIANGLES) != MODE_TRIANGLES)
+                {
+                    spdlog::warn("glTF \"{}\": primitive {} of \"{}\" is not made of triangles and is skipped", label, p, meshName);
+                    continue;
+                }
+                const JsonValue &attributes = json["attributes"];
+                if (!attributes.has("POSITION"))
+                {
+                    spdlog::warn("glTF \"{}\": primitive {} of \"{}\" has no positions and is skipped", label, p, meshName);
+                    continue;
+                }
+
+                GltfPrimitive primitive;
+                primitive.name = meshName + '.' + std::to_string(p);
+                primitive.materialIndex = static_cast<int32_t>(json["material"].asInt(-1));
+                readAccessor(attributes["POSITION"].asInt(), primitive.positions);
+                if (attributes.has("NORMAL"))
+                {
+                    readAccessor(attributes["NORMAL"].asInt(), primitive.normals);
+                }
+                if (attributes.has("TANGENT"))
+                {
+                    readAccessor(attributes["TANGENT"].asInt(), primitive.tangents);
+                }
+                if (attributes.has("TEXCOORD_0"))
+                {
+                    readAccessor(attributes["TEXCOORD_0"].asInt(), primitive.uvs);
+                }
+                if (json.has("indices"))
+                {
+                    readAccessor(json["indices"].asInt(), primitive.indices);
+                }
+
+                if (primitive.positions.components != 3 ||
+                    (primitive.normals.count != 0 && primitive.normals.count != primitive.positions.count) ||
+                    (primitive.tangents.count != 0 && primitive.tangents.count != primitive.positions.count) ||
+                    (primitive.uvs.count != 0 && primitive.uvs.count != primitive.positions.count) ||
+                    (primitive.indices.count != 0 && primitive.indices.components != 1))
+                {
+                    fail(label, "Primitive attributes do not match");
+                }
+                if (primitive.materialIndex >= static_cast<int32_t>(document["materials"].size()))
+                {
+                    fail(label, "Invalid material index");
+                }
+                model.primitives.push_back(primitive);
+            }
+        }
+
+        for (const JsonValue &json : document["images"].getElements())
+        {
+            GltfImage image;
+            if (json.has("bufferView"))
+            {
+                size_t viewIndex = static_cast<size_t>(json["bufferView"].asInt());
+                if (viewIndex >= bufferViews.size())
+                {
+                    fail(label, "Invalid buffer view index");
+                }
+                image.offset = bufferViews[viewIndex].offset;
+                image.size = bufferViews[viewIndex].length;
+            }
+            else if (json["uri"].asString().compare(0, 5, "data:") == 0)
+            {
+                spdlog::warn("glTF \"{}\": images in data URIs are not supported", label);
+            }
+            else
+            {
+                image.uri = json["uri"].asString();
+            }
+            model.images.push_back(image);
+        }
+
+        for (size_t i = 0; i < document["materials"].size(); i++)
+        {
+            const JsonValue &json = document["materials"][i];
+            const JsonValue &pbr = json["pbrMetallicRoughness"];
+
+            GltfMaterial material;
+            material.name = json.has("name") ? json["name"].asString() : "material" + std::to_string(i);
+            for (int c = 0; c < 4; c++)
+            {
+                material.baseColorFactor[c] = static_cast<float>(pbr["baseColorFactor"][c].asNumber(1.0));
+            }
+            for (int c = 0; c < 3; c++)
+            {
+                material.emissiveFactor[c] = static_cast<float>(json["emissiveFactor"][c].asNumber(0.0));
+            }
+            material.metallicFactor = static_cast<float>(pbr["metallicFactor"].asNumber(1.0));
+            material.roughnessFactor = static_cast<float>(pbr["roughnessFactor"].asNumber(1.0));
+            material.baseColorImage = imageOf(label, document, pbr["baseColorTexture"]);
+            material.metallicRoughnessImage = imageOf(label, document, pbr["metallicRoughnessTexture"]);
+            material.normalImage = imageOf(label, document, json["normalTexture"]);
+            material.occlusionImage = imageOf(label, document, json["occlusionTexture"]);
+            material.emissiveImage = imageOf(label, document, json["emissiveTexture"]);
+
+            for (int32_t image : {material.baseColorImage, material.metallicRoughnessImage, material.normalImage,
+                                  material.occlusionImage, material.emissiveImage})
+            {
+                if (image >= static_cast<int32_t>(model.images.size()))
+                {
+                    fail(label, "Invalid image index");
+                }
+            }
+            model.materials.push_back(material);
+        }
+
+        spdlog::trace("Imported {} primitives, {} materials and {} images from \"{}\"",
+                      model.primitives.size(), model.materials.size(), model.images.size(), label);
+        return model;
+    }
+
+    std::vector<glm::vec4> GltfImporter::readFloats(const GltfModel &model, const GltfAccessor &accessor)
+    {
+        std::vector<glm::vec4> values(accessor.count, glm::vec4(0.0f));
+        size_t componentSize = accessor.componentSize();
+        for (size_t i = 0; i < accessor.count; i++)
+        {
+            const unsigned char *element = model.binary + accessor.offset + i * accessor.stride;
+            for (GLint c = 0; c < std::min(accessor.components, 4); c++)
+            {
+                const unsigned char *component = element + c * componentSize;
+                float value;
+                switch (accessor.componentType)
+                {
+                case GL_BYTE:
+                {
+                    int8_t v;
+                    std::memcpy(&v, component, sizeof(v));
+                    value = accessor.normalized ? std::max(v / 127.0f, -1.0f) : v;
+                    break;
+                }
+                case GL_UNSIGNED_BYTE:
+                    value = accessor.normalized ? *component / 255.0f : *component;
+                    break;
+                case GL_SHORT:
+                {
+                    int16_t v;
+                    std::memcpy(&v, component, sizeof(v));
+                    value = accessor.normalized ? std::max(v / 32767.0f, -1.0f) : v;
+                    break;
+                }
+                case GL_UNSIGNED_SHORT:
+                {
+                    uint16_t v;
+                    std::memcpy(&v, component, sizeof(v));
+                    value = accessor.normalized ? v / 65535.0f : v;
+                    break;
+                }
+                case GL_UNSIGNED_INT:
+                {
+                    uint32_t v;
+                    std::memcpy(&v, component, sizeof(v));
+                    value = static_cast<float>(v);
+                    break;
+                }
+                default:
+                    std::memcpy(&value, component, sizeof(value));
+                    break;
+                }
+                values[i][c] = value;
+            }
+        }
+        return values;
+    }
+
+    std::vector<GLuint> GltfImporter::readIndices(const GltfModel &model, const GltfAccessor &accessor)
+    {
+        std::vector<GLuint> indices(accessor.count);
+        for (size_t i = 0; i < accessor.count; i++)
+        {
+            const unsigned char *element = model.binary + accessor.offset + i * accessor.stride;
+            switch (accessor.componentType)
+            {
+            case GL_UNSIGNED_BYTE:
+                indices[i] = *element;
+                break;
+            case GL_UNSIGNED_SHORT:
+            {
+                uint16_t index;
+                std::memcpy(&index, element, sizeof(index));
+                indices[i] = index;
+                break;
+            }
+            default:
+                std::memcpy(&indices[i], element, sizeof(GLuint));
+                break;
+            }
+        }
+        return indices;
+    }
+}
@@ -0,0 +1,347 @@
+#include "Json.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <stdexcept>
+#include <cstdlib>
+#include <cstring>
+
+namespace planets
+{
+    namespace
+    {
+        const JsonValue NULL_VALUE;
+
+        // Nesting deeper than this is rejected instead of overflowing the stack
+        constexpr int MAX_DEPTH = 256;
+
+        void appendUtf8(std::string &str, uint32_t codepoint)
+        {
+            if (codepoint < 0x80)
+            {
+                str += static_cast<char>(codepoint);
+            }
+            else if (codepoint < 0x800)
+            {
+                str += static_cast<char>(0xc0 | (codepoint >> 6));
+                str += static_cast<char>(0x80 | (codepoint & 0x3f));
+            }
+            else if (codepoint < 0x10000)
+            {
+                str += static_cast<char>(0xe0 | (codepoint >> 12));
+                str += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3f));
+                str += static_cast<char>(0x80 | (codepoint & 0x3f));
+            }
+            else
+            {
+                str += static_cast<char>(0xf0 | (codepoint >> 18));
+                str += static_cast<char>(0x80 | ((codepoint >> 12) & 0x3f));
+                str += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3f));
+                str += static_cast<char>(0x80 | (codepoint & 0x3f));
+            }
+        }
+    }
+
+    // Recursive descent over the text, only JsonValue::parse uses it
+    class JsonParser
+    {
+    public:
+        JsonParser(const char *text, size_t length) : m_Text(text), m_Length(length), m_Offset(0) {}
+
+        JsonValue parseDocument()
+        {
+            JsonValue value = parseValue(0);
+            skipWhitespace();
+            if (m_Offset != m_Length)
+            {
+                fail("Unexpected data after the document");
+            }
+            return value;
+        }
+
+    private:
+        const char *m_Text;
+        size_t m_Length;
+        size_t m_Offset;
+
+        [[noreturn]] void fail(const char *message)
+        {
+            spdlog::error("JSON: {} at offset {}", message, m_Offset);
+            throw std::runtime_error(message);
+        }
+
+        void skipWhitespace()
+        {
+            while (m_Offset < m_Length && std::strchr(" \t\r\n", m_Text[m_Offset]) != nullptr && m_Text[m_Offset] != '\0')
+            {
+                m_Offset++;
+            }
+        }
+
+        char peek()
+        {
+            skipWhitespace();
+            return m_Offset < m_Length ? m_Text[m_Offset] : '\0';
+        }
+
+        void expect(char c)
+        {
+            if (peek() != c)
+            {
+                fail("Unexpected character");
+            }
+            m_Offset++;
+        }
+
+        void expectLiteral(const char *literal)
+        {
+            size_t length = std::strlen(literal);
+            if (m_Length - m_Offset < length || std::memcmp(m_Text + m_Offset, literal, length) != 0)
+            {
+                fail("Invalid literal");
+            }
+            m_Offset += length;
+        }
+
+        JsonValue parseValue(int depth)
+        {
+            if (depth > MAX_DEPTH)
+            {
+                fail("Document is nested too deeply");
+            }
+
+            JsonValue value;
+            switch (peek())
+            {
+            case '{':
+                value.m_Type = JsonValue::Type::Object;
+                m_Offset++;
+                if (peek() == '}')
+                {
+                    m_Offset++;
+                    break;
+                }
+                do
+                {
+                    if (peek() != '"')
+                    {
+                        fail("Expected a member name");
+                    }
+                    value.m_Keys.push_back(parseString());
+                    expect(':');
+                    value.m_Values.push_back(parseValue(depth + 1));
+                } while (peek() == ',' && ++m_Offset);
+                expect('}');
+                break;
+            case '[':
+                value.m_Type = JsonValue::Type::Array;
+                m_Offset++;
+                if (peek() == ']')
+                {
+                    m_Offset++;
+                    break;
+                }
+                do
+                {
+                    value.m_Values.push_back(parseValue(depth + 1));
+                } while (peek() == ',' && ++m_Offset);
+                expect(']');
+                break;
+            case '"':
+                value.m_Type = JsonValue::Type::String;
+                value.m_String = parseString();
+                break;
+            case 't':
+                expectLiteral("true");
+                value.m_Type = JsonValue::Type::Bool;
+                value.m_Bool = true;
+                break;
+            case 'f':
+                expectLiteral("false");
+                value.m_Type = JsonValue::Type::Bool;
+                break;
+            case 'n':
+                expectLiteral("null");
+                break;
+            default:
+                value.m_Type = JsonValue::Type::Number;
+                value.m_Number = parseNumber();
+                break;
+            }
+            return value;
+        }
+
+        double parseNumber()
+        {
+            // strtod accepts more than JSON does (hex, inf), so check the characters first
+            size_t start = m_Offset;
+            while (m_Offset < m_Length && std::strchr("0123456789+-.eE", m_Text[m_Offset]) != nullptr && m_Text[m_Offset] != '\0')
+            {
+                m_Offset++;
+            }
+            if (m_Offset == start)
+            {
+                fail("Unexpected character");
+            }
+            std::string number(m_Text + start, m_Offset - start);
+            char *end;
+            double result = std::strtod(number.c_str(), &end);
+            if (*end != '\0')
+            {
+                m_Offset = start;
+                fail("Invalid number");
+            }
+            return result;
+        }
+
+        uint32_t parseHex4()
+        {
+            if (m_Length - m_Offset < 4)
+            {
+                fail("Invalid escape sequence");
+            }
+            uint32_t value = 0;
+            for (int i = 0; i < 4; i++)
+            {
+                char c = m_Text[m_Offset++];
+                value <<= 4;
+                if (c >= '0' && c <= '9')
+                {
+                    value |= c - '0';
+                }
+                else if (c >= 'a' && c <= 'f')
+                {
+                    value |= c - 'a' + 10;
+                }
+                else if (c >= 'A' && c <= 'F')
+                {
+                    value |= c - 'A' + 10;
+                }
+                else
+                {
+                    fail("Invalid escape sequence");
+                }
+            }
+            return value;
+        }
+
+        std::string parseString()
+        {
+            m_Offset++; // opening quote
+            std::string str;
+            while (true)
+            {
+                if (m_Offset >= m_Length)
+                {
+                    fail("Unterminated string");
+                }
+                char c = m_Text[m_Offset++];
+                if (c == '"')
+                {
+                    return str;
+                }
+                if (c != '\\')
+                {
+                    str += c;
+                    continue;
+                }
+
+                if (m_Offset >= m_Length)
+                {
+                    fail("Unterminated string");
+                }
+                char escaped = m_Text[m_Offset++];
+                switch (escaped)
+                {
+                case '"':
+                case '\\':
+                case '/':
+                    str += escaped;
+                    break;
+                case 'b':
+                    str += '\b';
+                    break;
+                case 'f':
+                    str += '\f';
+                    break;
+                case 'n':
+                    str += '\n';
+                    break;
+                case 'r':
+                    str += '\r';
+                    break;
+                case 't':
+                    str += '\t';
+                    break;
+                case 'u':
+                {
+                    uint32_t codepoint = parseHex4();
+                    // Characters outside the BMP are written as surrogate pairs
+                    if (codepoint >= 0xd800 && codepoint < 0xdc00 && m_Length - m_Offset >= 2 &&
+                        m_Text[m_Offset] == '\\' && m_Text[m_Offset + 1] == 'u')
+                    {
+                        m_Offset += 2;
+                        uint32_t low = parseHex4();
+                        codepoint = 0x10000 + ((codepoint - 0xd800) << 10) + (low - 0xdc00);
+                    }
+                    appendUtf8(str, codepoint);
+                    break;
+                }
+                default:
+                    fail("Invalid escape sequence");
+                }
+            }
+        }
+    };
+
+    JsonValue JsonValue::parse(const char *text, size_t length)
+    {
+        JsonParser parser(text, length);
+        return parser.parseDocument();
+    }
+
+    bool JsonValue::asBool(bool defaultValue) const
+    {
+        return m_Type == Type::Bool ? m_Bool : defaultValue;
+    }
+
+    double JsonValue::asNumber(double defaultValue) const
+    {
+        return m_Type == Type::Number ? m_Number : defaultValue;
+    }
+
+    int64_t JsonValue::asInt(int64_t defaultValue) const
+    {
+        return m_Type == Type::Number ? static_cast<int64_t>(m_Number) : defaultValue;
+    }
+
+    const std::string &JsonValue::asString() const
+    {
+        return m_String;
+    }
+
+    const JsonValue &JsonValue::operator[](size_t index) const
+    {
+        return m_Type == Type::Array && index < m_Values.size() ? m_Values[index] : NULL_VALUE;
+    }
+
+    const JsonValue &JsonValue::operator[](const std::string &key) const
+    {
+        if (m_Type == Type::Object)
+        {
+            for (size_t i = 0; i < m_Keys.size(); i++)
+            {
+                if (m_Keys[i] == key)
+                {
+                    return m_Values[i];
+                }
+            }
+        }
+        return NULL_VALUE;
+    }
+
+    bool JsonValue::has(const std::string &key) const
+    {
+        return !(*this)[key].isNull();
+    }
+}
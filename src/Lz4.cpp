@@ -0,0 +1,178 @@
+#include "Lz4.hpp"
+
+#include <cstdint>
+#include <cstring>
+
+namespace planets
+{
+    namespace
+    {
+        constexpr size_t MIN_MATCH = 4;
+        // The format requires the last 5 bytes to be literals and the last match to start 12 bytes before the end
+        constexpr size_t LAST_LITERALS = 5;
+        constexpr size_t MATCH_FIND_LIMIT = 12;
+        constexpr size_t MAX_OFFSET = 65535;
+        constexpr int HASH_BITS = 16;
+
+        uint32_t read32(const unsigned char *p)
+        {
+            uint32_t value;
+            std::memcpy(&value, p, sizeof(value));
+            return value;
+        }
+
+        uint32_t hashSequence(uint32_t sequence)
+        {
+            return (sequence * 2654435761u) >> (32 - HASH_BITS);
+        }
+
+        void writeLength(std::vector<unsigned char> &out, size_t length)
+        {
+            while (length >= 255)
+            {
+                out.push_back(255);
+                length -= 255;
+            }
+            out.push_back(static_cast<unsigned char>(length));
+        }
+
+        void writeLiterals(std::vector<unsigned char> &out, const unsigned char *literals, size_t count, unsigned char matchNibble)
+        {
+            out.push_back(static_cast<unsigned char>((count < 15 ? count : 15) << 4 | matchNibble));
+            if (count >= 15)
+            {
+                writeLength(out, count - 15);
+            }
+            out.insert(out.end(), literals, literals + count);
+        }
+
+        // Reads the extension bytes of a length whose nibble was 15
+        bool readLength(const unsigned char *data, size_t size, size_t &offset, size_t &length)
+        {
+            unsigned char byte;
+            do
+            {
+                if (offset >= size)
+                {
+                    return false;
+                }
+                byte = data[offset++];
+                length += byte;
+            } while (byte == 255);
+            return true;
+        }
+    }
+
+    std::vector<unsigned char> Lz4::compress(const unsigned char *data, size_t size)
+    {
+        std::vector<unsigned char> out;
+        out.reserve(compressBound(size));
+
+        // Position + 1 of the last occurrence of each hashed 4-byte sequence, 0 if none
+        std::vector<uint32_t> table(size_t{1} << HASH_BITS, 0);
+        size_t anchor = 0;
+        size_t position = 0;
+        while (position + MATCH_FIND_LIMIT <= size)
+        {
+            uint32_t sequence = read32(data + position);
+            uint32_t &entry = table[hashSequence(sequence)];
+            size_t candidate = entry;
+            entry = static_cast<uint32_t>(position + 1);
+
+            if (candidate == 0 || position - (candidate - 1) > MAX_OFFSET || read32(data + candidate - 1) != sequence)
+            {
+                position++;
+                continue;
+            }
+            candidate--;
+
+            size_t matchLength = MIN_MATCH;
+            while (position + matchLength < size - LAST_LITERALS && data[candidate + matchLength] == data[position + matchLength])
+            {
+                matchLength++;
+            }
+
+            size_t matchExtra = matchLength - MIN_MATCH;
+            writeLiterals(out, data + anchor, position - anchor, static_cast<unsigned char>(matchExtra < 15 ? matchExtra : 15));
+            size_t offset = position - candidate;
+            out.push_back(static_cast<unsigned char>(offset & 0xff));
+            out.push_back(static_cast<unsigned char>(offset >> 8));
+            if (matchExtra >= 15)
+            {
+                writeLength(out, matchExtra - 15);
+            }
+
+            position += matchLength;
+            anchor = position;
+        }
+
+        writeLiterals(out, data + anchor, size - anchor, 0);
+        return out;
+    }
+
+    bool Lz4::decompress(const unsigned char *data, size_t size, unsigned char *decompressed, size_t decompressedSize)
+    {
+        size_t in = 0, out = 0;
+        while (in < size)
+        {
+            unsigned char token = data[in++];
+
+            size_t literalCount = token >> 4;
+            if (literalCount == 15 && !readLength(data, size, in, literalCount))
+            {
+                return false;
+            }
+            if (literalCount > size - in || literalCount > decompressedSize - out)
+            {
+                return false;
+            }
+            std::memcpy(decompressed + out, data + in, literalCount);
+            in += literalCount;
+            out += literalCount;
+
+            // The last sequence has no match
+            if (in == size)
+            {
+                break;
+            }
+
+            if (size - in < 2)
+            {
+                return false;
+            }
+            size_t offset = data[in] | static_cast<size_t>(data[in + 1]) << 8;
+            in += 2;
+            if (offset == 0 || offset > out)
+            {
+                return false;
+            }
+
+            size_t matchLength = token & 15;
+            if (matchLength == 15 && !readLength(data, size, in, matchLength))
+            {
+                return false;
+            }
+            matchLength += MIN_MATCH;
+            if (matchLength > decompressedSize - out)
+            {
+                return false;
+            }
+
+            const unsigned char *match = decompressed + out - offset;
+            if (offset >= matchLength)
+            {
+                std::memcpy(decompressed + out, match, matchLength);
+            }
+            else
+            {
+                // Overlapping copies repeat the last offset bytes
+                for (size_t i = 0; i < matchLength; i++)
+                {
+                    decompressed[out + i] = match[i];
+                }
+            }
+            out += matchLength;
+        }
+        return out == decompressedSize;
+    }
+}
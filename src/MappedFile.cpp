@@ -0,0 +1,58 @@
+#include "MappedFile.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <stdexcept>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace planets
+{
+    MappedFile::MappedFile(const std::string &path) : m_Data(nullptr), m_Size(0)
+    {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            spdlog::error("Unable to open file \"{}\" for mapping", path);
+            throw std::runtime_error("Unable to open file for mapping");
+        }
+
+        struct stat fileStat;
+        if (fstat(fd, &fileStat) != 0)
+        {
+            close(fd);
+            spdlog::error("Unable to stat file \"{}\"", path);
+            throw std::runtime_error("Unable to stat file");
+        }
+
+        m_Size = static_cast<size_t>(fileStat.st_size);
+        // Empty files cannot be mapped, they are represented by a null pointer
+        if (m_Size > 0)
+        {
+            void *ptr = mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (ptr == MAP_FAILED)
+            {
+                close(fd);
+                spdlog::error("Unable to map file \"{}\"", path);
+                throw std::runtime_error("Unable to map file");
+            }
+            // We read files front to back
+            madvise(ptr, m_Size, MADV_SEQUENTIAL);
+            m_Data = static_cast<const unsigned char *>(ptr);
+        }
+
+        // The mapping stays valid after the descriptor is closed
+        close(fd);
+    }
+
+    MappedFile::~MappedFile()
+    {
+        if (m_Data != nullptr)
+        {
+            munmap(const_cast<unsigned char *>(m_Data), m_Size);
+        }
+    }
+}
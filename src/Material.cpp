@@ -1,11 +1,48 @@
 #include "Material.hpp"
 
 #include "ShaderProgram.hpp"
+#include "Texture2DArray.hpp"
 
 #include <memory>
+#include <iterator>
+#include <cstring>
+#include <utility>
 
 namespace planets
 {
+    namespace
+    {
+        // Texture units used by StandardMaterial: 0-5 for 2D textures, 6-11 for arrays
+        constexpr GLint ARRAY_UNIT_OFFSET = 6;
+        constexpr GLint TRACKED_UNITS = 2 * ARRAY_UNIT_OFFSET;
+
+        struct BoundTexture
+        {
+            GLenum target{0};
+            GLuint textureId{0};
+        };
+
+        // Only touched by the thread owning the GL context
+        BoundTexture boundTextures[TRACKED_UNITS];
+        GLuint usedProgram{0};
+        GLuint boundMaterialBuffer{0};
+        std::shared_ptr<ShaderProgram> fallbackProgram;
+
+        // Sampler uniforms of the StandardMaterial maps, in texture unit order
+        struct MapUniformNames
+        {
+            GLint flag;
+            const char *map;
+            const char *array;
+        };
+        constexpr MapUniformNames MAP_UNIFORM_NAMES[] = {
+            {StandardMaterial::HAS_DIFFUSE_MAP, "diffuseMap", "diffuseArray"},
+            {StandardMaterial::HAS_ROUGHNESS_MAP, "roughnessMap", "roughnessArray"},
+            {StandardMaterial::HAS_NORMAL_MAP, "normalMap", "normalArray"},
+            {StandardMaterial::HAS_METALNESS_MAP, "metalnessMap", "metalnessArray"},
+            {StandardMaterial::HAS_EMISSION_MAP, "emissionMap", "emissionArray"},
+            {StandardMaterial::HAS_AO_MAP, "aoMap", "aoArray"}};
+    }
 
     Material::Material(std::shared_ptr<ShaderProgram> shaderProgram) : m_ShaderProgram(shaderProgram)
     {
@@ -17,22 +54,67 @@ namespace planets
 
     void Material::use(const MaterialInput &materialInput) const
     {
-        // Activate shader program
-        m_ShaderProgram->use();
+        const bool ready = m_ShaderProgram->isReady() || !fallbackProgram;
+        const ShaderProgram &program = ready ? *m_ShaderProgram : *fallbackProgram;
 
-        // Set built-in uniforms
-        m_ShaderProgram->setMatrix4f("modelToClipSpace", materialInput.modelToClipSpace);
-        m_ShaderProgram->setMatrix4f("modelToWorldSpace", materialInput.modelToWorldSpace);
-        m_ShaderProgram->setMatrix3f("modelToWorldSpace_Normal", materialInput.modelToWorldSpace_Normal);
-        m_ShaderProgram->setVector3f("cameraWorldPosition", materialInput.cameraPosition);
-        m_ShaderProgram->setVector3f("cameraDirection", materialInput.cameraDirection);
-        m_ShaderProgram->setFloat("time", materialInput.time);
+        // Consecutive draws with the same program keep it
+        if (usedProgram != program.getId())
+        {
+            program.use();
+            usedProgram = program.getId();
+        }
+        // The fallback has no uniforms outside the blocks
+        if (ready && m_ResolvedLinkId != m_ShaderProgram->getLinkId())
+        {
+            resolveUniforms();
+            m_ResolvedLinkId = m_ShaderProgram->getLinkId();
+        }
+
+        ObjectBlock block{};
+        block.modelToClipSpace = materialInput.modelToClipSpace;
+        block.modelToWorldSpace = materialInput.modelToWorldSpace;
+        for (int column = 0; column < 3; column++)
+        {
+            block.modelToWorldSpace_Normal[column] = glm::vec4(materialInput.modelToWorldSpace_Normal[column], 0.0f);
+        }
+        block.vertexFormat = materialInput.vertexFormat;
+        materialInput.objectUniforms.push(OBJECT_BLOCK_BINDING, &block, sizeof(block));
     }
 
     void Material::disable() const
     {
     }
 
+    void Material::resetBindings()
+    {
+        for (auto &bound : boundTextures)
+        {
+            bound = BoundTexture{};
+        }
+        usedProgram = 0;
+        boundMaterialBuffer = 0;
+    }
+
+    void Material::setFallbackProgram(std::shared_ptr<ShaderProgram> program)
+    {
+        fallbackProgram = std::move(program);
+    }
+
+    void Material::bindTexture(GLint unit, GLenum target, GLuint textureId, DrawStats &drawStats)
+    {
+        if (unit < TRACKED_UNITS && boundTextures[unit].target == target && boundTextures[unit].textureId == textureId)
+        {
+            return;
+        }
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(target, textureId);
+        drawStats.textureBinds++;
+        if (unit < TRACKED_UNITS)
+        {
+            boundTextures[unit] = BoundTexture{target, textureId};
+        }
+    }
+
     ////////////////////////////////////////////////////////////////////////////
     ////////////////////////////////////////////////////////////////////////////
     ////////////////////////////////////////////////////////////////////////////
@@ -44,83 +126,141 @@ namespace planets
         // All uniform locations have already been retrieved by the constructor of the ShaderProgram
     }
 
+    StandardMaterial::StandardMaterial(std::shared_ptr<ShaderVariants> variants,
+                                       GLint flags) : Material(variants->get(flags)), m_Flags(flags), m_Variants(variants)
+    {
+    }
+
     StandardMaterial::~StandardMaterial()
     {
     }
 
-    void StandardMaterial::use(const MaterialInput &materialInput) const
+    void StandardMaterial::updateFrom(const StandardMaterial &other)
     {
-        Material::use(materialInput);
+        m_Flags = other.m_Flags;
+        m_DiffuseColor = other.m_DiffuseColor;
+        m_Roughness = other.m_Roughness;
+        m_Metalness = other.m_Metalness;
+        m_EmissionColor = other.m_EmissionColor;
 
-        m_ShaderProgram->setInt("materialFlags", m_Flags);
+        m_DiffuseMap = other.m_DiffuseMap;
+        m_RoughnessMap = other.m_RoughnessMap;
+        m_NormalMap = other.m_NormalMap;
+        m_MetalnessMap = other.m_MetalnessMap;
+        m_EmissionMap = other.m_EmissionMap;
+        m_AoMap = other.m_AoMap;
 
-        m_ShaderProgram->setVector3f("diffuseColor", m_DiffuseColor);
-        m_ShaderProgram->setFloat("roughness", m_Roughness);
-        m_ShaderProgram->setFloat("metalness", m_Metalness);
-        m_ShaderProgram->setVector3f("emissionColor", m_EmissionColor);
+        selectVariant();
+        m_BlockDirty = true;
+    }
 
-        if (m_Flags & StandardMaterialFlags::HAS_DIFFUSE_MAP)
+    void StandardMaterial::selectVariant() const
+    {
+        if (m_Variants)
         {
-            m_DiffuseMap->bind(0);
-            m_ShaderProgram->setInt("diffuseMap", 0);
+            GLint flags = m_Flags & ~m_MissingMaps;
+            m_ShaderProgram = m_Variants->get(flags | ((m_ArrayMaps & flags) << ARRAY_MAP_SHIFT));
         }
+    }
 
-        if (m_Flags & StandardMaterialFlags::HAS_ROUGHNESS_MAP)
+    void StandardMaterial::use(const MaterialInput &materialInput) const
+    {
+        // Units 0-5 take plain textures, the arrays go to the same unit + ARRAY_UNIT_OFFSET
+        const ResourceHandle<Texture2D> *maps[MAP_COUNT] = {&m_DiffuseMap, &m_RoughnessMap, &m_NormalMap,
+                                                            &m_MetalnessMap, &m_EmissionMap, &m_AoMap};
+        const Texture2D *textures[MAP_COUNT] = {};
+        GLint arrayMaps = 0;
+        GLint missingMaps = 0;
+        for (size_t unit = 0; unit < MAP_COUNT; unit++)
         {
-            m_RoughnessMap->bind(1);
-            m_ShaderProgram->setInt("roughnessMap", 1);
+            if (m_Flags & MAP_UNIFORM_NAMES[unit].flag)
+            {
+                // Default or invalid handles have no placeholder, the map is left out of the draw
+                textures[unit] = maps[unit]->get();
+                if (textures[unit] == nullptr)
+                {
+                    missingMaps |= MAP_UNIFORM_NAMES[unit].flag;
+                }
+                else if (textures[unit]->getArray())
+                {
+                    arrayMaps |= MAP_UNIFORM_NAMES[unit].flag;
+                }
+            }
         }
-
-        if (m_Flags & StandardMaterialFlags::HAS_NORMAL_MAP)
+        // Maps only become array layers once they are loaded, which is first seen here
+        if (arrayMaps != m_ArrayMaps || missingMaps != m_MissingMaps)
         {
-            m_NormalMap->bind(2);
-            m_ShaderProgram->setInt("normalMap", 2);
+            m_ArrayMaps = arrayMaps;
+            m_MissingMaps = missingMaps;
+            selectVariant();
         }
 
-        if (m_Flags & StandardMaterialFlags::HAS_METALNESS_MAP)
-        {
-            m_MetalnessMap->bind(3);
-            m_ShaderProgram->setInt("metalnessMap", 3);
-        }
+        Material::use(materialInput);
 
-        if (m_Flags & StandardMaterialFlags::HAS_EMISSION_MAP)
-        {
-            m_EmissionMap->bind(4);
-            m_ShaderProgram->setInt("emissionMap", 4);
-        }
+        MaterialBlock block{};
+        block.diffuseColor = m_DiffuseColor;
+        block.roughness = m_Roughness;
+        block.emissionColor = m_EmissionColor;
+        block.metalness = m_Metalness;
+        block.materialFlags = m_Flags & ~missingMaps;
 
-        if (m_Flags & StandardMaterialFlags::HAS_AO_MAP)
+        GLint *layers[MAP_COUNT] = {&block.diffuseLayer, &block.roughnessLayer, &block.normalLayer,
+                                    &block.metalnessLayer, &block.emissionLayer, &block.aoLayer};
+        for (GLint unit = 0; unit < static_cast<GLint>(MAP_COUNT); unit++)
         {
-            m_AoMap->bind(5);
-            m_ShaderProgram->setInt("aoMap", 5);
+            *layers[unit] = -1;
+            const Texture2D *map = textures[unit];
+            if (map == nullptr)
+            {
+                continue;
+            }
+            if (map->getArray())
+            {
+                bindTexture(unit + ARRAY_UNIT_OFFSET, GL_TEXTURE_2D_ARRAY, map->getArray()->getId(), materialInput.drawStats);
+                *layers[unit] = map->getArrayLayer();
+            }
+            else
+            {
+                bindTexture(unit, GL_TEXTURE_2D, map->getId(), materialInput.drawStats);
+            }
         }
-    }
 
-    void StandardMaterial::disable() const
-    {
-        if (m_Flags & StandardMaterialFlags::HAS_DIFFUSE_MAP)
-        {
-            m_DiffuseMap->unbind(0);
-        }
-        if (m_Flags & StandardMaterialFlags::HAS_ROUGHNESS_MAP)
-        {
-            m_RoughnessMap->unbind(1);
-        }
-        if (m_Flags & StandardMaterialFlags::HAS_NORMAL_MAP)
+        // Setters, texture arrays and maps that finished loading all change the block
+        if (!m_MaterialBuffer)
         {
-            m_NormalMap->unbind(2);
+            m_MaterialBuffer = std::make_shared<UniformBuffer>(sizeof(MaterialBlock));
+            m_MaterialBuffer->update(&block, sizeof(block));
+            m_UploadedBlock = block;
         }
-        if (m_Flags & StandardMaterialFlags::HAS_METALNESS_MAP)
+        else if (m_BlockDirty || std::memcmp(&block, &m_UploadedBlock, sizeof(block)) != 0)
         {
-            m_MetalnessMap->unbind(3);
+            m_MaterialBuffer->update(&block, sizeof(block));
+            m_UploadedBlock = block;
         }
-        if (m_Flags & StandardMaterialFlags::HAS_EMISSION_MAP)
+        m_BlockDirty = false;
+        if (boundMaterialBuffer != m_MaterialBuffer->getId())
         {
-            m_EmissionMap->unbind(4);
+            m_MaterialBuffer->bind(MATERIAL_BLOCK_BINDING);
+            boundMaterialBuffer = m_MaterialBuffer->getId();
         }
-        if (m_Flags & StandardMaterialFlags::HAS_AO_MAP)
+    }
+
+    void StandardMaterial::resolveUniforms() const
+    {
+        Material::resolveUniforms();
+
+        static_assert(std::size(MAP_UNIFORM_NAMES) == MAP_COUNT, "Every map needs its uniform names");
+        for (GLint unit = 0; unit < static_cast<GLint>(MAP_COUNT); unit++)
         {
-            m_AoMap->unbind(5);
+            // Samplers of different types must never share a unit, even unused ones. Units are
+            // program state that no material changes, so setting them once per link is enough.
+            m_ShaderProgram->setInt(MAP_UNIFORM_NAMES[unit].map, unit);
+            m_ShaderProgram->setInt(MAP_UNIFORM_NAMES[unit].array, unit + ARRAY_UNIT_OFFSET);
         }
     }
-}
\ No newline at end of file
+
+    void StandardMaterial::disable() const
+    {
+        // Textures stay bound, the next material only binds the ones that differ
+    }
+}
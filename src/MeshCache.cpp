@@ -0,0 +1,450 @@
+#include "MeshCache.hpp"
+#include "MappedFile.hpp"
+#include "Hash.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <type_traits>
+#include <cstring>
+
+namespace planets
+{
+    static_assert(std::is_trivially_copyable<StaticMesh::Vertex>::value,
+                  "StaticMesh::Vertex is stored in the cache as raw bytes");
+
+    namespace
+    {
+        constexpr size_t ARRAY_ALIGNMENT = 16;
+
+        struct CacheHeader
+        {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t vertexSize;
+            uint32_t sourceCount;
+            uint32_t materialCount;
+            uint32_t submeshCount;
+        };
+
+        struct SourceStamp
+        {
+            uint64_t size;
+            int64_t mtime;
+            uint64_t hash;
+        };
+
+        std::string sourceFilePath(const std::string &sourceDirectory, const std::string &sourcePath)
+        {
+            return sourceDirectory.empty() ? sourcePath : sourceDirectory + '/' + sourcePath;
+        }
+
+        uint64_t hashFile(const std::string &path)
+        {
+            MappedFile file(path);
+            return hashBytes(file.data(), file.size());
+        }
+
+        // Size and modification time of a file, without reading it
+        bool statFile(const std::string &path, uint64_t &size, int64_t &mtime)
+        {
+            std::error_code ec;
+            size = std::filesystem::file_size(path, ec);
+            if (ec)
+            {
+                return false;
+            }
+            auto time = std::filesystem::last_write_time(path, ec);
+            if (ec)
+            {
+                return false;
+            }
+            mtime = static_cast<int64_t>(time.time_since_epoch().count());
+            return true;
+        }
+
+        class CacheReader
+        {
+        public:
+            CacheReader(const unsigned char *data, size_t size) : m_Data(data), m_Size(size), m_Offset(0) {}
+
+            template <typename T>
+            T read()
+            {
+                T value;
+                readBytes(&value, sizeof(T));
+                return value;
+            }
+
+            std::string readString()
+            {
+                uint32_t length = read<uint32_t>();
+                require(length);
+                std::string str(reinterpret_cast<const char *>(m_Data + m_Offset), length);
+                m_Offset += length;
+                return str;
+            }
+
+            void readBytes(void *dst, size_t size)
+            {
+                require(size);
+                std::memcpy(dst, m_Data + m_Offset, size);
+                m_Offset += size;
+            }
+
+            void align(size_t alignment)
+            {
+                size_t padding = (alignment - m_Offset % alignment) % alignment;
+                require(padding);
+                m_Offset += padding;
+            }
+
+            void skip(size_t size)
+            {
+                require(size);
+                m_Offset += size;
+            }
+
+        private:
+            const unsigned char *m_Data;
+            size_t m_Size;
+            size_t m_Offset;
+
+            void require(size_t size)
+            {
+                if (size > m_Size - m_Offset)
+                {
+                    throw std::runtime_error("Unexpected end of mesh cache");
+                }
+            }
+        };
+
+        bool readHeader(CacheReader &reader, const std::string &cachePath, CacheHeader &header)
+        {
+            header = reader.read<CacheHeader>();
+            if (header.magic != MeshCache::MAGIC || header.version != MeshCache::VERSION ||
+                header.vertexSize != sizeof(StaticMesh::Vertex))
+            {
+                spdlog::info("Mesh cache \"{}\" has an incompatible version and will be rebuilt", cachePath);
+                return false;
+            }
+            return true;
+        }
+
+        void readMaterial(CacheReader &reader, ImportedMaterial &material)
+        {
+            material.name = reader.readString();
+            material.diffuseColor = reader.read<glm::vec3>();
+            material.diffuseMap = reader.readString();
+            material.normalMap = reader.readString();
+            material.roughnessMap = reader.readString();
+            material.metalnessMap = reader.readString();
+        }
+
+        // Skips the vertex and index arrays instead of copying them if withData is false
+        void readSubmeshRecord(CacheReader &reader, size_t fileSize, ImportedSubmesh &submesh, bool withData)
+        {
+            submesh.name = reader.readString();
+            submesh.materialIndex = reader.read<int32_t>();
+            uint64_t vertexCount = reader.read<uint64_t>();
+            uint64_t indexCount = reader.read<uint64_t>();
+            uint32_t lodCount = reader.read<uint32_t>();
+
+            if (vertexCount > fileSize / sizeof(StaticMesh::Vertex) || indexCount > fileSize / sizeof(GLuint) ||
+                lodCount > fileSize / sizeof(StaticMesh::Lod))
+            {
+                throw std::runtime_error("Corrupt submesh header");
+            }
+            submesh.lods.resize(lodCount);
+            reader.readBytes(submesh.lods.data(), lodCount * sizeof(StaticMesh::Lod));
+
+            reader.align(ARRAY_ALIGNMENT);
+            if (withData)
+            {
+                submesh.vertices.resize(vertexCount);
+                reader.readBytes(submesh.vertices.data(), vertexCount * sizeof(StaticMesh::Vertex));
+            }
+            else
+            {
+                reader.skip(vertexCount * sizeof(StaticMesh::Vertex));
+            }
+
+            reader.align(ARRAY_ALIGNMENT);
+            if (withData)
+            {
+                submesh.triangleIndices.resize(indexCount);
+                reader.readBytes(submesh.triangleIndices.data(), indexCount * sizeof(GLuint));
+            }
+            else
+            {
+                reader.skip(indexCount * sizeof(GLuint));
+            }
+        }
+
+        class CacheWriter
+        {
+        public:
+            CacheWriter(std::ofstream &stream) : m_Stream(stream), m_Offset(0) {}
+
+            template <typename T>
+            void write(const T &value)
+            {
+                writeBytes(&value, sizeof(T));
+            }
+
+            void writeString(const std::string &str)
+            {
+                write<uint32_t>(static_cast<uint32_t>(str.size()));
+                writeBytes(str.data(), str.size());
+            }
+
+            void writeBytes(const void *src, size_t size)
+            {
+                m_Stream.write(reinterpret_cast<const char *>(src), size);
+                m_Offset += size;
+            }
+
+            void align(size_t alignment)
+            {
+                static const char zeros[ARRAY_ALIGNMENT]{};
+                writeBytes(zeros, (alignment - m_Offset % alignment) % alignment);
+            }
+
+        private:
+            std::ofstream &m_Stream;
+            size_t m_Offset;
+        };
+    }
+
+    bool MeshCache::read(const std::string &cachePath, ImportedMesh &mesh, const std::string &sourceDirectory)
+    {
+        if (!std::filesystem::exists(cachePath))
+        {
+            return false;
+        }
+
+        try
+        {
+            MappedFile file(cachePath);
+            return read(file.data(), file.size(), cachePath, mesh, true, sourceDirectory);
+        }
+        catch (std::exception &e)
+        {
+            spdlog::warn("Unable to read mesh cache \"{}\": {}", cachePath, e.what());
+            return false;
+        }
+    }
+
+    bool MeshCache::read(const unsigned char *data, size_t size, const std::string &label, ImportedMesh &mesh,
+                         bool validateSources, const std::string &sourceDirectory)
+    {
+        try
+        {
+            CacheReader reader(data, size);
+
+            CacheHeader header;
+            if (!readHeader(reader, label, header))
+            {
+                return false;
+            }
+
+            ImportedMesh result;
+
+            for (uint32_t i = 0; i < header.sourceCount; i++)
+            {
+                std::string sourcePath = reader.readString();
+                SourceStamp stamp = reader.read<SourceStamp>();
+                result.sourcePaths.push_back(sourcePath);
+                if (!validateSources)
+                {
+                    continue;
+                }
+
+                std::string filePath = sourceFilePath(sourceDirectory, sourcePath);
+                uint64_t sourceSize;
+                int64_t mtime;
+                if (!statFile(filePath, sourceSize, mtime))
+                {
+                    if (!sourceDirectory.empty())
+                    {
+                        continue;
+                    }
+                    spdlog::info("Mesh cache \"{}\" is stale: \"{}\" has changed", label, sourcePath);
+                    return false;
+                }
+                if (sourceSize != stamp.size)
+                {
+                    spdlog::info("Mesh cache \"{}\" is stale: \"{}\" has changed", label, sourcePath);
+                    return false;
+                }
+                // A touched but otherwise identical file keeps the cache valid
+                if (mtime != stamp.mtime && hashFile(filePath) != stamp.hash)
+                {
+                    spdlog::info("Mesh cache \"{}\" is stale: \"{}\" has changed", label, sourcePath);
+                    return false;
+                }
+            }
+
+            result.materials.resize(header.materialCount);
+            for (auto &material : result.materials)
+            {
+                readMaterial(reader, material);
+            }
+
+            result.submeshes.resize(header.submeshCount);
+            for (auto &submesh : result.submeshes)
+            {
+                readSubmeshRecord(reader, size, submesh, true);
+            }
+
+            mesh = std::move(result);
+        }
+        catch (std::exception &e)
+        {
+            spdlog::warn("Unable to read mesh cache \"{}\": {}", label, e.what());
+            return false;
+        }
+
+        spdlog::trace("Loaded {} submeshes from mesh cache \"{}\"", mesh.submeshes.size(), label);
+        return true;
+    }
+
+    bool MeshCache::readSubmesh(const std::string &cachePath, size_t submeshIndex, ImportedSubmesh &submesh)
+    {
+        try
+        {
+            MappedFile file(cachePath);
+            return readSubmesh(file.data(), file.size(), cachePath, submeshIndex, submesh);
+        }
+        catch (std::exception &e)
+        {
+            spdlog::warn("Unable to read submesh {} from mesh cache \"{}\": {}", submeshIndex, cachePath, e.what());
+            return false;
+        }
+    }
+
+    bool MeshCache::readSubmesh(const unsigned char *data, size_t size, const std::string &label,
+                                size_t submeshIndex, ImportedSubmesh &submesh)
+    {
+        try
+        {
+            CacheReader reader(data, size);
+
+            CacheHeader header;
+            if (!readHeader(reader, label, header))
+            {
+                return false;
+            }
+            if (submeshIndex >= header.submeshCount)
+            {
+                spdlog::warn("Mesh cache \"{}\" has no submesh {}", label, submeshIndex);
+                return false;
+            }
+
+            for (uint32_t i = 0; i < header.sourceCount; i++)
+            {
+                reader.readString();
+                reader.read<SourceStamp>();
+            }
+            ImportedMaterial material;
+            for (uint32_t i = 0; i < header.materialCount; i++)
+            {
+                readMaterial(reader, material);
+            }
+            ImportedSubmesh skipped;
+            for (size_t i = 0; i < submeshIndex; i++)
+            {
+                readSubmeshRecord(reader, size, skipped, false);
+            }
+            readSubmeshRecord(reader, size, submesh, true);
+        }
+        catch (std::exception &e)
+        {
+            spdlog::warn("Unable to read submesh {} from mesh cache \"{}\": {}", submeshIndex, label, e.what());
+            return false;
+        }
+        return true;
+    }
+
+    bool MeshCache::write(const std::string &cachePath, const ImportedMesh &mesh, const std::string &sourceDirectory)
+    {
+        spdlog::trace("Writing mesh cache \"{}\"", cachePath);
+
+        // Write to a temporary file first so that an interrupted write never leaves a broken cache
+        std::string tempPath = cachePath + ".tmp";
+        try
+        {
+            std::ofstream stream(tempPath, std::ios::out | std::ios::binary | std::ios::trunc);
+            if (!stream.is_open())
+            {
+                spdlog::warn("Unable to create mesh cache \"{}\"", cachePath);
+                return false;
+            }
+            CacheWriter writer(stream);
+
+            CacheHeader header{MAGIC,
+                               VERSION,
+                               static_cast<uint32_t>(sizeof(StaticMesh::Vertex)),
+                               static_cast<uint32_t>(mesh.sourcePaths.size()),
+                               static_cast<uint32_t>(mesh.materials.size()),
+                               static_cast<uint32_t>(mesh.submeshes.size())};
+            writer.write(header);
+
+            for (const auto &sourcePath : mesh.sourcePaths)
+            {
+                std::string filePath = sourceFilePath(sourceDirectory, sourcePath);
+                SourceStamp stamp;
+                if (!statFile(filePath, stamp.size, stamp.mtime))
+                {
+                    throw std::runtime_error("Unable to stat source file " + filePath);
+                }
+                stamp.hash = hashFile(filePath);
+                writer.writeString(sourcePath);
+                writer.write(stamp);
+            }
+
+            for (const auto &material : mesh.materials)
+            {
+                writer.writeString(material.name);
+                writer.write(material.diffuseColor);
+                writer.writeString(material.diffuseMap);
+                writer.writeString(material.normalMap);
+                writer.writeString(material.roughnessMap);
+                writer.writeString(material.metalnessMap);
+            }
+
+            for (const auto &submesh : mesh.submeshes)
+            {
+                writer.writeString(submesh.name);
+                writer.write<int32_t>(submesh.materialIndex);
+                writer.write<uint64_t>(submesh.vertices.size());
+                writer.write<uint64_t>(submesh.triangleIndices.size());
+                writer.write<uint32_t>(static_cast<uint32_t>(submesh.lods.size()));
+                writer.writeBytes(submesh.lods.data(), submesh.lods.size() * sizeof(StaticMesh::Lod));
+
+                writer.align(ARRAY_ALIGNMENT);
+                writer.writeBytes(submesh.vertices.data(), submesh.vertices.size() * sizeof(StaticMesh::Vertex));
+                writer.align(ARRAY_ALIGNMENT);
+                writer.writeBytes(submesh.triangleIndices.data(), submesh.triangleIndices.size() * sizeof(GLuint));
+            }
+
+            stream.close();
+            if (stream.fail())
+            {
+                throw std::runtime_error("Write failed");
+            }
+            std::filesystem::rename(tempPath, cachePath);
+        }
+        catch (std::exception &e)
+        {
+            spdlog::warn("Unable to write mesh cache \"{}\": {}", cachePath, e.what());
+            std::error_code ec;
+            std::filesystem::remove(tempPath, ec);
+            return false;
+        }
+
+        return true;
+    }
+}
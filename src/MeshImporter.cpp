@@ -0,0 +1,159 @@
+#include "MeshImporter.hpp"
+#include "ObjParser.hpp"
+#include "StaticMesh.hpp"
+#include "MeshOptimizer.hpp"
+#include "MeshSimplifier.hpp"
+#include "Hash.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <unordered_map>
+#include <filesystem>
+#include <stdexcept>
+#include <chrono>
+#include <cstring>
+
+namespace planets
+{
+    namespace
+    {
+        // Unique combination of vertex attributes, used to weld the per-corner OBJ vertices
+        struct VertexKey
+        {
+            glm::vec3 position;
+            glm::vec3 normal;
+            glm::vec2 uv;
+
+            bool operator==(const VertexKey &other) const
+            {
+                // Bitwise comparison, consistent with the hash below
+                return std::memcmp(this, &other, sizeof(VertexKey)) == 0;
+            }
+        };
+
+        struct VertexKeyHash
+        {
+            size_t operator()(const VertexKey &key) const noexcept
+            {
+                return static_cast<size_t>(hashBytes(&key, sizeof(VertexKey)));
+            }
+        };
+
+        static_assert(sizeof(VertexKey) == 8 * sizeof(float), "VertexKey must not contain padding");
+    }
+
+    ImportedMesh MeshImporter::importObj(const std::string &fullPath, ThreadPool &threadPool)
+    {
+        std::filesystem::path path(fullPath);
+        VirtualFileSystem vfs(path.has_parent_path() ? path.parent_path().string() : std::string("."));
+        return importObj(vfs, path.filename().string(), threadPool);
+    }
+
+    ImportedMesh MeshImporter::importObj(const VirtualFileSystem &vfs, const std::string &path, ThreadPool &threadPool)
+    {
+        spdlog::trace("Parsing OBJ file \"{}\"", path);
+
+        auto parseStart = std::chrono::steady_clock::now();
+        VfsFile file = vfs.open(path, &threadPool);
+        ObjData obj = ObjParser::parseObj(reinterpret_cast<const char *>(file.data()), file.size(), threadPool);
+        spdlog::trace("Parsed OBJ file \"{}\" in {:.1f} ms ({} vertices, {} triangles)",
+                      path, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - parseStart).count(),
+                      obj.positions.size(), obj.indices.size() / 3);
+
+        ImportedMesh imported;
+        imported.sourcePaths.push_back(vfs.getLoosePath(path));
+
+        std::unordered_map<std::string, int32_t> materialIndices;
+        for (const auto &library : obj.materialLibraries)
+        {
+            // Material libraries are relative to the OBJ
+            std::string libraryPath = (std::filesystem::path(path).parent_path() / library).generic_string();
+            std::vector<ImportedMaterial> materials;
+            try
+            {
+                VfsFile libraryFile = vfs.open(libraryPath);
+                materials = ObjParser::parseMtl(reinterpret_cast<const char *>(libraryFile.data()), libraryFile.size());
+            }
+            catch (std::exception &e)
+            {
+                spdlog::warn("Unable to load material library \"{}\"", libraryPath);
+                continue;
+            }
+            imported.sourcePaths.push_back(vfs.getLoosePath(libraryPath));
+
+            for (auto &material : materials)
+            {
+                materialIndices[material.name] = static_cast<int32_t>(imported.materials.size());
+                imported.materials.push_back(std::move(material));
+            }
+        }
+
+        std::vector<glm::vec3> vertexPositions;
+        std::vector<glm::vec3> vertexNormals;
+        std::vector<glm::vec2> vertexUVs;
+        std::vector<GLuint> triangleIndices;
+        std::unordered_map<VertexKey, GLuint, VertexKeyHash> weldedVertices;
+        for (const auto &shape : obj.shapes)
+        {
+            for (size_t i = shape.indexBegin; i < shape.indexBegin + shape.indexCount; i++)
+            {
+                const ObjIndex &idx = obj.indices[i];
+                VertexKey key;
+
+                key.position = obj.positions[idx.position];
+                key.normal = idx.normal >= 0 ? obj.normals[idx.normal] : glm::vec3(0.0f);
+                key.uv = idx.texcoord >= 0 ? obj.texcoords[idx.texcoord] : glm::vec2(0.0f);
+
+                // Emit each unique vertex only once and reference it from the index buffer
+                auto [it, inserted] = weldedVertices.try_emplace(key, static_cast<GLuint>(vertexPositions.size()));
+                if (inserted)
+                {
+                    vertexPositions.push_back(key.position);
+                    vertexNormals.push_back(key.normal);
+                    vertexUVs.push_back(key.uv);
+                }
+                triangleIndices.push_back(it->second);
+            }
+
+            spdlog::trace("Submesh \"{}\": welded {} face corners into {} unique vertices",
+                          shape.name, triangleIndices.size(), vertexPositions.size());
+
+            ImportedSubmesh submesh;
+            submesh.name = shape.name;
+            // Pick the correct matrial for this (sub)mesh
+            auto materialIt = materialIndices.find(shape.materialName);
+            submesh.materialIndex = materialIt != materialIndices.end() ? materialIt->second : -1;
+            submesh.vertices = StaticMesh::buildVertices(vertexPositions, vertexNormals, vertexUVs, triangleIndices, &threadPool);
+            submesh.triangleIndices = triangleIndices;
+
+            // Reorder for the GPU once here, the caches and cooked meshes store the optimized order
+            auto optimizeStart = std::chrono::steady_clock::now();
+            MeshOptimizer::Statistics statistics = MeshOptimizer::optimize(submesh.vertices, submesh.triangleIndices);
+            spdlog::trace("Submesh \"{}\": ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f} (optimized in {:.1f} ms)",
+                          shape.name, statistics.before.acmr, statistics.after.acmr,
+                          statistics.before.atvr, statistics.after.atvr,
+                          std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - optimizeStart).count());
+
+            auto lodStart = std::chrono::steady_clock::now();
+            submesh.lods = MeshSimplifier::generateLods(submesh.vertices, submesh.triangleIndices);
+            std::string lodSummary;
+            for (const auto &lod : submesh.lods)
+            {
+                lodSummary += fmt::format(" {} ({:.4f})", lod.indexCount / 3, lod.error);
+            }
+            spdlog::trace("Submesh \"{}\": {} LODs in {:.1f} ms, triangles (error):{}",
+                          shape.name, submesh.lods.size(),
+                          std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - lodStart).count(),
+                          lodSummary);
+            imported.submeshes.push_back(std::move(submesh));
+
+            vertexPositions.clear();
+            vertexNormals.clear();
+            vertexUVs.clear();
+            triangleIndices.clear();
+            weldedVertices.clear();
+        }
+
+        return imported;
+    }
+}
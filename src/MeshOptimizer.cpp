@@ -0,0 +1,409 @@
+#include "MeshOptimizer.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <cmath>
+#include <cstdint>
+
+namespace planets
+{
+    namespace
+    {
+        constexpr GLuint INVALID_INDEX = ~0u;
+
+        // Forsyth's scoring, see https://tomforsyth1000.github.io/papers/fast_vert_cache_opt.html
+        constexpr size_t FORSYTH_CACHE_SIZE = 32;
+        constexpr size_t FORSYTH_MAX_VALENCE = 32;
+        constexpr float LAST_TRIANGLE_SCORE = 0.75f;
+        constexpr float CACHE_DECAY_POWER = 1.5f;
+        constexpr float VALENCE_BOOST_SCALE = 2.0f;
+        constexpr float VALENCE_BOOST_POWER = 0.5f;
+
+        struct ScoreTables
+        {
+            float cache[FORSYTH_CACHE_SIZE];
+            float valence[FORSYTH_MAX_VALENCE + 1];
+
+            ScoreTables()
+            {
+                for (size_t i = 0; i < FORSYTH_CACHE_SIZE; i++)
+                {
+                    // The three vertices of the last triangle get a fixed score so the next one doesn't just reuse them
+                    cache[i] = i < 3 ? LAST_TRIANGLE_SCORE
+                                     : std::pow(1.0f - static_cast<float>(i - 3) / (FORSYTH_CACHE_SIZE - 3), CACHE_DECAY_POWER);
+                }
+                valence[0] = 0.0f;
+                for (size_t i = 1; i <= FORSYTH_MAX_VALENCE; i++)
+                {
+                    // Vertices with few triangles left get finished first so they can leave the cache
+                    valence[i] = VALENCE_BOOST_SCALE * std::pow(static_cast<float>(i), -VALENCE_BOOST_POWER);
+                }
+            }
+
+            float score(int cachePosition, size_t remainingTriangles) const
+            {
+                if (remainingTriangles == 0)
+                {
+                    return -1.0f;
+                }
+                float score = cachePosition >= 0 ? cache[cachePosition] : 0.0f;
+                return score + valence[std::min(remainingTriangles, FORSYTH_MAX_VALENCE)];
+            }
+        };
+
+        void validateIndices(const std::vector<GLuint> &triangleIndices, size_t vertexCount)
+        {
+            if (triangleIndices.size() % 3 != 0)
+            {
+                spdlog::error("Index count {} is not a multiple of 3", triangleIndices.size());
+                throw std::runtime_error("Index count is not a multiple of 3");
+            }
+            for (GLuint index : triangleIndices)
+            {
+                if (index >= vertexCount)
+                {
+                    spdlog::error("Index {} is out of range for {} vertices", index, vertexCount);
+                    throw std::runtime_error("Index out of range");
+                }
+            }
+        }
+
+        // Counts the FIFO misses of every triangle, the timestamps trick avoids storing the cache itself
+        class FifoCache
+        {
+        public:
+            FifoCache(size_t vertexCount, size_t cacheSize)
+                : m_Timestamps(vertexCount, 0), m_CacheSize(static_cast<uint32_t>(cacheSize)), m_Time(m_CacheSize + 1)
+            {
+            }
+
+            void reset() { m_Time += m_CacheSize + 1; }
+
+            unsigned triangleMisses(const GLuint *triangle)
+            {
+                unsigned misses = 0;
+                for (int corner = 0; corner < 3; corner++)
+                {
+                    if (m_Time - m_Timestamps[triangle[corner]] > m_CacheSize)
+                    {
+                        m_Timestamps[triangle[corner]] = m_Time++;
+                        misses++;
+                    }
+                }
+                return misses;
+            }
+
+        private:
+            std::vector<uint32_t> m_Timestamps;
+            uint32_t m_CacheSize;
+            uint32_t m_Time;
+        };
+    }
+
+    MeshOptimizer::VertexCacheStatistics MeshOptimizer::analyzeVertexCache(const std::vector<GLuint> &triangleIndices,
+                                                                           size_t vertexCount,
+                                                                           size_t cacheSize)
+    {
+        VertexCacheStatistics statistics;
+        if (triangleIndices.empty())
+        {
+            return statistics;
+        }
+
+        FifoCache cache(vertexCount, cacheSize);
+        std::vector<bool> referenced(vertexCount, false);
+        size_t misses = 0, referencedCount = 0;
+        for (size_t i = 0; i < triangleIndices.size(); i += 3)
+        {
+            misses += cache.triangleMisses(&triangleIndices[i]);
+            for (int corner = 0; corner < 3; corner++)
+            {
+                if (!referenced[triangleIndices[i + corner]])
+                {
+                    referenced[triangleIndices[i + corner]] = true;
+                    referencedCount++;
+                }
+            }
+        }
+
+        statistics.acmr = static_cast<float>(misses) / (triangleIndices.size() / 3);
+        statistics.atvr = static_cast<float>(misses) / referencedCount;
+        return statistics;
+    }
+
+    std::vector<GLuint> MeshOptimizer::optimizeVertexCache(const std::vector<GLuint> &triangleIndices, size_t vertexCount)
+    {
+        validateIndices(triangleIndices, vertexCount);
+        static const ScoreTables scoreTables;
+
+        size_t triangleCount = triangleIndices.size() / 3;
+
+        // Triangles around each vertex, the first remainingTriangles[v] of them are not emitted yet
+        std::vector<size_t> remainingTriangles(vertexCount, 0);
+        for (GLuint index : triangleIndices)
+        {
+            remainingTriangles[index]++;
+        }
+        std::vector<size_t> adjacencyOffsets(vertexCount + 1, 0);
+        std::partial_sum(remainingTriangles.begin(), remainingTriangles.end(), adjacencyOffsets.begin() + 1);
+        std::vector<GLuint> adjacency(triangleIndices.size());
+        {
+            std::vector<size_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+            for (size_t i = 0; i < triangleIndices.size(); i++)
+            {
+                adjacency[fill[triangleIndices[i]]++] = static_cast<GLuint>(i / 3);
+            }
+        }
+
+        std::vector<float> vertexScores(vertexCount);
+        for (size_t v = 0; v < vertexCount; v++)
+        {
+            vertexScores[v] = scoreTables.score(-1, remainingTriangles[v]);
+        }
+
+        std::vector<float> triangleScores(triangleCount);
+        std::vector<bool> emitted(triangleCount, false);
+        GLuint bestTriangle = INVALID_INDEX;
+        for (size_t t = 0; t < triangleCount; t++)
+        {
+            triangleScores[t] = vertexScores[triangleIndices[3 * t]] +
+                                vertexScores[triangleIndices[3 * t + 1]] +
+                                vertexScores[triangleIndices[3 * t + 2]];
+            if (bestTriangle == INVALID_INDEX || triangleScores[t] > triangleScores[bestTriangle])
+            {
+                bestTriangle = static_cast<GLuint>(t);
+            }
+        }
+
+        std::vector<GLuint> optimized;
+        optimized.reserve(triangleIndices.size());
+        std::vector<GLuint> cache, nextCache;
+        cache.reserve(FORSYTH_CACHE_SIZE + 3);
+        nextCache.reserve(FORSYTH_CACHE_SIZE + 3);
+        size_t cursor = 0;
+
+        for (size_t emittedCount = 0; emittedCount < triangleCount; emittedCount++)
+        {
+            // Dead end, nothing in the cache has triangles left: continue with the next triangle in input order
+            if (bestTriangle == INVALID_INDEX)
+            {
+                while (emitted[cursor])
+                {
+                    cursor++;
+                }
+                bestTriangle = static_cast<GLuint>(cursor);
+            }
+
+            const GLuint *triangle = &triangleIndices[3 * bestTriangle];
+            optimized.insert(optimized.end(), triangle, triangle + 3);
+            emitted[bestTriangle] = true;
+
+            // Move the triangle out of the live part of its vertices' adjacency
+            for (int corner = 0; corner < 3; corner++)
+            {
+                GLuint v = triangle[corner];
+                GLuint *begin = &adjacency[adjacencyOffsets[v]];
+                GLuint *last = begin + remainingTriangles[v] - 1;
+                std::iter_swap(std::find(begin, last + 1, bestTriangle), last);
+                remainingTriangles[v]--;
+            }
+
+            // LRU: the triangle's vertices go to the front, everything else moves back
+            nextCache.assign(triangle, triangle + 3);
+            for (GLuint v : cache)
+            {
+                if (v != triangle[0] && v != triangle[1] && v != triangle[2])
+                {
+                    nextCache.push_back(v);
+                }
+            }
+            std::swap(cache, nextCache);
+
+            // Rescore everything that was or is in the cache and find the best triangle around it
+            bestTriangle = INVALID_INDEX;
+            float bestScore = 0.0f;
+            for (size_t position = 0; position < cache.size(); position++)
+            {
+                GLuint v = cache[position];
+                int cachePosition = position < FORSYTH_CACHE_SIZE ? static_cast<int>(position) : -1;
+
+                float score = scoreTables.score(cachePosition, remainingTriangles[v]);
+                float delta = score - vertexScores[v];
+                vertexScores[v] = score;
+
+                for (size_t a = adjacencyOffsets[v]; a < adjacencyOffsets[v] + remainingTriangles[v]; a++)
+                {
+                    GLuint t = adjacency[a];
+                    triangleScores[t] += delta;
+                    if (bestTriangle == INVALID_INDEX || triangleScores[t] > bestScore)
+                    {
+                        bestTriangle = t;
+                        bestScore = triangleScores[t];
+                    }
+                }
+            }
+            // Vertices pushed out of the cache have been rescored as uncached above
+            if (cache.size() > FORSYTH_CACHE_SIZE)
+            {
+                cache.resize(FORSYTH_CACHE_SIZE);
+            }
+        }
+
+        return optimized;
+    }
+
+    std::vector<GLuint> MeshOptimizer::optimizeOverdraw(const std::vector<GLuint> &triangleIndices,
+                                                        const std::vector<StaticMesh::Vertex> &vertices,
+                                                        float threshold)
+    {
+        validateIndices(triangleIndices, vertices.size());
+        size_t triangleCount = triangleIndices.size() / 3;
+        if (triangleCount < 2)
+        {
+            return triangleIndices;
+        }
+
+        // Hard boundaries: triangles where the cache optimized order had to start from scratch
+        std::vector<size_t> hardClusters;
+        {
+            FifoCache cache(vertices.size(), FIFO_CACHE_SIZE);
+            for (size_t t = 0; t < triangleCount; t++)
+            {
+                if (cache.triangleMisses(&triangleIndices[3 * t]) == 3)
+                {
+                    hardClusters.push_back(t);
+                }
+            }
+        }
+        if (hardClusters.empty() || hardClusters.front() != 0)
+        {
+            hardClusters.insert(hardClusters.begin(), 0);
+        }
+        hardClusters.push_back(triangleCount);
+
+        // Soft boundaries: split hard clusters wherever a cold restart keeps the ACMR within the threshold
+        std::vector<size_t> clusters;
+        FifoCache cache(vertices.size(), FIFO_CACHE_SIZE);
+        for (size_t c = 0; c + 1 < hardClusters.size(); c++)
+        {
+            size_t begin = hardClusters[c], end = hardClusters[c + 1];
+
+            cache.reset();
+            size_t clusterMisses = 0;
+            for (size_t t = begin; t < end; t++)
+            {
+                clusterMisses += cache.triangleMisses(&triangleIndices[3 * t]);
+            }
+            float clusterThreshold = threshold * clusterMisses / (end - begin);
+
+            clusters.push_back(begin);
+            cache.reset();
+            size_t misses = 0, start = begin;
+            for (size_t t = begin; t < end; t++)
+            {
+                misses += cache.triangleMisses(&triangleIndices[3 * t]);
+                if (t + 1 < end && misses <= clusterThreshold * (t + 1 - start))
+                {
+                    clusters.push_back(t + 1);
+                    cache.reset();
+                    misses = 0;
+                    start = t + 1;
+                }
+            }
+        }
+        clusters.push_back(triangleCount);
+
+        // Area weighted centroids and normals, clusters facing away from the mesh centre go first
+        glm::vec3 meshCentroid(0.0f);
+        float meshArea = 0.0f;
+        std::vector<glm::vec3> clusterCentroids(clusters.size() - 1, glm::vec3(0.0f));
+        std::vector<glm::vec3> clusterNormals(clusters.size() - 1, glm::vec3(0.0f));
+        for (size_t c = 0; c + 1 < clusters.size(); c++)
+        {
+            float clusterArea = 0.0f;
+            for (size_t t = clusters[c]; t < clusters[c + 1]; t++)
+            {
+                const glm::vec3 &p0 = vertices[triangleIndices[3 * t]].position;
+                const glm::vec3 &p1 = vertices[triangleIndices[3 * t + 1]].position;
+                const glm::vec3 &p2 = vertices[triangleIndices[3 * t + 2]].position;
+                glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+                float area = glm::length(normal);
+
+                clusterCentroids[c] += (p0 + p1 + p2) * (area / 3.0f);
+                clusterNormals[c] += normal;
+                clusterArea += area;
+            }
+            meshCentroid += clusterCentroids[c];
+            meshArea += clusterArea;
+            clusterCentroids[c] = clusterArea > 0.0f ? clusterCentroids[c] / clusterArea : vertices[triangleIndices[3 * clusters[c]]].position;
+        }
+        meshCentroid = meshArea > 0.0f ? meshCentroid / meshArea : glm::vec3(0.0f);
+
+        std::vector<float> sortKeys(clusters.size() - 1, 0.0f);
+        for (size_t c = 0; c + 1 < clusters.size(); c++)
+        {
+            float normalLength = glm::length(clusterNormals[c]);
+            if (normalLength > 0.0f)
+            {
+                sortKeys[c] = glm::dot(clusterCentroids[c] - meshCentroid, clusterNormals[c] / normalLength);
+            }
+        }
+
+        std::vector<size_t> order(clusters.size() - 1);
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b)
+                         { return sortKeys[a] > sortKeys[b]; });
+
+        std::vector<GLuint> optimized;
+        optimized.reserve(triangleIndices.size());
+        for (size_t c : order)
+        {
+            optimized.insert(optimized.end(),
+                             triangleIndices.begin() + 3 * clusters[c],
+                             triangleIndices.begin() + 3 * clusters[c + 1]);
+        }
+
+        // The soft boundaries are a local estimate, never give away more vertex cache efficiency than allowed
+        float inputAcmr = analyzeVertexCache(triangleIndices, vertices.size()).acmr;
+        if (analyzeVertexCache(optimized, vertices.size()).acmr > threshold * inputAcmr)
+        {
+            return triangleIndices;
+        }
+        return optimized;
+    }
+
+    void MeshOptimizer::optimizeVertexFetch(std::vector<StaticMesh::Vertex> &vertices, std::vector<GLuint> &triangleIndices)
+    {
+        validateIndices(triangleIndices, vertices.size());
+
+        std::vector<GLuint> remap(vertices.size(), INVALID_INDEX);
+        std::vector<StaticMesh::Vertex> reordered;
+        reordered.reserve(vertices.size());
+        for (GLuint &index : triangleIndices)
+        {
+            if (remap[index] == INVALID_INDEX)
+            {
+                remap[index] = static_cast<GLuint>(reordered.size());
+                reordered.push_back(vertices[index]);
+            }
+            index = remap[index];
+        }
+        vertices = std::move(reordered);
+    }
+
+    MeshOptimizer::Statistics MeshOptimizer::optimize(std::vector<StaticMesh::Vertex> &vertices, std::vector<GLuint> &triangleIndices)
+    {
+        Statistics statistics;
+        statistics.before = analyzeVertexCache(triangleIndices, vertices.size());
+
+        triangleIndices = optimizeVertexCache(triangleIndices, vertices.size());
+        triangleIndices = optimizeOverdraw(triangleIndices, vertices);
+        optimizeVertexFetch(vertices, triangleIndices);
+
+        statistics.after = analyzeVertexCache(triangleIndices, vertices.size());
+        return statistics;
+    }
+}
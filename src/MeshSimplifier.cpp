@@ -0,0 +1,343 @@
+#include "MeshSimplifier.hpp"
+#include "MeshOptimizer.hpp"
+#include "Hash.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <unordered_map>
+#include <algorithm>
+#include <stdexcept>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace planets
+{
+    namespace
+    {
+        // Symmetric 4x4 matrix summing squared distances to planes, weighted by triangle area
+        struct Quadric
+        {
+            double a00{0}, a01{0}, a02{0}, a03{0};
+            double a11{0}, a12{0}, a13{0};
+            double a22{0}, a23{0};
+            double a33{0};
+            double weight{0};
+
+            void addPlane(const glm::vec3 &normal, double d, double w)
+            {
+                double nx = normal.x, ny = normal.y, nz = normal.z;
+                a00 += w * nx * nx;
+                a01 += w * nx * ny;
+                a02 += w * nx * nz;
+                a03 += w * nx * d;
+                a11 += w * ny * ny;
+                a12 += w * ny * nz;
+                a13 += w * ny * d;
+                a22 += w * nz * nz;
+                a23 += w * nz * d;
+                a33 += w * d * d;
+                weight += w;
+            }
+
+            Quadric &operator+=(const Quadric &q)
+            {
+                a00 += q.a00;
+                a01 += q.a01;
+                a02 += q.a02;
+                a03 += q.a03;
+                a11 += q.a11;
+                a12 += q.a12;
+                a13 += q.a13;
+                a22 += q.a22;
+                a23 += q.a23;
+                a33 += q.a33;
+                weight += q.weight;
+                return *this;
+            }
+
+            // Weighted mean squared distance of p to the planes
+            double error(const glm::vec3 &p) const
+            {
+                double x = p.x, y = p.y, z = p.z;
+                double e = a00 * x * x + 2 * a01 * x * y + 2 * a02 * x * z + 2 * a03 * x +
+                           a11 * y * y + 2 * a12 * y * z + 2 * a13 * y +
+                           a22 * z * z + 2 * a23 * z +
+                           a33;
+                return weight > 0.0 ? std::max(e, 0.0) / weight : 0.0;
+            }
+        };
+
+        struct Collapse
+        {
+            GLuint from;
+            GLuint to;
+            double error;
+        };
+
+        struct PositionHash
+        {
+            size_t operator()(const glm::vec3 &p) const noexcept
+            {
+                return static_cast<size_t>(hashBytes(&p, sizeof(glm::vec3)));
+            }
+        };
+
+        struct PositionEqual
+        {
+            bool operator()(const glm::vec3 &a, const glm::vec3 &b) const noexcept
+            {
+                return std::memcmp(&a, &b, sizeof(glm::vec3)) == 0;
+            }
+        };
+
+        uint64_t edgeKey(GLuint a, GLuint b)
+        {
+            return a < b ? (static_cast<uint64_t>(a) << 32) | b : (static_cast<uint64_t>(b) << 32) | a;
+        }
+    }
+
+    std::vector<GLuint> MeshSimplifier::simplify(const std::vector<StaticMesh::Vertex> &vertices,
+                                                 const std::vector<GLuint> &triangleIndices,
+                                                 size_t targetIndexCount,
+                                                 float maxError,
+                                                 float &resultError)
+    {
+        resultError = 0.0f;
+        if (triangleIndices.size() % 3 != 0)
+        {
+            spdlog::error("Index count {} is not a multiple of 3", triangleIndices.size());
+            throw std::runtime_error("Index count is not a multiple of 3");
+        }
+
+        // Vertices sharing a position (split by normals or UVs) form one group
+        std::vector<GLuint> groups(vertices.size());
+        std::vector<GLuint> groupSizes;
+        {
+            std::unordered_map<glm::vec3, GLuint, PositionHash, PositionEqual> groupIds;
+            for (size_t v = 0; v < vertices.size(); v++)
+            {
+                auto [it, inserted] = groupIds.try_emplace(vertices[v].position, static_cast<GLuint>(groupSizes.size()));
+                if (inserted)
+                {
+                    groupSizes.push_back(0);
+                }
+                groups[v] = it->second;
+                groupSizes[it->second]++;
+            }
+        }
+
+        // Edges used by a single triangle (between position groups) are open borders
+        std::vector<bool> locked(vertices.size(), false);
+        {
+            std::unordered_map<uint64_t, int> edgeUses;
+            for (size_t i = 0; i < triangleIndices.size(); i += 3)
+            {
+                for (int e = 0; e < 3; e++)
+                {
+                    edgeUses[edgeKey(groups[triangleIndices[i + e]], groups[triangleIndices[i + (e + 1) % 3]])]++;
+                }
+            }
+            std::vector<bool> borderGroups(groupSizes.size(), false);
+            for (size_t i = 0; i < triangleIndices.size(); i += 3)
+            {
+                for (int e = 0; e < 3; e++)
+                {
+                    GLuint a = groups[triangleIndices[i + e]], b = groups[triangleIndices[i + (e + 1) % 3]];
+                    if (edgeUses[edgeKey(a, b)] == 1)
+                    {
+                        borderGroups[a] = borderGroups[b] = true;
+                    }
+                }
+            }
+            for (size_t v = 0; v < vertices.size(); v++)
+            {
+                locked[v] = groupSizes[groups[v]] > 1 || borderGroups[groups[v]];
+            }
+        }
+
+        std::vector<Quadric> quadrics(groupSizes.size());
+        for (size_t i = 0; i < triangleIndices.size(); i += 3)
+        {
+            const glm::vec3 &p0 = vertices[triangleIndices[i]].position;
+            const glm::vec3 &p1 = vertices[triangleIndices[i + 1]].position;
+            const glm::vec3 &p2 = vertices[triangleIndices[i + 2]].position;
+            glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+            float length = glm::length(normal);
+            if (length == 0.0f)
+            {
+                continue;
+            }
+            normal /= length;
+            double d = -glm::dot(normal, p0);
+            for (int corner = 0; corner < 3; corner++)
+            {
+                quadrics[groups[triangleIndices[i + corner]]].addPlane(normal, d, length * 0.5);
+            }
+        }
+
+        std::vector<GLuint> current = triangleIndices;
+        double maxErrorSquared = static_cast<double>(maxError) * maxError;
+        double largestError = 0.0;
+
+        // Each pass makes independent collapses (no two touch the same triangles), then compacts the indices
+        while (current.size() > targetIndexCount)
+        {
+            std::vector<GLuint> triangleOffsets(vertices.size() + 1, 0);
+            for (GLuint index : current)
+            {
+                triangleOffsets[index + 1]++;
+            }
+            for (size_t v = 0; v < vertices.size(); v++)
+            {
+                triangleOffsets[v + 1] += triangleOffsets[v];
+            }
+            std::vector<GLuint> vertexTriangles(current.size());
+            {
+                std::vector<GLuint> fill(triangleOffsets.begin(), triangleOffsets.end() - 1);
+                for (size_t i = 0; i < current.size(); i++)
+                {
+                    vertexTriangles[fill[current[i]]++] = static_cast<GLuint>(i / 3);
+                }
+            }
+
+            std::vector<Collapse> collapses;
+            for (size_t i = 0; i < current.size(); i += 3)
+            {
+                for (int e = 0; e < 3; e++)
+                {
+                    GLuint a = current[i + e], b = current[i + (e + 1) % 3];
+                    for (auto [from, to] : {std::make_pair(a, b), std::make_pair(b, a)})
+                    {
+                        if (locked[from])
+                        {
+                            continue;
+                        }
+                        Quadric merged = quadrics[groups[from]];
+                        merged += quadrics[groups[to]];
+                        collapses.push_back({from, to, merged.error(vertices[to].position)});
+                    }
+                }
+            }
+            std::sort(collapses.begin(), collapses.end(), [](const Collapse &a, const Collapse &b)
+                      { return a.error < b.error; });
+
+            std::vector<GLuint> remap(vertices.size());
+            for (size_t v = 0; v < vertices.size(); v++)
+            {
+                remap[v] = static_cast<GLuint>(v);
+            }
+            std::vector<bool> touched(vertices.size(), false);
+            size_t trianglesToRemove = (current.size() - targetIndexCount + 2) / 3;
+            size_t removed = 0, collapsed = 0;
+
+            for (const Collapse &collapse : collapses)
+            {
+                if (collapse.error > maxErrorSquared || removed >= trianglesToRemove)
+                {
+                    break;
+                }
+                if (touched[collapse.from] || touched[collapse.to])
+                {
+                    continue;
+                }
+
+                // Reject collapses that flip a triangle around the removed vertex
+                bool flips = false;
+                size_t shared = 0;
+                const glm::vec3 &target = vertices[collapse.to].position;
+                for (GLuint t = triangleOffsets[collapse.from]; t < triangleOffsets[collapse.from + 1] && !flips; t++)
+                {
+                    const GLuint *triangle = &current[3 * vertexTriangles[t]];
+                    if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to)
+                    {
+                        shared++;
+                        continue;
+                    }
+                    glm::vec3 before[3], after[3];
+                    for (int corner = 0; corner < 3; corner++)
+                    {
+                        before[corner] = vertices[triangle[corner]].position;
+                        after[corner] = triangle[corner] == collapse.from ? target : before[corner];
+                    }
+                    glm::vec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+                    glm::vec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+                    flips = glm::dot(normalBefore, normalAfter) <= 0.0f;
+                }
+                if (flips)
+                {
+                    continue;
+                }
+
+                remap[collapse.from] = collapse.to;
+                for (GLuint t = triangleOffsets[collapse.from]; t < triangleOffsets[collapse.from + 1]; t++)
+                {
+                    for (int corner = 0; corner < 3; corner++)
+                    {
+                        touched[current[3 * vertexTriangles[t] + corner]] = true;
+                    }
+                }
+                quadrics[groups[collapse.to]] += quadrics[groups[collapse.from]];
+                largestError = std::max(largestError, collapse.error);
+                removed += shared;
+                collapsed++;
+            }
+
+            if (collapsed == 0)
+            {
+                break;
+            }
+
+            std::vector<GLuint> next;
+            next.reserve(current.size());
+            for (size_t i = 0; i < current.size(); i += 3)
+            {
+                GLuint a = remap[current[i]], b = remap[current[i + 1]], c = remap[current[i + 2]];
+                if (a != b && b != c && a != c)
+                {
+                    next.insert(next.end(), {a, b, c});
+                }
+            }
+            current = std::move(next);
+        }
+
+        resultError = static_cast<float>(std::sqrt(largestError));
+        return current;
+    }
+
+    std::vector<StaticMesh::Lod> MeshSimplifier::generateLods(const std::vector<StaticMesh::Vertex> &vertices,
+                                                              std::vector<GLuint> &triangleIndices)
+    {
+        std::vector<StaticMesh::Lod> lods{{0, static_cast<GLuint>(triangleIndices.size()), 0.0f}};
+
+        glm::vec3 center;
+        float radius;
+        StaticMesh::computeBoundingSphere(vertices, center, radius);
+
+        std::vector<GLuint> previous = triangleIndices;
+        float error = 0.0f;
+        while (lods.size() < MAX_LODS)
+        {
+            size_t targetIndexCount = previous.size() / 6 * 3;
+            if (targetIndexCount / 3 < MIN_LOD_TRIANGLES)
+            {
+                break;
+            }
+
+            float lodError;
+            std::vector<GLuint> simplified = simplify(vertices, previous, targetIndexCount, radius * MAX_LOD_ERROR, lodError);
+            if (simplified.empty() || simplified.size() > previous.size() * (1.0f - MIN_LOD_REDUCTION))
+            {
+                break;
+            }
+
+            // Each level is simplified from the previous one, so their errors add up at most
+            error += lodError;
+            simplified = MeshOptimizer::optimizeVertexCache(simplified, vertices.size());
+            lods.push_back({static_cast<GLuint>(triangleIndices.size()), static_cast<GLuint>(simplified.size()), error});
+            triangleIndices.insert(triangleIndices.end(), simplified.begin(), simplified.end());
+            previous = std::move(simplified);
+        }
+        return lods;
+    }
+}
@@ -0,0 +1,597 @@
+#include "ObjParser.hpp"
+#include "MappedFile.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+#include <atomic>
+
+namespace planets
+{
+    namespace
+    {
+        // Chunks smaller than this are not worth a task of their own
+        constexpr size_t MIN_CHUNK_SIZE = 1 << 20;
+
+        struct Cursor
+        {
+            const char *ptr;
+            const char *end;
+
+            bool atLineEnd() const { return ptr >= end || *ptr == '\n' || *ptr == '\r' || *ptr == '#'; }
+
+            void skipSpaces()
+            {
+                while (ptr < end && (*ptr == ' ' || *ptr == '\t'))
+                {
+                    ptr++;
+                }
+            }
+
+            void skipLine()
+            {
+                const char *newline = static_cast<const char *>(std::memchr(ptr, '\n', end - ptr));
+                ptr = newline ? newline + 1 : end;
+            }
+
+            std::string_view token()
+            {
+                skipSpaces();
+                const char *begin = ptr;
+                while (ptr < end && *ptr != ' ' && *ptr != '\t' && *ptr != '\n' && *ptr != '\r')
+                {
+                    ptr++;
+                }
+                return std::string_view(begin, ptr - begin);
+            }
+
+            // Rest of the line without surrounding whitespace
+            std::string_view restOfLine()
+            {
+                skipSpaces();
+                const char *begin = ptr;
+                const char *newline = static_cast<const char *>(std::memchr(ptr, '\n', end - ptr));
+                const char *lineEnd = newline ? newline : end;
+                ptr = lineEnd;
+                while (lineEnd > begin && (lineEnd[-1] == '\r' || lineEnd[-1] == ' ' || lineEnd[-1] == '\t'))
+                {
+                    lineEnd--;
+                }
+                return std::string_view(begin, lineEnd - begin);
+            }
+
+            bool parseInt(int64_t &value)
+            {
+                bool negative = false;
+                if (ptr < end && (*ptr == '-' || *ptr == '+'))
+                {
+                    negative = *ptr == '-';
+                    ptr++;
+                }
+                if (ptr >= end || *ptr < '0' || *ptr > '9')
+                {
+                    return false;
+                }
+                int64_t result = 0;
+                while (ptr < end && *ptr >= '0' && *ptr <= '9')
+                {
+                    result = result * 10 + (*ptr - '0');
+                    ptr++;
+                }
+                value = negative ? -result : result;
+                return true;
+            }
+
+            // Locale independent float parser, a lot faster than strtof
+            bool parseFloat(float &value)
+            {
+                static const double POWERS_OF_TEN[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+                                                       1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18};
+                skipSpaces();
+                bool negative = false;
+                if (ptr < end && (*ptr == '-' || *ptr == '+'))
+                {
+                    negative = *ptr == '-';
+                    ptr++;
+                }
+
+                uint64_t mantissa = 0;
+                int exponent = 0;
+                int numDigits = 0;
+                bool anyDigits = false;
+                while (ptr < end && *ptr >= '0' && *ptr <= '9')
+                {
+                    if (numDigits < 18)
+                    {
+                        mantissa = mantissa * 10 + (*ptr - '0');
+                        numDigits += mantissa > 0;
+                    }
+                    else
+                    {
+                        exponent++;
+                    }
+                    anyDigits = true;
+                    ptr++;
+                }
+                if (ptr < end && *ptr == '.')
+                {
+                    ptr++;
+                    while (ptr < end && *ptr >= '0' && *ptr <= '9')
+                    {
+                        if (numDigits < 18)
+                        {
+                            mantissa = mantissa * 10 + (*ptr - '0');
+                            numDigits += mantissa > 0;
+                            exponent--;
+                        }
+                        anyDigits = true;
+                        ptr++;
+                    }
+                }
+                if (!anyDigits)
+                {
+                    return false;
+                }
+                if (ptr < end && (*ptr == 'e' || *ptr == 'E'))
+                {
+                    ptr++;
+                    int64_t explicitExponent;
+                    if (!parseInt(explicitExponent))
+                    {
+                        return false;
+                    }
+                    exponent += static_cast<int>(std::clamp<int64_t>(explicitExponent, -1000, 1000));
+                }
+
+                double result = static_cast<double>(mantissa);
+                while (exponent > 0)
+                {
+                    int step = std::min(exponent, 18);
+                    result *= POWERS_OF_TEN[step];
+                    exponent -= step;
+                }
+                while (exponent < 0 && result != 0.0)
+                {
+                    int step = std::min(-exponent, 18);
+                    result /= POWERS_OF_TEN[step];
+                    exponent += step;
+                }
+                value = static_cast<float>(negative ? -result : result);
+                return true;
+            }
+        };
+
+        // Statements that affect how faces are grouped into shapes
+        struct ChunkStatement
+        {
+            enum class Kind
+            {
+                Object,
+                Material,
+                MaterialLibrary
+            } kind;
+            size_t cornerPosition; // number of triangle corners in the chunk before the statement
+            std::string value;
+        };
+
+        struct ChunkResult
+        {
+            std::vector<glm::vec3> positions;
+            std::vector<glm::vec3> normals;
+            std::vector<glm::vec2> texcoords;
+            // Positive OBJ indices are already global, relative (negative) ones are local to the chunk
+            std::vector<ObjIndex> indices;
+            // Corners with relative indices and a mask of which of their components need the chunk offset
+            std::vector<std::pair<size_t, uint8_t>> relativeCorners;
+            std::vector<ChunkStatement> statements;
+            size_t malformedLines{0};
+        };
+
+        constexpr uint8_t RELATIVE_POSITION = 1 << 0;
+        constexpr uint8_t RELATIVE_TEXCOORD = 1 << 1;
+        constexpr uint8_t RELATIVE_NORMAL = 1 << 2;
+
+        // Converts an OBJ index into a zero-based one, returns true if it is relative to the chunk
+        bool resolveIndex(int64_t objIndex, size_t localCount, int32_t &index)
+        {
+            if (objIndex > 0)
+            {
+                index = static_cast<int32_t>(objIndex - 1);
+                return false;
+            }
+            index = static_cast<int32_t>(static_cast<int64_t>(localCount) + objIndex);
+            return true;
+        }
+
+        bool parseFaceCorner(Cursor &cursor, const ChunkResult &chunk, ObjIndex &corner, uint8_t &relativeMask)
+        {
+            corner = ObjIndex{-1, -1, -1};
+            relativeMask = 0;
+
+            int64_t value;
+            if (!cursor.parseInt(value) || value == 0)
+            {
+                return false;
+            }
+            if (resolveIndex(value, chunk.positions.size(), corner.position))
+            {
+                relativeMask |= RELATIVE_POSITION;
+            }
+
+            if (cursor.ptr < cursor.end && *cursor.ptr == '/')
+            {
+                cursor.ptr++;
+                // v//vn has no texture coordinate
+                if (cursor.ptr < cursor.end && *cursor.ptr != '/')
+                {
+                    if (!cursor.parseInt(value) || value == 0)
+                    {
+                        return false;
+                    }
+                    if (resolveIndex(value, chunk.texcoords.size(), corner.texcoord))
+                    {
+                        relativeMask |= RELATIVE_TEXCOORD;
+                    }
+                }
+                if (cursor.ptr < cursor.end && *cursor.ptr == '/')
+                {
+                    cursor.ptr++;
+                    if (!cursor.parseInt(value) || value == 0)
+                    {
+                        return false;
+                    }
+                    if (resolveIndex(value, chunk.normals.size(), corner.normal))
+                    {
+                        relativeMask |= RELATIVE_NORMAL;
+                    }
+                }
+            }
+            return true;
+        }
+
+        void parseChunk(const char *begin, const char *end, ChunkResult &chunk)
+        {
+            Cursor cursor{begin, end};
+            std::vector<ObjIndex> polygon;
+            std::vector<uint8_t> polygonMasks;
+
+            while (cursor.ptr < cursor.end)
+            {
+                cursor.skipSpaces();
+                if (cursor.atLineEnd())
+                {
+                    cursor.skipLine();
+                    continue;
+                }
+
+                std::string_view keyword = cursor.token();
+                bool ok = true;
+
+                if (keyword == "v")
+                {
+                    glm::vec3 p;
+                    ok = cursor.parseFloat(p.x) && cursor.parseFloat(p.y) && cursor.parseFloat(p.z);
+                    chunk.positions.push_back(p);
+                }
+                else if (keyword == "vn")
+                {
+                    glm::vec3 n;
+                    ok = cursor.parseFloat(n.x) && cursor.parseFloat(n.y) && cursor.parseFloat(n.z);
+                    chunk.normals.push_back(n);
+                }
+                else if (keyword == "vt")
+                {
+                    glm::vec2 t;
+                    ok = cursor.parseFloat(t.x) && cursor.parseFloat(t.y);
+                    chunk.texcoords.push_back(t);
+                }
+                else if (keyword == "f")
+                {
+                    polygon.clear();
+                    polygonMasks.clear();
+                    while (true)
+                    {
+                        cursor.skipSpaces();
+                        if (cursor.atLineEnd())
+                        {
+                            break;
+                        }
+                        ObjIndex corner;
+                        uint8_t mask;
+                        if (!parseFaceCorner(cursor, chunk, corner, mask))
+                        {
+                            ok = false;
+                            break;
+                        }
+                        polygon.push_back(corner);
+                        polygonMasks.push_back(mask);
+                    }
+                    ok = ok && polygon.size() >= 3;
+                    if (ok)
+                    {
+                        // Fan triangulation
+                        for (size_t i = 1; i + 1 < polygon.size(); i++)
+                        {
+                            const size_t triangle[3] = {0, i, i + 1};
+                            for (size_t corner : triangle)
+                            {
+                                if (polygonMasks[corner] != 0)
+                                {
+                                    chunk.relativeCorners.emplace_back(chunk.indices.size(), polygonMasks[corner]);
+                                }
+                                chunk.indices.push_back(polygon[corner]);
+                            }
+                        }
+                    }
+                }
+                else if (keyword == "o" || keyword == "g")
+                {
+                    chunk.statements.push_back({ChunkStatement::Kind::Object, chunk.indices.size(), std::string(cursor.restOfLine())});
+                }
+                else if (keyword == "usemtl")
+                {
+                    chunk.statements.push_back({ChunkStatement::Kind::Material, chunk.indices.size(), std::string(cursor.restOfLine())});
+                }
+                else if (keyword == "mtllib")
+                {
+                    chunk.statements.push_back({ChunkStatement::Kind::MaterialLibrary, chunk.indices.size(), std::string(cursor.restOfLine())});
+                }
+                // Everything else (s, l, p, ...) is ignored
+
+                if (!ok)
+                {
+                    chunk.malformedLines++;
+                }
+                cursor.skipLine();
+            }
+        }
+
+        std::string directoryOf(const std::string &path)
+        {
+            size_t slash = path.find_last_of('/');
+            return slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+        }
+    }
+
+    ObjData ObjParser::parseObj(const std::string &path, ThreadPool &threadPool)
+    {
+        MappedFile file(path);
+        ObjData data = parseObj(reinterpret_cast<const char *>(file.data()), file.size(), threadPool);
+
+        // Material libraries are relative to the OBJ
+        std::string directory = directoryOf(path);
+        for (auto &library : data.materialLibraries)
+        {
+            library = directory + library;
+        }
+        return data;
+    }
+
+    ObjData ObjParser::parseObj(const char *data, size_t size, ThreadPool &threadPool)
+    {
+        // Split the file into chunks at line boundaries
+        size_t numChunks = std::clamp<size_t>(size / MIN_CHUNK_SIZE, 1, threadPool.size() * 4);
+        std::vector<const char *> boundaries{data};
+        for (size_t i = 1; i < numChunks; i++)
+        {
+            const char *target = std::max(data + size * i / numChunks, boundaries.back());
+            const char *newline = static_cast<const char *>(std::memchr(target, '\n', data + size - target));
+            if (newline == nullptr)
+            {
+                break;
+            }
+            boundaries.push_back(newline + 1);
+        }
+        boundaries.push_back(data + size);
+        numChunks = boundaries.size() - 1;
+
+        std::vector<ChunkResult> chunks(numChunks);
+        threadPool.parallelFor(0, numChunks, 1, [&](size_t begin, size_t end)
+                               {
+                                   for (size_t i = begin; i < end; i++)
+                                   {
+                                       parseChunk(boundaries[i], boundaries[i + 1], chunks[i]);
+                                   } });
+
+        // Exclusive prefix sums of the per-chunk counts give each chunk's place in the merged arrays
+        std::vector<size_t> positionOffsets(numChunks + 1, 0);
+        std::vector<size_t> normalOffsets(numChunks + 1, 0);
+        std::vector<size_t> texcoordOffsets(numChunks + 1, 0);
+        std::vector<size_t> indexOffsets(numChunks + 1, 0);
+        size_t malformedLines = 0;
+        for (size_t i = 0; i < numChunks; i++)
+        {
+            positionOffsets[i + 1] = positionOffsets[i] + chunks[i].positions.size();
+            normalOffsets[i + 1] = normalOffsets[i] + chunks[i].normals.size();
+            texcoordOffsets[i + 1] = texcoordOffsets[i] + chunks[i].texcoords.size();
+            indexOffsets[i + 1] = indexOffsets[i] + chunks[i].indices.size();
+            malformedLines += chunks[i].malformedLines;
+        }
+
+        if (malformedLines > 0)
+        {
+            spdlog::warn("OBJ parser: skipped {} malformed lines", malformedLines);
+        }
+
+        ObjData result;
+        result.positions.resize(positionOffsets[numChunks]);
+        result.normals.resize(normalOffsets[numChunks]);
+        result.texcoords.resize(texcoordOffsets[numChunks]);
+        result.indices.resize(indexOffsets[numChunks]);
+
+        const int32_t numPositions = static_cast<int32_t>(result.positions.size());
+        const int32_t numNormals = static_cast<int32_t>(result.normals.size());
+        const int32_t numTexcoords = static_cast<int32_t>(result.texcoords.size());
+
+        std::atomic<size_t> invalidCorners{0};
+        threadPool.parallelFor(0, numChunks, 1, [&](size_t begin, size_t end)
+                               {
+                                   for (size_t i = begin; i < end; i++)
+                                   {
+                                       ChunkResult &chunk = chunks[i];
+                                       std::copy(chunk.positions.begin(), chunk.positions.end(), result.positions.begin() + positionOffsets[i]);
+                                       std::copy(chunk.normals.begin(), chunk.normals.end(), result.normals.begin() + normalOffsets[i]);
+                                       std::copy(chunk.texcoords.begin(), chunk.texcoords.end(), result.texcoords.begin() + texcoordOffsets[i]);
+
+                                       for (const auto &[corner, mask] : chunk.relativeCorners)
+                                       {
+                                           ObjIndex &index = chunk.indices[corner];
+                                           if (mask & RELATIVE_POSITION)
+                                               index.position += static_cast<int32_t>(positionOffsets[i]);
+                                           if (mask & RELATIVE_TEXCOORD)
+                                               index.texcoord += static_cast<int32_t>(texcoordOffsets[i]);
+                                           if (mask & RELATIVE_NORMAL)
+                                               index.normal += static_cast<int32_t>(normalOffsets[i]);
+                                       }
+
+                                       size_t invalid = 0;
+                                       for (ObjIndex &index : chunk.indices)
+                                       {
+                                           if (index.position < 0 || index.position >= numPositions)
+                                           {
+                                               index.position = 0;
+                                               invalid++;
+                                           }
+                                           if (index.normal >= numNormals || index.normal < -1)
+                                           {
+                                               index.normal = -1;
+                                               invalid++;
+                                           }
+                                           if (index.texcoord >= numTexcoords || index.texcoord < -1)
+                                           {
+                                               index.texcoord = -1;
+                                               invalid++;
+                                           }
+                                       }
+                                       invalidCorners += invalid;
+
+                                       std::copy(chunk.indices.begin(), chunk.indices.end(), result.indices.begin() + indexOffsets[i]);
+
+                                       // Free the chunk's memory early, large files would otherwise need twice the space
+                                       chunk.positions = {};
+                                       chunk.normals = {};
+                                       chunk.texcoords = {};
+                                       chunk.indices = {};
+                                   } });
+
+        if (invalidCorners > 0)
+        {
+            if (numPositions == 0)
+            {
+                spdlog::error("OBJ parser: faces reference vertices but the file has none");
+                throw std::runtime_error("OBJ faces without vertices");
+            }
+            spdlog::warn("OBJ parser: {} face corners reference non-existent attributes", invalidCorners.load());
+        }
+
+        // Group faces into shapes, a new shape starts with every object/group and on every material change
+        ObjShape current;
+        auto closeShape = [&](size_t cornerPosition)
+        {
+            current.indexCount = cornerPosition - current.indexBegin;
+            if (current.indexCount > 0)
+            {
+                result.shapes.push_back(current);
+            }
+            current.indexBegin = cornerPosition;
+        };
+
+        for (size_t i = 0; i < numChunks; i++)
+        {
+            for (const auto &statement : chunks[i].statements)
+            {
+                size_t cornerPosition = indexOffsets[i] + statement.cornerPosition;
+                switch (statement.kind)
+                {
+                case ChunkStatement::Kind::Object:
+                    closeShape(cornerPosition);
+                    current.name = statement.value;
+                    break;
+                case ChunkStatement::Kind::Material:
+                    if (statement.value != current.materialName)
+                    {
+                        closeShape(cornerPosition);
+                        current.materialName = statement.value;
+                    }
+                    break;
+                case ChunkStatement::Kind::MaterialLibrary:
+                    result.materialLibraries.push_back(statement.value);
+                    break;
+                }
+            }
+        }
+        closeShape(result.indices.size());
+
+        return result;
+    }
+
+    std::vector<ImportedMaterial> ObjParser::parseMtl(const std::string &path)
+    {
+        MappedFile file(path);
+        return parseMtl(reinterpret_cast<const char *>(file.data()), file.size());
+    }
+
+    std::vector<ImportedMaterial> ObjParser::parseMtl(const char *data, size_t size)
+    {
+        std::vector<ImportedMaterial> materials;
+        Cursor cursor{data, data + size};
+
+        // Texture statements may carry options (e.g. "-bm 1.0"), the file name is the last token
+        auto textureName = [](std::string_view line)
+        {
+            size_t space = line.find_last_of(" \t");
+            return std::string(space == std::string_view::npos ? line : line.substr(space + 1));
+        };
+
+        while (cursor.ptr < cursor.end)
+        {
+            cursor.skipSpaces();
+            if (cursor.atLineEnd())
+            {
+                cursor.skipLine();
+                continue;
+            }
+
+            std::string_view keyword = cursor.token();
+            if (keyword == "newmtl")
+            {
+                materials.emplace_back();
+                materials.back().name = std::string(cursor.restOfLine());
+            }
+            else if (!materials.empty())
+            {
+                ImportedMaterial &material = materials.back();
+                if (keyword == "Kd")
+                {
+                    glm::vec3 color;
+                    if (cursor.parseFloat(color.x) && cursor.parseFloat(color.y) && cursor.parseFloat(color.z))
+                    {
+                        material.diffuseColor = color;
+                    }
+                }
+                else if (keyword == "map_Kd")
+                {
+                    material.diffuseMap = textureName(cursor.restOfLine());
+                }
+                else if (keyword == "norm")
+                {
+                    material.normalMap = textureName(cursor.restOfLine());
+                }
+                else if (keyword == "map_Pr")
+                {
+                    material.roughnessMap = textureName(cursor.restOfLine());
+                }
+                else if (keyword == "map_Pm")
+                {
+                    material.metalnessMap = textureName(cursor.restOfLine());
+                }
+            }
+            cursor.skipLine();
+        }
+
+        return materials;
+    }
+}
@@ -1,122 +1,207 @@
 #include "ResourceManager.hpp"
 #include "ShaderProgram.hpp"
+#include "ShaderVariants.hpp"
+#include "ShaderPreprocessor.hpp"
+#include "Hash.hpp"
 #include "StaticMesh.hpp"
 #include "Material.hpp"
 #include "Texture2D.hpp"
+#include "MeshCache.hpp"
+#include "MeshImporter.hpp"
+#include "CookedTexture.hpp"
+#include "VirtualFileSystem.hpp"
+#include "Texture2DArray.hpp"
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
 #include <unordered_map>
+#include <unordered_set>
+#include <map>
+#include <tuple>
 #include <memory>
 #include <stdexcept>
+#include <algorithm>
+#include <numeric>
+#include <filesystem>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
 
 #include <spdlog/spdlog.h>
 
-#include <tinyobjloader/tiny_obj_loader.h>
-
 #include <stb/stb_image.h>
 
 #include <fstream>
-#include <sstream>
 
 namespace planets
 {
-    ResourceManager::ResourceManager(const std::string &dataDirectory) : m_DataDirectory(dataDirectory)
+    ResourceManager::ResourceManager(const std::string &dataDirectory, const std::string &archivePath)
+        : m_DataDirectory(dataDirectory), m_Vfs(std::make_shared<VirtualFileSystem>(dataDirectory))
     {
-        // Load the standard feature-rich shader
-        loadShaderProgram("Standard", "shaders/Standard_vert.glsl", "shaders/Standard_frag.glsl");
+        if (!archivePath.empty())
+        {
+            try
+            {
+                m_Vfs->mountArchive(archivePath);
+            }
+            catch (std::exception &e)
+            {
+                spdlog::warn("Unable to mount asset archive \"{}\", loading loose files from \"{}\"", archivePath, dataDirectory);
+            }
+        }
+
+        bool manifestLoaded = false;
+        if (m_Vfs->exists(AssetManifest::DEFAULT_PATH))
+        {
+            VfsFile manifest = m_Vfs->open(AssetManifest::DEFAULT_PATH);
+            manifestLoaded = m_AssetManifest.load(reinterpret_cast<const char *>(manifest.data()), manifest.size(), AssetManifest::DEFAULT_PATH);
+        }
+        if (!manifestLoaded)
+        {
+            spdlog::info("No cooked assets found, all assets will be imported from their sources");
+        }
+
+        m_ShaderPreprocessor = std::make_shared<ShaderPreprocessor>(m_Vfs, "shaders");
+        m_ShaderPreprocessor->setEngineDefines();
+
+        // Tiny, drawn while the other programs compile
+        Material::setFallbackProgram(loadShaderProgram("Fallback", "shaders/Fallback_vert.glsl", "shaders/Fallback_frag.glsl"));
+        // Load the standard feature-rich shader, materials draw with variants of it specialized for their maps.
+        // All of them are only submitted here, the driver compiles them while loading goes on.
+        auto standard = loadShaderProgram("Standard", "shaders/Standard_vert.glsl", "shaders/Standard_frag.glsl",
+                                          ShaderProgram::CompileMode::Deferred);
+        m_StandardVariants = std::make_shared<ShaderVariants>(standard,
+                                                              m_ShaderPreprocessor,
+                                                              "shaders/Standard_vert.glsl",
+                                                              "shaders/Standard_frag.glsl",
+                                                              "VARIANT_FLAGS",
+                                                              ShaderProgram::CompileMode::Deferred);
         loadTexture2DFromPNG("NOTEXTURE", "textures/NOTEXTURE.png");
+        // Used for submeshes without a material
+        createStandardMaterial("DEFAULT", 0);
     }
 
     ResourceManager::~ResourceManager()
     {
+        // Workers still preparing loads write into this object
+        for (auto &task : m_LoadTasks)
+        {
+            task.wait();
+        }
+        // Would otherwise outlive the GL context
+        Material::setFallbackProgram(nullptr);
     }
 
     std::shared_ptr<ShaderProgram> ResourceManager::loadShaderProgram(const std::string &name,
                                                                       const std::string &vertexShaderSourcePath,
-                                                                      const std::string &fragmentShaderSourcePath)
+                                                                      const std::string &fragmentShaderSourcePath,
+                                                                      ShaderProgram::CompileMode mode)
     {
-        std::string vertexShaderSourcePathFull = makePath(vertexShaderSourcePath);
-        std::string fragmentShaderSourcePathFull = makePath(fragmentShaderSourcePath);
-
         spdlog::trace("Loading shader program \"{}\" with vertex shader source \"{}\" and fragment shader source \"{}\"",
-                      name, vertexShaderSourcePathFull, fragmentShaderSourcePathFull);
-        if (m_ShaderPrograms.find(name) != m_ShaderPrograms.end())
+                      name, makePath(vertexShaderSourcePath), makePath(fragmentShaderSourcePath));
+        if (m_ShaderPrograms.contains(name))
         {
             spdlog::warn("Shader program \"{}\" already exists and will be replaced", name);
         }
 
-        std::string vertexShaderSource;
-        std::string fragmentShaderSource;
+        ShaderSources sources{vertexShaderSourcePath, fragmentShaderSourcePath, {}, 0};
+        auto [vertexSource, fragmentSource] = preprocessShaderSources(sources);
+        std::shared_ptr<ShaderProgram> prog = std::make_shared<ShaderProgram>(vertexSource, fragmentSource, mode);
 
-        std::ifstream vertexShaderSourceStream(vertexShaderSourcePathFull, std::ios::in);
-        if (vertexShaderSourceStream.is_open())
-        {
-            std::stringstream buffer;
-            buffer << vertexShaderSourceStream.rdbuf();
-            vertexShaderSource = buffer.str();
-            vertexShaderSourceStream.close();
-        }
-        else
-        {
-            spdlog::error("Unable to open vertex shader source file at \"{}\"", vertexShaderSourcePathFull);
-            throw std::runtime_error("Unable to open vertex shader source file");
-        }
+        m_ShaderPrograms.add(name, prog);
+        m_ShaderSources[name] = std::move(sources);
 
-        std::ifstream fragmentShaderSourceStream(fragmentShaderSourcePathFull, std::ios::in);
-        if (fragmentShaderSourceStream.is_open())
-        {
-            std::stringstream buffer;
-            buffer << fragmentShaderSourceStream.rdbuf();
-            fragmentShaderSource = buffer.str();
-            fragmentShaderSourceStream.close();
-        }
-        else
+        return prog;
+    }
+
+    std::pair<std::string, std::string> ResourceManager::preprocessShaderSources(ShaderSources &sources) const
+    {
+        PreprocessedShader vertex = m_ShaderPreprocessor->process(sources.vertex);
+        PreprocessedShader fragment = m_ShaderPreprocessor->process(sources.fragment);
+
+        sources.dependencies = vertex.dependencies;
+        for (auto &path : fragment.dependencies)
         {
-            spdlog::error("Unable to open fragment shader source file at \"{}\"", fragmentShaderSourcePathFull);
-            throw std::runtime_error("Unable to open fragment shader source file");
+            if (std::find(sources.dependencies.begin(), sources.dependencies.end(), path) == sources.dependencies.end())
+            {
+                sources.dependencies.push_back(std::move(path));
+            }
         }
+        sources.hash = hashBytes(&fragment.hash, sizeof(fragment.hash), vertex.hash);
 
-        std::shared_ptr<ShaderProgram> prog = std::make_shared<ShaderProgram>(vertexShaderSource, fragmentShaderSource);
-
-        m_ShaderPrograms[name] = prog;
+        return {std::move(vertex.source), std::move(fragment.source)};
+    }
 
-        return prog;
+    void ResourceManager::pollShaderPrograms()
+    {
+        size_t compiling = 0;
+        m_ShaderPrograms.forEach([&](const std::string &name, const std::shared_ptr<ShaderProgram> &program)
+                                 {
+                                     if (program->isReady() || program->hasFailed())
+                                     {
+                                         return;
+                                     }
+                                     if (!program->poll())
+                                     {
+                                         compiling++;
+                                     }
+                                     else if (program->hasFailed())
+                                     {
+                                         spdlog::error("Shader program \"{}\" could not be compiled, its materials draw with the fallback", name);
+                                     } });
+        compiling += m_StandardVariants->poll();
+        m_CompilingShaders = compiling;
     }
 
     std::shared_ptr<ShaderProgram> ResourceManager::getShaderProgram(const std::string &name) const
     {
-        auto it = m_ShaderPrograms.find(name);
-        if (it == m_ShaderPrograms.end())
+        const auto *resource = m_ShaderPrograms.find(name);
+        if (resource == nullptr)
+        {
+            spdlog::error("Unable to find shader program \"{}\"", name);
+            throw std::runtime_error("Unable to find shader program");
+        }
+        return *resource;
+    }
+
+    uint64_t ResourceManager::getShaderProgramHash(const std::string &name) const
+    {
+        auto it = m_ShaderSources.find(name);
+        if (it == m_ShaderSources.end())
         {
             spdlog::error("Unable to find shader program \"{}\"", name);
             throw std::runtime_error("Unable to find shader program");
         }
-        return it->second;
+        return it->second.hash;
     }
 
     std::shared_ptr<Material> ResourceManager::createMaterial(const std::string &name, std::shared_ptr<ShaderProgram> shaderProgram)
     {
         spdlog::trace("Creating material \"{}\"", name);
-        if (m_Materials.find(name) != m_Materials.end())
+        std::shared_ptr<Material> mat = std::make_shared<Material>(shaderProgram);
+        addMaterial(name, mat);
+        return mat;
+    }
+
+    MaterialHandle ResourceManager::addMaterial(const std::string &name, std::shared_ptr<Material> material)
+    {
+        if (m_Materials.contains(name))
         {
             spdlog::warn("Material \"{}\" already exists and will be replaced", name);
         }
-        std::shared_ptr<Material> mat = std::make_shared<Material>(shaderProgram);
-        m_Materials[name] = mat;
-        return mat;
+        return m_Materials.add(name, std::move(material));
     }
 
     std::shared_ptr<Material> ResourceManager::getMaterial(const std::string &name)
     {
-        auto it = m_Materials.find(name);
-        if (it == m_Materials.end())
+        const auto *resource = m_Materials.find(name);
+        if (resource == nullptr)
         {
             spdlog::error("Unable to find material \"{}\"", name);
             throw std::runtime_error("Unable to find material");
         }
-        return it->second;
+        return *resource;
     }
 
     std::shared_ptr<Texture2D> ResourceManager::loadTexture2DFromPNG(const std::string &name,
@@ -124,263 +209,1451 @@ namespace planets
     {
         std::string fullPath = makePath(path);
         spdlog::trace("Loading a 2D texture \"{}\" from PNG file \"{}\"", name, fullPath);
-        if (m_Textures2D.find(name) != m_Textures2D.end())
+
+        m_TextureSources[name] = path;
+        if (auto cooked = loadCookedTexture2D(name, path))
         {
-            spdlog::warn("2D texture \"{}\" already exists and will be replaced", name);
+            return cooked;
         }
 
-        int width{0}, height{0}, numChannels{0};
         stbi_set_flip_vertically_on_load(true);
-        unsigned char *data = stbi_load(fullPath.c_str(), &width, &height, &numChannels, 0);
-        // If we couldn't load the texture, we just return the Source-like emo checkerboard
-        if (data == NULL)
+        DecodedImage image = decodeImage(path);
+        return createTexture2D(name, image);
+    }
+
+    std::unordered_map<std::string, std::shared_ptr<Texture2D>>
+    ResourceManager::loadTextures2D(const std::vector<std::pair<std::string, std::string>> &namesAndPaths)
+    {
+        std::unordered_map<std::string, std::shared_ptr<Texture2D>> textures;
+
+        // Several materials commonly share a texture, decode each of them only once.
+        // Cooked textures need no decoding and are uploaded right away.
+        std::vector<std::pair<std::string, std::string>> unique;
+        for (const auto &[name, path] : namesAndPaths)
         {
-            spdlog::warn("Unable to load 2D texture from \"{}\"", fullPath);
-            return getTexture2D("NOTEXTURE");
+            if (textures.find(name) != textures.end())
+            {
+                continue;
+            }
+            m_TextureSources[name] = path;
+            if (auto cooked = loadCookedTexture2D(name, path))
+            {
+                textures[name] = cooked;
+                continue;
+            }
+            textures[name] = nullptr;
+            unique.emplace_back(name, path);
+        }
+
+        spdlog::trace("Decoding {} textures on {} threads", unique.size(), m_ThreadPool.size());
+
+        // The flag is global in stb_image, set it before any worker starts decoding
+        stbi_set_flip_vertically_on_load(true);
+
+        double decodeStart = glfwGetTime();
+        std::vector<DecodedImage> images(unique.size());
+        m_ThreadPool.parallelFor(0, unique.size(), 1, [&](size_t begin, size_t end)
+                                 {
+                                     for (size_t i = begin; i < end; i++)
+                                     {
+                                         images[i] = decodeImage(unique[i].second);
+                                     } });
+        double decodeWallMs = (glfwGetTime() - decodeStart) * 1000.0;
+
+        // Only the GL calls are left for this thread
+        double decodeSumMs = 0.0;
+        double uploadStart = glfwGetTime();
+        for (size_t i = 0; i < unique.size(); i++)
+        {
+            decodeSumMs += images[i].decodeMs;
+            textures[unique[i].first] = createTexture2D(unique[i].first, images[i]);
+            images[i].pixels.reset();
+        }
+        double uploadMs = (glfwGetTime() - uploadStart) * 1000.0;
+
+        spdlog::trace("Decoded {} textures in {:.1f} ms ({:.1f} ms of decoding in total), uploaded them in {:.1f} ms",
+                      unique.size(), decodeWallMs, decodeSumMs, uploadMs);
+
+        return textures;
+    }
+
+    std::shared_ptr<Texture2D> ResourceManager::loadCookedTexture2D(const std::string &name, const std::string &path)
+    {
+        std::string cookedPath = m_AssetManifest.find(AssetManifest::AssetKind::Texture, path);
+        if (cookedPath.empty())
+        {
+            return nullptr;
         }
 
-        Texture2D::TextureDataFormat format;
-        if (numChannels == 1)
+        try
         {
-            format = Texture2D::TextureDataFormat::R8;
+            VfsFile file = m_Vfs->open(cookedPath, &m_ThreadPool);
+            CookedTexture cooked(cookedPath, file.data(), file.size(), file.getOwner());
+            return createTexture2D(name, cooked);
         }
-        else if (numChannels == 3)
+        catch (std::exception &e)
         {
-            format = Texture2D::TextureDataFormat::RGB8;
+            spdlog::warn("Unable to use cooked texture \"{}\", falling back to \"{}\"", cookedPath, path);
+            return nullptr;
         }
-        else if (numChannels == 4)
+    }
+
+    ResourceManager::DecodedImage ResourceManager::decodeImage(const std::string &path)
+    {
+        VfsFile file;
+        try
         {
-            format = Texture2D::TextureDataFormat::RGBA8;
+            file = m_Vfs->open(path);
         }
-        else
+        catch (std::exception &e)
+        {
+            // Reported by whoever uses the image
+            DecodedImage image;
+            image.path = makePath(path);
+            return image;
+        }
+        return decodeImage(makePath(path), file.data(), file.size());
+    }
+
+    ResourceManager::DecodedImage ResourceManager::decodeImage(const std::string &label, const unsigned char *data, size_t size)
+    {
+        DecodedImage image;
+        image.path = label;
+
+        double start = glfwGetTime();
+        unsigned char *pixels = stbi_load_from_memory(data, static_cast<int>(size), &image.width, &image.height, &image.numChannels, 0);
+        image.pixels = std::unique_ptr<unsigned char, void (*)(void *)>(pixels, stbi_image_free);
+        image.decodeMs = (glfwGetTime() - start) * 1000.0;
+
+        if (pixels != NULL)
+        {
+            spdlog::trace("Decoded \"{}\" ({}x{}, {} channels) in {:.1f} ms",
+                          label, image.width, image.height, image.numChannels, image.decodeMs);
+        }
+        return image;
+    }
+
+    std::shared_ptr<Texture2D> ResourceManager::createTexture2D(const std::string &name, const DecodedImage &image)
+    {
+        // If we couldn't load the texture, we just return the Source-like emo checkerboard
+        if (!image.pixels)
+        {
+            spdlog::warn("Unable to load 2D texture from \"{}\"", image.path);
+            return getTexture2D("NOTEXTURE");
+        }
+
+        if (m_Textures2D.contains(name))
+        {
+            spdlog::warn("2D texture \"{}\" already exists and will be replaced", name);
+        }
+
+        double start = glfwGetTime();
+        std::shared_ptr<Texture2D> tex = std::make_shared<Texture2D>(static_cast<GLsizei>(image.width),
+                                                                     static_cast<GLsizei>(image.height),
+                                                                     reinterpret_cast<const void *>(image.pixels.get()),
+                                                                     formatForChannels(image.numChannels));
+        spdlog::trace("Uploaded 2D texture \"{}\" in {:.1f} ms", name, (glfwGetTime() - start) * 1000.0);
+
+        m_Textures2D.add(name, tex);
+        return tex;
+    }
+
+    Texture2D::TextureDataFormat ResourceManager::formatForChannels(int numChannels)
+    {
+        switch (numChannels)
         {
+        case 1:
+            return Texture2D::TextureDataFormat::R8;
+        case 3:
+            return Texture2D::TextureDataFormat::RGB8;
+        case 4:
+            return Texture2D::TextureDataFormat::RGBA8;
+        default:
             spdlog::warn("Unsupported image format");
-            stbi_image_free(data);
             throw std::runtime_error("Unsupported image format");
         }
+    }
 
-        std::shared_ptr<Texture2D> tex = std::make_shared<Texture2D>(static_cast<GLsizei>(width),
-                                                                     static_cast<GLsizei>(height),
-                                                                     reinterpret_cast<void *>(data),
-                                                                     format);
+    std::shared_ptr<Texture2D> ResourceManager::createTexture2D(const std::string &name, const CookedTexture &cooked)
+    {
+        double start = glfwGetTime();
+        std::shared_ptr<Texture2D> tex = std::make_shared<Texture2D>(cooked.getFormat(), cooked.getMipLevels());
+        spdlog::trace("Uploaded cooked 2D texture \"{}\" ({} mip levels) in {:.1f} ms",
+                      name, cooked.getMipLevels().size(), (glfwGetTime() - start) * 1000.0);
 
-        m_Textures2D[name] = tex;
-        stbi_image_free(data);
+        if (m_Textures2D.contains(name))
+        {
+            spdlog::warn("2D texture \"{}\" already exists and will be replaced", name);
+        }
+        m_Textures2D.add(name, tex);
         return tex;
     }
 
+    void ResourceManager::batchTextureArrays(const std::unordered_map<std::string, std::shared_ptr<Texture2D>> &textures)
+    {
+        if (!m_TextureArraysEnabled)
+        {
+            return;
+        }
+
+        // Textures can only share an array if all their levels match
+        using ArrayKey = std::tuple<Texture2D::TextureDataFormat, GLsizei, GLsizei, GLsizei>;
+        std::map<ArrayKey, std::vector<std::shared_ptr<Texture2D>>> groups;
+        std::unordered_set<const Texture2D *> seen;
+        // Failed loads all share the fallback texture, which stays on its own
+        if (const auto *fallback = m_Textures2D.find("NOTEXTURE"))
+        {
+            seen.insert(fallback->get());
+        }
+        for (const auto &[name, texture] : textures)
+        {
+            if (!texture || texture->getArray() || !seen.insert(texture.get()).second)
+            {
+                continue;
+            }
+            groups[{texture->getFormat(), texture->getWidth(), texture->getHeight(), texture->getMipLevelCount()}].push_back(texture);
+        }
+
+        size_t arrays = 0, layers = 0;
+        for (auto &[key, group] : groups)
+        {
+            if (group.size() < 2)
+            {
+                continue;
+            }
+            auto array = std::make_shared<Texture2DArray>(std::get<0>(key), std::get<1>(key), std::get<2>(key),
+                                                          std::get<3>(key), static_cast<GLsizei>(group.size()));
+            for (size_t layer = 0; layer < group.size(); layer++)
+            {
+                group[layer]->moveToArray(array, static_cast<GLint>(layer));
+            }
+            arrays++;
+            layers += group.size();
+        }
+
+        spdlog::trace("Batched {} of {} textures into {} texture arrays", layers, seen.size(), arrays);
+    }
+
     std::shared_ptr<Texture2D> ResourceManager::getTexture2D(const std::string &name)
     {
-        auto it = m_Textures2D.find(name);
-        if (it == m_Textures2D.end())
+        const auto *resource = m_Textures2D.find(name);
+        if (resource == nullptr)
         {
             spdlog::error("Unable to find 2D texture \"{}\"", name);
             throw std::runtime_error("Unable to find 2D texture");
         }
-        return it->second;
+        return *resource;
     }
 
-    std::shared_ptr<Material> ResourceManager::createStandardMaterial(const std::string &name,
-                                                                      GLint flags)
+    ResourceHandle<Texture2D> ResourceManager::requestTexture2D(const std::string &name, const std::string &path)
     {
-        spdlog::trace("Creating Standard material \"{}\"", name);
-        if (m_Materials.find(name) != m_Materials.end())
+        if (const auto *loaded = m_Textures2D.find(name))
         {
-            spdlog::warn("Material \"{}\" already exists and will be replaced", name);
+            return *loaded;
         }
-        std::shared_ptr<Material> mat = std::make_shared<StandardMaterial>(getShaderProgram("Standard"),
-                                                                           flags);
-        m_Materials[name] = mat;
-        return mat;
+        auto it = m_TextureHandles.find(name);
+        if (it != m_TextureHandles.end())
+        {
+            return it->second;
+        }
+
+        spdlog::trace("Deferring 2D texture \"{}\" from \"{}\" until it is used", name, path);
+        ResourceHandle<Texture2D> handle;
+        handle.m_State = std::make_shared<ResourceHandle<Texture2D>::State>();
+        handle.m_State->placeholder = getTexture2D("NOTEXTURE");
+        handle.m_State->requestLoad = [this, name, path]()
+        { queueTextureLoad(name, path); };
+        m_TextureHandles[name] = handle;
+        return handle;
+    }
+
+    void ResourceManager::queueTextureLoad(const std::string &name, const std::string &path)
+    {
+        spdlog::trace("Loading deferred 2D texture \"{}\"", name);
+        m_TextureSources[name] = path;
+
+        // The flag is global in stb_image, set it before any worker starts decoding
+        stbi_set_flip_vertically_on_load(true);
+
+        m_LoadsRequested++;
+        m_LoadTasks.push_back(m_ThreadPool.submit([this, name, path]()
+                                                  {
+                                                      PendingTexture pending;
+                                                      pending.name = name;
+                                                      pending.path = path;
+                                                      prepareTexture(pending);
+                                                      std::lock_guard<std::mutex> lock(m_LoadMutex);
+                                                      m_ReadyTextures.push_back(std::move(pending)); }));
+    }
+
+    void ResourceManager::finishTextureLoad(PendingTexture &pending)
+    {
+        m_LoadsCompleted++;
+        std::shared_ptr<Texture2D> texture = uploadPendingTexture(pending);
+
+        auto it = m_TextureHandles.find(pending.name);
+        if (it != m_TextureHandles.end())
+        {
+            it->second.m_State->resource = texture;
+            m_TextureHandles.erase(it);
+        }
+    }
+
+    void ResourceManager::logTextureMemoryUsage() const
+    {
+        size_t compressedCount{0}, sizeInBytes{0}, uncompressedSizeInBytes{0};
+        m_Textures2D.forEach([&](const std::string &, const std::shared_ptr<Texture2D> &texture)
+                             {
+                                 compressedCount += Texture2D::isCompressed(texture->getFormat()) ? 1 : 0;
+                                 sizeInBytes += texture->getGpuSizeInBytes();
+                                 uncompressedSizeInBytes += texture->getUncompressedSizeInBytes(); });
+
+        spdlog::info("{} 2D textures ({} block-compressed) take {:.1f} MB of VRAM, {:.1f} MB uncompressed ({:.1f} MB saved)",
+                     m_Textures2D.size(), compressedCount, sizeInBytes / 1048576.0, uncompressedSizeInBytes / 1048576.0,
+                     (uncompressedSizeInBytes - sizeInBytes) / 1048576.0);
     }
 
-    std::vector<std::pair<std::shared_ptr<StaticMesh>,
-                          std::shared_ptr<Material>>>
-    ResourceManager::loadStaticMesh(const std::string &name,
-                                    const std::string &objPath)
+    ResourceManager::MemoryReport ResourceManager::getMemoryReport() const
     {
-        std::string fullPath = makePath(objPath);
-        tinyobj::ObjReader reader;
-        tinyobj::ObjReaderConfig readerConfig;
-        readerConfig.mtl_search_path = makePath("/models/");
-        readerConfig.triangulate = true;
+        MemoryReport report;
+        m_ShaderPrograms.forEach([&](const std::string &, const std::shared_ptr<ShaderProgram> &program)
+                                 { report.shaderPrograms += {1, program->getCpuSizeInBytes(), program->getGpuSizeInBytes()}; });
+        // Variants that failed to compile are the Standard program itself, counted above
+        std::shared_ptr<ShaderProgram> standard = getShaderProgram("Standard");
+        m_StandardVariants->forEach([&](GLint, const std::shared_ptr<ShaderProgram> &program)
+                                    {
+                                        if (program != standard)
+                                        {
+                                            report.shaderPrograms += {1, program->getCpuSizeInBytes(), program->getGpuSizeInBytes()};
+                                        } });
+        m_Materials.forEach([&](const std::string &, const std::shared_ptr<Material> &material)
+                            { report.materials += {1, material->getCpuSizeInBytes(), 0}; });
+        m_Textures2D.forEach([&](const std::string &, const std::shared_ptr<Texture2D> &texture)
+                             { report.textures2D += {1, texture->getCpuSizeInBytes(), texture->getGpuSizeInBytes()}; });
+        m_StaticMeshes.forEach([&](const std::string &, const std::shared_ptr<StaticMesh> &mesh)
+                               { report.staticMeshes += {1, mesh->getCpuSizeInBytes(), mesh->getGpuSizeInBytes()}; });
+        return report;
+    }
 
-        spdlog::trace("Loading static mesh \"{}\" from OBJ file \"{}\"", name, fullPath);
+    bool ResourceManager::writeMemoryReport(const std::string &path) const
+    {
+        std::ofstream file(path, std::ios::out | std::ios::trunc);
+        if (!file.is_open())
+        {
+            spdlog::error("Unable to open \"{}\" for writing the memory report", path);
+            return false;
+        }
 
-        if (!reader.ParseFromFile(fullPath, readerConfig))
+        auto usageJson = [](const MemoryUsage &usage)
+        {
+            return fmt::format("{{\"count\": {}, \"cpuBytes\": {}, \"gpuBytes\": {}}}", usage.count, usage.cpuBytes, usage.gpuBytes);
+        };
+        // Resource names come from files, escape what JSON does not allow in strings
+        auto quoted = [](const std::string &text)
         {
-            if (!reader.Error().empty())
+            std::string result = "\"";
+            for (char c : text)
             {
-                spdlog::error("Unable to load OBJ \"{}\". TinyObjReader: {}", fullPath, reader.Error());
+                if (c == '"' || c == '\\')
+                {
+                    result += '\\';
+                    result += c;
+                }
+                else if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    result += fmt::format("\\u{:04x}", static_cast<int>(c));
+                }
+                else
+                {
+                    result += c;
+                }
             }
-            throw std::runtime_error("Unable to load OBJ");
+            return result + '"';
+        };
+        auto resourcesJson = [&](const auto &resources, auto cpuBytes, auto gpuBytes)
+        {
+            std::string json = "[";
+            resources.forEach([&](const std::string &name, const auto &resource)
+                              { json += fmt::format("{}\n      {{\"name\": {}, \"cpuBytes\": {}, \"gpuBytes\": {}}}",
+                                                    json.size() > 1 ? "," : "", quoted(name), cpuBytes(*resource), gpuBytes(*resource)); });
+            return json + "\n    ]";
+        };
+
+        MemoryReport report = getMemoryReport();
+        file << "{\n";
+        file << "  \"totals\": {\n";
+        file << "    \"shaderPrograms\": " << usageJson(report.shaderPrograms) << ",\n";
+        file << "    \"materials\": " << usageJson(report.materials) << ",\n";
+        file << "    \"textures2D\": " << usageJson(report.textures2D) << ",\n";
+        file << "    \"staticMeshes\": " << usageJson(report.staticMeshes) << ",\n";
+        file << "    \"all\": " << usageJson(report.total()) << "\n";
+        file << "  },\n";
+        file << "  \"resources\": {\n";
+        file << "    \"shaderPrograms\": " << resourcesJson(m_ShaderPrograms, [](const ShaderProgram &program)
+                                                         { return program.getCpuSizeInBytes(); }, [](const ShaderProgram &program)
+                                                         { return program.getGpuSizeInBytes(); }) << ",\n";
+        file << "    \"materials\": " << resourcesJson(m_Materials, [](const Material &material)
+                                                    { return material.getCpuSizeInBytes(); }, [](const Material &)
+                                                    { return size_t{0}; }) << ",\n";
+        file << "    \"textures2D\": " << resourcesJson(m_Textures2D, [](const Texture2D &texture)
+                                                     { return texture.getCpuSizeInBytes(); }, [](const Texture2D &texture)
+                                                     { return texture.getGpuSizeInBytes(); }) << ",\n";
+        file << "    \"staticMeshes\": " << resourcesJson(m_StaticMeshes, [](const StaticMesh &mesh)
+                                                       { return mesh.getCpuSizeInBytes(); }, [](const StaticMesh &mesh)
+                                                       { return mesh.getGpuSizeInBytes(); }) << "\n";
+        file << "  }\n";
+        file << "}\n";
+
+        if (!file.good())
+        {
+            spdlog::error("Unable to write the memory report to \"{}\"", path);
+            return false;
         }
+        spdlog::info("Wrote the memory report to \"{}\"", path);
+        return true;
+    }
+
+    std::shared_ptr<Material> ResourceManager::createStandardMaterial(const std::string &name,
+                                                                      GLint flags)
+    {
+        spdlog::trace("Creating Standard material \"{}\"", name);
+        std::shared_ptr<Material> mat = makeStandardMaterial(flags);
+        addMaterial(name, mat);
+        return mat;
+    }
+
+    std::shared_ptr<StandardMaterial> ResourceManager::makeStandardMaterial(GLint flags)
+    {
+        return m_ShaderVariantsEnabled
+                   ? std::make_shared<StandardMaterial>(m_StandardVariants, flags)
+                   : std::make_shared<StandardMaterial>(getShaderProgram("Standard"), flags);
+    }
+
+    ResourceManager::LoadedStaticMeshes ResourceManager::loadStaticMesh(const std::string &name,
+                                    const std::string &objPath,
+                                    StaticMesh::Residency residency)
+    {
+        spdlog::trace("Loading static mesh \"{}\" from OBJ file \"{}\"", name, makePath(objPath));
 
-        if (!reader.Warning().empty())
+        std::string streamPath;
+        ImportedMesh imported = importStaticMesh(objPath, true, streamPath);
+        m_MeshSources[name] = {objPath, {}};
+        for (const auto &sourcePath : imported.sourcePaths)
         {
-            spdlog::warn("TinyObjReader: {}", reader.Warning());
+            m_MeshSources[name].fullPaths.push_back(normalizePath(sourcePath));
         }
+        m_MeshSources[name].fullPaths.push_back(normalizePath(makePath(objPath)));
 
-        auto &attrib = reader.GetAttrib();
-        auto &shapes = reader.GetShapes();
-        auto &materials = reader.GetMaterials();
+        // Decode all textures referenced by the MTL in parallel, then upload them
+        auto textures = loadTextures2D(collectTextures(imported));
+        batchTextureArrays(textures);
 
         // Load material(s)
-        std::vector<std::shared_ptr<Material>> createdMaterials;
+        std::vector<MaterialHandle> createdMaterials;
+        for (const auto &importedMaterial : imported.materials)
+        {
+            createdMaterials.push_back(createImportedMaterial(importedMaterial, textures));
+        }
+        spdlog::trace("Loaded {} materials defined in the MTL", createdMaterials.size());
 
-        for (size_t i = 0; i < materials.size(); i++)
+        // Create static mesh(es)
+        LoadedStaticMeshes allMeshesWithMats;
+        for (size_t i = 0; i < imported.submeshes.size(); i++)
         {
-            const auto &objMaterial = materials[i];
-            std::shared_ptr<StandardMaterial> material = std::dynamic_pointer_cast<StandardMaterial>(createStandardMaterial(materials[i].name, 0));
+            ImportedSubmesh &submesh = imported.submeshes[i];
+            std::string submeshName = name + '.' + submesh.name;
 
-            // Load diffuse texture if exists
-            if (objMaterial.diffuse_texname.size() > 0)
+            std::shared_ptr<StaticMesh> mesh = createStaticMesh(submesh, streamPath, i, residency);
+            if (m_StaticMeshes.contains(submeshName))
             {
-                spdlog::trace("Loading diffuse map {}", objMaterial.diffuse_texname);
-                auto tex = loadTexture2DFromPNG(objMaterial.diffuse_texname, objMaterial.diffuse_texname);
-                material->setDiffuseMap(tex);
+                spdlog::warn("Static mesh \"{}\" already exists and will be replaced", submeshName);
             }
+            StaticMeshHandle meshHandle = m_StaticMeshes.add(submeshName, mesh);
 
-            glm::vec3 diffuseColor{objMaterial.diffuse[0],
-                                   objMaterial.diffuse[1],
-                                   objMaterial.diffuse[2]};
-            // To avoid getting black objects when diffuse color is missing in the MTL
-            if (glm::length(diffuseColor) > 0.01f)
-            {
-                material->setDiffuseColor(diffuseColor);
-            }
+            // Pick the correct matrial for this (sub)mesh
+            MaterialHandle material = submesh.materialIndex >= 0
+                                          ? createdMaterials[submesh.materialIndex]
+                                          : getMaterialHandle("DEFAULT");
+            allMeshesWithMats.push_back(std::make_pair(meshHandle, material));
+        }
+
+        spdlog::trace("Loaded {} static meshes", allMeshesWithMats.size());
 
-            // Load normal map if exists
-            if (objMaterial.normal_texname.size() > 0)
+        return allMeshesWithMats;
+    }
+
+    ImportedMesh ResourceManager::importStaticMesh(const std::string &objPath, bool allowCooked, std::string &streamPath)
+    {
+        std::string cachePath = MeshCache::cachePathFor(objPath);
+
+        ImportedMesh imported;
+        std::string cookedPath = allowCooked ? m_AssetManifest.find(AssetManifest::AssetKind::Mesh, objPath) : std::string();
+        if (!cookedPath.empty() && readMeshCache(cookedPath, imported, true))
+        {
+            spdlog::trace("Using cooked mesh \"{}\"", cookedPath);
+            streamPath = cookedPath;
+        }
+        else if (readMeshCache(cachePath, imported, false))
+        {
+            streamPath = cachePath;
+        }
+        else
+        {
+            imported = MeshImporter::importObj(*m_Vfs, objPath, m_ThreadPool);
+            // Caches are only written next to loose files, the archive is read-only
+            bool cached = !m_Vfs->isArchived(objPath) && MeshCache::write(makePath(cachePath), imported);
+            streamPath = cached ? cachePath : std::string();
+        }
+        return imported;
+    }
+
+    bool ResourceManager::readMeshCache(const std::string &cachePath, ImportedMesh &imported, bool cooked)
+    {
+        bool read = false;
+        if (!m_Vfs->isArchived(cachePath))
+        {
+            // Cooked meshes are stale once a source they were cooked from changed
+            read = MeshCache::read(makePath(cachePath), imported, cooked ? m_DataDirectory : std::string());
+        }
+        else
+        {
+            try
             {
-                spdlog::trace("Loading normal map {}", objMaterial.normal_texname);
-                auto tex = loadTexture2DFromPNG(objMaterial.normal_texname, objMaterial.normal_texname);
-                material->setNormalMap(tex);
+                VfsFile file = m_Vfs->open(cachePath, &m_ThreadPool);
+                read = MeshCache::read(file.data(), file.size(), cachePath, imported, false);
             }
-
-            // Load roughness map if exists
-            if (objMaterial.roughness_texname.size() > 0)
+            catch (std::exception &e)
             {
-                spdlog::trace("Loading rougness map {}", objMaterial.roughness_texname);
-                auto tex = loadTexture2DFromPNG(objMaterial.roughness_texname, objMaterial.roughness_texname);
-                material->setRoughnessMap(tex);
+                spdlog::warn("Unable to read mesh cache \"{}\" from the asset archive", cachePath);
+                return false;
             }
+        }
 
-            // Load metalness map if exists
-            if (objMaterial.metallic_texname.size() > 0)
+        // The file watcher matches full paths
+        if (read && cooked)
+        {
+            for (auto &sourcePath : imported.sourcePaths)
             {
-                spdlog::trace("Loading metalness map {}", objMaterial.metallic_texname);
-                auto tex = loadTexture2DFromPNG(objMaterial.metallic_texname, objMaterial.metallic_texname);
-                material->setMetalnessMap(tex);
+                sourcePath = makePath(sourcePath);
             }
+        }
+        return read;
+    }
 
-            spdlog::info("Material flags: {}", material->getFlags());
-
-            createdMaterials.push_back(material);
+    std::shared_ptr<StaticMesh> ResourceManager::createStaticMesh(ImportedSubmesh &submesh,
+                                                                  const std::string &streamPath,
+                                                                  size_t submeshIndex,
+                                                                  StaticMesh::Residency residency)
+    {
+        std::shared_ptr<StaticMesh> mesh = std::make_shared<StaticMesh>(std::move(submesh.vertices),
+                                                                        std::move(submesh.triangleIndices),
+                                                                        std::move(submesh.lods));
+        if (!streamPath.empty())
+        {
+            // Holds on to the VFS, the mesh may outlive this object
+            mesh->setStreamSource([vfs = m_Vfs, streamPath, submeshIndex](std::vector<StaticMesh::Vertex> &vertices, std::vector<GLuint> &triangleIndices)
+                                  {
+                                      ImportedSubmesh submesh;
+                                      try
+                                      {
+                                          VfsFile file = vfs->open(streamPath);
+                                          if (!MeshCache::readSubmesh(file.data(), file.size(), streamPath, submeshIndex, submesh))
+                                          {
+                                              return false;
+                                          }
+                                      }
+                                      catch (std::exception &e)
+                                      {
+                                          spdlog::warn("Unable to re-stream submesh {} from \"{}\"", submeshIndex, streamPath);
+                                          return false;
+                                      }
+                                      vertices = std::move(submesh.vertices);
+                                      triangleIndices = std::move(submesh.triangleIndices);
+                                      return true; });
         }
-        spdlog::trace("Loaded {} materials defined in the MTL", createdMaterials.size());
+        mesh->setResidency(residency);
+        return mesh;
+    }
 
-        // Create static mesh(es)
-        std::vector<std::shared_ptr<StaticMesh>> createdMeshes;
-        std::vector<int> materialIndices;
-        std::vector<glm::vec3> vertexPositions;
-        std::vector<glm::vec3> vertexNormals;
-        std::vector<glm::vec2> vertexUVs;
-        std::vector<GLuint> triangleIndices;
-        for (size_t s = 0; s < shapes.size(); s++)
+    std::vector<std::pair<std::string, std::string>> ResourceManager::collectTextures(const ImportedMesh &imported)
+    {
+        std::vector<std::pair<std::string, std::string>> textures;
+        for (const auto &importedMaterial : imported.materials)
         {
-            size_t index_offset = 0;
-            for (size_t f = 0; f < shapes[s].mesh.num_face_vertices.size(); f++)
+            for (const std::string *map : {&importedMaterial.diffuseMap,
+                                           &importedMaterial.normalMap,
+                                           &importedMaterial.roughnessMap,
+                                           &importedMaterial.metalnessMap})
             {
-                size_t fv = size_t(shapes[s].mesh.num_face_vertices[f]);
-
-                for (size_t v = 0; v < fv; v++)
+                if (map->size() > 0)
                 {
-                    tinyobj::index_t idx = shapes[s].mesh.indices[index_offset + v];
-                    tinyobj::real_t vx = attrib.vertices[3 * size_t(idx.vertex_index) + 0];
-                    tinyobj::real_t vy = attrib.vertices[3 * size_t(idx.vertex_index) + 1];
-                    tinyobj::real_t vz = attrib.vertices[3 * size_t(idx.vertex_index) + 2];
-
-                    vertexPositions.emplace_back(vx, vy, vz);
-
-                    if (idx.normal_index >= 0)
-                    {
-                        tinyobj::real_t nx = attrib.normals[3 * size_t(idx.normal_index) + 0];
-                        tinyobj::real_t ny = attrib.normals[3 * size_t(idx.normal_index) + 1];
-                        tinyobj::real_t nz = attrib.normals[3 * size_t(idx.normal_index) + 2];
-                        vertexNormals.emplace_back(nx, ny, nz);
-                    }
-                    else
-                    {
-                        vertexNormals.emplace_back(0.0f);
-                    }
-
-                    if (idx.texcoord_index >= 0)
-                    {
-                        tinyobj::real_t tx = attrib.texcoords[2 * size_t(idx.texcoord_index) + 0];
-                        tinyobj::real_t ty = attrib.texcoords[2 * size_t(idx.texcoord_index) + 1];
-                        vertexUVs.emplace_back(tx, ty);
-                    }
-                    else
-                    {
-                        vertexUVs.emplace_back(0.0f);
-                    }
-                    triangleIndices.emplace_back(index_offset + v);
+                    textures.emplace_back(*map, *map);
                 }
-                index_offset += fv;
             }
+        }
+        return textures;
+    }
 
-            // Pick the correct matrial for this (sub)mesh
-            materialIndices.push_back(shapes[s].mesh.material_ids[0]);
+    void ResourceManager::loadStaticMeshAsync(const std::string &name,
+                                              const std::string &objPath,
+                                              StaticMesh::VertexFormat vertexFormat,
+                                              StaticMesh::Residency residency,
+                                              std::function<void(LoadedStaticMeshes &)> onLoaded)
+    {
+        spdlog::trace("Queueing static mesh \"{}\" from OBJ file \"{}\"", name, makePath(objPath));
 
-            std::string submeshName = name + '.' + shapes[s].name;
+        auto load = std::make_unique<StaticMeshLoad>();
+        load->name = name;
+        load->objPath = objPath;
+        load->vertexFormat = vertexFormat;
+        load->residency = residency;
+        load->onLoaded = std::move(onLoaded);
 
-            std::shared_ptr<StaticMesh> mesh = std::make_shared<StaticMesh>(vertexPositions, vertexNormals, vertexUVs, triangleIndices);
-            if (m_StaticMeshes.find(submeshName) != m_StaticMeshes.end())
-            {
-                spdlog::warn("Static mesh \"{}\" already exists and will be replaced", name);
-            }
-            m_StaticMeshes[submeshName] = mesh;
-            createdMeshes.push_back(mesh);
+        queueStaticMeshLoad(std::move(load));
+    }
 
-            vertexPositions.clear();
-            vertexNormals.clear();
-            vertexUVs.clear();
-            triangleIndices.clear();
-        }
+    void ResourceManager::queueStaticMeshLoad(std::unique_ptr<StaticMeshLoad> load)
+    {
+        // The flag is global in stb_image, set it before any worker starts decoding
+        stbi_set_flip_vertically_on_load(true);
+
+        m_LoadsRequested++;
+        m_LoadTasks.push_back(m_ThreadPool.submit([this, load = std::move(load)]() mutable
+                                                  {
+                                                      double start = glfwGetTime();
+                                                      try
+                                                      {
+                                                          prepareStaticMeshLoad(*load);
+                                                          spdlog::trace("Prepared static mesh \"{}\" for upload in {:.1f} ms",
+                                                                        load->name, (glfwGetTime() - start) * 1000.0);
+                                                      }
+                                                      catch (std::exception &e)
+                                                      {
+                                                          load->error = e.what();
+                                                      }
+                                                      std::lock_guard<std::mutex> lock(m_LoadMutex);
+                                                      m_ReadyLoads.push_back(std::move(load)); }));
+    }
 
-        spdlog::trace("Loaded {} static meshes", createdMeshes.size());
+    void ResourceManager::collectFinishedLoadTasks()
+    {
+        auto finished = std::remove_if(m_LoadTasks.begin(), m_LoadTasks.end(), [](std::future<void> &task)
+                                       {
+                                           if (task.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+                                           {
+                                               return false;
+                                           }
+                                           try
+                                           {
+                                               task.get();
+                                           }
+                                           catch (std::exception &e)
+                                           {
+                                               spdlog::error("Asynchronous load failed: {}", e.what());
+                                           }
+                                           return true; });
+        m_LoadTasks.erase(finished, m_LoadTasks.end());
+    }
 
-        std::vector<std::pair<std::shared_ptr<StaticMesh>, std::shared_ptr<Material>>> allMeshesWithMats;
-        for (size_t i = 0; i < createdMeshes.size(); i++)
+    void ResourceManager::releaseReplacedResources()
+    {
+        size_t released = m_ShaderPrograms.releaseUnreferenced() + m_Materials.releaseUnreferenced() +
+                          m_Textures2D.releaseUnreferenced() + m_StaticMeshes.releaseUnreferenced();
+        if (released > 0)
         {
-            allMeshesWithMats.push_back(std::make_pair(createdMeshes[i], createdMaterials[materialIndices[i]]));
+            spdlog::debug("Released {} replaced resources", released);
         }
-
-        return allMeshesWithMats;
     }
 
-    std::shared_ptr<StaticMesh> ResourceManager::getStaticMesh(const std::string &name) const
+    void ResourceManager::prepareStaticMeshLoad(StaticMeshLoad &load)
     {
-        auto it = m_StaticMeshes.find(name);
-        if (it == m_StaticMeshes.end())
+        // Cooked meshes are stale once their source changed
+        std::string streamPath;
+        load.imported = importStaticMesh(load.objPath, !load.reload, streamPath);
+
+        // Same deduplication as loadTextures2D, but textures loaded earlier are only skipped at upload
+        std::vector<std::pair<std::string, std::string>> unique;
+        for (const auto &[name, path] : collectTextures(load.imported))
         {
-            spdlog::error("Unable to find static mesh \"{}\"", name);
-            throw std::runtime_error("Unable to find static mesh");
+            if (load.loadedTextures.count(name) == 0 &&
+                std::find_if(unique.begin(), unique.end(), [&name = name](const auto &texture)
+                             { return texture.first == name; }) == unique.end())
+            {
+                unique.emplace_back(name, path);
+            }
+        }
+
+        load.textures.resize(unique.size());
+        m_ThreadPool.parallelFor(0, unique.size(), 1, [&](size_t begin, size_t end)
+                                 {
+                                     for (size_t i = begin; i < end; i++)
+                                     {
+                                         load.textures[i].name = unique[i].first;
+                                         load.textures[i].path = unique[i].second;
+                                         prepareTexture(load.textures[i]);
+                                     } });
+
+        // Creating the meshes does not touch OpenGL yet
+        for (size_t i = 0; i < load.imported.submeshes.size(); i++)
+        {
+            load.meshes.push_back(createStaticMesh(load.imported.submeshes[i], streamPath, i, load.residency));
         }
-        return it->second;
     }
 
-    void ResourceManager::reloadStandardShader()
+    void ResourceManager::prepareTexture(PendingTexture &pending)
     {
-        auto newProgram = loadShaderProgram("Standard", "shaders/Standard_vert.glsl", "shaders/Standard_frag.glsl");
-        for (auto &m : m_Materials)
+        std::string cookedPath = m_AssetManifest.find(AssetManifest::AssetKind::Texture, pending.path);
+        if (!cookedPath.empty())
         {
-            auto sm = std::dynamic_pointer_cast<StandardMaterial>(m.second);
-            if (sm)
+            try
             {
-                sm->replaceProgram(newProgram);
+                VfsFile file = m_Vfs->open(cookedPath);
+                pending.cooked = std::make_unique<CookedTexture>(cookedPath, file.data(), file.size(), file.getOwner());
+                return;
+            }
+            catch (std::exception &e)
+            {
+                spdlog::warn("Unable to use cooked texture \"{}\", falling back to \"{}\"", cookedPath, pending.path);
             }
         }
+        pending.image = decodeImage(pending.path);
+    }
+
+    void ResourceManager::processUploads(double budgetMs)
+    {
+        pollShaderPrograms();
+        collectFinishedLoadTasks();
+        releaseReplacedResources();
+
+        double start = glfwGetTime();
+        do
+        {
+            std::unique_ptr<TextureReload> textureReload;
+            {
+                std::lock_guard<std::mutex> lock(m_LoadMutex);
+                if (!m_ReadyTextureReloads.empty())
+                {
+                    textureReload = std::make_unique<TextureReload>(std::move(m_ReadyTextureReloads.front()));
+                    m_ReadyTextureReloads.pop_front();
+                }
+            }
+            if (textureReload)
+            {
+                finishTextureReload(*textureReload);
+                continue;
+            }
+
+            std::unique_ptr<PendingTexture> texture;
+            {
+                std::lock_guard<std::mutex> lock(m_LoadMutex);
+                if (!m_ReadyTextures.empty())
+                {
+                    texture = std::make_unique<PendingTexture>(std::move(m_ReadyTextures.front()));
+                    m_ReadyTextures.pop_front();
+                }
+            }
+            if (texture)
+            {
+                finishTextureLoad(*texture);
+                continue;
+            }
+
+            if (!m_UploadingLoad)
+            {
+                std::lock_guard<std::mutex> lock(m_LoadMutex);
+                if (m_ReadyLoads.empty())
+                {
+                    return;
+                }
+                m_UploadingLoad = std::move(m_ReadyLoads.front());
+                m_ReadyLoads.pop_front();
+            }
+
+            if (advanceUpload(*m_UploadingLoad))
+            {
+                // Reset first, the callback may queue further loads
+                std::unique_ptr<StaticMeshLoad> load = std::move(m_UploadingLoad);
+                m_LoadsCompleted++;
+                if (load->reload)
+                {
+                    finishStaticMeshReload(*load);
+                }
+                else
+                {
+                    finishStaticMeshLoad(*load);
+                }
+            }
+        } while ((glfwGetTime() - start) * 1000.0 < budgetMs);
+    }
+
+    bool ResourceManager::advanceUpload(StaticMeshLoad &load)
+    {
+        if (!load.error.empty())
+        {
+            return true;
+        }
+
+        size_t upload = load.nextUpload++;
+        if (upload < load.textures.size())
+        {
+            PendingTexture &pending = load.textures[upload];
+            load.uploadedTextures[pending.name] = uploadPendingTexture(pending);
+            m_TextureSources[pending.name] = pending.path;
+        }
+        else if (upload - load.textures.size() < load.meshes.size())
+        {
+            load.meshes[upload - load.textures.size()]->uploadToGPU(load.vertexFormat);
+        }
+        return load.nextUpload >= load.textures.size() + load.meshes.size();
+    }
+
+    std::shared_ptr<Texture2D> ResourceManager::uploadPendingTexture(PendingTexture &pending)
+    {
+        // Shared with a mesh that finished loading earlier
+        if (const auto *loaded = m_Textures2D.find(pending.name))
+        {
+            return *loaded;
+        }
+
+        std::shared_ptr<Texture2D> tex = pending.cooked ? createTexture2D(pending.name, *pending.cooked)
+                                                        : createTexture2D(pending.name, pending.image);
+        pending.cooked.reset();
+        pending.image.pixels.reset();
+        return tex;
+    }
+
+    void ResourceManager::finishStaticMeshLoad(StaticMeshLoad &load)
+    {
+        if (!load.error.empty())
+        {
+            spdlog::error("Unable to load static mesh \"{}\": {}", load.name, load.error);
+            return;
+        }
+
+        m_MeshSources[load.name] = {load.objPath, {}};
+        for (const auto &sourcePath : load.imported.sourcePaths)
+        {
+            m_MeshSources[load.name].fullPaths.push_back(normalizePath(sourcePath));
+        }
+        m_MeshSources[load.name].fullPaths.push_back(normalizePath(makePath(load.objPath)));
+        batchTextureArrays(load.uploadedTextures);
+
+        std::vector<MaterialHandle> createdMaterials;
+        for (const auto &importedMaterial : load.imported.materials)
+        {
+            createdMaterials.push_back(createImportedMaterial(importedMaterial, load.uploadedTextures));
+        }
+
+        LoadedStaticMeshes meshesWithMats;
+        for (size_t i = 0; i < load.meshes.size(); i++)
+        {
+            const ImportedSubmesh &submesh = load.imported.submeshes[i];
+            std::string submeshName = load.name + '.' + submesh.name;
+            if (m_StaticMeshes.contains(submeshName))
+            {
+                spdlog::warn("Static mesh \"{}\" already exists and will be replaced", submeshName);
+            }
+            StaticMeshHandle meshHandle = m_StaticMeshes.add(submeshName, load.meshes[i]);
+
+            MaterialHandle material = submesh.materialIndex >= 0
+                                          ? createdMaterials[submesh.materialIndex]
+                                          : getMaterialHandle("DEFAULT");
+            meshesWithMats.push_back(std::make_pair(meshHandle, material));
+        }
+
+        spdlog::trace("Loaded {} static meshes of \"{}\" asynchronously", meshesWithMats.size(), load.name);
+        if (load.onLoaded)
+        {
+            load.onLoaded(meshesWithMats);
+        }
+    }
+
+    ResourceManager::LoadedStaticMeshes ResourceManager::loadGltfModel(const std::string &name,
+                                                                       const std::string &glbPath,
+                                                                       StaticMesh::VertexFormat vertexFormat)
+    {
+        spdlog::trace("Loading glTF model \"{}\" from \"{}\"", name, makePath(glbPath));
+        double start = glfwGetTime();
+
+        VfsFile file = m_Vfs->open(glbPath, &m_ThreadPool);
+        GltfModel model = GltfImporter::importGlb(makePath(glbPath), file.data(), file.size(), file.getOwner());
+        auto textures = loadGltfTextures(glbPath, model);
+        batchTextureArrays(textures);
+
+        std::vector<MaterialHandle> createdMaterials;
+        for (const auto &gltfMaterial : model.materials)
+        {
+            std::shared_ptr<StandardMaterial> material = makeStandardMaterial(0);
+            material->setDiffuseColor(glm::vec3(gltfMaterial.baseColorFactor));
+            material->setRoughness(gltfMaterial.roughnessFactor);
+            material->setMetalness(gltfMaterial.metallicFactor);
+            material->setEmissionColor(gltfMaterial.emissiveFactor);
+            // The shader uses the maps instead of the factors, glTF would multiply them
+            if (gltfMaterial.baseColorImage >= 0)
+            {
+                material->setDiffuseMap(textures.at(gltfImageName(glbPath, model, gltfMaterial.baseColorImage)));
+            }
+            if (gltfMaterial.normalImage >= 0)
+            {
+                material->setNormalMap(textures.at(gltfImageName(glbPath, model, gltfMaterial.normalImage)));
+            }
+            if (gltfMaterial.metallicRoughnessImage >= 0)
+            {
+                std::string imageName = gltfImageName(glbPath, model, gltfMaterial.metallicRoughnessImage);
+                material->setRoughnessMap(textures.at(imageName + "#roughness"));
+                material->setMetalnessMap(textures.at(imageName + "#metalness"));
+            }
+            if (gltfMaterial.occlusionImage >= 0)
+            {
+                material->setAoMap(textures.at(gltfImageName(glbPath, model, gltfMaterial.occlusionImage)));
+            }
+            if (gltfMaterial.emissiveImage >= 0)
+            {
+                material->setEmissionMap(textures.at(gltfImageName(glbPath, model, gltfMaterial.emissiveImage)));
+            }
+            createdMaterials.push_back(addMaterial(name + '.' + gltfMaterial.name, material));
+        }
+
+        LoadedStaticMeshes meshesWithMats;
+        for (const auto &primitive : model.primitives)
+        {
+            std::string meshName = name + '.' + primitive.name;
+            std::shared_ptr<StaticMesh> mesh = createGltfStaticMesh(model, primitive);
+            mesh->uploadToGPU(vertexFormat);
+            if (m_StaticMeshes.contains(meshName))
+            {
+                spdlog::warn("Static mesh \"{}\" already exists and will be replaced", meshName);
+            }
+            StaticMeshHandle meshHandle = m_StaticMeshes.add(meshName, mesh);
+
+            MaterialHandle material = primitive.materialIndex >= 0
+                                          ? createdMaterials[primitive.materialIndex]
+                                          : getMaterialHandle("DEFAULT");
+            meshesWithMats.push_back(std::make_pair(meshHandle, material));
+        }
+
+        spdlog::trace("Loaded {} static meshes of glTF model \"{}\" in {:.1f} ms",
+                      meshesWithMats.size(), name, (glfwGetTime() - start) * 1000.0);
+        return meshesWithMats;
+    }
+
+    std::string ResourceManager::gltfImageName(const std::string &glbPath, const GltfModel &model, int32_t image)
+    {
+        const GltfImage &gltfImage = model.images[image];
+        if (gltfImage.uri.empty())
+        {
+            return glbPath + "#image" + std::to_string(image);
+        }
+        // Relative to the data directory, like the paths of all other textures
+        return normalizePath((std::filesystem::path(glbPath).parent_path() / gltfImage.uri).string());
+    }
+
+    void ResourceManager::prepareGltfImage(DecodedImage &image, int channel)
+    {
+        if (!image.pixels)
+        {
+            return;
+        }
+
+        // stb_image flips every image since the flag is global and shared with the OBJ textures
+        size_t rowSize = static_cast<size_t>(image.width) * image.numChannels;
+        std::vector<unsigned char> row(rowSize);
+        unsigned char *pixels = image.pixels.get();
+        for (int y = 0; y < image.height / 2; y++)
+        {
+            unsigned char *top = pixels + y * rowSize;
+            unsigned char *bottom = pixels + (image.height - 1 - y) * rowSize;
+            std::memcpy(row.data(), top, rowSize);
+            std::memcpy(top, bottom, rowSize);
+            std::memcpy(bottom, row.data(), rowSize);
+        }
+
+        if (channel < 0)
+        {
+            return;
+        }
+        size_t pixelCount = static_cast<size_t>(image.width) * image.height;
+        unsigned char *extracted = static_cast<unsigned char *>(std::malloc(pixelCount));
+        if (extracted == nullptr)
+        {
+            image.pixels.reset();
+            return;
+        }
+        // Grayscale images carry the value in their only channel
+        int source = std::min(channel, image.numChannels - 1);
+        for (size_t i = 0; i < pixelCount; i++)
+        {
+            extracted[i] = pixels[i * image.numChannels + source];
+        }
+        image.pixels = std::unique_ptr<unsigned char, void (*)(void *)>(extracted, std::free);
+        image.numChannels = 1;
+    }
+
+    std::unordered_map<std::string, std::shared_ptr<Texture2D>>
+    ResourceManager::loadGltfTextures(const std::string &glbPath, const GltfModel &model)
+    {
+        struct TextureRequest
+        {
+            std::string name;
+            int32_t image;
+            int channel;
+        };
+
+        // The shader reads roughness and metalness from the red channel, so the packed
+        // metallic-roughness image is split into two single channel textures
+        std::unordered_map<std::string, std::shared_ptr<Texture2D>> textures;
+        std::vector<TextureRequest> requests;
+        auto request = [&](int32_t image, int channel, const char *suffix)
+        {
+            if (image < 0)
+            {
+                return;
+            }
+            std::string textureName = gltfImageName(glbPath, model, image) + suffix;
+            if (textures.find(textureName) != textures.end())
+            {
+                return;
+            }
+            const auto *loaded = m_Textures2D.find(textureName);
+            textures[textureName] = loaded != nullptr ? *loaded : nullptr;
+            if (loaded == nullptr)
+            {
+                requests.push_back({textureName, image, channel});
+            }
+        };
+        for (const auto &material : model.materials)
+        {
+            request(material.baseColorImage, -1, "");
+            request(material.normalImage, -1, "");
+            request(material.occlusionImage, -1, "");
+            request(material.emissiveImage, -1, "");
+            request(material.metallicRoughnessImage, 1, "#roughness");
+            request(material.metallicRoughnessImage, 2, "#metalness");
+        }
+
+        stbi_set_flip_vertically_on_load(true);
+        std::vector<DecodedImage> images(requests.size());
+        m_ThreadPool.parallelFor(0, requests.size(), 1, [&](size_t begin, size_t end)
+                                 {
+                                     for (size_t i = begin; i < end; i++)
+                                     {
+                                         const GltfImage &image = model.images[requests[i].image];
+                                         images[i] = image.uri.empty() ? decodeImage(requests[i].name, model.binary + image.offset, image.size)
+                                                                       : decodeImage(gltfImageName(glbPath, model, requests[i].image));
+                                         prepareGltfImage(images[i], requests[i].channel);
+                                     } });
+
+        for (size_t i = 0; i < requests.size(); i++)
+        {
+            textures[requests[i].name] = createTexture2D(requests[i].name, images[i]);
+            images[i].pixels.reset();
+        }
+        return textures;
+    }
+
+    std::shared_ptr<StaticMesh> ResourceManager::createGltfStaticMesh(const GltfModel &model, const GltfPrimitive &primitive)
+    {
+        auto isFloat = [](const GltfAccessor &accessor, GLint components)
+        { return accessor.componentType == GL_FLOAT && accessor.components == components; };
+        bool drawableUVs = primitive.uvs.count == 0 || isFloat(primitive.uvs, 2) ||
+                           (primitive.uvs.normalized && primitive.uvs.componentType != GL_UNSIGNED_INT);
+        bool direct = isFloat(primitive.positions, 3) && isFloat(primitive.normals, 3) && isFloat(primitive.tangents, 4) &&
+                      drawableUVs && primitive.indices.count != 0 && primitive.indices.componentType != GL_FLOAT &&
+                      primitive.indices.stride == primitive.indices.componentSize();
+
+        if (direct)
+        {
+            // The byte range covering all accessors of the primitive, its start kept 4-byte aligned
+            size_t begin = model.binarySize, end = 0;
+            for (const GltfAccessor *accessor : {&primitive.positions, &primitive.normals, &primitive.tangents,
+                                                 &primitive.uvs, &primitive.indices})
+            {
+                if (accessor->count != 0)
+                {
+                    begin = std::min(begin, accessor->offset);
+                    end = std::max(end, accessor->offset + accessor->byteLength());
+                }
+            }
+            begin &= ~size_t{3};
+
+            auto view = [begin](const GltfAccessor &accessor)
+            {
+                StaticMesh::AttributeView attribute;
+                if (accessor.count != 0)
+                {
+                    attribute = {accessor.offset - begin, static_cast<GLsizei>(accessor.stride), accessor.componentType,
+                                 accessor.components, static_cast<GLboolean>(accessor.normalized ? GL_TRUE : GL_FALSE)};
+                }
+                return attribute;
+            };
+
+            StaticMesh::ExternalBuffer buffer;
+            buffer.owner = model.owner;
+            buffer.data = model.binary + begin;
+            buffer.size = end - begin;
+            buffer.vertexCount = primitive.positions.count;
+            buffer.position = view(primitive.positions);
+            buffer.normal = view(primitive.normals);
+            buffer.tangent = view(primitive.tangents);
+            buffer.uv = view(primitive.uvs);
+            buffer.indexOffset = primitive.indices.offset - begin;
+            buffer.indexCount = primitive.indices.count;
+            buffer.indexType = primitive.indices.componentType;
+            return std::make_shared<StaticMesh>(std::move(buffer));
+        }
+
+        spdlog::trace("glTF primitive \"{}\" cannot be drawn from the file as it is and is converted", primitive.name);
+        if (primitive.normals.count == 0)
+        {
+            spdlog::error("glTF primitive \"{}\" has no normals", primitive.name);
+            throw std::runtime_error("glTF primitives without normals are not supported");
+        }
+
+        std::vector<glm::vec3> positions, normals;
+        std::vector<glm::vec2> uvs(primitive.positions.count, glm::vec2(0.0f));
+        for (const glm::vec4 &position : GltfImporter::readFloats(model, primitive.positions))
+        {
+            positions.emplace_back(position);
+        }
+        for (const glm::vec4 &normal : GltfImporter::readFloats(model, primitive.normals))
+        {
+            normals.emplace_back(normal);
+        }
+        if (primitive.uvs.count != 0)
+        {
+            std::vector<glm::vec4> values = GltfImporter::readFloats(model, primitive.uvs);
+            for (size_t i = 0; i < values.size(); i++)
+            {
+                uvs[i] = glm::vec2(values[i].x, values[i].y);
+            }
+        }
+        std::vector<GLuint> indices;
+        if (primitive.indices.count != 0)
+        {
+            indices = GltfImporter::readIndices(model, primitive.indices);
+        }
+        else
+        {
+            indices.resize(primitive.positions.count);
+            std::iota(indices.begin(), indices.end(), 0);
+        }
+
+        return std::make_shared<StaticMesh>(StaticMesh::buildVertices(positions, normals, uvs, indices, &m_ThreadPool),
+                                            std::move(indices));
+    }
+
+    ResourceManager::LoadingProgress ResourceManager::getLoadingProgress() const
+    {
+        LoadingProgress progress;
+        progress.requested = m_LoadsRequested;
+        progress.completed = m_LoadsCompleted;
+        progress.compilingShaders = m_CompilingShaders;
+        if (m_UploadingLoad)
+        {
+            progress.uploading = m_UploadingLoad->name;
+            progress.uploadsDone = m_UploadingLoad->nextUpload;
+            progress.uploadsTotal = m_UploadingLoad->textures.size() + m_UploadingLoad->meshes.size();
+        }
+        return progress;
+    }
+
+    MaterialHandle ResourceManager::createImportedMaterial(const ImportedMaterial &importedMaterial,
+                                                           const std::unordered_map<std::string, std::shared_ptr<Texture2D>> &textures)
+    {
+        spdlog::trace("Creating Standard material \"{}\"", importedMaterial.name);
+        return addMaterial(importedMaterial.name, makeImportedMaterial(importedMaterial, textures));
+    }
+
+    std::shared_ptr<StandardMaterial> ResourceManager::makeImportedMaterial(const ImportedMaterial &importedMaterial,
+                                                                            const std::unordered_map<std::string, std::shared_ptr<Texture2D>> &textures)
+    {
+        std::shared_ptr<StandardMaterial> material = makeStandardMaterial(0);
+
+        // Set diffuse texture if exists
+        if (importedMaterial.diffuseMap.size() > 0)
+        {
+            material->setDiffuseMap(textures.at(importedMaterial.diffuseMap));
+        }
+
+        // To avoid getting black objects when diffuse color is missing in the MTL
+        if (glm::length(importedMaterial.diffuseColor) > 0.01f)
+        {
+            material->setDiffuseColor(importedMaterial.diffuseColor);
+        }
+
+        // Set normal map if exists
+        if (importedMaterial.normalMap.size() > 0)
+        {
+            material->setNormalMap(textures.at(importedMaterial.normalMap));
+        }
+
+        // Set roughness map if exists
+        if (importedMaterial.roughnessMap.size() > 0)
+        {
+            material->setRoughnessMap(textures.at(importedMaterial.roughnessMap));
+        }
+
+        // Set metalness map if exists
+        if (importedMaterial.metalnessMap.size() > 0)
+        {
+            material->setMetalnessMap(textures.at(importedMaterial.metalnessMap));
+        }
+
+        spdlog::info("Material flags: {}", material->getFlags());
+
+        return material;
+    }
+
+    ResourceHandle<StaticModel> ResourceManager::requestStaticModel(const std::string &name,
+                                                                     const std::string &objPath,
+                                                                     StaticMesh::VertexFormat vertexFormat,
+                                                                     StaticMesh::Residency residency)
+    {
+        auto it = m_ModelHandles.find(name);
+        if (it != m_ModelHandles.end())
+        {
+            return it->second;
+        }
+
+        spdlog::trace("Deferring static model \"{}\" from OBJ file \"{}\" until it is drawn", name, makePath(objPath));
+        ResourceHandle<StaticModel> handle;
+        handle.m_State = std::make_shared<ResourceHandle<StaticModel>::State>();
+        // Weak, the state owns this function until the load is requested
+        std::weak_ptr<ResourceHandle<StaticModel>::State> state = handle.m_State;
+        handle.m_State->requestLoad = [this, name, objPath, vertexFormat, residency, state]()
+        {
+            loadStaticMeshAsync(name, objPath, vertexFormat, residency,
+                                [name, state](LoadedStaticMeshes &meshes)
+                                {
+                                    if (auto loadedState = state.lock())
+                                    {
+                                        loadedState->resource = std::make_shared<StaticModel>(StaticModel{name, meshes});
+                                    }
+                                });
+        };
+        m_ModelHandles[name] = handle;
+        return handle;
+    }
+
+    std::shared_ptr<StaticMesh> ResourceManager::getStaticMesh(const std::string &name) const
+    {
+        const auto *resource = m_StaticMeshes.find(name);
+        if (resource == nullptr)
+        {
+            spdlog::error("Unable to find static mesh \"{}\"", name);
+            throw std::runtime_error("Unable to find static mesh");
+        }
+        return *resource;
+    }
+
+    void ResourceManager::reloadShaderProgram(const std::string &name)
+    {
+        auto sourcesIt = m_ShaderSources.find(name);
+        if (sourcesIt == m_ShaderSources.end())
+        {
+            spdlog::error("Unable to find shader program \"{}\"", name);
+            throw std::runtime_error("Unable to find shader program");
+        }
+
+        // Only replaced once the new program works, a broken edit keeps the old dependencies watched
+        ShaderSources sources{sourcesIt->second.vertex, sourcesIt->second.fragment, {}, 0};
+        std::shared_ptr<ShaderProgram> newProgram;
+        std::pair<std::string, std::string> preprocessed;
+        try
+        {
+            preprocessed = preprocessShaderSources(sources);
+            if (sources.hash == sourcesIt->second.hash)
+            {
+                spdlog::trace("Shader program \"{}\" is unchanged after preprocessing, not reloading it", name);
+                return;
+            }
+            spdlog::info("Reloading shader program \"{}\"", name);
+            newProgram = std::make_shared<ShaderProgram>(preprocessed.first, preprocessed.second);
+        }
+        catch (std::exception &e)
+        {
+            spdlog::warn("Shader program \"{}\" could not be rebuilt, keeping the old one", name);
+            return;
+        }
+        // The old program is deleted together with newProgram
+        (*m_ShaderPrograms.find(name))->swap(*newProgram);
+        sourcesIt->second = std::move(sources);
+
+        if (name == "Standard")
+        {
+            m_StandardVariants->reload();
+        }
+    }
+
+    void ResourceManager::reloadStandardShader()
+    {
+        reloadShaderProgram("Standard");
+    }
+
+    void ResourceManager::watchDataDirectory()
+    {
+        if (m_Vfs->hasArchive())
+        {
+            spdlog::warn("Hot reload is not available while assets are read from an archive");
+            return;
+        }
+        if (!m_FileWatcher)
+        {
+            m_FileWatcher = std::make_unique<FileWatcher>(m_DataDirectory);
+        }
+    }
+
+    std::string ResourceManager::normalizePath(const std::string &path)
+    {
+        return std::filesystem::path(path).lexically_normal().generic_string();
+    }
+
+    void ResourceManager::reloadChangedResources()
+    {
+        if (!m_FileWatcher)
+        {
+            return;
+        }
+
+        std::vector<std::string> changedFiles = m_FileWatcher->takeChangedFiles();
+        if (changedFiles.empty())
+        {
+            return;
+        }
+        std::unordered_set<std::string> changed;
+        for (const auto &path : changedFiles)
+        {
+            changed.insert(normalizePath(path));
+        }
+        auto hasChanged = [&](const std::string &relativePath)
+        { return changed.count(normalizePath(makePath(relativePath))) > 0; };
+
+        for (const auto &[name, sources] : m_ShaderSources)
+        {
+            if (std::any_of(sources.dependencies.begin(), sources.dependencies.end(), hasChanged))
+            {
+                reloadShaderProgram(name);
+            }
+        }
+
+        for (const auto &[name, path] : m_TextureSources)
+        {
+            // Textures that failed to load are not registered, materials use NOTEXTURE instead
+            if (!hasChanged(path) || !m_Textures2D.contains(name))
+            {
+                continue;
+            }
+            spdlog::info("Reloading 2D texture \"{}\" from \"{}\"", name, path);
+            // Always from the source image, a cooked version is outdated now
+            stbi_set_flip_vertically_on_load(true);
+            m_LoadTasks.push_back(m_ThreadPool.submit([this, name = name, path = path]()
+                                                      {
+                                                          TextureReload reload{name, decodeImage(path)};
+                                                          std::lock_guard<std::mutex> lock(m_LoadMutex);
+                                                          m_ReadyTextureReloads.push_back(std::move(reload)); }));
+        }
+
+        for (const auto &[name, sources] : m_MeshSources)
+        {
+            if (std::none_of(sources.fullPaths.begin(), sources.fullPaths.end(), [&](const std::string &path)
+                             { return changed.count(path) > 0; }))
+            {
+                continue;
+            }
+            spdlog::info("Reloading static mesh \"{}\" from \"{}\"", name, sources.objPath);
+
+            auto load = std::make_unique<StaticMeshLoad>();
+            load->name = name;
+            load->objPath = sources.objPath;
+            load->vertexFormat = StaticMesh::VertexFormat::Packed;
+            load->reload = true;
+            m_StaticMeshes.forEach([&, &name = name](const std::string &meshName, const std::shared_ptr<StaticMesh> &mesh)
+                                   {
+                                       // Keep the format and residency the submeshes were uploaded with
+                                       if (meshName.compare(0, name.size() + 1, name + '.') == 0)
+                                       {
+                                           load->vertexFormat = mesh->getVertexFormat();
+                                           load->residency = mesh->getResidency();
+                                       } });
+            m_Textures2D.forEach([&](const std::string &textureName, const std::shared_ptr<Texture2D> &)
+                                 { load->loadedTextures.insert(textureName); });
+            queueStaticMeshLoad(std::move(load));
+        }
+    }
+
+    void ResourceManager::finishTextureReload(TextureReload &reload)
+    {
+        if (!reload.image.pixels)
+        {
+            spdlog::warn("Unable to reload 2D texture \"{}\" from \"{}\", keeping the old one", reload.name, reload.image.path);
+            return;
+        }
+
+        try
+        {
+            Texture2D texture(static_cast<GLsizei>(reload.image.width),
+                              static_cast<GLsizei>(reload.image.height),
+                              reinterpret_cast<const void *>(reload.image.pixels.get()),
+                              formatForChannels(reload.image.numChannels));
+            // The old texture is deleted when texture goes out of scope
+            (*m_Textures2D.find(reload.name))->swap(texture);
+            spdlog::info("Reloaded 2D texture \"{}\"", reload.name);
+        }
+        catch (std::exception &e)
+        {
+            spdlog::warn("Unable to reload 2D texture \"{}\", keeping the old one", reload.name);
+        }
+    }
+
+    void ResourceManager::finishStaticMeshReload(StaticMeshLoad &load)
+    {
+        if (!load.error.empty())
+        {
+            spdlog::error("Unable to reload static mesh \"{}\", keeping the old one: {}", load.name, load.error);
+            return;
+        }
+
+        // Textures that were already loaded have not been uploaded again
+        m_Textures2D.forEach([&](const std::string &textureName, const std::shared_ptr<Texture2D> &texture)
+                             { load.uploadedTextures.emplace(textureName, texture); });
+
+        // Materials are updated in place, instances keep pointing to the same objects
+        for (const auto &importedMaterial : load.imported.materials)
+        {
+            const auto *oldMaterial = m_Materials.find(importedMaterial.name);
+            if (oldMaterial == nullptr)
+            {
+                // Submeshes keep the materials they were loaded with, only a new load uses it
+                spdlog::warn("Reloaded static mesh \"{}\" has a new material \"{}\" that is not shown", load.name, importedMaterial.name);
+                createImportedMaterial(importedMaterial, load.uploadedTextures);
+                continue;
+            }
+            auto oldStandard = std::dynamic_pointer_cast<StandardMaterial>(*oldMaterial);
+            if (!oldStandard)
+            {
+                spdlog::warn("Material \"{}\" is not a Standard material and is not reloaded", importedMaterial.name);
+                continue;
+            }
+            oldStandard->updateFrom(*makeImportedMaterial(importedMaterial, load.uploadedTextures));
+        }
+
+        size_t swapped = 0;
+        for (size_t i = 0; i < load.meshes.size(); i++)
+        {
+            std::string submeshName = load.name + '.' + load.imported.submeshes[i].name;
+            const auto *oldMesh = m_StaticMeshes.find(submeshName);
+            if (oldMesh == nullptr)
+            {
+                // Nothing in the scene uses it yet
+                spdlog::warn("Reloaded static mesh \"{}\" has a new submesh \"{}\" that is not shown", load.name, submeshName);
+                m_StaticMeshes.add(submeshName, load.meshes[i]);
+                continue;
+            }
+            // The old data is deleted together with the load
+            (*oldMesh)->swap(*load.meshes[i]);
+            swapped++;
+        }
+
+        spdlog::info("Reloaded static mesh \"{}\" ({} of {} submeshes swapped in place)", load.name, swapped, load.meshes.size());
     }
 }
\ No newline at end of file
@@ -14,11 +14,20 @@
 
 namespace planets
 {
+    namespace
+    {
+        // Per-draw uniforms of one frame, room for over 4000 draws
+        constexpr GLsizeiptr OBJECT_UNIFORMS_PER_FRAME = 1 << 20;
+    }
+
     Scene::Scene()
     {
         spdlog::trace("Creating scene");
         // Create root node
         m_Root = std::make_shared<SpatialObject>("ROOT", nullptr);
+
+        m_FrameUniforms = std::make_unique<UniformBuffer>(sizeof(FrameBlock));
+        m_ObjectUniforms = std::make_unique<UniformRingBuffer>(OBJECT_UNIFORMS_PER_FRAME);
     }
 
     Scene::~Scene()
@@ -46,7 +55,7 @@ namespace planets
     {
     }
 
-    void Scene::draw(int viewportWidth, int viewportHeight)
+    void Scene::draw(int viewportWidth, int viewportHeight, const ResourceManager &resources)
     {
         m_ActiveCamera->setAspectRatio(static_cast<float>(viewportWidth) / static_cast<float>(viewportHeight));
         glm::mat4 viewProjection = m_ActiveCamera->getViewProjectionMatrix();
@@ -55,9 +64,20 @@ namespace planets
             viewProjection,
             m_ActiveCamera->getGlobalPosition(),
             -m_ActiveCamera->getGlobalRotation()[2],
-            static_cast<float>(glfwGetTime())
+            static_cast<float>(glfwGetTime()),
+            0.5f * static_cast<float>(viewportHeight) * m_ActiveCamera->getProjectionMatrix()[1][1],
+            lodBias,
+            *m_ObjectUniforms,
+            resources
         };
 
+        FrameBlock frame{};
+        frame.viewProjection = viewProjection;
+        frame.cameraWorldPosition = drawInput.cameraPosition;
+        frame.time = drawInput.time;
+        frame.cameraDirection = drawInput.cameraDirection;
+        m_FrameUniforms->update(&frame, sizeof(frame));
+
         glClearColor(0.f, 0.f, 0.f, 1.f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
         glViewport(0, 0, viewportWidth, viewportHeight);
@@ -65,8 +85,14 @@ namespace planets
         glEnable(GL_CULL_FACE);
 
         drawStats.reset();
+        // Uploads and the UI may have changed the bindings since the last frame
+        Material::resetBindings();
+        m_FrameUniforms->bind(FRAME_BLOCK_BINDING);
+        m_ObjectUniforms->beginFrame();
 
         // Recursively draw the tree (DFS)
         m_Root->draw(drawInput, drawStats);
+
+        m_ObjectUniforms->endFrame();
     }
 }
\ No newline at end of file
@@ -0,0 +1,186 @@
+#include "ShaderPreprocessor.hpp"
+#include "Hash.hpp"
+#include "Material.hpp"
+#include "LightSource.hpp"
+#include "StaticMesh.hpp"
+#include "UniformBuffer.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <stdexcept>
+
+namespace planets
+{
+    namespace
+    {
+        bool startsWithDirective(const std::string &line, const char *directive, size_t &end)
+        {
+            size_t start = line.find_first_not_of(" \t");
+            size_t length = std::char_traits<char>::length(directive);
+            if (start == std::string::npos || line.compare(start, length, directive) != 0)
+            {
+                return false;
+            }
+            end = start + length;
+            return true;
+        }
+    }
+
+    ShaderPreprocessor::ShaderPreprocessor(std::shared_ptr<VirtualFileSystem> vfs, const std::string &includeDirectory)
+        : m_Vfs(std::move(vfs)), m_IncludeDirectory(includeDirectory)
+    {
+    }
+
+    void ShaderPreprocessor::setDefine(const std::string &name, const std::string &value)
+    {
+        auto it = std::find_if(m_Defines.begin(), m_Defines.end(), [&](const auto &define)
+                               { return define.first == name; });
+        if (it != m_Defines.end())
+        {
+            it->second = value;
+        }
+        else
+        {
+            m_Defines.emplace_back(name, value);
+        }
+    }
+
+    void ShaderPreprocessor::setEngineDefines()
+    {
+        setDefine("HAS_DIFFUSE_MAP", StandardMaterial::HAS_DIFFUSE_MAP);
+        setDefine("HAS_ROUGHNESS_MAP", StandardMaterial::HAS_ROUGHNESS_MAP);
+        setDefine("HAS_NORMAL_MAP", StandardMaterial::HAS_NORMAL_MAP);
+        setDefine("HAS_METALNESS_MAP", StandardMaterial::HAS_METALNESS_MAP);
+        setDefine("HAS_EMISSION_MAP", StandardMaterial::HAS_EMISSION_MAP);
+        setDefine("HAS_AO_MAP", StandardMaterial::HAS_AO_MAP);
+        setDefine("ARRAY_MAP_SHIFT", StandardMaterial::ARRAY_MAP_SHIFT);
+
+        setDefine("MAX_LIGHTS", LightSource::MAX_LIGHTS);
+
+        // ShaderProgram binds the blocks by name, these are for shaders binding them in the layout
+        setDefine("FRAME_BLOCK_BINDING", FRAME_BLOCK_BINDING);
+        setDefine("MATERIAL_BLOCK_BINDING", MATERIAL_BLOCK_BINDING);
+        setDefine("OBJECT_BLOCK_BINDING", OBJECT_BLOCK_BINDING);
+
+        setDefine("VERTEX_FORMAT_FLOAT", static_cast<long long>(StaticMesh::VertexFormat::Float));
+        setDefine("VERTEX_FORMAT_PACKED", static_cast<long long>(StaticMesh::VertexFormat::Packed));
+    }
+
+    PreprocessedShader ShaderPreprocessor::process(const std::string &path, const Defines &extraDefines) const
+    {
+        PreprocessedShader shader;
+        shader.dependencies.push_back(path);
+        std::string text = readFile(path);
+
+        // #version must stay the first line, the engine defines go right after it
+        size_t bodyStart = 0;
+        size_t firstLine = 1;
+        size_t directiveEnd;
+        if (startsWithDirective(text.substr(0, text.find('\n')), "#version", directiveEnd))
+        {
+            size_t lineEnd = text.find('\n');
+            bodyStart = lineEnd != std::string::npos ? lineEnd + 1 : text.size();
+            firstLine = 2;
+            shader.source = text.substr(0, bodyStart);
+            if (shader.source.back() != '\n')
+            {
+                shader.source += '\n';
+            }
+        }
+        for (const Defines *defines : {&m_Defines, &extraDefines})
+        {
+            for (const auto &[name, value] : *defines)
+            {
+                shader.source += "#define " + name + ' ' + value + '\n';
+            }
+        }
+        shader.source += "#line " + std::to_string(firstLine) + " 0\n";
+
+        std::vector<std::string> includeStack{path};
+        expand(text.substr(bodyStart), firstLine, 0, shader, includeStack);
+
+        shader.hash = hashBytes(shader.source.data(), shader.source.size());
+        spdlog::trace("Preprocessed shader \"{}\" with {} included files, hash {:016x}",
+                      path, shader.dependencies.size() - 1, shader.hash);
+        return shader;
+    }
+
+    std::string ShaderPreprocessor::readFile(const std::string &path) const
+    {
+        if (!m_Vfs->exists(path))
+        {
+            spdlog::error("Unable to open shader source file at \"{}\"", m_Vfs->getLoosePath(path));
+            throw std::runtime_error("Unable to open shader source file");
+        }
+        VfsFile file = m_Vfs->open(path);
+        return std::string(reinterpret_cast<const char *>(file.data()), file.size());
+    }
+
+    void ShaderPreprocessor::expand(const std::string &text, size_t firstLine, size_t fileIndex, PreprocessedShader &shader,
+                                    std::vector<std::string> &includeStack) const
+    {
+        // A copy, includes grow dependencies
+        const std::string path = shader.dependencies[fileIndex];
+        size_t lineNumber = firstLine;
+        size_t lineStart = 0;
+        while (lineStart < text.size())
+        {
+            size_t lineEnd = text.find('\n', lineStart);
+            if (lineEnd == std::string::npos)
+            {
+                lineEnd = text.size();
+            }
+            std::string line = text.substr(lineStart, lineEnd - lineStart);
+            lineStart = lineEnd + 1;
+
+            size_t directiveEnd;
+            if (startsWithDirective(line, "#version", directiveEnd))
+            {
+                spdlog::error("\"{}\" line {}: #version is only allowed in the first line of a shader", path, lineNumber);
+                throw std::runtime_error("Misplaced #version");
+            }
+            if (!startsWithDirective(line, "#include", directiveEnd))
+            {
+                shader.source += line;
+                shader.source += '\n';
+                lineNumber++;
+                continue;
+            }
+
+            size_t nameStart = line.find('"', directiveEnd);
+            size_t nameEnd = nameStart != std::string::npos ? line.find('"', nameStart + 1) : std::string::npos;
+            if (nameEnd == std::string::npos || nameEnd == nameStart + 1)
+            {
+                spdlog::error("\"{}\" line {}: expected #include \"file\"", path, lineNumber);
+                throw std::runtime_error("Malformed #include");
+            }
+            std::string includePath = std::filesystem::path(m_IncludeDirectory + '/' + line.substr(nameStart + 1, nameEnd - nameStart - 1))
+                                          .lexically_normal()
+                                          .generic_string();
+
+            if (std::find(includeStack.begin(), includeStack.end(), includePath) != includeStack.end())
+            {
+                spdlog::error("\"{}\" line {}: \"{}\" includes itself", path, lineNumber, includePath);
+                throw std::runtime_error("Recursive #include");
+            }
+            if (std::find(shader.dependencies.begin(), shader.dependencies.end(), includePath) != shader.dependencies.end())
+            {
+                // Already in the shader, keeps the line count
+                shader.source += '\n';
+                lineNumber++;
+                continue;
+            }
+
+            shader.dependencies.push_back(includePath);
+            size_t includeIndex = shader.dependencies.size() - 1;
+            shader.source += "#line 1 " + std::to_string(includeIndex) + '\n';
+            includeStack.push_back(includePath);
+            expand(readFile(includePath), 1, includeIndex, shader, includeStack);
+            includeStack.pop_back();
+            lineNumber++;
+            shader.source += "#line " + std::to_string(lineNumber) + ' ' + std::to_string(fileIndex) + '\n';
+        }
+    }
+}
@@ -1,4 +1,6 @@
 #include "ShaderProgram.hpp"
+#include "UniformBuffer.hpp"
+#include "Hash.hpp"
 
 #include <spdlog/spdlog.h>
 
@@ -7,132 +9,434 @@
 
 #include <string>
 #include <stdexcept>
+#include <utility>
+#include <algorithm>
+#include <fstream>
+#include <filesystem>
 
 namespace planets
 {
+    namespace
+    {
+        // Only programs are created on the thread owning the GL context, 0 is never used
+        uint32_t nextLinkId = 1;
+
+        std::string binaryCacheDirectory;
+        ShaderProgram::SetupStats setupStats;
+
+        // GL_KHR_parallel_shader_compile is not in the generated loader
+        constexpr GLenum GL_MAX_SHADER_COMPILER_THREADS_KHR = 0x91B0;
+        constexpr GLenum GL_COMPLETION_STATUS_KHR = 0x91B1;
+        using MaxShaderCompilerThreadsFunction = void (*)(GLuint count);
+
+        enum class ParallelCompile
+        {
+            Unknown,
+            Available,
+            Unavailable
+        };
+        ParallelCompile parallelCompile = ParallelCompile::Unknown;
+
+        void initParallelCompile()
+        {
+            parallelCompile = ParallelCompile::Unavailable;
+            // The ARB extension has the same enums, its function only differs in the suffix
+            const char *function = nullptr;
+            if (glfwExtensionSupported("GL_KHR_parallel_shader_compile"))
+            {
+                function = "glMaxShaderCompilerThreadsKHR";
+            }
+            else if (glfwExtensionSupported("GL_ARB_parallel_shader_compile"))
+            {
+                function = "glMaxShaderCompilerThreadsARB";
+            }
+            if (function == nullptr)
+            {
+                spdlog::trace("Parallel shader compilation is not supported, link status is checked when polled");
+                return;
+            }
+
+            auto maxShaderCompilerThreads = reinterpret_cast<MaxShaderCompilerThreadsFunction>(glfwGetProcAddress(function));
+            if (maxShaderCompilerThreads != nullptr)
+            {
+                // As many threads as the driver likes
+                maxShaderCompilerThreads(0xFFFFFFFF);
+            }
+            GLint threads{0};
+            glGetIntegerv(GL_MAX_SHADER_COMPILER_THREADS_KHR, &threads);
+            parallelCompile = ParallelCompile::Available;
+            spdlog::trace("Parallel shader compilation is supported, up to {} compiler threads", threads);
+        }
+
+        struct BinaryHeader
+        {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t format; // GLenum from glGetProgramBinary
+            uint32_t length;
+        };
+
+        std::string glString(GLenum name)
+        {
+            const GLubyte *value = glGetString(name);
+            return value != nullptr ? reinterpret_cast<const char *>(value) : "";
+        }
+
+        /*
+        Empty if the cache is disabled. Binaries only work with the driver that produced them,
+        so it is part of the key.
+        */
+        std::string binaryCachePath(const std::string &vertexSource, const std::string &fragmentSource)
+        {
+            if (binaryCacheDirectory.empty())
+            {
+                return "";
+            }
+            uint64_t hash = FNV1A_64_OFFSET_BASIS;
+            for (const std::string &part : {vertexSource, fragmentSource, glString(GL_VENDOR), glString(GL_RENDERER), glString(GL_VERSION)})
+            {
+                // The length keeps the boundaries between the parts from moving unnoticed
+                uint64_t length = part.size();
+                hash = hashBytes(&length, sizeof(length), hash);
+                hash = hashBytes(part.data(), part.size(), hash);
+            }
+            return fmt::format("{}/{:016x}.progbin", binaryCacheDirectory, hash);
+        }
+    }
 
     ShaderProgram::ShaderProgram(const std::string &vertexSource, const std::string &fragmentSource)
+        : ShaderProgram(vertexSource, fragmentSource, CompileMode::Blocking)
+    {
+    }
+
+    ShaderProgram::ShaderProgram(const std::string &vertexSource, const std::string &fragmentSource, CompileMode mode)
     {
-        // TODO: Insert builtins
+        double start = glfwGetTime();
+
+        std::string cachePath = binaryCachePath(vertexSource, fragmentSource);
+        if (!cachePath.empty() && loadBinary(cachePath))
+        {
+            finishSetup(start, true);
+            return;
+        }
 
         spdlog::trace("Creating a shader program from source");
-        spdlog::trace("Creating shader objects");
-        GLuint vertexShaderId{glCreateShader(GL_VERTEX_SHADER)};
-        GLuint fragmentShaderId{glCreateShader(GL_FRAGMENT_SHADER)};
+        m_Pending = std::make_unique<PendingLink>(submit(vertexSource, fragmentSource, !cachePath.empty()));
+        m_Pending->cachePath = cachePath;
+        m_Pending->submitMs = (glfwGetTime() - start) * 1000.0;
+        m_ProgramId = m_Pending->programId;
+
+        if (mode == CompileMode::Blocking)
+        {
+            try
+            {
+                finishLink();
+            }
+            catch (std::exception &e)
+            {
+                // The destructor does not run for a constructor that throws
+                glDeleteProgram(m_ProgramId);
+                throw;
+            }
+        }
+    }
 
-        if (vertexShaderId == 0)
+    ShaderProgram::PendingLink ShaderProgram::submit(const std::string &vertexSource, const std::string &fragmentSource, bool retrievable)
+    {
+        // Once per context, lets the driver compile on its own threads if it can
+        if (parallelCompile == ParallelCompile::Unknown)
         {
-            glDeleteShader(vertexShaderId);
-            glDeleteShader(fragmentShaderId);
-            spdlog::error("Error creating vertex shader");
-            throw std::runtime_error("Error creating vertex shader");
+            initParallelCompile();
         }
-        if (fragmentShaderId == 0)
+
+        PendingLink pending;
+        pending.vertexShaderId = glCreateShader(GL_VERTEX_SHADER);
+        pending.fragmentShaderId = glCreateShader(GL_FRAGMENT_SHADER);
+        pending.programId = glCreateProgram();
+        if (pending.vertexShaderId == 0 || pending.fragmentShaderId == 0 || pending.programId == 0)
         {
-            glDeleteShader(vertexShaderId);
-            glDeleteShader(fragmentShaderId);
-            spdlog::error("Error creating fragment shader");
-            throw std::runtime_error("Error creating fragment shader");
+            glDeleteShader(pending.vertexShaderId);
+            glDeleteShader(pending.fragmentShaderId);
+            glDeleteProgram(pending.programId);
+            spdlog::error("Error creating shader objects");
+            throw std::runtime_error("Error creating shader objects");
         }
 
+        // No status is queried here, that would wait for the driver
         const char *vertexSourcePtr = vertexSource.c_str();
-        glShaderSource(vertexShaderId, 1, &vertexSourcePtr, NULL);
-        spdlog::trace("Compiling vertex shader");
-        glCompileShader(vertexShaderId);
+        glShaderSource(pending.vertexShaderId, 1, &vertexSourcePtr, NULL);
+        glCompileShader(pending.vertexShaderId);
+        const char *fragmentSourcePtr = fragmentSource.c_str();
+        glShaderSource(pending.fragmentShaderId, 1, &fragmentSourcePtr, NULL);
+        glCompileShader(pending.fragmentShaderId);
 
-        GLint compileStatus{GL_FALSE};
-        GLint infoLogLength{0};
+        if (retrievable)
+        {
+            glProgramParameteri(pending.programId, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        }
+        glAttachShader(pending.programId, pending.vertexShaderId);
+        glAttachShader(pending.programId, pending.fragmentShaderId);
+        glLinkProgram(pending.programId);
+        return pending;
+    }
 
-        glGetShaderiv(vertexShaderId, GL_COMPILE_STATUS, &compileStatus);
-        glGetShaderiv(vertexShaderId, GL_INFO_LOG_LENGTH, &infoLogLength);
+    void ShaderProgram::finishLink()
+    {
+        // Submitting counts as setup time, compiling in the background while frames are drawn does not
+        std::unique_ptr<PendingLink> pending = std::move(m_Pending);
+        double start = glfwGetTime() - pending->submitMs / 1000.0;
+        auto deleteObjects = [&]()
+        {
+            glDetachShader(pending->programId, pending->vertexShaderId);
+            glDetachShader(pending->programId, pending->fragmentShaderId);
+            glDeleteShader(pending->vertexShaderId);
+            glDeleteShader(pending->fragmentShaderId);
+        };
+
+        const std::pair<GLuint, const char *> shaders[] = {{pending->vertexShaderId, "vertex"},
+                                                           {pending->fragmentShaderId, "fragment"}};
+        for (const auto &[shaderId, stage] : shaders)
+        {
+            GLint compileStatus{GL_FALSE};
+            GLint infoLogLength{0};
+            glGetShaderiv(shaderId, GL_COMPILE_STATUS, &compileStatus);
+            glGetShaderiv(shaderId, GL_INFO_LOG_LENGTH, &infoLogLength);
+            if (compileStatus == GL_FALSE)
+            {
+                spdlog::error("Error compiling {} shader", stage);
+                std::vector<char> infoLog(infoLogLength + 1);
+                glGetShaderInfoLog(shaderId, infoLogLength, NULL, &infoLog[0]);
+                spdlog::error("[GLSL]: {}", &infoLog[0]);
+                deleteObjects();
+                throw std::runtime_error(std::string("Error compiling ") + stage + " shader");
+            }
+        }
+        spdlog::trace("Successfully compiled shaders");
 
-        if (compileStatus == GL_FALSE)
+        GLint linkStatus{GL_FALSE};
+        GLint infoLogLength{0};
+        glGetProgramiv(pending->programId, GL_LINK_STATUS, &linkStatus);
+        glGetProgramiv(pending->programId, GL_INFO_LOG_LENGTH, &infoLogLength);
+        if (linkStatus == GL_FALSE)
         {
-            spdlog::error("Error compiling vertex shader");
+            spdlog::error("Error linking program");
             std::vector<char> infoLog(infoLogLength + 1);
-            glGetShaderInfoLog(vertexShaderId, infoLogLength, NULL, &infoLog[0]);
+            glGetProgramInfoLog(pending->programId, infoLogLength, NULL, &infoLog[0]);
             spdlog::error("[GLSL]: {}", &infoLog[0]);
-            glDeleteShader(vertexShaderId);
-            glDeleteShader(fragmentShaderId);
-            throw std::runtime_error("Error compiling vertex shader");
+            deleteObjects();
+            throw std::runtime_error("Error linking program");
         }
-        spdlog::trace("Successfully compiled vertex shader");
+        spdlog::trace("Successfully linked program");
+        deleteObjects();
 
-        compileStatus = GL_FALSE;
-        infoLogLength = 0;
+        if (!pending->cachePath.empty())
+        {
+            saveBinary(pending->cachePath);
+        }
+        finishSetup(start, false);
+    }
 
-        const char *fragmentSourcePtr = fragmentSource.c_str();
-        glShaderSource(fragmentShaderId, 1, &fragmentSourcePtr, NULL);
-        spdlog::trace("Compiling fragment shader");
-        glCompileShader(fragmentShaderId);
+    void ShaderProgram::finishSetup(double start, bool cached)
+    {
+        m_LinkId = nextLinkId++;
 
-        glGetShaderiv(fragmentShaderId, GL_COMPILE_STATUS, &compileStatus);
-        glGetShaderiv(fragmentShaderId, GL_INFO_LOG_LENGTH, &infoLogLength);
+        getUniformLocations();
+        bindUniformBlocks();
 
-        if (compileStatus == GL_FALSE)
+        double milliseconds = (glfwGetTime() - start) * 1000.0;
+        setupStats.programs++;
+        setupStats.fromCache += cached ? 1 : 0;
+        setupStats.milliseconds += milliseconds;
+        spdlog::trace("Set up shader program {} in {:.2f} ms from {}", m_ProgramId, milliseconds, cached ? "the binary cache" : "source");
+    }
+
+    bool ShaderProgram::poll()
+    {
+        if (!m_Pending)
         {
-            spdlog::error("Error compiling fragment shader");
-            std::vector<char> infoLog(infoLogLength + 1);
-            glGetShaderInfoLog(fragmentShaderId, infoLogLength, NULL, &infoLog[0]);
-            spdlog::error("[GLSL]: {}", &infoLog[0]);
-            glDeleteShader(vertexShaderId);
-            glDeleteShader(fragmentShaderId);
-            throw std::runtime_error("Error compiling fragment shader");
+            return true;
+        }
+        // Without the extension the status queries below wait for the driver. Programs were
+        // still all submitted before the first wait, which drivers compiling in the background
+        // make use of as well.
+        if (parallelCompile == ParallelCompile::Available)
+        {
+            GLint completed{GL_FALSE};
+            glGetProgramiv(m_ProgramId, GL_COMPLETION_STATUS_KHR, &completed);
+            if (completed == GL_FALSE)
+            {
+                return false;
+            }
         }
-        spdlog::trace("Successfully compiled fragment shader");
 
-        spdlog::trace("Creating program");
-        GLuint programId{glCreateProgram()};
-        if (programId == 0)
+        try
+        {
+            finishLink();
+        }
+        catch (std::exception &e)
+        {
+            m_Failed = true;
+        }
+        return true;
+    }
+
+    void ShaderProgram::setBinaryCacheDirectory(const std::string &directory)
+    {
+        binaryCacheDirectory.clear();
+        if (directory.empty())
+        {
+            return;
+        }
+
+        GLint numFormats{0};
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+        if (numFormats == 0)
         {
-            spdlog::error("Error creating program");
-            glDeleteShader(vertexShaderId);
-            glDeleteShader(fragmentShaderId);
-            throw std::runtime_error("Error creating program");
+            spdlog::warn("The driver offers no program binary formats, shaders will always be compiled from source");
+            return;
         }
 
-        spdlog::trace("Linking program");
-        glAttachShader(programId, vertexShaderId);
-        glAttachShader(programId, fragmentShaderId);
-        glLinkProgram(programId);
+        std::error_code ec;
+        std::filesystem::create_directories(directory, ec);
+        if (ec)
+        {
+            spdlog::warn("Unable to create the shader cache directory \"{}\", shaders will always be compiled from source", directory);
+            return;
+        }
+        binaryCacheDirectory = directory;
+        spdlog::trace("Caching program binaries in \"{}\"", directory);
+    }
 
+    ShaderProgram::SetupStats ShaderProgram::getSetupStats()
+    {
+        return setupStats;
+    }
+
+    bool ShaderProgram::loadBinary(const std::string &cachePath)
+    {
+        std::ifstream stream(cachePath, std::ios::in | std::ios::binary);
+        if (!stream.is_open())
+        {
+            return false;
+        }
+
+        BinaryHeader header{};
+        stream.read(reinterpret_cast<char *>(&header), sizeof(header));
+        if (!stream || header.magic != BINARY_MAGIC || header.version != BINARY_VERSION)
+        {
+            spdlog::info("Program binary \"{}\" is unreadable or has an incompatible version and will be rebuilt", cachePath);
+            return false;
+        }
+        std::vector<char> binary(header.length);
+        stream.read(binary.data(), static_cast<std::streamsize>(binary.size()));
+        if (!stream)
+        {
+            spdlog::info("Program binary \"{}\" is truncated and will be rebuilt", cachePath);
+            return false;
+        }
+
+        GLuint programId{glCreateProgram()};
+        glProgramBinary(programId, header.format, binary.data(), static_cast<GLsizei>(binary.size()));
         GLint linkStatus{GL_FALSE};
-        infoLogLength = 0;
         glGetProgramiv(programId, GL_LINK_STATUS, &linkStatus);
-        glGetProgramiv(programId, GL_INFO_LOG_LENGTH, &infoLogLength);
-
         if (linkStatus == GL_FALSE)
         {
-            spdlog::error("Error linking program");
-            std::vector<char> infoLog(infoLogLength + 1);
-            glGetProgramInfoLog(programId, infoLogLength, NULL, &infoLog[0]);
-            spdlog::error("[GLSL]: {}", &infoLog[0]);
-            glDetachShader(programId, vertexShaderId);
-            glDetachShader(programId, fragmentShaderId);
-            glDeleteShader(vertexShaderId);
-            glDeleteShader(fragmentShaderId);
+            // Drivers may reject binaries of their own, e.g. after an update that kept the version string
+            spdlog::info("Program binary \"{}\" was rejected by the driver and will be rebuilt", cachePath);
             glDeleteProgram(programId);
-            throw std::runtime_error("Error linking program");
+            return false;
         }
-        spdlog::trace("Successfully linked program");
-
-        glDetachShader(programId, vertexShaderId);
-        glDetachShader(programId, fragmentShaderId);
-
-        glDeleteShader(vertexShaderId);
-        glDeleteShader(fragmentShaderId);
 
         m_ProgramId = programId;
+        return true;
+    }
 
-        getUniformLocations();
+    bool ShaderProgram::saveBinary(const std::string &cachePath) const
+    {
+        GLint length{0};
+        glGetProgramiv(m_ProgramId, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0)
+        {
+            spdlog::warn("The driver returned no binary for shader program {}", m_ProgramId);
+            return false;
+        }
+        std::vector<char> binary(static_cast<size_t>(length));
+        GLenum format{0};
+        glGetProgramBinary(m_ProgramId, length, &length, &format, binary.data());
+
+        // Write to a temporary file first so that an interrupted write never leaves a broken binary
+        std::string tempPath = cachePath + ".tmp";
+        try
+        {
+            std::ofstream stream(tempPath, std::ios::out | std::ios::binary | std::ios::trunc);
+            if (!stream.is_open())
+            {
+                spdlog::warn("Unable to create program binary \"{}\"", cachePath);
+                return false;
+            }
+            BinaryHeader header{BINARY_MAGIC, BINARY_VERSION, format, static_cast<uint32_t>(length)};
+            stream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            stream.write(binary.data(), length);
+            stream.close();
+            if (stream.fail())
+            {
+                throw std::runtime_error("Write failed");
+            }
+            std::filesystem::rename(tempPath, cachePath);
+        }
+        catch (std::exception &e)
+        {
+            spdlog::warn("Unable to write program binary \"{}\": {}", cachePath, e.what());
+            std::error_code ec;
+            std::filesystem::remove(tempPath, ec);
+            return false;
+        }
+        spdlog::trace("Wrote program binary \"{}\" ({} bytes)", cachePath, length);
+        return true;
     }
 
     ShaderProgram::~ShaderProgram()
     {
         spdlog::trace("Deleting a shader program");
+        if (m_Pending)
+        {
+            glDeleteShader(m_Pending->vertexShaderId);
+            glDeleteShader(m_Pending->fragmentShaderId);
+        }
         glDeleteProgram(m_ProgramId);
     }
 
+    void ShaderProgram::swap(ShaderProgram &other) noexcept
+    {
+        std::swap(m_ProgramId, other.m_ProgramId);
+        std::swap(m_LinkId, other.m_LinkId);
+        std::swap(m_UniformLocations, other.m_UniformLocations);
+        std::swap(m_Pending, other.m_Pending);
+        std::swap(m_Failed, other.m_Failed);
+    }
+
+    size_t ShaderProgram::getCpuSizeInBytes() const
+    {
+        size_t size = sizeof(ShaderProgram);
+        for (const auto &[name, location] : m_UniformLocations)
+        {
+            size += sizeof(std::pair<const std::string, GLint>) + name.capacity();
+        }
+        return size;
+    }
+
+    size_t ShaderProgram::getGpuSizeInBytes() const
+    {
+        // The query would wait for the link
+        if (!isReady())
+        {
+            return 0;
+        }
+        GLint binaryLength{0};
+        glGetProgramiv(m_ProgramId, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+        return static_cast<size_t>(std::max(binaryLength, 0));
+    }
+
     void ShaderProgram::use() const noexcept
     {
         glUseProgram(m_ProgramId);
@@ -160,51 +464,105 @@ namespace planets
         }
     }
 
+    UniformHandle ShaderProgram::getUniform(const char *name) const
+    {
+        auto it = m_UniformLocations.find(name);
+        return it != m_UniformLocations.end() ? UniformHandle{it->second} : UniformHandle{};
+    }
+
+    void ShaderProgram::bindUniformBlocks()
+    {
+        const std::pair<const char *, GLuint> blocks[] = {{"FrameData", FRAME_BLOCK_BINDING},
+                                                          {"MaterialData", MATERIAL_BLOCK_BINDING},
+                                                          {"ObjectData", OBJECT_BLOCK_BINDING}};
+        for (const auto &[name, binding] : blocks)
+        {
+            GLuint index = glGetUniformBlockIndex(m_ProgramId, name);
+            if (index != GL_INVALID_INDEX)
+            {
+                glUniformBlockBinding(m_ProgramId, index, binding);
+                spdlog::trace("Uniform block \"{}\" is bound to {}", name, binding);
+            }
+        }
+    }
+
     void ShaderProgram::setMatrix4f(const char *name, const glm::mat4 &matrix)
     {
-        if (uniformExists(name))
-            glUniformMatrix4fv(m_UniformLocations[name], 1, GL_FALSE, &matrix[0][0]);
+        setMatrix4f(getUniform(name), matrix);
     }
 
     void ShaderProgram::setMatrix3f(const char *name, const glm::mat3 &matrix)
     {
-        if (uniformExists(name))
-            glUniformMatrix3fv(m_UniformLocations[name], 1, GL_FALSE, &matrix[0][0]);
+        setMatrix3f(getUniform(name), matrix);
     }
 
     void ShaderProgram::setMatrix2f(const char *name, const glm::mat2 &matrix)
     {
-        if (uniformExists(name))
-            glUniformMatrix2fv(m_UniformLocations[name], 1, GL_FALSE, &matrix[0][0]);
+        setMatrix2f(getUniform(name), matrix);
     }
 
     void ShaderProgram::setVector4f(const char *name, const glm::vec4 &vector)
     {
-        if (uniformExists(name))
-            glUniform4fv(m_UniformLocations[name], 1, &vector[0]);
+        setVector4f(getUniform(name), vector);
     }
 
     void ShaderProgram::setVector3f(const char *name, const glm::vec3 &vector)
     {
-        if (uniformExists(name))
-            glUniform3fv(m_UniformLocations[name], 1, &vector[0]);
+        setVector3f(getUniform(name), vector);
     }
 
     void ShaderProgram::setVector2f(const char *name, const glm::vec2 &vector)
     {
-        if (uniformExists(name))
-            glUniform2fv(m_UniformLocations[name], 1, &vector[0]);
+        setVector2f(getUniform(name), vector);
     }
 
     void ShaderProgram::setFloat(const char *name, GLfloat value)
     {
-        if (uniformExists(name))
-            glUniform1f(m_UniformLocations[name], value);
+        setFloat(getUniform(name), value);
     }
 
     void ShaderProgram::setInt(const char *name, GLint value)
     {
-        if (uniformExists(name))
-            glUniform1i(m_UniformLocations[name], value);
+        setInt(getUniform(name), value);
+    }
+
+    void ShaderProgram::setMatrix4f(UniformHandle uniform, const glm::mat4 &matrix) const noexcept
+    {
+        glUniformMatrix4fv(uniform.location, 1, GL_FALSE, &matrix[0][0]);
+    }
+
+    void ShaderProgram::setMatrix3f(UniformHandle uniform, const glm::mat3 &matrix) const noexcept
+    {
+        glUniformMatrix3fv(uniform.location, 1, GL_FALSE, &matrix[0][0]);
+    }
+
+    void ShaderProgram::setMatrix2f(UniformHandle uniform, const glm::mat2 &matrix) const noexcept
+    {
+        glUniformMatrix2fv(uniform.location, 1, GL_FALSE, &matrix[0][0]);
+    }
+
+    void ShaderProgram::setVector4f(UniformHandle uniform, const glm::vec4 &vector) const noexcept
+    {
+        glUniform4fv(uniform.location, 1, &vector[0]);
+    }
+
+    void ShaderProgram::setVector3f(UniformHandle uniform, const glm::vec3 &vector) const noexcept
+    {
+        glUniform3fv(uniform.location, 1, &vector[0]);
+    }
+
+    void ShaderProgram::setVector2f(UniformHandle uniform, const glm::vec2 &vector) const noexcept
+    {
+        glUniform2fv(uniform.location, 1, &vector[0]);
+    }
+
+    void ShaderProgram::setFloat(UniformHandle uniform, GLfloat value) const noexcept
+    {
+        glUniform1f(uniform.location, value);
+    }
+
+    void ShaderProgram::setInt(UniformHandle uniform, GLint value) const noexcept
+    {
+        glUniform1i(uniform.location, value);
     }
 }
\ No newline at end of file
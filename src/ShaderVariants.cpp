@@ -0,0 +1,108 @@
+#include "ShaderVariants.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <stdexcept>
+#include <utility>
+
+namespace planets
+{
+    ShaderVariants::ShaderVariants(std::shared_ptr<ShaderProgram> fallback,
+                                   std::shared_ptr<const ShaderPreprocessor> preprocessor,
+                                   const std::string &vertexSourcePath,
+                                   const std::string &fragmentSourcePath,
+                                   const std::string &defineName,
+                                   ShaderProgram::CompileMode mode)
+        : m_Fallback(std::move(fallback)),
+          m_Preprocessor(std::move(preprocessor)),
+          m_VertexSourcePath(vertexSourcePath),
+          m_FragmentSourcePath(fragmentSourcePath),
+          m_DefineName(defineName),
+          m_Mode(mode)
+    {
+    }
+
+    std::shared_ptr<ShaderProgram> ShaderVariants::get(GLint mask)
+    {
+        auto it = m_Variants.find(mask);
+        if (it != m_Variants.end())
+        {
+            return it->second;
+        }
+
+        std::shared_ptr<ShaderProgram> program;
+        try
+        {
+            program = compile(definesFor(mask), m_Mode);
+            spdlog::trace("Created variant {} = {:#x}, {} variants in total", m_DefineName, mask, m_Variants.size() + 1);
+        }
+        catch (std::exception &e)
+        {
+            // Remembered as well, the sources are not going to compile any better on the next request
+            spdlog::warn("Variant {} = {:#x} could not be compiled, using the unspecialized program", m_DefineName, mask);
+            program = m_Fallback;
+        }
+        m_Variants.emplace(mask, program);
+        return program;
+    }
+
+    size_t ShaderVariants::poll()
+    {
+        size_t compiling = 0;
+        for (auto &[mask, program] : m_Variants)
+        {
+            // Only variants still compiling, the fallback is polled by its owner
+            if (program == m_Fallback || program->isReady() || program->hasFailed())
+            {
+                continue;
+            }
+            if (!program->poll())
+            {
+                compiling++;
+                continue;
+            }
+            if (program->hasFailed())
+            {
+                spdlog::warn("Variant {} = {:#x} could not be compiled, using the unspecialized program", m_DefineName, mask);
+                try
+                {
+                    program->swap(*compile({}, ShaderProgram::CompileMode::Blocking));
+                }
+                catch (std::exception &e)
+                {
+                    // Materials of this variant draw with the fallback of Material until a reload fixes the sources
+                }
+            }
+        }
+        return compiling;
+    }
+
+    void ShaderVariants::reload()
+    {
+        for (auto &[mask, program] : m_Variants)
+        {
+            // The fallback is reloaded by its owner
+            if (program == m_Fallback)
+            {
+                continue;
+            }
+            try
+            {
+                // The old program is deleted together with newProgram
+                std::shared_ptr<ShaderProgram> newProgram = compile(definesFor(mask), ShaderProgram::CompileMode::Blocking);
+                program->swap(*newProgram);
+            }
+            catch (std::exception &e)
+            {
+                spdlog::warn("Variant {} = {:#x} could not be rebuilt, keeping the old one", m_DefineName, mask);
+            }
+        }
+    }
+
+    std::shared_ptr<ShaderProgram> ShaderVariants::compile(const ShaderPreprocessor::Defines &defines, ShaderProgram::CompileMode mode) const
+    {
+        return std::make_shared<ShaderProgram>(m_Preprocessor->process(m_VertexSourcePath, defines).source,
+                                               m_Preprocessor->process(m_FragmentSourcePath, defines).source,
+                                               mode);
+    }
+}
@@ -16,8 +16,9 @@
 #include <glm/gtx/euler_angles.hpp>
 
 #include <memory>
-#include <unordered_map>
+#include <vector>
 #include <string>
+#include <algorithm>
 #include <stdexcept>
 
 namespace planets
@@ -37,30 +38,36 @@ namespace planets
 
     std::shared_ptr<SpatialObject> SpatialObject::addChild(std::shared_ptr<SpatialObject> object)
     {
-        if (m_Children.find(object->m_Name) != m_Children.end())
+        if (findChild(object->m_Name) != m_Children.end())
         {
             spdlog::error("Trying to add a child object with the same name \"{}\"", object->m_Name);
             return object;
         }
-        m_Children[object->m_Name] = object;
+        m_Children.push_back(object);
         object->recalculateWorldMatrices();
         return object;
     }
 
+    std::vector<std::shared_ptr<SpatialObject>>::const_iterator SpatialObject::findChild(const std::string &name) const noexcept
+    {
+        return std::find_if(m_Children.begin(), m_Children.end(), [&](const std::shared_ptr<SpatialObject> &child)
+                            { return child->m_Name == name; });
+    }
+
     bool SpatialObject::hasChild(const std::string &name) const noexcept
     {
-        return m_Children.find(name) != m_Children.end();
+        return findChild(name) != m_Children.end();
     }
 
     std::shared_ptr<SpatialObject> SpatialObject::getChild(const std::string &name) const noexcept
     {
-        auto it = m_Children.find(name);
+        auto it = findChild(name);
         if (it == m_Children.end())
         {
             spdlog::error("Unable to get child \"{}\" of object \"{}\"", name, m_Name);
             return std::shared_ptr<SpatialObject>{nullptr};
         }
-        return it->second;
+        return *it;
     }
 
     void SpatialObject::setLocalPosition(const glm::vec3 &localPosition) noexcept
@@ -114,9 +121,9 @@ namespace planets
 
         m_WorldToLocal = glm::inverse(m_LocalToWorld);
 
-        for (auto it = m_Children.begin(); it != m_Children.end(); it++)
+        for (const auto &child : m_Children)
         {
-            it->second->recalculateWorldMatrices();
+            child->recalculateWorldMatrices();
         }
     }
 
@@ -132,9 +139,9 @@ namespace planets
     void SpatialObject::draw(const DrawInput &drawInput, DrawStats &drawStats)
     {
         // Don't draw self (since it's just an empty object) but draw children
-        for (auto it = m_Children.begin(); it != m_Children.end(); it++)
+        for (const auto &child : m_Children)
         {
-            it->second->draw(drawInput, drawStats);
+            child->draw(drawInput, drawStats);
         }
     }
 }
\ No newline at end of file
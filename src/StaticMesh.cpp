@@ -1,4 +1,5 @@
 #include "StaticMesh.hpp"
+#include "TangentGenerator.hpp"
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
@@ -7,22 +8,235 @@
 
 #include <vector>
 #include <stdexcept>
+#include <utility>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
 
 #include <spdlog/spdlog.h>
 
 namespace planets
 {
+    namespace
+    {
+        // Octahedral mapping of a unit vector to [-1, 1]^2, a zero vector maps to +Z
+        glm::vec2 octahedralEncode(const glm::vec3 &v)
+        {
+            float sum = std::fabs(v.x) + std::fabs(v.y) + std::fabs(v.z);
+            if (sum == 0.0f)
+            {
+                return glm::vec2(0.0f);
+            }
+            glm::vec2 p = glm::vec2(v.x, v.y) / sum;
+            if (v.z < 0.0f)
+            {
+                p = glm::vec2((1.0f - std::fabs(p.y)) * (p.x >= 0.0f ? 1.0f : -1.0f),
+                              (1.0f - std::fabs(p.x)) * (p.y >= 0.0f ? 1.0f : -1.0f));
+            }
+            return p;
+        }
+
+        uint16_t quantizeUnorm16(float value)
+        {
+            return static_cast<uint16_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 65535.0f));
+        }
+
+        size_t indexSizeOf(GLenum indexType)
+        {
+            switch (indexType)
+            {
+            case GL_UNSIGNED_BYTE:
+                return sizeof(uint8_t);
+            case GL_UNSIGNED_SHORT:
+                return sizeof(uint16_t);
+            default:
+                return sizeof(GLuint);
+            }
+        }
+
+        // Whether count elements of size bytes, stride apart, fit into the buffer after offset
+        bool viewFits(size_t bufferSize, size_t offset, size_t stride, size_t size, size_t count)
+        {
+            return count == 0 || (offset <= bufferSize && size <= bufferSize - offset &&
+                                  (count - 1) <= (bufferSize - offset - size) / std::max<size_t>(stride, 1));
+        }
+
+        void setAttribute(GLuint attribute, const StaticMesh::AttributeView &view)
+        {
+            if (view.components == 0)
+            {
+                glDisableVertexAttribArray(attribute);
+                return;
+            }
+            glVertexAttribPointer(attribute, view.components, view.componentType, view.normalized, view.stride,
+                                  reinterpret_cast<void *>(view.offset));
+            glEnableVertexAttribArray(attribute);
+        }
+    }
+
     StaticMesh::StaticMesh(const std::vector<glm::vec3> &vertexPositions,
                            const std::vector<glm::vec3> &vertexNormals,
                            const std::vector<glm::vec2> &vertexUVs,
-                           const std::vector<GLuint> &triangleIndices) : m_TriangleIndices(triangleIndices),
-                                                                         m_IsOnGPU(false),
-                                                                         m_VboId(0),
-                                                                         m_VaoId(0),
-                                                                         m_EboId(0)
+                           const std::vector<GLuint> &triangleIndices) : StaticMesh(buildVertices(vertexPositions,
+                                                                                                  vertexNormals,
+                                                                                                  vertexUVs,
+                                                                                                  triangleIndices),
+                                                                                    triangleIndices)
+    {
+    }
 
+    StaticMesh::StaticMesh(std::vector<StaticMesh::Vertex> vertices,
+                           std::vector<GLuint> triangleIndices,
+                           std::vector<StaticMesh::Lod> lods) : m_Vertices(std::move(vertices)),
+                                                                m_TriangleIndices(std::move(triangleIndices)),
+                                                                m_Lods(std::move(lods)),
+                                                                m_IsOnGPU(false),
+                                                                m_VboId(0),
+                                                                m_VaoId(0),
+                                                                m_EboId(0)
     {
         spdlog::trace("Creating a static mesh");
+        if (m_Vertices.size() == 0 || m_TriangleIndices.size() == 0)
+        {
+            spdlog::error("Array of vertices and array of idices cannot be empty");
+            throw std::runtime_error("Array of vertices and array of idices cannot be empty");
+        }
+        if (m_TriangleIndices.size() % 3 != 0)
+        {
+            spdlog::error("Length of the array of indices must be divisible by 3");
+            throw std::runtime_error("Length of the array of indices must be divisible by 3");
+        }
+
+        if (m_Lods.empty())
+        {
+            m_Lods.push_back({0, static_cast<GLuint>(m_TriangleIndices.size()), 0.0f});
+        }
+        for (const auto &lod : m_Lods)
+        {
+            if (lod.indexCount == 0 || lod.indexCount % 3 != 0 ||
+                static_cast<size_t>(lod.indexOffset) + lod.indexCount > m_TriangleIndices.size())
+            {
+                spdlog::error("LOD index range [{}, {}) is invalid", lod.indexOffset, lod.indexOffset + lod.indexCount);
+                throw std::runtime_error("Invalid LOD index range");
+            }
+        }
+
+        computeBoundingSphere(m_Vertices, m_BoundsCenter, m_BoundsRadius);
+        m_VertexCount = m_Vertices.size();
+        m_IndexCount = m_TriangleIndices.size();
+    }
+
+    StaticMesh::StaticMesh(StaticMesh::ExternalBuffer buffer) : m_IsOnGPU(false),
+                                                                m_VboId(0),
+                                                                m_VaoId(0),
+                                                                m_EboId(0)
+    {
+        spdlog::trace("Creating a static mesh from an external buffer");
+        m_External = std::move(buffer);
+        const ExternalBuffer &ext = m_External;
+
+        if (ext.data == nullptr || ext.vertexCount == 0 || ext.indexCount == 0 || ext.indexCount % 3 != 0)
+        {
+            spdlog::error("External buffer must contain vertices and a multiple of 3 indices");
+            throw std::runtime_error("External buffer must contain vertices and a multiple of 3 indices");
+        }
+        if (ext.position.componentType != GL_FLOAT || ext.position.components != 3 ||
+            ext.normal.componentType != GL_FLOAT || ext.normal.components != 3 ||
+            ext.tangent.componentType != GL_FLOAT || ext.tangent.components != 4 ||
+            (ext.indexType != GL_UNSIGNED_BYTE && ext.indexType != GL_UNSIGNED_SHORT && ext.indexType != GL_UNSIGNED_INT))
+        {
+            spdlog::error("Unsupported attribute or index types in external buffer");
+            throw std::runtime_error("Unsupported attribute or index types in external buffer");
+        }
+
+        auto attributeSize = [](const AttributeView &view)
+        {
+            size_t componentSize = view.componentType == GL_FLOAT || view.componentType == GL_UNSIGNED_INT ? 4
+                                   : view.componentType == GL_SHORT || view.componentType == GL_UNSIGNED_SHORT ? 2
+                                                                                                               : 1;
+            return view.components * componentSize;
+        };
+        for (const AttributeView *view : {&ext.position, &ext.normal, &ext.tangent, &ext.uv})
+        {
+            if (view->components != 0 &&
+                !viewFits(ext.size, view->offset, view->stride, attributeSize(*view), ext.vertexCount))
+            {
+                spdlog::error("Vertex attribute exceeds the external buffer");
+                throw std::runtime_error("Vertex attribute exceeds the external buffer");
+            }
+        }
+        size_t indexSize = indexSizeOf(ext.indexType);
+        if (ext.indexOffset % indexSize != 0 || !viewFits(ext.size, ext.indexOffset, indexSize, indexSize, ext.indexCount))
+        {
+            spdlog::error("Indices exceed the external buffer");
+            throw std::runtime_error("Indices exceed the external buffer");
+        }
+
+        // The GPU would read out of bounds otherwise, checking needs no copy of the indices
+        for (size_t i = 0; i < ext.indexCount; i++)
+        {
+            const unsigned char *index = ext.data + ext.indexOffset + i * indexSize;
+            uint32_t value = 0;
+            std::memcpy(&value, index, indexSize); // little endian, like glTF
+            if (value >= ext.vertexCount)
+            {
+                spdlog::error("Index {} is out of range ({} vertices)", value, ext.vertexCount);
+                throw std::runtime_error("Index out of range");
+            }
+        }
+
+        // Same bounds as computeBoundingSphere, read in place
+        auto positionAt = [&](size_t i)
+        {
+            glm::vec3 position;
+            std::memcpy(&position, ext.data + ext.position.offset + i * ext.position.stride, sizeof(position));
+            return position;
+        };
+        glm::vec3 positionMin = positionAt(0), positionMax = positionMin;
+        for (size_t i = 1; i < ext.vertexCount; i++)
+        {
+            positionMin = glm::min(positionMin, positionAt(i));
+            positionMax = glm::max(positionMax, positionAt(i));
+        }
+        m_BoundsCenter = (positionMin + positionMax) * 0.5f;
+        for (size_t i = 0; i < ext.vertexCount; i++)
+        {
+            m_BoundsRadius = std::max(m_BoundsRadius, glm::length(positionAt(i) - m_BoundsCenter));
+        }
+
+        m_Lods.push_back({0, static_cast<GLuint>(ext.indexCount), 0.0f});
+        m_VertexCount = ext.vertexCount;
+        m_IndexCount = ext.indexCount;
+    }
+
+    void StaticMesh::computeBoundingSphere(const std::vector<StaticMesh::Vertex> &vertices,
+                                           glm::vec3 &center,
+                                           float &radius)
+    {
+        // Centred on the AABB, not minimal but good enough for LOD selection
+        glm::vec3 positionMin = vertices.empty() ? glm::vec3(0.0f) : vertices[0].position;
+        glm::vec3 positionMax = positionMin;
+        for (const auto &vertex : vertices)
+        {
+            positionMin = glm::min(positionMin, vertex.position);
+            positionMax = glm::max(positionMax, vertex.position);
+        }
+        center = (positionMin + positionMax) * 0.5f;
+
+        radius = 0.0f;
+        for (const auto &vertex : vertices)
+        {
+            radius = std::max(radius, glm::length(vertex.position - center));
+        }
+    }
+
+    std::vector<StaticMesh::Vertex> StaticMesh::buildVertices(const std::vector<glm::vec3> &vertexPositions,
+                                                              const std::vector<glm::vec3> &vertexNormals,
+                                                              const std::vector<glm::vec2> &vertexUVs,
+                                                              const std::vector<GLuint> &triangleIndices,
+                                                              ThreadPool *threadPool)
+    {
         if (vertexPositions.size() == 0 || vertexNormals.size() == 0 || vertexUVs.size() == 0 || triangleIndices.size() == 0)
         {
             spdlog::error("Vertex attribute arrays and array of idices cannot be empty");
@@ -40,50 +254,16 @@ namespace planets
         }
 
         spdlog::trace("Precomputing tangents for static mesh");
+        std::vector<glm::vec4> tangents = TangentGenerator::generate(vertexPositions, vertexNormals, vertexUVs,
+                                                                     triangleIndices, threadPool);
 
-        std::vector<std::pair<glm::vec3, size_t>> tangents(vertexNormals.size());
-        for (auto &[tangent, numSamples] : tangents)
-        {
-            tangent = glm::vec3{0.0};
-            numSamples = 0;
-        }
-
-        for (size_t i = 0; i < triangleIndices.size(); i += 3)
-        {
-            // https://learnopengl.com/Advanced-Lighting/Normal-Mapping
-            const glm::vec3 &pos1 = vertexPositions[triangleIndices[i + 0]];
-            const glm::vec3 &pos2 = vertexPositions[triangleIndices[i + 1]];
-            const glm::vec3 &pos3 = vertexPositions[triangleIndices[i + 2]];
-            const glm::vec2 &uv1 = vertexUVs[triangleIndices[i + 0]];
-            const glm::vec2 &uv2 = vertexUVs[triangleIndices[i + 1]];
-            const glm::vec2 &uv3 = vertexUVs[triangleIndices[i + 2]];
-            glm::vec3 edge1 = pos2 - pos1;
-            glm::vec3 edge2 = pos3 - pos1;
-            glm::vec2 deltaUV1 = uv2 - uv1;
-            glm::vec2 deltaUV2 = uv3 - uv1;
-
-            float f = 1.0f / (deltaUV1.x * deltaUV2.y - deltaUV2.x * deltaUV1.y);
-
-            glm::vec3 tangent;
-            tangent.x = f * (deltaUV2.y * edge1.x - deltaUV1.y * edge2.x);
-            tangent.y = f * (deltaUV2.y * edge1.y - deltaUV1.y * edge2.y);
-            tangent.z = f * (deltaUV2.y * edge1.z - deltaUV1.y * edge2.z);
-
-            tangents[triangleIndices[i + 0]].first += tangent;
-            tangents[triangleIndices[i + 0]].second++;
-            tangents[triangleIndices[i + 1]].first += tangent;
-            tangents[triangleIndices[i + 1]].second++;
-            tangents[triangleIndices[i + 2]].first += tangent;
-            tangents[triangleIndices[i + 2]].second++;
-        }
-
+        std::vector<StaticMesh::Vertex> vertices;
+        vertices.reserve(vertexPositions.size());
         for (size_t i = 0; i < vertexPositions.size(); i++)
         {
-            m_Vertices.emplace_back(vertexPositions[i],
-                                    vertexNormals[i],
-                                    glm::normalize(tangents[i].first / static_cast<float>(tangents[i].second)), // averaging
-                                    vertexUVs[i]);
+            vertices.emplace_back(vertexPositions[i], vertexNormals[i], tangents[i], vertexUVs[i]);
         }
+        return vertices;
     }
 
     StaticMesh::~StaticMesh()
@@ -95,7 +275,66 @@ namespace planets
         }
     }
 
-    void StaticMesh::uploadToGPU()
+    void StaticMesh::swap(StaticMesh &other) noexcept
+    {
+        std::swap(m_Vertices, other.m_Vertices);
+        std::swap(m_TriangleIndices, other.m_TriangleIndices);
+        std::swap(m_Lods, other.m_Lods);
+        std::swap(m_Positions, other.m_Positions);
+        std::swap(m_VertexCount, other.m_VertexCount);
+        std::swap(m_IndexCount, other.m_IndexCount);
+        std::swap(m_Residency, other.m_Residency);
+        std::swap(m_StreamSource, other.m_StreamSource);
+        std::swap(m_External, other.m_External);
+        std::swap(m_BoundsCenter, other.m_BoundsCenter);
+        std::swap(m_BoundsRadius, other.m_BoundsRadius);
+        std::swap(m_IsOnGPU, other.m_IsOnGPU);
+        std::swap(m_VertexFormat, other.m_VertexFormat);
+        std::swap(m_IndexType, other.m_IndexType);
+        std::swap(m_IndexByteOffset, other.m_IndexByteOffset);
+        std::swap(m_PositionDecode, other.m_PositionDecode);
+        std::swap(m_GpuSizeInBytes, other.m_GpuSizeInBytes);
+        std::swap(m_VboId, other.m_VboId);
+        std::swap(m_VaoId, other.m_VaoId);
+        std::swap(m_EboId, other.m_EboId);
+    }
+
+    std::vector<StaticMesh::PackedVertex> StaticMesh::packVertices(const std::vector<StaticMesh::Vertex> &vertices,
+                                                                   glm::vec3 &positionMin,
+                                                                   glm::vec3 &positionExtent)
+    {
+        positionMin = vertices.empty() ? glm::vec3(0.0f) : vertices[0].position;
+        glm::vec3 positionMax = positionMin;
+        for (const auto &vertex : vertices)
+        {
+            positionMin = glm::min(positionMin, vertex.position);
+            positionMax = glm::max(positionMax, vertex.position);
+        }
+        positionExtent = positionMax - positionMin;
+
+        // Flat axes keep a unit extent so the division below stays defined
+        glm::vec3 safeExtent(positionExtent.x > 0.0f ? positionExtent.x : 1.0f,
+                             positionExtent.y > 0.0f ? positionExtent.y : 1.0f,
+                             positionExtent.z > 0.0f ? positionExtent.z : 1.0f);
+        positionExtent = safeExtent;
+
+        std::vector<StaticMesh::PackedVertex> packed(vertices.size());
+        for (size_t i = 0; i < vertices.size(); i++)
+        {
+            const Vertex &vertex = vertices[i];
+            glm::vec3 normalized = (vertex.position - positionMin) / safeExtent;
+            packed[i].position[0] = quantizeUnorm16(normalized.x);
+            packed[i].position[1] = quantizeUnorm16(normalized.y);
+            packed[i].position[2] = quantizeUnorm16(normalized.z);
+            packed[i].position[3] = vertex.tangent.w < 0.0f ? 0 : 65535;
+            packed[i].normal = glm::packSnorm2x16(octahedralEncode(vertex.normal));
+            packed[i].tangent = glm::packSnorm2x16(octahedralEncode(glm::vec3(vertex.tangent)));
+            packed[i].uv = glm::packHalf2x16(vertex.uv);
+        }
+        return packed;
+    }
+
+    void StaticMesh::uploadToGPU(StaticMesh::VertexFormat format)
     {
         spdlog::trace("Uploading static mesh to GPU");
         if (m_IsOnGPU)
@@ -103,6 +342,7 @@ namespace planets
             spdlog::warn("Trying to upload mesh data that has already been uploaded");
             return;
         }
+        restreamCpuData();
 
         GLuint vboId, vaoId, eboId;
 
@@ -121,43 +361,96 @@ namespace planets
             throw std::runtime_error("Unable to create Vertex Buffer Object");
         }
 
-        glGenBuffers(1, &eboId);
-        if (eboId == 0)
+        // External buffers hold the indices in the vertex buffer
+        eboId = 0;
+        if (m_External.data == nullptr)
+        {
+            glGenBuffers(1, &eboId);
+        }
+        if (m_External.data == nullptr && eboId == 0)
         {
             glDeleteVertexArrays(1, &vaoId);
-            glDeleteVertexArrays(1, &vboId);
+            glDeleteBuffers(1, &vboId);
             spdlog::error("Unable to create Element Buffer Object");
             throw std::runtime_error("Unable to create Element Buffer Object");
         }
 
         glBindVertexArray(vaoId);
-
-        // Upload vertex attributes
         glBindBuffer(GL_ARRAY_BUFFER, vboId);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(m_Vertices[0]) * m_Vertices.size(),
-                     reinterpret_cast<void *>(&m_Vertices[0]), GL_STATIC_DRAW);
-
-        // Upload indices
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, eboId);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(m_TriangleIndices[0]) * m_TriangleIndices.size(),
-                     reinterpret_cast<void *>(&m_TriangleIndices[0]), GL_STATIC_DRAW);
-
-        // Set vertex attribute pointer
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(StaticMesh::Vertex),
-                              reinterpret_cast<void *>(offsetof(StaticMesh::Vertex, position)));
-        glEnableVertexAttribArray(0);
-
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(StaticMesh::Vertex),
-                              reinterpret_cast<void *>(offsetof(StaticMesh::Vertex, normal)));
-        glEnableVertexAttribArray(1);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_External.data != nullptr ? vboId : eboId);
 
-        glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(StaticMesh::Vertex),
-                              reinterpret_cast<void *>(offsetof(StaticMesh::Vertex, tangent)));
-        glEnableVertexAttribArray(2);
+        size_t vertexBytes, indexBytes;
+        m_IndexByteOffset = 0;
+        if (m_External.data != nullptr)
+        {
+            uploadExternalBuffer(vertexBytes, indexBytes);
+            format = VertexFormat::Float;
+        }
+        else if (format == VertexFormat::Packed)
+        {
+            glm::vec3 positionMin, positionExtent;
+            std::vector<PackedVertex> packed = packVertices(m_Vertices, positionMin, positionExtent);
+            vertexBytes = sizeof(PackedVertex) * packed.size();
+            glBufferData(GL_ARRAY_BUFFER, vertexBytes, packed.data(), GL_STATIC_DRAW);
+
+            // Column-major: scale by the extent, then translate to the AABB minimum
+            m_PositionDecode = glm::mat4(1.0f);
+            m_PositionDecode[0][0] = positionExtent.x;
+            m_PositionDecode[1][1] = positionExtent.y;
+            m_PositionDecode[2][2] = positionExtent.z;
+            m_PositionDecode[3] = glm::vec4(positionMin, 1.0f);
+
+            if (m_Vertices.size() < 65536)
+            {
+                std::vector<uint16_t> shortIndices(m_TriangleIndices.begin(), m_TriangleIndices.end());
+                indexBytes = sizeof(uint16_t) * shortIndices.size();
+                glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, shortIndices.data(), GL_STATIC_DRAW);
+                m_IndexType = GL_UNSIGNED_SHORT;
+            }
+            else
+            {
+                indexBytes = sizeof(GLuint) * m_TriangleIndices.size();
+                glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, m_TriangleIndices.data(), GL_STATIC_DRAW);
+                m_IndexType = GL_UNSIGNED_INT;
+            }
+
+            glVertexAttribPointer(0, 4, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedVertex),
+                                  reinterpret_cast<void *>(offsetof(PackedVertex, position)));
+            glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, sizeof(PackedVertex),
+                                  reinterpret_cast<void *>(offsetof(PackedVertex, normal)));
+            glVertexAttribPointer(2, 2, GL_SHORT, GL_TRUE, sizeof(PackedVertex),
+                                  reinterpret_cast<void *>(offsetof(PackedVertex, tangent)));
+            glVertexAttribPointer(3, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(PackedVertex),
+                                  reinterpret_cast<void *>(offsetof(PackedVertex, uv)));
+        }
+        else
+        {
+            vertexBytes = sizeof(Vertex) * m_Vertices.size();
+            glBufferData(GL_ARRAY_BUFFER, vertexBytes, m_Vertices.data(), GL_STATIC_DRAW);
+            m_PositionDecode = glm::mat4(1.0f);
+
+            indexBytes = sizeof(GLuint) * m_TriangleIndices.size();
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, m_TriangleIndices.data(), GL_STATIC_DRAW);
+            m_IndexType = GL_UNSIGNED_INT;
+
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(StaticMesh::Vertex),
+                                  reinterpret_cast<void *>(offsetof(StaticMesh::Vertex, position)));
+            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(StaticMesh::Vertex),
+                                  reinterpret_cast<void *>(offsetof(StaticMesh::Vertex, normal)));
+            glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(StaticMesh::Vertex),
+                                  reinterpret_cast<void *>(offsetof(StaticMesh::Vertex, tangent)));
+            glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(StaticMesh::Vertex),
+                                  reinterpret_cast<void *>(offsetof(StaticMesh::Vertex, uv)));
+        }
+        for (GLuint attribute = 0; attribute < 4 && m_External.data == nullptr; attribute++)
+        {
+            glEnableVertexAttribArray(attribute);
+        }
 
-        glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(StaticMesh::Vertex),
-                              reinterpret_cast<void *>(offsetof(StaticMesh::Vertex, uv)));
-        glEnableVertexAttribArray(3);
+        spdlog::trace("Uploaded {} vertices and {} indices ({:.1f} KB, {})",
+                      m_VertexCount, m_IndexCount, (vertexBytes + indexBytes) / 1024.0,
+                      m_External.data != nullptr ? "external" : format == VertexFormat::Packed ? "packed"
+                                                                                              : "float");
 
         glBindVertexArray(0);
 
@@ -165,7 +458,93 @@ namespace planets
         m_VboId = vboId;
         m_EboId = eboId;
 
+        m_VertexFormat = format;
+        m_GpuSizeInBytes = vertexBytes + indexBytes;
         m_IsOnGPU = true;
+
+        applyResidency();
+    }
+
+    void StaticMesh::uploadExternalBuffer(size_t &vertexBytes, size_t &indexBytes)
+    {
+        // The whole block goes into one buffer, bound as both the vertex and the element buffer
+        glBufferData(GL_ARRAY_BUFFER, m_External.size, m_External.data, GL_STATIC_DRAW);
+        m_PositionDecode = glm::mat4(1.0f);
+        m_IndexType = m_External.indexType;
+        m_IndexByteOffset = m_External.indexOffset;
+
+        setAttribute(0, m_External.position);
+        setAttribute(1, m_External.normal);
+        setAttribute(2, m_External.tangent);
+        setAttribute(3, m_External.uv);
+
+        indexBytes = m_External.indexCount * indexSizeOf(m_External.indexType);
+        vertexBytes = m_External.size - indexBytes;
+    }
+
+    void StaticMesh::setResidency(StaticMesh::Residency residency)
+    {
+        m_Residency = residency;
+        if (m_IsOnGPU)
+        {
+            applyResidency();
+        }
+    }
+
+    void StaticMesh::applyResidency()
+    {
+        if (m_Residency == Residency::Keep || m_Vertices.empty())
+        {
+            return;
+        }
+        if (!m_StreamSource)
+        {
+            spdlog::warn("Static mesh has no stream source, keeping its data in system memory");
+            return;
+        }
+
+        if (m_Residency == Residency::PositionsOnly)
+        {
+            m_Positions.resize(m_Vertices.size());
+            for (size_t i = 0; i < m_Vertices.size(); i++)
+            {
+                m_Positions[i] = m_Vertices[i].position;
+            }
+        }
+        else
+        {
+            std::vector<GLuint>().swap(m_TriangleIndices);
+        }
+        // Swapping with an empty vector releases the memory, clear() would keep the capacity
+        std::vector<Vertex>().swap(m_Vertices);
+    }
+
+    void StaticMesh::restreamCpuData()
+    {
+        if (!m_Vertices.empty() || m_External.data != nullptr)
+        {
+            return;
+        }
+
+        spdlog::trace("Re-streaming static mesh data dropped after the last upload");
+        std::vector<Vertex> vertices;
+        std::vector<GLuint> triangleIndices;
+        if (!m_StreamSource || !m_StreamSource(vertices, triangleIndices))
+        {
+            spdlog::error("Unable to re-stream static mesh data");
+            throw std::runtime_error("Unable to re-stream static mesh data");
+        }
+        // The LOD table and bounds stayed in memory, the data has to match them
+        if (vertices.size() != m_VertexCount || triangleIndices.size() != m_IndexCount)
+        {
+            spdlog::error("Re-streamed static mesh has {} vertices and {} indices instead of {} and {}",
+                          vertices.size(), triangleIndices.size(), m_VertexCount, m_IndexCount);
+            throw std::runtime_error("Re-streamed static mesh does not match");
+        }
+
+        m_Vertices = std::move(vertices);
+        m_TriangleIndices = std::move(triangleIndices);
+        std::vector<glm::vec3>().swap(m_Positions);
     }
 
     void StaticMesh::unloadFromGPU()
@@ -185,10 +564,20 @@ namespace planets
         m_VboId = 0;
         m_EboId = 0;
 
+        m_GpuSizeInBytes = 0;
         m_IsOnGPU = false;
     }
 
-    void StaticMesh::draw() const noexcept
+    size_t StaticMesh::getCpuSizeInBytes() const
+    {
+        return sizeof(StaticMesh) +
+               m_Vertices.capacity() * sizeof(Vertex) +
+               m_TriangleIndices.capacity() * sizeof(GLuint) +
+               m_Positions.capacity() * sizeof(glm::vec3) +
+               m_Lods.capacity() * sizeof(Lod);
+    }
+
+    void StaticMesh::draw(size_t lod) const noexcept
     {
         if (!m_IsOnGPU)
         {
@@ -197,7 +586,9 @@ namespace planets
         }
 
         glBindVertexArray(m_VaoId);
-        glDrawElements(GL_TRIANGLES, m_TriangleIndices.size(), GL_UNSIGNED_INT, 0);
+        const Lod &range = m_Lods[std::min(lod, m_Lods.size() - 1)];
+        glDrawElements(GL_TRIANGLES, range.indexCount, m_IndexType,
+                       reinterpret_cast<void *>(m_IndexByteOffset + range.indexOffset * indexSizeOf(m_IndexType)));
         glBindVertexArray(0);
     }
 }
\ No newline at end of file
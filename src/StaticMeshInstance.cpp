@@ -3,41 +3,131 @@
 #include "SpatialObject.hpp"
 #include "StaticMesh.hpp"
 #include "Material.hpp"
+#include "ResourceManager.hpp"
 
 #include "DebugUtils.hpp"
 
 #include <memory>
+#include <algorithm>
+#include <cmath>
 
 #include <glm/glm.hpp>
 
 namespace planets
 {
+    namespace
+    {
+        // Tolerated pixel error at a LOD bias of 0
+        constexpr float LOD_PIXEL_ERROR = 1.0f;
+        // Fraction of the tolerance by which the projected error has to leave it before switching
+        constexpr float LOD_HYSTERESIS = 0.2f;
+    }
+
     StaticMeshInstance::StaticMeshInstance(const std::string &name,
                                            std::shared_ptr<SpatialObject> parent,
-                                           std::shared_ptr<StaticMesh> mesh,
-                                           std::shared_ptr<Material> material) : SpatialObject(name, parent),
-                                                                                 m_Mesh(mesh),
-                                                                                 m_Material(material)
+                                           StaticMeshHandle mesh,
+                                           MaterialHandle material) : SpatialObject(name, parent),
+                                                                                 m_Parts{{mesh, material}}
     {
     }
 
-    void StaticMeshInstance::draw(const DrawInput &drawInput, DrawStats &drawStats)
+    StaticMeshInstance::StaticMeshInstance(const std::string &name,
+                                           std::shared_ptr<SpatialObject> parent,
+                                           ResourceHandle<StaticModel> model) : SpatialObject(name, parent),
+                                                                                m_Model(std::move(model))
     {
+    }
+
+    size_t StaticMeshInstance::selectLod(Part &part, const StaticMesh &mesh, const DrawInput &drawInput)
+    {
+        const std::vector<StaticMesh::Lod> &lods = mesh.getLods();
+        if (lods.size() == 1)
+        {
+            return 0;
+        }
+
+        glm::vec3 center = glm::vec3(m_LocalToWorld * glm::vec4(mesh.getBoundsCenter(), 1.0f));
+        float scale = std::max({glm::length(glm::vec3(m_LocalToWorld[0])),
+                                glm::length(glm::vec3(m_LocalToWorld[1])),
+                                glm::length(glm::vec3(m_LocalToWorld[2]))});
+        float distance = glm::length(center - drawInput.cameraPosition) - mesh.getBoundsRadius() * scale;
+        if (distance <= 0.0f)
+        {
+            part.currentLod = 0;
+            return part.currentLod;
+        }
+
+        // LOD errors are in model space, project them to pixels at the closest point of the bounding sphere
+        auto screenError = [&](size_t lod)
+        { return lods[lod].error * scale * drawInput.lodScale / distance; };
+        float tolerance = LOD_PIXEL_ERROR * std::exp2(drawInput.lodBias);
+
+        size_t lod = std::min(part.currentLod, lods.size() - 1);
+        if (screenError(lod) > tolerance * (1.0f + LOD_HYSTERESIS))
+        {
+            while (lod > 0 && screenError(lod) > tolerance)
+            {
+                lod--;
+            }
+        }
+        else
+        {
+            while (lod + 1 < lods.size() && screenError(lod + 1) <= tolerance * (1.0f - LOD_HYSTERESIS))
+            {
+                lod++;
+            }
+        }
+        part.currentLod = lod;
+        return part.currentLod;
+    }
+
+    void StaticMeshInstance::drawPart(Part &part, const DrawInput &drawInput, DrawStats &drawStats)
+    {
+        StaticMesh *mesh = drawInput.resources.resolve(part.mesh);
+        Material *material = drawInput.resources.resolve(part.material);
+        if (mesh == nullptr || material == nullptr)
+        {
+            return;
+        }
+        size_t lod = selectLod(part, *mesh, drawInput);
+
+        // Packed positions are relative to the mesh AABB, decoding them is part of the model matrix
+        glm::mat4 modelToWorld = m_LocalToWorld * mesh->getPositionDecodeMatrix();
         MaterialInput matInput{
-            drawInput.viewProjection,
-            drawInput.viewProjection * m_LocalToWorld,
-            m_LocalToWorld,
+            drawInput.viewProjection * modelToWorld,
+            modelToWorld,
             m_WorldRotationM3x3, // For normals
-            drawInput.cameraPosition,
-            drawInput.cameraDirection,
-            drawInput.time};
+            static_cast<GLint>(mesh->getVertexFormat()),
+            drawInput.objectUniforms,
+            drawStats};
 
         drawStats.drawCalls++;
         drawStats.staticMeshes++;
+        drawStats.triangles += static_cast<int>(mesh->getLods()[lod].indexCount / 3);
+
+        material->use(matInput);
+        mesh->draw(lod);
+        material->disable();
+    }
+
+    void StaticMeshInstance::draw(const DrawInput &drawInput, DrawStats &drawStats)
+    {
+        if (m_Model.isValid())
+        {
+            if (const StaticModel *model = m_Model.get())
+            {
+                for (const auto &[mesh, material] : model->meshes)
+                {
+                    m_Parts.push_back({mesh, material});
+                }
+                m_Model = {};
+            }
+        }
 
-        m_Material->use(matInput);
-        m_Mesh->draw();
-        m_Material->disable();
+        for (auto &part : m_Parts)
+        {
+            drawPart(part, drawInput, drawStats);
+        }
 
         SpatialObject::draw(drawInput, drawStats);
     }
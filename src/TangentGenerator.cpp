@@ -0,0 +1,199 @@
+#include "TangentGenerator.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <cmath>
+
+namespace planets
+{
+    namespace
+    {
+        struct TangentSum
+        {
+            glm::vec3 tangent{0.0f};
+            float orientation{0.0f}; // angle weighted sum of the UV winding signs
+        };
+
+        // Triangles [triangleBegin, triangleEnd) accumulate into the vertices [vertexBegin, vertexEnd)
+        struct TriangleRange
+        {
+            size_t triangleBegin;
+            size_t triangleEnd;
+            GLuint vertexBegin;
+            GLuint vertexEnd;
+            std::vector<TangentSum> sums;
+        };
+
+        glm::vec3 projectOntoPlane(const glm::vec3 &v, const glm::vec3 &normal)
+        {
+            return v - normal * glm::dot(normal, v);
+        }
+
+        glm::vec3 safeNormalize(const glm::vec3 &v)
+        {
+            float length = glm::length(v);
+            return length > 0.0f ? v / length : glm::vec3(0.0f);
+        }
+
+        // Any unit vector perpendicular to normal, +X for a zero normal
+        glm::vec3 perpendicular(const glm::vec3 &normal)
+        {
+            if (glm::dot(normal, normal) == 0.0f)
+            {
+                return glm::vec3(1.0f, 0.0f, 0.0f);
+            }
+            glm::vec3 axis = std::fabs(normal.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+            return safeNormalize(projectOntoPlane(axis, normal));
+        }
+
+        void accumulateTriangles(TriangleRange &range,
+                                 const std::vector<glm::vec3> &vertexPositions,
+                                 const std::vector<glm::vec3> &vertexNormals,
+                                 const std::vector<glm::vec2> &vertexUVs,
+                                 const std::vector<GLuint> &triangleIndices)
+        {
+            for (size_t triangle = range.triangleBegin; triangle < range.triangleEnd; triangle++)
+            {
+                const GLuint *corners = &triangleIndices[3 * triangle];
+                glm::vec3 edge1 = vertexPositions[corners[1]] - vertexPositions[corners[0]];
+                glm::vec3 edge2 = vertexPositions[corners[2]] - vertexPositions[corners[0]];
+                glm::vec2 deltaUV1 = vertexUVs[corners[1]] - vertexUVs[corners[0]];
+                glm::vec2 deltaUV2 = vertexUVs[corners[2]] - vertexUVs[corners[0]];
+
+                float uvArea = deltaUV1.x * deltaUV2.y - deltaUV2.x * deltaUV1.y;
+                if (std::fabs(uvArea) <= TangentGenerator::DEGENERATE_UV_AREA)
+                {
+                    continue;
+                }
+                float orientation = uvArea > 0.0f ? 1.0f : -1.0f;
+                // dP/du scaled by |uvArea|, only the direction matters
+                glm::vec3 faceTangent = (edge1 * deltaUV2.y - edge2 * deltaUV1.y) * orientation;
+
+                for (int corner = 0; corner < 3; corner++)
+                {
+                    GLuint vertex = corners[corner];
+                    const glm::vec3 &normal = vertexNormals[vertex];
+                    glm::vec3 tangent = safeNormalize(projectOntoPlane(faceTangent, normal));
+                    if (tangent == glm::vec3(0.0f))
+                    {
+                        continue;
+                    }
+
+                    // Weight by the angle of the corner within the tangent plane
+                    const glm::vec3 &position = vertexPositions[vertex];
+                    glm::vec3 toNext = safeNormalize(projectOntoPlane(vertexPositions[corners[(corner + 1) % 3]] - position, normal));
+                    glm::vec3 toPrevious = safeNormalize(projectOntoPlane(vertexPositions[corners[(corner + 2) % 3]] - position, normal));
+                    float angle = std::acos(std::clamp(glm::dot(toNext, toPrevious), -1.0f, 1.0f));
+
+                    TangentSum &sum = range.sums[vertex - range.vertexBegin];
+                    sum.tangent += tangent * angle;
+                    sum.orientation += orientation * angle;
+                }
+            }
+        }
+    }
+
+    std::vector<glm::vec4> TangentGenerator::generate(const std::vector<glm::vec3> &vertexPositions,
+                                                      const std::vector<glm::vec3> &vertexNormals,
+                                                      const std::vector<glm::vec2> &vertexUVs,
+                                                      const std::vector<GLuint> &triangleIndices,
+                                                      ThreadPool *threadPool)
+    {
+        if (vertexPositions.size() != vertexNormals.size() || vertexPositions.size() != vertexUVs.size())
+        {
+            spdlog::error("Vertex attribute arrays must have equal lengths");
+            throw std::runtime_error("Vertex attribute arrays must have equal lengths");
+        }
+        if (triangleIndices.size() % 3 != 0)
+        {
+            spdlog::error("Length of the array of indices must be divisible by 3");
+            throw std::runtime_error("Length of the array of indices must be divisible by 3");
+        }
+        for (GLuint index : triangleIndices)
+        {
+            if (index >= vertexPositions.size())
+            {
+                spdlog::error("Index {} is out of range ({} vertices)", index, vertexPositions.size());
+                throw std::runtime_error("Index out of range");
+            }
+        }
+
+        size_t triangleCount = triangleIndices.size() / 3;
+        size_t vertexCount = vertexPositions.size();
+        size_t numRanges = 1;
+        if (threadPool != nullptr)
+        {
+            numRanges = std::clamp<size_t>(triangleCount / MIN_TRIANGLES_PER_RANGE, 1, threadPool->size() + 1);
+        }
+
+        // Each range only allocates sums for the vertices it references, which for meshes in
+        // first-use vertex order is a small window instead of the whole vertex array
+        std::vector<TriangleRange> ranges(numRanges);
+        for (size_t r = 0; r < numRanges; r++)
+        {
+            TriangleRange &range = ranges[r];
+            range.triangleBegin = triangleCount * r / numRanges;
+            range.triangleEnd = triangleCount * (r + 1) / numRanges;
+            if (range.triangleBegin == range.triangleEnd)
+            {
+                range.vertexBegin = range.vertexEnd = 0;
+                continue;
+            }
+            auto [minIt, maxIt] = std::minmax_element(triangleIndices.begin() + 3 * range.triangleBegin,
+                                                      triangleIndices.begin() + 3 * range.triangleEnd);
+            range.vertexBegin = *minIt;
+            range.vertexEnd = *maxIt + 1;
+        }
+
+        auto accumulate = [&](size_t rangeBegin, size_t rangeEnd)
+        {
+            for (size_t r = rangeBegin; r < rangeEnd; r++)
+            {
+                ranges[r].sums.resize(ranges[r].vertexEnd - ranges[r].vertexBegin);
+                accumulateTriangles(ranges[r], vertexPositions, vertexNormals, vertexUVs, triangleIndices);
+            }
+        };
+
+        std::vector<glm::vec4> tangents(vertexCount);
+        // Sums ranges in a fixed order, so the result does not depend on the scheduling
+        auto reduce = [&](size_t vertexBegin, size_t vertexEnd)
+        {
+            for (size_t vertex = vertexBegin; vertex < vertexEnd; vertex++)
+            {
+                TangentSum sum;
+                for (const TriangleRange &range : ranges)
+                {
+                    if (vertex >= range.vertexBegin && vertex < range.vertexEnd)
+                    {
+                        const TangentSum &partial = range.sums[vertex - range.vertexBegin];
+                        sum.tangent += partial.tangent;
+                        sum.orientation += partial.orientation;
+                    }
+                }
+
+                const glm::vec3 &normal = vertexNormals[vertex];
+                glm::vec3 tangent = safeNormalize(projectOntoPlane(sum.tangent, normal));
+                if (tangent == glm::vec3(0.0f))
+                {
+                    tangent = perpendicular(safeNormalize(normal));
+                }
+                tangents[vertex] = glm::vec4(tangent, sum.orientation < 0.0f ? -1.0f : 1.0f);
+            }
+        };
+
+        if (threadPool != nullptr)
+        {
+            threadPool->parallelFor(0, numRanges, 1, accumulate);
+            threadPool->parallelFor(0, vertexCount, 4096, reduce);
+        }
+        else
+        {
+            accumulate(0, numRanges);
+            reduce(0, vertexCount);
+        }
+
+        return tangents;
+    }
+}
@@ -1,21 +1,159 @@
 #include "Texture2D.hpp"
+#include "Texture2DArray.hpp"
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
+#include <utility>
 #include <stdexcept>
 
+// S3TC is not part of core OpenGL, glad was generated without the extension
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
 namespace planets
 {
+    namespace
+    {
+        size_t blockSize(Texture2D::TextureDataFormat format)
+        {
+            switch (format)
+            {
+            case Texture2D::TextureDataFormat::BC1:
+            case Texture2D::TextureDataFormat::BC4:
+                return 8;
+            case Texture2D::TextureDataFormat::BC3:
+            case Texture2D::TextureDataFormat::BC5:
+            case Texture2D::TextureDataFormat::BC7:
+                return 16;
+            default:
+                return 0;
+            }
+        }
+
+        GLenum compressedInternalFormat(Texture2D::TextureDataFormat format)
+        {
+            switch (format)
+            {
+            case Texture2D::TextureDataFormat::BC1:
+                return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+            case Texture2D::TextureDataFormat::BC3:
+                return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+            case Texture2D::TextureDataFormat::BC4:
+                return GL_COMPRESSED_RED_RGTC1;
+            case Texture2D::TextureDataFormat::BC5:
+                return GL_COMPRESSED_RG_RGTC2;
+            case Texture2D::TextureDataFormat::BC7:
+                return GL_COMPRESSED_RGBA_BPTC_UNORM;
+            default:
+                return 0;
+            }
+        }
+
+        // Format the cooker would have had to ship without compression
+        Texture2D::TextureDataFormat uncompressedEquivalent(Texture2D::TextureDataFormat format)
+        {
+            switch (format)
+            {
+            case Texture2D::TextureDataFormat::BC1:
+            case Texture2D::TextureDataFormat::BC5:
+                return Texture2D::TextureDataFormat::RGB8;
+            case Texture2D::TextureDataFormat::BC3:
+            case Texture2D::TextureDataFormat::BC7:
+                return Texture2D::TextureDataFormat::RGBA8;
+            case Texture2D::TextureDataFormat::BC4:
+                return Texture2D::TextureDataFormat::R8;
+            default:
+                return format;
+            }
+        }
+
+        void setSamplingParameters(GLenum target)
+        {
+            glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_REPEAT);
+            glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+            glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+            glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameterf(target, GL_TEXTURE_MAX_ANISOTROPY_EXT, 8.0f);
+        }
+
+        // Drivers pad RGB8 texels to 32 bits
+        Texture2D::TextureDataFormat storedFormat(Texture2D::TextureDataFormat format)
+        {
+            return format == Texture2D::TextureDataFormat::RGB8 ? Texture2D::TextureDataFormat::RGBA8 : format;
+        }
+    }
+
+    void Texture2D::swap(Texture2D &other) noexcept
+    {
+        std::swap(m_TextureId, other.m_TextureId);
+        std::swap(m_Width, other.m_Width);
+        std::swap(m_Height, other.m_Height);
+        std::swap(m_Format, other.m_Format);
+        std::swap(m_MipLevelCount, other.m_MipLevelCount);
+        std::swap(m_SizeInBytes, other.m_SizeInBytes);
+        std::swap(m_UncompressedSizeInBytes, other.m_UncompressedSizeInBytes);
+        // A reloaded texture leaves its array, the old layer is not sampled anymore
+        std::swap(m_Array, other.m_Array);
+        std::swap(m_ArrayLayer, other.m_ArrayLayer);
+    }
+
+    void Texture2D::moveToArray(std::shared_ptr<Texture2DArray> array, GLint layer)
+    {
+        array->copyLayer(layer, *this);
+
+        GLuint viewId;
+        glGenTextures(1, &viewId);
+        glTextureView(viewId, GL_TEXTURE_2D, array->getId(), internalFormat(m_Format), 0, m_MipLevelCount, layer, 1);
+        glBindTexture(GL_TEXTURE_2D, viewId);
+        setSamplingParameters(GL_TEXTURE_2D);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        glDeleteTextures(1, &m_TextureId);
+        m_TextureId = viewId;
+        m_Array = std::move(array);
+        m_ArrayLayer = layer;
+    }
+
     Texture2D::Texture2D(GLsizei width, GLsizei height, const void *dataPtr, Texture2D::TextureDataFormat format)
+        : Texture2D(format, {MipLevel{width, height, dataPtr, levelSize(format, width, height)}})
     {
-        if (format != TextureDataFormat::RGB8 && format != TextureDataFormat::RGBA8 && format != TextureDataFormat::R8)
+    }
+
+    Texture2D::Texture2D(Texture2D::TextureDataFormat format, const std::vector<Texture2D::MipLevel> &mipLevels)
+        : m_Format(format)
+    {
+        bool compressed = isCompressed(format);
+        if (!compressed && format != TextureDataFormat::RGB8 && format != TextureDataFormat::RGBA8 && format != TextureDataFormat::R8)
         {
-            spdlog::error("Only R8, RGB8 and RGBA8 textures are supported");
+            spdlog::error("Only R8, RGB8, RGBA8 and BC1/3/4/5/7 textures are supported");
             throw std::runtime_error("Texture format not supported");
         }
+        if (mipLevels.empty())
+        {
+            spdlog::error("A texture needs at least one mip level");
+            throw std::runtime_error("A texture needs at least one mip level");
+        }
+        for (const auto &mip : mipLevels)
+        {
+            if (compressed && mip.size != levelSize(format, mip.width, mip.height))
+            {
+                spdlog::error("Compressed {}x{} mip level has {} bytes instead of {}",
+                              mip.width, mip.height, mip.size, levelSize(format, mip.width, mip.height));
+                throw std::runtime_error("Compressed mip level has a wrong size");
+            }
+        }
+
+        m_Width = mipLevels.front().width;
+        m_Height = mipLevels.front().height;
 
         GLuint textureId;
         glGenTextures(1, &textureId);
@@ -23,32 +161,65 @@ namespace planets
         // TODO: add error handling
 
         glBindTexture(GL_TEXTURE_2D, textureId);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        setSamplingParameters(GL_TEXTURE_2D);
 
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, 8.0f);
-        switch (format)
+        // Rows of tightly packed RGB8 and R8 data are not 4-byte aligned
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+        for (size_t level = 0; level < mipLevels.size(); level++)
         {
-        case TextureDataFormat::R8:
-            spdlog::trace("Uploading {}x{} R8 texture data to GPU", width, height);
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, width, height, 0, GL_RED, GL_UNSIGNED_BYTE, dataPtr);
-            break;
-        case TextureDataFormat::RGB8:
-            spdlog::trace("Uploading {}x{} RGB8 texture data to GPU", width, height);
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, dataPtr);
-            break;
-        case TextureDataFormat::RGBA8:
-            spdlog::trace("Uploading {}x{} RGBA8 texture data to GPU", width, height);
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, dataPtr);
-            break;
-        default:
-            break;
+            const MipLevel &mip = mipLevels[level];
+            GLint glLevel = static_cast<GLint>(level);
+            switch (format)
+            {
+            case TextureDataFormat::R8:
+                spdlog::trace("Uploading {}x{} R8 texture data to GPU", mip.width, mip.height);
+                glTexImage2D(GL_TEXTURE_2D, glLevel, GL_R8, mip.width, mip.height, 0, GL_RED, GL_UNSIGNED_BYTE, mip.data);
+                break;
+            case TextureDataFormat::RGB8:
+                spdlog::trace("Uploading {}x{} RGB8 texture data to GPU", mip.width, mip.height);
+                glTexImage2D(GL_TEXTURE_2D, glLevel, GL_RGB, mip.width, mip.height, 0, GL_RGB, GL_UNSIGNED_BYTE, mip.data);
+                break;
+            case TextureDataFormat::RGBA8:
+                spdlog::trace("Uploading {}x{} RGBA8 texture data to GPU", mip.width, mip.height);
+                glTexImage2D(GL_TEXTURE_2D, glLevel, GL_RGBA, mip.width, mip.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, mip.data);
+                break;
+            case TextureDataFormat::BC1:
+            case TextureDataFormat::BC3:
+            case TextureDataFormat::BC4:
+            case TextureDataFormat::BC5:
+            case TextureDataFormat::BC7:
+                spdlog::trace("Uploading {}x{} compressed texture data to GPU", mip.width, mip.height);
+                glCompressedTexImage2D(GL_TEXTURE_2D, glLevel, compressedInternalFormat(format), mip.width, mip.height, 0,
+                                       static_cast<GLsizei>(mip.size), mip.data);
+                break;
+            default:
+                break;
+            }
+            m_SizeInBytes += levelSize(storedFormat(format), mip.width, mip.height);
+            m_UncompressedSizeInBytes += levelSize(storedFormat(uncompressedEquivalent(format)), mip.width, mip.height);
         }
 
-        glGenerateMipmap(GL_TEXTURE_2D);
+        // The GPU cannot generate mips of compressed textures, those are only sampled from the levels we have
+        if (mipLevels.size() == 1 && !compressed)
+        {
+            glGenerateMipmap(GL_TEXTURE_2D);
+            for (GLsizei width = m_Width, height = m_Height; width > 1 || height > 1;)
+            {
+                width = std::max(1, width / 2);
+                height = std::max(1, height / 2);
+                m_MipLevelCount++;
+                m_SizeInBytes += levelSize(storedFormat(format), width, height);
+                m_UncompressedSizeInBytes += levelSize(storedFormat(format), width, height);
+            }
+        }
+        else
+        {
+            m_MipLevelCount = static_cast<GLsizei>(mipLevels.size());
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(mipLevels.size() - 1));
+        }
 
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
         glBindTexture(GL_TEXTURE_2D, 0);
 
         m_TextureId = textureId;
@@ -59,4 +230,56 @@ namespace planets
         glDeleteTextures(1, &m_TextureId);
     }
 
-}
\ No newline at end of file
+    size_t Texture2D::bytesPerPixel(Texture2D::TextureDataFormat format)
+    {
+        switch (format)
+        {
+        case TextureDataFormat::R8:
+            return 1;
+        case TextureDataFormat::RGB8:
+            return 3;
+        case TextureDataFormat::RGBA8:
+            return 4;
+        case TextureDataFormat::R_FLOAT:
+            return 4;
+        case TextureDataFormat::RGB_FLOAT:
+            return 12;
+        case TextureDataFormat::RGBA_FLOAT:
+            return 16;
+        default:
+            return 0;
+        }
+    }
+
+    bool Texture2D::isCompressed(Texture2D::TextureDataFormat format)
+    {
+        return blockSize(format) != 0;
+    }
+
+    GLenum Texture2D::internalFormat(Texture2D::TextureDataFormat format)
+    {
+        switch (format)
+        {
+        case TextureDataFormat::R8:
+            return GL_R8;
+        case TextureDataFormat::RGB8:
+            return GL_RGB8;
+        case TextureDataFormat::RGBA8:
+            return GL_RGBA8;
+        default:
+            return compressedInternalFormat(format);
+        }
+    }
+
+    size_t Texture2D::levelSize(Texture2D::TextureDataFormat format, GLsizei width, GLsizei height)
+    {
+        if (isCompressed(format))
+        {
+            size_t blocksX = (static_cast<size_t>(width) + 3) / 4;
+            size_t blocksY = (static_cast<size_t>(height) + 3) / 4;
+            return blocksX * blocksY * blockSize(format);
+        }
+        return static_cast<size_t>(width) * height * bytesPerPixel(format);
+    }
+
+}
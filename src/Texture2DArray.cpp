@@ -0,0 +1,66 @@
+#include "Texture2DArray.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace planets
+{
+    Texture2DArray::Texture2DArray(Texture2D::TextureDataFormat format, GLsizei width, GLsizei height,
+                                   GLsizei mipLevelCount, GLsizei layerCount)
+        : m_Format(format), m_Width(width), m_Height(height), m_MipLevelCount(mipLevelCount), m_LayerCount(layerCount)
+    {
+        GLenum internalFormat = Texture2D::internalFormat(format);
+        if (internalFormat == 0)
+        {
+            spdlog::error("Texture arrays of this format are not supported");
+            throw std::runtime_error("Texture format not supported");
+        }
+
+        glGenTextures(1, &m_TextureId);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, m_TextureId);
+        // Same sampling as Texture2D
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameterf(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_ANISOTROPY_EXT, 8.0f);
+        // Immutable storage, so that the layers can be viewed as 2D textures
+        glTexStorage3D(GL_TEXTURE_2D_ARRAY, mipLevelCount, internalFormat, width, height, layerCount);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+        spdlog::trace("Created {}x{} texture array with {} layers and {} mip levels", width, height, layerCount, mipLevelCount);
+    }
+
+    Texture2DArray::~Texture2DArray()
+    {
+        glDeleteTextures(1, &m_TextureId);
+    }
+
+    bool Texture2DArray::fits(const Texture2D &texture) const
+    {
+        return texture.getFormat() == m_Format && texture.getWidth() == m_Width && texture.getHeight() == m_Height &&
+               texture.getMipLevelCount() == m_MipLevelCount;
+    }
+
+    void Texture2DArray::copyLayer(GLint layer, const Texture2D &texture)
+    {
+        if (!fits(texture) || layer < 0 || layer >= m_LayerCount)
+        {
+            spdlog::error("{}x{} texture does not fit into layer {} of a {}x{} texture array",
+                          texture.getWidth(), texture.getHeight(), layer, m_Width, m_Height);
+            throw std::runtime_error("Texture does not fit into the texture array");
+        }
+
+        GLsizei width = m_Width, height = m_Height;
+        for (GLint level = 0; level < m_MipLevelCount; level++)
+        {
+            glCopyImageSubData(texture.getId(), GL_TEXTURE_2D, level, 0, 0, 0,
+                               m_TextureId, GL_TEXTURE_2D_ARRAY, level, 0, 0, layer,
+                               width, height, 1);
+            width = std::max(1, width / 2);
+            height = std::max(1, height / 2);
+        }
+    }
+}
@@ -0,0 +1,524 @@
+#include "TextureCompressor.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <array>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+
+namespace planets
+{
+    namespace
+    {
+        template <size_t D>
+        using Color = std::array<float, D>;
+
+        // 4x4 texels, edge blocks repeat the last row/column
+        struct Block
+        {
+            unsigned char texels[16][4];
+        };
+
+        Block fetchBlock(const unsigned char *pixels, int width, int height, int channels, int blockX, int blockY)
+        {
+            Block block;
+            for (int y = 0; y < 4; y++)
+            {
+                int py = std::min(blockY * 4 + y, height - 1);
+                for (int x = 0; x < 4; x++)
+                {
+                    int px = std::min(blockX * 4 + x, width - 1);
+                    const unsigned char *texel = pixels + (static_cast<size_t>(py) * width + px) * channels;
+                    unsigned char *out = block.texels[y * 4 + x];
+                    out[0] = channels > 0 ? texel[0] : 0;
+                    out[1] = channels > 1 ? texel[1] : 0;
+                    out[2] = channels > 2 ? texel[2] : 0;
+                    out[3] = channels > 3 ? texel[3] : 255;
+                }
+            }
+            return block;
+        }
+
+        template <size_t D>
+        float distanceSquared(const Color<D> &a, const Color<D> &b)
+        {
+            float sum = 0.0f;
+            for (size_t c = 0; c < D; c++)
+            {
+                sum += (a[c] - b[c]) * (a[c] - b[c]);
+            }
+            return sum;
+        }
+
+        // Endpoints at the extremes of the block's principal axis
+        template <size_t D>
+        void principalAxisEndpoints(const Color<D> (&texels)[16], Color<D> &start, Color<D> &end)
+        {
+            Color<D> mean{};
+            for (const auto &texel : texels)
+            {
+                for (size_t c = 0; c < D; c++)
+                {
+                    mean[c] += texel[c] / 16.0f;
+                }
+            }
+
+            float covariance[D][D]{};
+            for (const auto &texel : texels)
+            {
+                for (size_t i = 0; i < D; i++)
+                {
+                    for (size_t j = 0; j < D; j++)
+                    {
+                        covariance[i][j] += (texel[i] - mean[i]) * (texel[j] - mean[j]);
+                    }
+                }
+            }
+
+            // Power iteration, starting from the channel with the largest variance
+            Color<D> axis{};
+            size_t largest = 0;
+            for (size_t c = 1; c < D; c++)
+            {
+                largest = covariance[c][c] > covariance[largest][largest] ? c : largest;
+            }
+            axis[largest] = 1.0f;
+            for (int iteration = 0; iteration < 8; iteration++)
+            {
+                Color<D> next{};
+                for (size_t i = 0; i < D; i++)
+                {
+                    for (size_t j = 0; j < D; j++)
+                    {
+                        next[i] += covariance[i][j] * axis[j];
+                    }
+                }
+                float length = std::sqrt(distanceSquared(next, Color<D>{}));
+                if (length < 1e-6f)
+                {
+                    break;
+                }
+                for (size_t c = 0; c < D; c++)
+                {
+                    axis[c] = next[c] / length;
+                }
+            }
+
+            float minProjection = 0.0f, maxProjection = 0.0f;
+            for (const auto &texel : texels)
+            {
+                float projection = 0.0f;
+                for (size_t c = 0; c < D; c++)
+                {
+                    projection += (texel[c] - mean[c]) * axis[c];
+                }
+                minProjection = std::min(minProjection, projection);
+                maxProjection = std::max(maxProjection, projection);
+            }
+            for (size_t c = 0; c < D; c++)
+            {
+                start[c] = std::clamp(mean[c] + axis[c] * minProjection, 0.0f, 255.0f);
+                end[c] = std::clamp(mean[c] + axis[c] * maxProjection, 0.0f, 255.0f);
+            }
+        }
+
+        /*
+        Least squares endpoints for fixed interpolation weights (0 = start, 1 = end).
+        Returns false if all texels use the same weight and the system is singular.
+        */
+        template <size_t D>
+        bool refineEndpoints(const Color<D> (&texels)[16], const float (&weights)[16], Color<D> &start, Color<D> &end)
+        {
+            float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+            Color<D> ax{}, bx{};
+            for (int i = 0; i < 16; i++)
+            {
+                float a = 1.0f - weights[i];
+                float b = weights[i];
+                aa += a * a;
+                ab += a * b;
+                bb += b * b;
+                for (size_t c = 0; c < D; c++)
+                {
+                    ax[c] += a * texels[i][c];
+                    bx[c] += b * texels[i][c];
+                }
+            }
+
+            float determinant = aa * bb - ab * ab;
+            if (std::fabs(determinant) < 1e-6f)
+            {
+                return false;
+            }
+            for (size_t c = 0; c < D; c++)
+            {
+                start[c] = std::clamp((ax[c] * bb - bx[c] * ab) / determinant, 0.0f, 255.0f);
+                end[c] = std::clamp((bx[c] * aa - ax[c] * ab) / determinant, 0.0f, 255.0f);
+            }
+            return true;
+        }
+
+        // Little-endian bit stream over one 64- or 128-bit block
+        class BlockWriter
+        {
+        public:
+            BlockWriter(unsigned char *out) : m_Out(out) {}
+
+            void write(uint32_t value, int bits)
+            {
+                for (int i = 0; i < bits; i++, m_Bit++)
+                {
+                    m_Out[m_Bit / 8] |= static_cast<unsigned char>(((value >> i) & 1u) << (m_Bit % 8));
+                }
+            }
+
+        private:
+            unsigned char *m_Out;
+            int m_Bit{0};
+        };
+
+        // BC1 colour block ------------------------------------------------------------------------
+
+        uint16_t packRGB565(const Color<3> &color)
+        {
+            uint32_t r = static_cast<uint32_t>(std::lround(color[0] * 31.0f / 255.0f));
+            uint32_t g = static_cast<uint32_t>(std::lround(color[1] * 63.0f / 255.0f));
+            uint32_t b = static_cast<uint32_t>(std::lround(color[2] * 31.0f / 255.0f));
+            return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+        }
+
+        Color<3> unpackRGB565(uint16_t packed)
+        {
+            uint32_t r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+            return {static_cast<float>((r << 3) | (r >> 2)),
+                    static_cast<float>((g << 2) | (g >> 4)),
+                    static_cast<float>((b << 3) | (b >> 2))};
+        }
+
+        // Picks the four-colour palette entries for quantized endpoints, returns the squared error
+        float fitColorIndices(const Color<3> (&texels)[16], uint16_t color0, uint16_t color1, uint8_t (&indices)[16])
+        {
+            Color<3> c0 = unpackRGB565(color0), c1 = unpackRGB565(color1);
+            Color<3> palette[4] = {c0, c1, {}, {}};
+            for (size_t c = 0; c < 3; c++)
+            {
+                palette[2][c] = (2.0f * c0[c] + c1[c]) / 3.0f;
+                palette[3][c] = (c0[c] + 2.0f * c1[c]) / 3.0f;
+            }
+
+            float error = 0.0f;
+            for (int i = 0; i < 16; i++)
+            {
+                float best = distanceSquared(texels[i], palette[0]);
+                indices[i] = 0;
+                for (uint8_t p = 1; p < 4; p++)
+                {
+                    float distance = distanceSquared(texels[i], palette[p]);
+                    if (distance < best)
+                    {
+                        best = distance;
+                        indices[i] = p;
+                    }
+                }
+                error += best;
+            }
+            return error;
+        }
+
+        void encodeColorBlock(const Block &block, unsigned char *out)
+        {
+            Color<3> texels[16];
+            for (int i = 0; i < 16; i++)
+            {
+                texels[i] = {static_cast<float>(block.texels[i][0]),
+                             static_cast<float>(block.texels[i][1]),
+                             static_cast<float>(block.texels[i][2])};
+            }
+
+            Color<3> start, end;
+            principalAxisEndpoints(texels, start, end);
+            uint16_t color0 = packRGB565(end), color1 = packRGB565(start);
+            uint8_t indices[16];
+            float error = fitColorIndices(texels, color0, color1, indices);
+
+            // Palette index -> position between color0 and color1
+            static constexpr float WEIGHTS[4] = {0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f};
+            float weights[16];
+            for (int i = 0; i < 16; i++)
+            {
+                weights[i] = WEIGHTS[indices[i]];
+            }
+            Color<3> refined0, refined1;
+            if (refineEndpoints(texels, weights, refined0, refined1))
+            {
+                uint16_t refinedColor0 = packRGB565(refined0), refinedColor1 = packRGB565(refined1);
+                uint8_t refinedIndices[16];
+                float refinedError = fitColorIndices(texels, refinedColor0, refinedColor1, refinedIndices);
+                if (refinedError < error)
+                {
+                    color0 = refinedColor0;
+                    color1 = refinedColor1;
+                    std::memcpy(indices, refinedIndices, sizeof(indices));
+                }
+            }
+
+            // color0 > color1 selects the four-colour mode in BC1
+            if (color0 < color1)
+            {
+                std::swap(color0, color1);
+                static constexpr uint8_t SWAPPED[4] = {1, 0, 3, 2};
+                for (auto &index : indices)
+                {
+                    index = SWAPPED[index];
+                }
+            }
+            else if (color0 == color1)
+            {
+                std::memset(indices, 0, sizeof(indices));
+            }
+
+            BlockWriter writer(out);
+            writer.write(color0, 16);
+            writer.write(color1, 16);
+            for (uint8_t index : indices)
+            {
+                writer.write(index, 2);
+            }
+        }
+
+        // BC4 single channel block, also used for BC3 alpha and both BC5 channels -------------------
+
+        void encodeChannelBlock(const Block &block, int channel, unsigned char *out)
+        {
+            unsigned char minValue = 255, maxValue = 0;
+            for (const auto &texel : block.texels)
+            {
+                minValue = std::min(minValue, texel[channel]);
+                maxValue = std::max(maxValue, texel[channel]);
+            }
+
+            BlockWriter writer(out);
+            writer.write(maxValue, 8);
+            writer.write(minValue, 8);
+            if (minValue == maxValue)
+            {
+                writer.write(0, 32);
+                writer.write(0, 16);
+                return;
+            }
+
+            // Eight-value mode (red0 > red1): index 0 = max, 1 = min, 2..7 interpolate from max to min
+            float palette[8] = {static_cast<float>(maxValue), static_cast<float>(minValue)};
+            for (int i = 2; i < 8; i++)
+            {
+                palette[i] = ((8 - i) * maxValue + (i - 1) * minValue) / 7.0f;
+            }
+            for (const auto &texel : block.texels)
+            {
+                uint32_t bestIndex = 0;
+                float best = std::fabs(texel[channel] - palette[0]);
+                for (uint32_t p = 1; p < 8; p++)
+                {
+                    float distance = std::fabs(texel[channel] - palette[p]);
+                    if (distance < best)
+                    {
+                        best = distance;
+                        bestIndex = p;
+                    }
+                }
+                writer.write(bestIndex, 3);
+            }
+        }
+
+        // BC7 mode 6: one subset, RGBA 7.7.7.7 endpoints with a p-bit each, 4-bit indices -----------
+
+        constexpr int BC7_WEIGHTS[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+        struct Mode6Endpoint
+        {
+            uint8_t value[4]; // 7 bits
+            uint8_t pBit;
+
+            Color<4> unpack() const
+            {
+                return {static_cast<float>((value[0] << 1) | pBit), static_cast<float>((value[1] << 1) | pBit),
+                        static_cast<float>((value[2] << 1) | pBit), static_cast<float>((value[3] << 1) | pBit)};
+            }
+        };
+
+        Mode6Endpoint quantizeMode6(const Color<4> &color)
+        {
+            Mode6Endpoint best{};
+            float bestError = -1.0f;
+            for (uint8_t pBit = 0; pBit < 2; pBit++)
+            {
+                Mode6Endpoint candidate{};
+                candidate.pBit = pBit;
+                for (size_t c = 0; c < 4; c++)
+                {
+                    long value = std::lround((color[c] - pBit) / 2.0f);
+                    candidate.value[c] = static_cast<uint8_t>(std::clamp(value, 0L, 127L));
+                }
+                float error = distanceSquared(candidate.unpack(), color);
+                if (bestError < 0.0f || error < bestError)
+                {
+                    best = candidate;
+                    bestError = error;
+                }
+            }
+            return best;
+        }
+
+        float fitMode6Indices(const Color<4> (&texels)[16], const Mode6Endpoint &e0, const Mode6Endpoint &e1, uint8_t (&indices)[16])
+        {
+            Color<4> c0 = e0.unpack(), c1 = e1.unpack();
+            Color<4> palette[16];
+            for (int p = 0; p < 16; p++)
+            {
+                for (size_t c = 0; c < 4; c++)
+                {
+                    palette[p][c] = static_cast<float>(((64 - BC7_WEIGHTS[p]) * static_cast<int>(c0[c]) +
+                                                        BC7_WEIGHTS[p] * static_cast<int>(c1[c]) + 32) >> 6);
+                }
+            }
+
+            float error = 0.0f;
+            for (int i = 0; i < 16; i++)
+            {
+                float best = distanceSquared(texels[i], palette[0]);
+                indices[i] = 0;
+                for (uint8_t p = 1; p < 16; p++)
+                {
+                    float distance = distanceSquared(texels[i], palette[p]);
+                    if (distance < best)
+                    {
+                        best = distance;
+                        indices[i] = p;
+                    }
+                }
+                error += best;
+            }
+            return error;
+        }
+
+        void encodeMode6Block(const Block &block, unsigned char *out)
+        {
+            Color<4> texels[16];
+            for (int i = 0; i < 16; i++)
+            {
+                for (size_t c = 0; c < 4; c++)
+                {
+                    texels[i][c] = static_cast<float>(block.texels[i][c]);
+                }
+            }
+
+            Color<4> start, end;
+            principalAxisEndpoints(texels, start, end);
+            Mode6Endpoint e0 = quantizeMode6(start), e1 = quantizeMode6(end);
+            uint8_t indices[16];
+            float error = fitMode6Indices(texels, e0, e1, indices);
+
+            float weights[16];
+            for (int i = 0; i < 16; i++)
+            {
+                weights[i] = BC7_WEIGHTS[indices[i]] / 64.0f;
+            }
+            Color<4> refined0, refined1;
+            if (refineEndpoints(texels, weights, refined0, refined1))
+            {
+                Mode6Endpoint r0 = quantizeMode6(refined0), r1 = quantizeMode6(refined1);
+                uint8_t refinedIndices[16];
+                float refinedError = fitMode6Indices(texels, r0, r1, refinedIndices);
+                if (refinedError < error)
+                {
+                    e0 = r0;
+                    e1 = r1;
+                    std::memcpy(indices, refinedIndices, sizeof(indices));
+                }
+            }
+
+            // The most significant bit of the first index is implicitly 0
+            if (indices[0] & 8)
+            {
+                std::swap(e0, e1);
+                for (auto &index : indices)
+                {
+                    index = static_cast<uint8_t>(15 - index);
+                }
+            }
+
+            BlockWriter writer(out);
+            writer.write(1u << 6, 7);
+            for (size_t c = 0; c < 4; c++)
+            {
+                writer.write(e0.value[c], 7);
+                writer.write(e1.value[c], 7);
+            }
+            writer.write(e0.pBit, 1);
+            writer.write(e1.pBit, 1);
+            writer.write(indices[0], 3);
+            for (int i = 1; i < 16; i++)
+            {
+                writer.write(indices[i], 4);
+            }
+        }
+    }
+
+    std::vector<unsigned char> TextureCompressor::compress(Texture2D::TextureDataFormat format,
+                                                           const unsigned char *pixels,
+                                                           int width,
+                                                           int height,
+                                                           int channels)
+    {
+        if (!Texture2D::isCompressed(format))
+        {
+            spdlog::error("TextureCompressor only encodes block-compressed formats");
+            throw std::runtime_error("Format is not block-compressed");
+        }
+        if (channels < 1 || channels > 4 || width <= 0 || height <= 0)
+        {
+            spdlog::error("Unable to compress a {}x{} image with {} channels", width, height, channels);
+            throw std::runtime_error("Unsupported image for compression");
+        }
+
+        int blocksX = (width + 3) / 4;
+        int blocksY = (height + 3) / 4;
+        size_t blockBytes = Texture2D::levelSize(format, 4, 4);
+        std::vector<unsigned char> compressed(Texture2D::levelSize(format, width, height), 0);
+
+        for (int by = 0; by < blocksY; by++)
+        {
+            for (int bx = 0; bx < blocksX; bx++)
+            {
+                Block block = fetchBlock(pixels, width, height, channels, bx, by);
+                unsigned char *out = compressed.data() + (static_cast<size_t>(by) * blocksX + bx) * blockBytes;
+                switch (format)
+                {
+                case Texture2D::TextureDataFormat::BC1:
+                    encodeColorBlock(block, out);
+                    break;
+                case Texture2D::TextureDataFormat::BC3:
+                    encodeChannelBlock(block, 3, out);
+                    encodeColorBlock(block, out + 8);
+                    break;
+                case Texture2D::TextureDataFormat::BC4:
+                    encodeChannelBlock(block, 0, out);
+                    break;
+                case Texture2D::TextureDataFormat::BC5:
+                    encodeChannelBlock(block, 0, out);
+                    encodeChannelBlock(block, 1, out + 8);
+                    break;
+                case Texture2D::TextureDataFormat::BC7:
+                    encodeMode6Block(block, out);
+                    break;
+                default:
+                    break;
+                }
+            }
+        }
+        return compressed;
+    }
+}
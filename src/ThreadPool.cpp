@@ -0,0 +1,145 @@
+#include "ThreadPool.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <atomic>
+#include <algorithm>
+#include <exception>
+
+namespace planets
+{
+    ThreadPool::ThreadPool(size_t numThreads)
+    {
+        if (numThreads == 0)
+        {
+            numThreads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        spdlog::trace("Starting a thread pool with {} workers", numThreads);
+        for (size_t i = 0; i < numThreads; i++)
+        {
+            m_Workers.emplace_back(&ThreadPool::workerLoop, this);
+        }
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Stopping = true;
+        }
+        m_Condition.notify_all();
+        for (auto &worker : m_Workers)
+        {
+            worker.join();
+        }
+    }
+
+    void ThreadPool::enqueue(std::function<void()> task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Tasks.push(std::move(task));
+        }
+        m_Condition.notify_one();
+    }
+
+    bool ThreadPool::runPendingTask()
+    {
+        std::function<void()> task;
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            if (m_Tasks.empty())
+            {
+                return false;
+            }
+            task = std::move(m_Tasks.front());
+            m_Tasks.pop();
+        }
+        task();
+        return true;
+    }
+
+    void ThreadPool::workerLoop()
+    {
+        while (true)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(m_Mutex);
+                m_Condition.wait(lock, [this]()
+                                 { return m_Stopping || !m_Tasks.empty(); });
+                if (m_Stopping && m_Tasks.empty())
+                {
+                    return;
+                }
+                task = std::move(m_Tasks.front());
+                m_Tasks.pop();
+            }
+            task();
+        }
+    }
+
+    void ThreadPool::parallelFor(size_t begin, size_t end, size_t grainSize,
+                                 const std::function<void(size_t, size_t)> &rangeFunction)
+    {
+        if (begin >= end)
+        {
+            return;
+        }
+
+        size_t count = end - begin;
+        grainSize = std::max<size_t>(1, grainSize);
+        // A few ranges per worker for load balancing
+        size_t numRanges = std::min((count + grainSize - 1) / grainSize, (size() + 1) * 4);
+        if (numRanges <= 1)
+        {
+            rangeFunction(begin, end);
+            return;
+        }
+
+        std::atomic<size_t> remaining{numRanges};
+        std::exception_ptr firstException;
+        std::mutex exceptionMutex;
+
+        auto runRange = [&](size_t rangeIndex)
+        {
+            size_t rangeBegin = begin + count * rangeIndex / numRanges;
+            size_t rangeEnd = begin + count * (rangeIndex + 1) / numRanges;
+            try
+            {
+                rangeFunction(rangeBegin, rangeEnd);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(exceptionMutex);
+                if (!firstException)
+                {
+                    firstException = std::current_exception();
+                }
+            }
+            remaining--;
+        };
+
+        for (size_t i = 1; i < numRanges; i++)
+        {
+            enqueue([&runRange, i]()
+                    { runRange(i); });
+        }
+        // The calling thread takes the first range itself
+        runRange(0);
+
+        // Help with queued work instead of blocking, this keeps nested calls from deadlocking
+        while (remaining > 0)
+        {
+            if (!runPendingTask())
+            {
+                std::this_thread::yield();
+            }
+        }
+
+        if (firstException)
+        {
+            std::rethrow_exception(firstException);
+        }
+    }
+}
@@ -0,0 +1,113 @@
+#include "UniformBuffer.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <stdexcept>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+
+namespace planets
+{
+    UniformBuffer::UniformBuffer(GLsizeiptr size)
+    {
+        glCreateBuffers(1, &m_BufferId);
+        glNamedBufferStorage(m_BufferId, size, nullptr, GL_DYNAMIC_STORAGE_BIT);
+    }
+
+    UniformBuffer::~UniformBuffer()
+    {
+        glDeleteBuffers(1, &m_BufferId);
+    }
+
+    void UniformBuffer::update(const void *data, GLsizeiptr size) noexcept
+    {
+        glNamedBufferSubData(m_BufferId, 0, size, data);
+    }
+
+    void UniformBuffer::bind(GLuint binding) const noexcept
+    {
+        glBindBufferBase(GL_UNIFORM_BUFFER, binding, m_BufferId);
+    }
+
+    UniformRingBuffer::UniformRingBuffer(GLsizeiptr regionSize)
+    {
+        GLint alignment{0};
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        m_Alignment = std::max<GLsizeiptr>(alignment, 1);
+        m_RegionSize = (regionSize + m_Alignment - 1) / m_Alignment * m_Alignment;
+
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glCreateBuffers(1, &m_BufferId);
+        glNamedBufferStorage(m_BufferId, m_RegionSize * FRAMES_IN_FLIGHT, nullptr, flags);
+        m_Mapped = static_cast<unsigned char *>(glMapNamedBufferRange(m_BufferId, 0, m_RegionSize * FRAMES_IN_FLIGHT, flags));
+        if (m_Mapped == nullptr)
+        {
+            glDeleteBuffers(1, &m_BufferId);
+            spdlog::error("Unable to map a uniform ring buffer of {} bytes", m_RegionSize * FRAMES_IN_FLIGHT);
+            throw std::runtime_error("Unable to map uniform ring buffer");
+        }
+        spdlog::trace("Created a uniform ring buffer with {} regions of {} bytes, {} byte alignment",
+                      FRAMES_IN_FLIGHT, m_RegionSize, m_Alignment);
+    }
+
+    UniformRingBuffer::~UniformRingBuffer()
+    {
+        for (GLsync fence : m_Fences)
+        {
+            if (fence != nullptr)
+            {
+                glDeleteSync(fence);
+            }
+        }
+        glUnmapNamedBuffer(m_BufferId);
+        glDeleteBuffers(1, &m_BufferId);
+    }
+
+    void UniformRingBuffer::beginFrame()
+    {
+        m_Region = (m_Region + 1) % FRAMES_IN_FLIGHT;
+        m_Offset = 0;
+
+        GLsync &fence = m_Fences[m_Region];
+        if (fence != nullptr)
+        {
+            // Normally signaled long ago, the region was last written FRAMES_IN_FLIGHT frames back
+            GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+            while (result == GL_TIMEOUT_EXPIRED)
+            {
+                result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+            }
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+
+    void UniformRingBuffer::endFrame()
+    {
+        m_Fences[m_Region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    void UniformRingBuffer::push(GLuint binding, const void *data, GLsizeiptr size)
+    {
+        if (m_Offset + size > m_RegionSize)
+        {
+            if (!m_OverflowReported)
+            {
+                spdlog::warn("A frame needs more than {} bytes of per-draw uniforms, waiting for the GPU to reuse them", m_RegionSize);
+                m_OverflowReported = true;
+            }
+            // Earlier draws of this frame may still read the start of the region
+            glFinish();
+            m_Offset = 0;
+        }
+
+        GLintptr offset = m_Region * m_RegionSize + m_Offset;
+        std::memcpy(m_Mapped + offset, data, static_cast<size_t>(size));
+        glBindBufferRange(GL_UNIFORM_BUFFER, binding, m_BufferId, offset, size);
+        m_Offset += (size + m_Alignment - 1) / m_Alignment * m_Alignment;
+    }
+}
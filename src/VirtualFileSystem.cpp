@@ -0,0 +1,68 @@
+#include "VirtualFileSystem.hpp"
+#include "MappedFile.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <filesystem>
+#include <stdexcept>
+#include <vector>
+
+namespace planets
+{
+    namespace
+    {
+        // Archive entries are stored as "textures/a.png", whatever way the path was written
+        std::string normalizePath(const std::string &path)
+        {
+            return std::filesystem::path(path).lexically_normal().generic_string();
+        }
+    }
+
+    VirtualFileSystem::VirtualFileSystem(const std::string &rootDirectory) : m_RootDirectory(rootDirectory)
+    {
+    }
+
+    void VirtualFileSystem::mountArchive(const std::string &archivePath)
+    {
+        m_Archive = std::make_unique<AssetArchive>(archivePath);
+        spdlog::info("Mounted asset archive \"{}\" with {} files", archivePath, m_Archive->getEntries().size());
+    }
+
+    const AssetArchive::Entry *VirtualFileSystem::findEntry(const std::string &path) const
+    {
+        return m_Archive ? m_Archive->find(normalizePath(path)) : nullptr;
+    }
+
+    bool VirtualFileSystem::exists(const std::string &path) const
+    {
+        if (findEntry(path) != nullptr)
+        {
+            return true;
+        }
+        std::error_code ec;
+        return std::filesystem::is_regular_file(getLoosePath(path), ec);
+    }
+
+    VfsFile VirtualFileSystem::open(const std::string &path, ThreadPool *threadPool) const
+    {
+        const AssetArchive::Entry *entry = findEntry(path);
+        if (entry == nullptr)
+        {
+            auto file = std::make_shared<MappedFile>(getLoosePath(path));
+            return VfsFile(file, file->data(), file->size());
+        }
+
+        if (entry->compression == AssetArchive::Compression::None)
+        {
+            return VfsFile(m_Archive->getFile(), m_Archive->getStoredData(*entry), entry->size);
+        }
+
+        auto decompressed = std::make_shared<std::vector<unsigned char>>(entry->size);
+        if (!m_Archive->decompress(*entry, decompressed->data(), threadPool))
+        {
+            spdlog::error("Entry \"{}\" of asset archive \"{}\" is corrupt", entry->path, m_Archive->getPath());
+            throw std::runtime_error("Archive entry is corrupt");
+        }
+        return VfsFile(decompressed, decompressed->data(), decompressed->size());
+    }
+}
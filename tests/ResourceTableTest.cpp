@@ -0,0 +1,64 @@
+/*
+Checks that ResourceTable removes replaced resources once they are unowned and that their
+handles stop resolving.
+
+Usage: planets-resourcetabletest
+*/
+
+#include "ResourceTable.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <memory>
+#include <cstdlib>
+
+namespace
+{
+    int failures{0};
+
+    void check(bool condition, const char *what)
+    {
+        if (!condition)
+        {
+            spdlog::error("Failed: {}", what);
+            failures++;
+        }
+    }
+}
+
+int main()
+{
+    planets::ResourceTable<int> table;
+
+    // Replacing a resource only the table owns makes its handle stale at once
+    auto first = table.add("a", std::make_shared<int>(1));
+    check(table.resolve(first) != nullptr && *table.resolve(first) == 1, "a new handle resolves");
+    auto second = table.add("a", std::make_shared<int>(2));
+    check(table.resolve(first) == nullptr, "the handle of an unowned replaced resource is stale");
+    check(table.findHandle("a") == second && *table.resolve(second) == 2, "the name moves to the new resource");
+
+    // The slot is reused with a new generation, the stale handle must not reach the new value
+    auto third = table.add("b", std::make_shared<int>(3));
+    check(table.resolve(first) == nullptr, "a stale handle does not resolve to a reused slot");
+    check(table.resolve(third) != nullptr && *table.resolve(third) == 3, "the reused slot resolves by its new handle");
+
+    // A replaced resource that is still owned elsewhere stays reachable until it is released
+    auto owned = std::make_shared<int>(4);
+    auto kept = table.add("c", owned);
+    table.add("c", std::make_shared<int>(5));
+    check(table.resolve(kept) == owned.get(), "an owned replaced resource still resolves");
+    check(table.size() == 3, "replaced resources are not counted");
+    check(table.releaseUnreferenced() == 0, "owned resources are not released");
+    owned.reset();
+    check(table.releaseUnreferenced() == 1, "unowned replaced resources are released");
+    check(table.resolve(kept) == nullptr, "the handle of a released resource is stale");
+    check(table.resolve(planets::ResourceTable<int>::Handle()) == nullptr, "the default handle does not resolve");
+
+    if (failures > 0)
+    {
+        spdlog::error("{} checks failed", failures);
+        return EXIT_FAILURE;
+    }
+    spdlog::info("All checks passed");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,318 @@
+/*
+Offline asset cooker. Imports every OBJ/MTL and every PNG/JPG image under the
+data directory and writes runtime-ready versions of them to <data>/cooked:
+welded meshes with precomputed tangents in the mesh cache format, and textures
+with their complete mip chain in a block-compressed format picked by how the
+materials use them: BC1 (opaque) or BC7 (with alpha) for colour maps, BC5 for
+normal maps and BC4 for single channel maps like roughness and metalness. The manifest written next to them tells the
+ResourceManager which cooked file replaces which source asset. Cooked meshes keep
+the stamps of their OBJ/MTL sources, a source edited after cooking is imported again.
+
+Usage: planets-cook [data directory]
+*/
+
+#include "AssetManifest.hpp"
+#include "CookedTexture.hpp"
+#include "MeshCache.hpp"
+#include "MeshImporter.hpp"
+#include "ThreadPool.hpp"
+#include "Texture2D.hpp"
+#include "TextureCompressor.hpp"
+
+#include <stb/stb_image.h>
+
+#include <spdlog/spdlog.h>
+
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#include <cmath>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    const std::string COOKED_DIRECTORY = "cooked";
+
+    bool hasExtension(const fs::path &path, std::initializer_list<const char *> extensions)
+    {
+        std::string extension = path.extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+        return std::find_if(extensions.begin(), extensions.end(), [&](const char *e)
+                            { return extension == e; }) != extensions.end();
+    }
+
+    // All files below the data directory except for already cooked ones, relative to the data directory
+    std::vector<std::string> findSources(const fs::path &dataDirectory, std::initializer_list<const char *> extensions)
+    {
+        std::vector<std::string> sources;
+        for (const auto &entry : fs::recursive_directory_iterator(dataDirectory))
+        {
+            fs::path relative = fs::relative(entry.path(), dataDirectory);
+            if (!entry.is_regular_file() || *relative.begin() == COOKED_DIRECTORY || !hasExtension(relative, extensions))
+            {
+                continue;
+            }
+            sources.push_back(relative.generic_string());
+        }
+        std::sort(sources.begin(), sources.end());
+        return sources;
+    }
+
+    // 2x2 box filter down to 1x1, odd edges reuse the last row/column
+    std::vector<std::vector<unsigned char>> generateMipChain(const unsigned char *pixels, int width, int height, int channels)
+    {
+        std::vector<std::vector<unsigned char>> chain;
+        chain.emplace_back(pixels, pixels + static_cast<size_t>(width) * height * channels);
+
+        while (width > 1 || height > 1)
+        {
+            const std::vector<unsigned char> &source = chain.back();
+            int mipWidth = std::max(1, width / 2);
+            int mipHeight = std::max(1, height / 2);
+            std::vector<unsigned char> mip(static_cast<size_t>(mipWidth) * mipHeight * channels);
+
+            for (int y = 0; y < mipHeight; y++)
+            {
+                int y0 = std::min(2 * y, height - 1);
+                int y1 = std::min(2 * y + 1, height - 1);
+                for (int x = 0; x < mipWidth; x++)
+                {
+                    int x0 = std::min(2 * x, width - 1);
+                    int x1 = std::min(2 * x + 1, width - 1);
+                    for (int c = 0; c < channels; c++)
+                    {
+                        unsigned sum = source[(static_cast<size_t>(y0) * width + x0) * channels + c] +
+                                       source[(static_cast<size_t>(y0) * width + x1) * channels + c] +
+                                       source[(static_cast<size_t>(y1) * width + x0) * channels + c] +
+                                       source[(static_cast<size_t>(y1) * width + x1) * channels + c];
+                        mip[(static_cast<size_t>(y) * mipWidth + x) * channels + c] = static_cast<unsigned char>((sum + 2) / 4);
+                    }
+                }
+            }
+
+            chain.push_back(std::move(mip));
+            width = mipWidth;
+            height = mipHeight;
+        }
+        return chain;
+    }
+
+    enum class TextureRole
+    {
+        Color,
+        Normal,
+        Mask
+    };
+
+    // For textures that no material references, guess the role from the usual file name suffixes
+    TextureRole guessTextureRole(const std::string &path)
+    {
+        std::string name = fs::path(path).stem().string();
+        std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+        for (const char *tag : {"_nor", "normal", "_nrm"})
+        {
+            if (name.find(tag) != std::string::npos)
+            {
+                return TextureRole::Normal;
+            }
+        }
+        for (const char *tag : {"rough", "metal", "spec", "gloss", "mask", "bump", "_ao"})
+        {
+            if (name.find(tag) != std::string::npos)
+            {
+                return TextureRole::Mask;
+            }
+        }
+        return TextureRole::Color;
+    }
+
+    // Box filtering shortens normals, bring them back to unit length
+    void renormalize(std::vector<unsigned char> &mip, int channels)
+    {
+        for (size_t i = 0; i + 2 < mip.size(); i += channels)
+        {
+            float x = mip[i] / 127.5f - 1.0f, y = mip[i + 1] / 127.5f - 1.0f, z = mip[i + 2] / 127.5f - 1.0f;
+            float length = std::sqrt(x * x + y * y + z * z);
+            if (length < 1e-4f)
+            {
+                continue;
+            }
+            mip[i] = static_cast<unsigned char>(std::lround((x / length + 1.0f) * 127.5f));
+            mip[i + 1] = static_cast<unsigned char>(std::lround((y / length + 1.0f) * 127.5f));
+            mip[i + 2] = static_cast<unsigned char>(std::lround((z / length + 1.0f) * 127.5f));
+        }
+    }
+
+    struct TextureSizes
+    {
+        size_t uncompressed{0}; // what the runtime importer would upload, mips included
+        size_t cooked{0};
+    };
+
+    bool cookTexture(const fs::path &sourcePath, const fs::path &cookedPath, TextureRole role, TextureSizes &sizes)
+    {
+        // Colour maps are expanded to RGBA so grey images stay grey, BC4 and BC5 read the leading channels
+        int width{0}, height{0}, sourceChannels{0};
+        int requestedChannels = role == TextureRole::Color ? 4 : 0;
+        unsigned char *pixels = stbi_load(sourcePath.string().c_str(), &width, &height, &sourceChannels, requestedChannels);
+        if (pixels == nullptr)
+        {
+            spdlog::error("Unable to decode \"{}\": {}", sourcePath.string(), stbi_failure_reason());
+            return false;
+        }
+        int numChannels = requestedChannels != 0 ? requestedChannels : sourceChannels;
+
+        planets::Texture2D::TextureDataFormat format;
+        if (role == TextureRole::Normal && numChannels >= 3)
+        {
+            format = planets::Texture2D::TextureDataFormat::BC5;
+        }
+        else if (role == TextureRole::Color)
+        {
+            bool hasAlpha = false;
+            for (size_t i = 3; i < static_cast<size_t>(width) * height * 4 && !hasAlpha; i += 4)
+            {
+                hasAlpha = pixels[i] != 255;
+            }
+            format = hasAlpha ? planets::Texture2D::TextureDataFormat::BC7 : planets::Texture2D::TextureDataFormat::BC1;
+        }
+        else
+        {
+            format = planets::Texture2D::TextureDataFormat::BC4;
+        }
+
+        std::vector<std::vector<unsigned char>> chain = generateMipChain(pixels, width, height, numChannels);
+        stbi_image_free(pixels);
+
+        std::vector<std::vector<unsigned char>> compressed;
+        std::vector<planets::Texture2D::MipLevel> mipLevels;
+        int mipWidth = width, mipHeight = height;
+        for (size_t level = 0; level < chain.size(); level++)
+        {
+            if (format == planets::Texture2D::TextureDataFormat::BC5 && level > 0)
+            {
+                renormalize(chain[level], numChannels);
+            }
+            compressed.push_back(planets::TextureCompressor::compress(format, chain[level].data(), mipWidth, mipHeight, numChannels));
+            mipLevels.push_back({mipWidth, mipHeight, compressed.back().data(), compressed.back().size()});
+
+            sizes.uncompressed += static_cast<size_t>(mipWidth) * mipHeight * sourceChannels;
+            sizes.cooked += compressed.back().size();
+            mipWidth = std::max(1, mipWidth / 2);
+            mipHeight = std::max(1, mipHeight / 2);
+        }
+
+        return planets::CookedTexture::write(cookedPath.string(), format, mipLevels);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    fs::path dataDirectory = argc > 1 ? argv[1] : "data";
+    if (!fs::is_directory(dataDirectory))
+    {
+        spdlog::critical("Data directory \"{}\" does not exist", dataDirectory.string());
+        return EXIT_FAILURE;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    planets::ThreadPool threadPool;
+    planets::AssetManifest manifest;
+    std::mutex manifestMutex;
+    size_t failures = 0;
+    std::unordered_map<std::string, TextureRole> textureRoles;
+
+    // Meshes, each of them is parsed in parallel internally
+    for (const auto &source : findSources(dataDirectory, {".obj"}))
+    {
+        std::string cooked = COOKED_DIRECTORY + '/' + source + ".pmesh";
+        spdlog::info("Cooking mesh \"{}\"", source);
+        try
+        {
+            planets::ImportedMesh mesh = planets::MeshImporter::importObj((dataDirectory / source).string(), threadPool);
+            for (const auto &material : mesh.materials)
+            {
+                for (auto [map, role] : {std::make_pair(&material.diffuseMap, TextureRole::Color),
+                                         std::make_pair(&material.normalMap, TextureRole::Normal),
+                                         std::make_pair(&material.roughnessMap, TextureRole::Mask),
+                                         std::make_pair(&material.metalnessMap, TextureRole::Mask)})
+                {
+                    if (map->size() > 0)
+                    {
+                        textureRoles[*map] = role;
+                    }
+                }
+            }
+            // The engine checks cooked meshes against their sources, relative to its data directory
+            for (auto &sourcePath : mesh.sourcePaths)
+            {
+                sourcePath = fs::path(sourcePath).lexically_relative(dataDirectory).generic_string();
+            }
+
+            fs::create_directories((dataDirectory / cooked).parent_path());
+            if (!planets::MeshCache::write((dataDirectory / cooked).string(), mesh, dataDirectory.string()))
+            {
+                throw std::runtime_error("Unable to write cooked mesh");
+            }
+            manifest.add(planets::AssetManifest::AssetKind::Mesh, source, cooked);
+        }
+        catch (std::exception &e)
+        {
+            spdlog::error("Unable to cook mesh \"{}\": {}", source, e.what());
+            failures++;
+        }
+    }
+
+    // Textures, one per task. Must be flipped the same way as in the ResourceManager.
+    stbi_set_flip_vertically_on_load(true);
+    std::vector<std::string> textures = findSources(dataDirectory, {".png", ".jpg", ".jpeg"});
+    TextureSizes totalSizes;
+    threadPool.parallelFor(0, textures.size(), 1, [&](size_t begin, size_t end)
+                           {
+                               for (size_t i = begin; i < end; i++)
+                               {
+                                   const std::string &source = textures[i];
+                                   std::string cooked = COOKED_DIRECTORY + '/' + source + ".ptex";
+                                   spdlog::info("Cooking texture \"{}\"", source);
+
+                                   auto role = textureRoles.find(source);
+                                   TextureSizes sizes;
+                                   bool ok = cookTexture(dataDirectory / source, dataDirectory / cooked,
+                                                         role != textureRoles.end() ? role->second : guessTextureRole(source),
+                                                         sizes);
+                                   std::lock_guard<std::mutex> lock(manifestMutex);
+                                   if (ok)
+                                   {
+                                       manifest.add(planets::AssetManifest::AssetKind::Texture, source, cooked);
+                                       totalSizes.uncompressed += sizes.uncompressed;
+                                       totalSizes.cooked += sizes.cooked;
+                                   }
+                                   else
+                                   {
+                                       failures++;
+                                   }
+                               } });
+
+    if (!manifest.save((dataDirectory / planets::AssetManifest::DEFAULT_PATH).string()))
+    {
+        return EXIT_FAILURE;
+    }
+
+    if (totalSizes.uncompressed > 0)
+    {
+        spdlog::info("Textures take {:.1f} MB of VRAM instead of {:.1f} MB uncompressed ({:.1f} MB, {:.0f}% saved)",
+                     totalSizes.cooked / 1048576.0, totalSizes.uncompressed / 1048576.0,
+                     (totalSizes.uncompressed - totalSizes.cooked) / 1048576.0,
+                     100.0 * (totalSizes.uncompressed - totalSizes.cooked) / totalSizes.uncompressed);
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    spdlog::info("Cooked {} assets in {:.1f} s, {} failed", manifest.size(), seconds, failures);
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,89 @@
+/*
+Packs every file under the data directory (including cooked assets and mesh caches)
+into one asset archive that the engine memory maps instead of opening loose files,
+see AssetArchive. Files are compressed with LZ4 unless they are images that already
+are compressed or compression saves less than MIN_SAVING of their size. Run planets-cook
+first so that the archive contains the runtime-ready versions of the assets.
+
+Usage: planets-pack [data directory] [archive path]
+*/
+
+#include "AssetArchive.hpp"
+#include "ThreadPool.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    // Smaller savings are not worth decompressing for
+    constexpr double MIN_SAVING = 0.125;
+
+    bool isCompressedFormat(const fs::path &path)
+    {
+        std::string extension = path.extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+        return extension == ".png" || extension == ".jpg" || extension == ".jpeg";
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    fs::path dataDirectory = argc > 1 ? argv[1] : "data";
+    fs::path archivePath = argc > 2 ? fs::path(argv[2]) : fs::path(dataDirectory.string() + ".pak");
+    if (!fs::is_directory(dataDirectory))
+    {
+        spdlog::critical("Data directory \"{}\" does not exist", dataDirectory.string());
+        return EXIT_FAILURE;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<planets::AssetArchive::SourceFile> files;
+    std::error_code ec;
+    for (const auto &entry : fs::recursive_directory_iterator(dataDirectory))
+    {
+        // An archive written into the data directory must not pack itself
+        if (!entry.is_regular_file() || fs::equivalent(entry.path(), archivePath, ec))
+        {
+            continue;
+        }
+        planets::AssetArchive::SourceFile file;
+        file.path = fs::relative(entry.path(), dataDirectory).lexically_normal().generic_string();
+        file.fullPath = entry.path().string();
+        file.compress = !isCompressedFormat(entry.path());
+        files.push_back(std::move(file));
+    }
+    // Files of the same directory end up next to each other
+    std::sort(files.begin(), files.end(), [](const auto &a, const auto &b)
+              { return a.path < b.path; });
+
+    planets::ThreadPool threadPool;
+    if (!planets::AssetArchive::write(archivePath.string(), files, threadPool, MIN_SAVING))
+    {
+        return EXIT_FAILURE;
+    }
+
+    planets::AssetArchive archive(archivePath.string());
+    size_t totalSize = 0, storedSize = 0, compressed = 0;
+    for (const auto &entry : archive.getEntries())
+    {
+        totalSize += entry.size;
+        storedSize += entry.storedSize;
+        compressed += entry.compression != planets::AssetArchive::Compression::None ? 1 : 0;
+    }
+
+    spdlog::info("Packed {} files ({} compressed) into \"{}\": {:.1f} MiB -> {:.1f} MiB in {:.1f} s",
+                 files.size(), compressed, archivePath.string(),
+                 totalSize / (1024.0 * 1024.0), storedSize / (1024.0 * 1024.0),
+                 std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    return EXIT_SUCCESS;
+}